@@ -0,0 +1,51 @@
+// Shared with ColorVertexShader.hlsl.
+cbuffer FrameConstantBuffer : register(b0)
+{
+    matrix view;
+    matrix projection;
+};
+
+// Written per draw, into the constant ring; the world matrices come from the instance stream.
+cbuffer ModelConstantBuffer : register(b1)
+{
+    // Dequantization for packed vertex formats; a scale of one and a bias of zero for float vertices.
+    float4 positionScale;
+    float4 positionBias;
+};
+
+struct VertexShaderInput
+{
+    float3 pos : POSITION;
+    float4 color : COLOR0;
+
+    // Per instance data from input slot 1; the world matrix arrives as four rows.
+    float4 world0 : WORLD0;
+    float4 world1 : WORLD1;
+    float4 world2 : WORLD2;
+    float4 world3 : WORLD3;
+    float4 instanceColor : INSTANCECOLOR0;
+};
+
+struct VertexShaderOutput
+{
+    float4 pos : SV_POSITION;
+    float4 color : COLOR0;
+};
+
+VertexShaderOutput main(VertexShaderInput input)
+{
+    VertexShaderOutput output;
+    float4 pos = float4(input.pos * positionScale.xyz + positionBias.xyz, 1.0f);
+    float4x4 world = float4x4(input.world0, input.world1, input.world2, input.world3);
+
+    // Transform the vertex position into projected space.
+    pos = mul(pos, world);
+    pos = mul(pos, view);
+    pos = mul(pos, projection);
+    output.pos = pos;
+
+    // Tint the vertex color by the instance color.
+    output.color = input.color * input.instanceColor;
+
+    return output;
+}
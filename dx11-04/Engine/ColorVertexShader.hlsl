@@ -1,10 +1,20 @@
-cbuffer ModelViewProjectionConstantBuffer : register(b0)
+// Written once per frame.
+cbuffer FrameConstantBuffer : register(b0)
 {
-    matrix world;
     matrix view;
     matrix projection;
 };
 
+// Written per draw, into the constant ring.
+cbuffer ObjectConstantBuffer : register(b1)
+{
+    matrix world;
+
+    // Dequantization for packed vertex formats; a scale of one and a bias of zero for float vertices.
+    float4 positionScale;
+    float4 positionBias;
+};
+
 struct VertexShaderInput
 {
     float3 pos : POSITION;
@@ -20,7 +30,7 @@ struct VertexShaderOutput
 VertexShaderOutput main(VertexShaderInput input)
 {
     VertexShaderOutput output;
-    float4 pos = float4(input.pos, 1.0f);
+    float4 pos = float4(input.pos * positionScale.xyz + positionBias.xyz, 1.0f);
 
     // Transform the vertex position into projected space.
     pos = mul(pos, world);
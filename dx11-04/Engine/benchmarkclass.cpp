@@ -0,0 +1,248 @@
+#include "benchmarkclass.h"
+#include "cameraclass.h"
+#include "linearallocatorclass.h"
+#include "poolallocatorclass.h"
+#include <fstream>
+#include <map>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+    // Each sample runs for about this long.
+    const double SAMPLE_SECONDS = 0.01;
+
+    // Keeps the optimizer from dropping the benchmarked work.
+    volatile unsigned int g_sink;
+}
+
+const double BenchmarkClass::REGRESSION_THRESHOLD = 0.10;
+
+BenchmarkClass::Result BenchmarkClass::Measure(const char* name, const function<void(unsigned int)>& body)
+{
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+
+    // Double the iterations until one sample lasts a tenth of SAMPLE_SECONDS, then scale up to the full sample length.
+    unsigned int iterations = 1;
+    double seconds = 0.0;
+    for (;;)
+    {
+        QueryPerformanceCounter(&start);
+        body(iterations);
+        QueryPerformanceCounter(&end);
+        seconds = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+        if (seconds >= SAMPLE_SECONDS / 10.0 || iterations >= 0x10000000)
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+    iterations = max((unsigned int)(iterations * SAMPLE_SECONDS / max(seconds, 1e-9)), 1u);
+
+    double samples[SAMPLE_COUNT];
+    double sum = 0.0;
+    unsigned long long allocations = MemoryClass::GetThreadHeapAllocationCount();
+    for (int i = 0; i < SAMPLE_COUNT; i++)
+    {
+        QueryPerformanceCounter(&start);
+        body(iterations);
+        QueryPerformanceCounter(&end);
+        samples[i] = (double)(end.QuadPart - start.QuadPart) * 1e9 / frequency.QuadPart / iterations;
+        sum += samples[i];
+    }
+    allocations = MemoryClass::GetThreadHeapAllocationCount() - allocations;
+
+    Result result;
+    result.name = name;
+    result.nanosecondsPerOp = sum / SAMPLE_COUNT;
+    double squares = 0.0;
+    for (int i = 0; i < SAMPLE_COUNT; i++)
+    {
+        squares += (samples[i] - result.nanosecondsPerOp) * (samples[i] - result.nanosecondsPerOp);
+    }
+    result.deviation = sqrt(squares / (SAMPLE_COUNT - 1));
+    result.allocationsPerOp = (double)allocations / ((double)iterations * SAMPLE_COUNT);
+    return result;
+}
+
+vector<BenchmarkClass::Result> BenchmarkClass::RunAll()
+{
+    vector<Result> results;
+
+    // A turning camera, so the rotation isn't the same every call.
+    unique_ptr<CameraClass> camera(new CameraClass());
+    camera->SetPosition(XMFLOAT3(0.0f, 0.0f, -10.0f));
+    CameraClass* cameraPtr = camera.get();
+    results.push_back(Measure("CameraClass::Render", [cameraPtr](unsigned int iterations)
+    {
+        for (unsigned int i = 0; i < iterations; i++)
+        {
+            cameraPtr->SetRotation(XMFLOAT3((float)(i & 63), (float)(i & 255), 0.0f));
+            cameraPtr->Render();
+        }
+    }));
+
+    results.push_back(Measure("engine_exception formatting", [](unsigned int iterations)
+    {
+        size_t length = 0;
+        for (unsigned int i = 0; i < iterations; i++)
+        {
+            engine_exception exception("Couldn't create buffer, result code = ");
+            exception << (long)(0x80070057 + i);
+            length += strlen(exception.what());
+        }
+        g_sink = (unsigned int)length;
+    }));
+
+    // Frame allocations of a few culling or command arrays, with the reset at the end of every frame.
+    LinearAllocatorClass frameAllocator;
+    frameAllocator.Initialize("Benchmark frame allocator", 1024 * 1024, false);
+    LinearAllocatorClass* frameAllocatorPtr = &frameAllocator;
+    results.push_back(Measure("LinearAllocatorClass::Allocate", [frameAllocatorPtr](unsigned int iterations)
+    {
+        size_t addresses = 0;
+        for (unsigned int i = 0; i < iterations; i++)
+        {
+            if ((i & 1023) == 0)
+            {
+                frameAllocatorPtr->Reset();
+            }
+            addresses += (size_t)frameAllocatorPtr->Allocate(64 + (i & 7) * 16, 16);
+        }
+        g_sink = (unsigned int)addresses;
+    }));
+
+    // An object taken from its pool and given back, under the pool's lock.
+    PoolAllocatorClass pool("Benchmark pool", 256, 16, 64);
+    PoolAllocatorClass* poolPtr = &pool;
+    results.push_back(Measure("PoolAllocatorClass::Allocate and Free", [poolPtr](unsigned int iterations)
+    {
+        size_t addresses = 0;
+        for (unsigned int i = 0; i < iterations; i++)
+        {
+            void* block = poolPtr->Allocate(256);
+            addresses += (size_t)block;
+            poolPtr->Free(block);
+        }
+        g_sink = (unsigned int)addresses;
+    }));
+
+    // A steady-state log call. The sinks are off while it runs so the writer thread only has to skip the records and keeps
+    // up; a dropped record would make the call look cheaper than it is.
+    unsigned int sinks = LogClass::GetSinks();
+    LogClass::Flush();
+    LogClass::SetSinks(0);
+    unsigned long long dropped = LogClass::GetDroppedCount();
+    results.push_back(Measure("LogClass::Write", [](unsigned int iterations)
+    {
+        for (unsigned int i = 0; i < iterations; i++)
+        {
+            LogClass::Write(LOG_LEVEL_INFO, "Benchmark record {}: {} ms on {}", i, i * 0.5, "the benchmark thread");
+        }
+    }));
+    dropped = LogClass::GetDroppedCount() - dropped;
+    LogClass::Flush();
+    LogClass::SetSinks(sinks);
+    if (dropped > 0)
+    {
+        LOG_WARNING("LogClass::Write benchmark dropped {} records and is too optimistic", dropped);
+    }
+
+    // Reported at the end, so the log's writer thread isn't formatting while the benchmarks run.
+    LogResults(results);
+    return results;
+}
+
+void BenchmarkClass::LogResults(const vector<Result>& results)
+{
+    for (const Result& result : results)
+    {
+        LOG_INFO("Benchmark {}: {} ns/op +- {} ns, {} allocations/op", result.name, result.nanosecondsPerOp, result.deviation, result.allocationsPerOp);
+    }
+}
+
+void BenchmarkClass::SaveBaseline(const char* fileName, const vector<Result>& results)
+{
+    ofstream file(fileName);
+    if (!file)
+    {
+        throw engine_exception("Couldn't write benchmark baseline ") << fileName;
+    }
+
+    // One benchmark per line: name, ns/op, deviation and allocations/op, tab separated.
+    file.precision(9);
+    for (const Result& result : results)
+    {
+        file << result.name << '\t' << result.nanosecondsPerOp << '\t' << result.deviation << '\t' << result.allocationsPerOp << '\n';
+    }
+
+    if (!file)
+    {
+        throw engine_exception("Couldn't write benchmark baseline ") << fileName;
+    }
+}
+
+int BenchmarkClass::CompareWithBaseline(const char* fileName, const vector<Result>& results, const double threshold)
+{
+    ifstream file(fileName);
+    if (!file)
+    {
+        throw engine_exception("Couldn't read benchmark baseline ") << fileName;
+    }
+
+    map<string, Result> baseline;
+    string line;
+    while (getline(file, line))
+    {
+        size_t tab = line.find('\t');
+        if (tab == string::npos)
+        {
+            continue;
+        }
+
+        Result result;
+        result.name = line.substr(0, tab);
+        stringstream values(line.substr(tab + 1));
+        if (values >> result.nanosecondsPerOp >> result.deviation >> result.allocationsPerOp)
+        {
+            baseline[result.name] = result;
+        }
+    }
+
+    // A benchmark regresses when it is threshold slower than its baseline, or three baseline deviations if that's more.
+    int regressions = 0;
+    for (const Result& result : results)
+    {
+        map<string, Result>::iterator entry = baseline.find(result.name);
+        if (entry == baseline.end())
+        {
+            LOG_INFO("  {}: not in the baseline", result.name);
+            continue;
+        }
+
+        const Result& previous = entry->second;
+        double limit = previous.nanosecondsPerOp + max(previous.nanosecondsPerOp * threshold, previous.deviation * 3.0);
+        bool slower = result.nanosecondsPerOp > limit;
+        bool allocates = result.allocationsPerOp > previous.allocationsPerOp + 0.01;
+        if (slower || allocates)
+        {
+            regressions++;
+        }
+
+        LOG_INFO("  {}: {} ns/op against {} ({}%), {} allocations/op against {}{}{}", result.name, result.nanosecondsPerOp, previous.nanosecondsPerOp,
+                 (result.nanosecondsPerOp / previous.nanosecondsPerOp - 1.0) * 100.0, result.allocationsPerOp, previous.allocationsPerOp,
+                 slower ? ", SLOWER" : "", allocates ? ", MORE ALLOCATIONS" : "");
+        baseline.erase(entry);
+    }
+
+    for (map<string, Result>::iterator entry = baseline.begin(); entry != baseline.end(); ++entry)
+    {
+        LOG_INFO("  {}: in the baseline but not run", entry->first);
+    }
+
+    LOG_INFO("Benchmark comparison with {}: {} regressions", fileName, regressions);
+    return regressions;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "engine_core.h"
+#include <vector>
+#include <string>
+#include <functional>
+
+using namespace std;
+
+// Microbenchmarks of the engine's platform independent CPU hot paths, run by EngineBenchmarks on any platform and by
+// "Engine.exe -benchmark baseline" (with Win32BenchmarkClass's) before any window or device exists. Every benchmark is
+// timed over SAMPLE_COUNT samples, each long enough to swamp the timer, and reports the mean cost per operation, the
+// standard deviation between samples and the heap allocations per operation. Results can be saved as a baseline file; a
+// later run fails when a benchmark is slower than its baseline by more than the regression threshold (or its noise, if
+// that's larger) or allocates more.
+class BenchmarkClass
+{
+public:
+    struct Result
+    {
+        string name;
+        double nanosecondsPerOp;
+        double deviation; // Nanoseconds per op between samples.
+        double allocationsPerOp;
+    };
+
+    // Runs every benchmark and logs the results.
+    static vector<Result> RunAll();
+
+    // body runs the operation the given number of times.
+    static Result Measure(const char* name, const function<void(unsigned int)>& body);
+
+    static void LogResults(const vector<Result>& results);
+
+    static void SaveBaseline(const char* fileName, const vector<Result>& results);
+
+    // Fraction slower than the baseline that counts as a regression, unless the caller passes its own.
+    static const double REGRESSION_THRESHOLD;
+
+    // Compares results with a saved baseline, writes the verdict for every benchmark and returns the number of regressions.
+    // Benchmarks missing from either side are reported but don't fail.
+    static int CompareWithBaseline(const char* fileName, const vector<Result>& results, const double threshold = REGRESSION_THRESHOLD);
+
+private:
+    static const int SAMPLE_COUNT = 15;
+};
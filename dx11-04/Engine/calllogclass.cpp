@@ -0,0 +1,209 @@
+#include "calllogclass.h"
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    // Calls of a frame the logs have room for up front.
+    const size_t FRAME_LOG_CAPACITY = 4096;
+
+    const char* const CALL_NAMES[CallLogClass::CALL_COUNT] =
+    {
+        "IASetInputLayout", "IASetVertexBuffers", "IASetIndexBuffer", "IASetPrimitiveTopology",
+        "VSSetShader", "VSSetConstantBuffers", "VSSetShaderResources", "VSSetSamplers",
+        "PSSetShader", "PSSetConstantBuffers", "PSSetShaderResources", "PSSetSamplers",
+        "RSSetState", "RSSetViewports", "RSSetScissorRects",
+        "OMSetRenderTargets", "OMSetBlendState", "OMSetDepthStencilState",
+        "Draw", "DrawIndexed", "DrawInstanced", "DrawIndexedInstanced",
+        "Map", "Unmap", "UpdateSubresource",
+        "ClearRenderTargetView", "ClearDepthStencilView", "ClearState", "Flush", "ExecuteCommandList", "FinishCommandList", "Other",
+        "CreateBuffer", "CreateTexture2D", "CreateShaderResourceView", "CreateRenderTargetView", "CreateDepthStencilView",
+        "CreateInputLayout", "CreateVertexShader", "CreatePixelShader",
+        "CreateBlendState", "CreateDepthStencilState", "CreateRasterizerState", "CreateSamplerState", "CreateDeferredContext"
+    };
+}
+
+CallLogClass::CallLogClass()
+{
+    ZeroMemory(&m_statistics, sizeof(m_statistics));
+    ZeroMemory(&m_frameStatistics, sizeof(m_frameStatistics));
+
+    // Both logs are swapped every frame, so with room for a typical frame neither allocates while frames are recorded.
+    m_log.reserve(FRAME_LOG_CAPACITY);
+    m_frameLog.reserve(FRAME_LOG_CAPACITY);
+}
+
+void CallLogClass::EndFrame()
+{
+    lock_guard<mutex> lock(m_frameMutex);
+    m_frameLog.swap(m_log);
+    m_log.clear();
+    m_frameStatistics = m_statistics;
+    ZeroMemory(&m_statistics, sizeof(m_statistics));
+}
+
+const CallLogClass::FrameStatistics& CallLogClass::GetFrameStatistics()
+{
+    return m_frameStatistics;
+}
+
+const vector<CallLogClass::CallRecord>& CallLogClass::GetFrameLog()
+{
+    return m_frameLog;
+}
+
+void CallLogClass::WriteFrameLog(ostream& stream)
+{
+    for (const CallRecord& record : m_frameLog)
+    {
+        stream << CALL_NAMES[record.call] << ' ' << record.arguments[0] << ' ' << record.arguments[1] << ' ' << record.arguments[2] << '\n';
+    }
+}
+
+const char* CallLogClass::GetCallName(const Call call)
+{
+    return CALL_NAMES[call];
+}
+
+void CallLogClass::Record(const Call call, const unsigned int argument0, const unsigned int argument1, const unsigned int argument2)
+{
+    CallRecord record;
+    record.call = call;
+    record.arguments[0] = argument0;
+    record.arguments[1] = argument1;
+    record.arguments[2] = argument2;
+
+    lock_guard<mutex> lock(m_frameMutex);
+    m_log.push_back(record);
+    Count(m_statistics, call);
+}
+
+void CallLogClass::Record(const vector<CallRecord>& records)
+{
+    lock_guard<mutex> lock(m_frameMutex);
+    m_log.insert(m_log.end(), records.begin(), records.end());
+    for (const CallRecord& record : records)
+    {
+        Count(m_statistics, record.call);
+    }
+}
+
+void CallLogClass::Count(FrameStatistics& statistics, const Call call)
+{
+    statistics.calls[call]++;
+    if (call <= CALL_OM_SET_DEPTH_STENCIL_STATE)
+    {
+        statistics.stateChanges++;
+    }
+    else if (call >= CALL_DRAW && call <= CALL_DRAW_INDEXED_INSTANCED)
+    {
+        statistics.draws++;
+    }
+    else if (call == CALL_MAP)
+    {
+        statistics.maps++;
+    }
+    else if (call >= CALL_CREATE_BUFFER)
+    {
+        statistics.creations++;
+    }
+}
+
+
+void CallLogClass::Validate()
+{
+    auto check = [](const bool passed, const char* what)
+    {
+        if (!passed)
+        {
+            throw engine_exception("Call log validation: ") << what;
+        }
+    };
+
+    // A frame like the engine's: creation, output state, then per draw a few state changes, a map and the draw.
+    auto recordFrame = [](CallLogClass& log, const unsigned int draws)
+    {
+        log.Record(CALL_CREATE_BUFFER, 1, 256, 4);
+        log.Record(CALL_OM_SET_RENDER_TARGETS, 1, 2, 3);
+        log.Record(CALL_RS_SET_VIEWPORTS, 1, 800, 600);
+        for (unsigned int i = 0; i < draws; i++)
+        {
+            log.Record(CALL_MAP, 1, 4, 0);
+            log.Record(CALL_UNMAP, 1, 0, 0);
+            log.Record(CALL_VS_SET_CONSTANT_BUFFERS, 1, 1, 1);
+            log.Record(CALL_DRAW_INDEXED, 36, i * 36, 0);
+        }
+        log.Record(CALL_FLUSH, 0, 0, 0);
+    };
+
+    CallLogClass log;
+    recordFrame(log, 10);
+    log.EndFrame();
+    const FrameStatistics& statistics = log.GetFrameStatistics();
+    check(log.GetFrameLog().size() == 44, "a frame lost or gained calls");
+    check(statistics.stateChanges == 12 && statistics.draws == 10 && statistics.maps == 10 && statistics.creations == 1,
+          "calls were counted into the wrong categories");
+    check(statistics.calls[CALL_UNMAP] == 10 && statistics.calls[CALL_FLUSH] == 1, "calls were miscounted");
+    check(log.GetFrameLog()[3].call == CALL_MAP && log.GetFrameLog()[6].arguments[1] == 0 && log.GetFrameLog()[10].arguments[1] == 36,
+          "a frame's calls are out of order");
+
+    // What is recorded after EndFrame belongs to the next frame only.
+    log.Record(CALL_DRAW, 3, 0, 0);
+    check(log.GetFrameStatistics().draws == 10 && log.GetFrameLog().size() == 44, "a call leaked into the closed frame");
+    log.EndFrame();
+    check(log.GetFrameStatistics().draws == 1 && log.GetFrameLog().size() == 1, "the next frame didn't start empty");
+
+    // A command list's calls join the frame as one run, between the calls around it.
+    vector<CallRecord> commandList;
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        CallRecord record = { i % 2 == 0 ? CALL_PS_SET_SHADER : CALL_DRAW_INDEXED, { i, 0, 0 } };
+        commandList.push_back(record);
+    }
+    log.Record(CALL_EXECUTE_COMMAND_LIST, 7, 100, 0);
+    log.Record(commandList);
+    log.Record(CALL_CLEAR_STATE, 0, 0, 0);
+    log.EndFrame();
+    check(log.GetFrameLog().size() == 102 && log.GetFrameLog()[0].call == CALL_EXECUTE_COMMAND_LIST && log.GetFrameLog()[101].call == CALL_CLEAR_STATE,
+          "a command list didn't join the frame in one run");
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        check(log.GetFrameLog()[i + 1].arguments[0] == i, "a command list's calls are out of order");
+    }
+    check(log.GetFrameStatistics().stateChanges == 50 && log.GetFrameStatistics().draws == 50, "a command list's calls were miscounted");
+
+    // Recording from several threads at once, as deferred contexts finishing and object creation do.
+    const unsigned int threadCount = 4, callsPerThread = 10000;
+    vector<thread> threads;
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        threads.push_back(thread([&log, t]()
+        {
+            for (unsigned int i = 0; i < callsPerThread; i++)
+            {
+                log.Record(i % 2 == 0 ? CALL_MAP : CALL_DRAW, t, i, 0);
+            }
+        }));
+    }
+    for (auto& recorder : threads)
+    {
+        recorder.join();
+    }
+    log.EndFrame();
+    check(log.GetFrameLog().size() == threadCount * callsPerThread && log.GetFrameStatistics().maps == threadCount * callsPerThread / 2
+          && log.GetFrameStatistics().draws == threadCount * callsPerThread / 2, "calls recorded from several threads were lost");
+
+    // The same frame writes the same log, which is what lets logs of headless runs be compared.
+    ostringstream first, second;
+    recordFrame(log, 3);
+    log.EndFrame();
+    log.WriteFrameLog(first);
+    recordFrame(log, 3);
+    log.EndFrame();
+    log.WriteFrameLog(second);
+    check(!first.str().empty() && first.str() == second.str(), "identical frames wrote different logs");
+    check(first.str().compare(0, 15, "CreateBuffer 1 ") == 0, "the log doesn't name its calls");
+    check(string(GetCallName(CALL_CREATE_DEFERRED_CONTEXT)) == "CreateDeferredContext", "call names are out of step with the calls");
+
+    LOG_INFO("Call log validation passed");
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "engine_core.h"
+#include <vector>
+#include <mutex>
+#include <ostream>
+
+using namespace std;
+
+// The frame log of the null device: every device and context call, with up to three of its arguments, counted into
+// state changes, draws, maps and object creations. Calls may be recorded from any thread; EndFrame closes the frame and
+// keeps its log and counters, so tests can hold a frame to budgets like state changes per draw. Nothing here touches
+// D3D, so it is tested on its own.
+class CallLogClass
+{
+public:
+    enum Call
+    {
+        // State changes.
+        CALL_IA_SET_INPUT_LAYOUT,
+        CALL_IA_SET_VERTEX_BUFFERS,
+        CALL_IA_SET_INDEX_BUFFER,
+        CALL_IA_SET_PRIMITIVE_TOPOLOGY,
+        CALL_VS_SET_SHADER,
+        CALL_VS_SET_CONSTANT_BUFFERS,
+        CALL_VS_SET_SHADER_RESOURCES,
+        CALL_VS_SET_SAMPLERS,
+        CALL_PS_SET_SHADER,
+        CALL_PS_SET_CONSTANT_BUFFERS,
+        CALL_PS_SET_SHADER_RESOURCES,
+        CALL_PS_SET_SAMPLERS,
+        CALL_RS_SET_STATE,
+        CALL_RS_SET_VIEWPORTS,
+        CALL_RS_SET_SCISSOR_RECTS,
+        CALL_OM_SET_RENDER_TARGETS,
+        CALL_OM_SET_BLEND_STATE,
+        CALL_OM_SET_DEPTH_STENCIL_STATE,
+        // Draws.
+        CALL_DRAW,
+        CALL_DRAW_INDEXED,
+        CALL_DRAW_INSTANCED,
+        CALL_DRAW_INDEXED_INSTANCED,
+        // Uploads.
+        CALL_MAP,
+        CALL_UNMAP,
+        CALL_UPDATE_SUBRESOURCE,
+        // Everything else on a context.
+        CALL_CLEAR_RENDER_TARGET_VIEW,
+        CALL_CLEAR_DEPTH_STENCIL_VIEW,
+        CALL_CLEAR_STATE,
+        CALL_FLUSH,
+        CALL_EXECUTE_COMMAND_LIST,
+        CALL_FINISH_COMMAND_LIST,
+        CALL_OTHER,
+        // Object creation on the device.
+        CALL_CREATE_BUFFER,
+        CALL_CREATE_TEXTURE_2D,
+        CALL_CREATE_SHADER_RESOURCE_VIEW,
+        CALL_CREATE_RENDER_TARGET_VIEW,
+        CALL_CREATE_DEPTH_STENCIL_VIEW,
+        CALL_CREATE_INPUT_LAYOUT,
+        CALL_CREATE_VERTEX_SHADER,
+        CALL_CREATE_PIXEL_SHADER,
+        CALL_CREATE_BLEND_STATE,
+        CALL_CREATE_DEPTH_STENCIL_STATE,
+        CALL_CREATE_RASTERIZER_STATE,
+        CALL_CREATE_SAMPLER_STATE,
+        CALL_CREATE_DEFERRED_CONTEXT,
+        CALL_COUNT
+    };
+
+    // One call with up to three of its arguments; objects are recorded by number, zero for none.
+    struct CallRecord
+    {
+        Call call;
+        unsigned int arguments[3];
+    };
+
+    struct FrameStatistics
+    {
+        unsigned int calls[CALL_COUNT];
+        unsigned int stateChanges;
+        unsigned int draws;
+        unsigned int maps;
+        unsigned int creations;
+    };
+
+    CallLogClass();
+
+    // Closes the current frame. Calls from here on count towards the next one.
+    void EndFrame();
+
+    // Counters and log of the last frame EndFrame closed. Only read them on the thread that calls EndFrame.
+    const FrameStatistics& GetFrameStatistics();
+
+    const vector<CallRecord>& GetFrameLog();
+
+    // One call per line: its name and arguments.
+    void WriteFrameLog(ostream& stream);
+
+    static const char* GetCallName(const Call call);
+
+    // Appends a call to the current frame; safe from any thread.
+    void Record(const Call call, const unsigned int argument0, const unsigned int argument1, const unsigned int argument2);
+
+    // Adds a command list's calls to the current frame, in order.
+    void Record(const vector<CallRecord>& records);
+
+    // Records frames from several threads, and command list batches, and checks the counters, the frame boundaries and
+    // that identical frames write identical logs. Throws on a failure.
+    static void Validate();
+
+private:
+    // Guards the current frame, which the immediate context and object creation on any thread record into.
+    mutex m_frameMutex;
+    vector<CallRecord> m_log;
+    FrameStatistics m_statistics;
+    vector<CallRecord> m_frameLog;
+    FrameStatistics m_frameStatistics;
+
+    static void Count(FrameStatistics& statistics, const Call call);
+};
@@ -1,21 +1,7 @@
-#include "CameraClass.h"
+#include "cameraclass.h"
 
-void* CameraClass::operator new (size_t size)
-{
-    void* p = _aligned_malloc(size, 16);
-    if (p == 0)
-    {
-        throw std::bad_alloc();
-    }
-    
-    return p;
-}
-
-void CameraClass::operator delete(void* p)
-{
-    CameraClass* d = static_cast<CameraClass*>(p);
-    _aligned_free(d);
-}
+// The graphics camera and those of the benchmarks.
+DEFINE_POOL_ALLOCATION(CameraClass, 4)
 
 CameraClass::CameraClass()
 {
@@ -54,6 +40,8 @@ XMFLOAT3 CameraClass::GetRotation()
 
 void CameraClass::Render()
 {
+    PROFILE_FUNCTION();
+
     float yaw, pitch, roll;
 
     // Setup the vector that points upwards.
@@ -1,5 +1,6 @@
 #pragma once
-#include "engine.h"
+#include "engine_core.h"
+#include "poolallocatorclass.h"
 
 using namespace DirectX;
 
@@ -18,10 +19,8 @@ public:
     void Render();
     void GetViewMatrix(XMMATRIX& view);
 
-    // Operators for new and delete needed to set 16-byte alignment.
-    static void* operator new (size_t size);
-
-    static void operator delete (void* p);
+    // From a pool that keeps the view matrix 16-byte aligned.
+    DECLARE_POOL_ALLOCATION();
 
 private:
     XMFLOAT3 m_position;
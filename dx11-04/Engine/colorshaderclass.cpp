@@ -1,156 +1,250 @@
-#include "ColorShaderClass.h"
+#include "colorshaderclass.h"
 
 
 ColorShaderClass::ColorShaderClass()
 {
+    m_instanceBufferOffset = 0;
+    m_frameConstantsValid = false;
+    for (int format = 0; format < VertexFormatClass::FORMAT_COUNT; format++)
+    {
+        m_pipelines[format] = nullptr;
+        m_instancedPipelines[format] = nullptr;
+    }
 }
 
 ColorShaderClass::~ColorShaderClass()
 {
 }
 
-void ColorShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
+void ColorShaderClass::Initialize(ID3D11Device* device, PipelineCacheClass* pipelineCache, ShaderLibraryClass* shaderLibrary)
 {
-    InitializeShader(device, hwnd, L"E:\\workspace\\rastertek-dx11\\dx11-04\\Debug\\ColorVertexShader.cso", L"E:\\workspace\\rastertek-dx11\\dx11-04\\Debug\\ColorPixelShader.cso");
+    PROFILE_FUNCTION();
+
+    ShaderLibraryClass::Bytecode pixelShaderBytes = shaderLibrary->Load(ShaderLibraryClass::SHADER_COLOR_PIXEL);
+    InitializeShader(device, pipelineCache, shaderLibrary->Load(ShaderLibraryClass::SHADER_COLOR_VERTEX), pixelShaderBytes);
+    InitializeInstancedShader(device, pipelineCache, shaderLibrary->Load(ShaderLibraryClass::SHADER_COLOR_INSTANCED_VERTEX), pixelShaderBytes);
 }
 
-void ColorShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* vertexShaderFileName, WCHAR* pixelShaderFileName)
+void ColorShaderClass::InitializeShader(ID3D11Device* device, PipelineCacheClass* pipelineCache, const ShaderLibraryClass::Bytecode& vertexShaderBytes,
+                                        const ShaderLibraryClass::Bytecode& pixelShaderBytes)
 {
-    ComPtr<ID3DBlob> vertexShaderBuffer;
-    ComPtr<ID3DBlob> pixelShaderBuffer;
+    PipelineCacheClass::PipelineDesc pipelineDesc = PipelineCacheClass::GetDefaultDesc();
+    pipelineDesc.vertexShader = vertexShaderBytes;
+    pipelineDesc.pixelShader = pixelShaderBytes;
+
+    // Now setup the layout of the data that goes into the shader, one pipeline state for every vertex format a model can
+    // use. The elements come from VertexFormatClass so they always match the vertex buffers ModelClass creates. The
+    // formats share their shaders and fixed function state through the cache.
+    for (int format = 0; format < VertexFormatClass::FORMAT_COUNT; format++)
+    {
+        D3D11_INPUT_ELEMENT_DESC polygonLayout[VertexFormatClass::MAX_ELEMENTS];
+        pipelineDesc.numInputElements = VertexFormatClass::GetInputLayout((VertexFormatClass::Format)format, polygonLayout);
+        pipelineDesc.inputElements = polygonLayout;
+        m_pipelines[format] = pipelineCache->Create(pipelineDesc);
+    }
 
-    unsigned int vertexShaderBytesSize;
-    auto vertexShaderBytes = LoadFile(vertexShaderFileName, vertexShaderBytesSize);
-    HRESULT result = device->CreateVertexShader(vertexShaderBytes.get(), vertexShaderBytesSize, nullptr, m_vertexShader.GetAddressOf());
+    // View and projection, shared by the plain and instanced shaders; per draw constants live in the constant ring.
+    D3D11_BUFFER_DESC frameBufferDesc;
+    frameBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    frameBufferDesc.ByteWidth = sizeof(FrameBufferType);
+    frameBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    frameBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    frameBufferDesc.MiscFlags = 0;
+    frameBufferDesc.StructureByteStride = 0;
+
+    HRESULT result = device->CreateBuffer(&frameBufferDesc, NULL, m_frameBuffer.GetAddressOf());
     if (FAILED(result))
     {
-        throw engine_exception("Couldn't create vertex shader, result code = ") << result;
+        throw engine_exception("Couldn't create buffer, result code = ") << result;
     }
+    m_frameConstantsValid = false;
+}
 
-    unsigned int numBytes;
-    auto pixelShaderBytes = LoadFile(pixelShaderFileName, numBytes);
-    device->CreatePixelShader(pixelShaderBytes.get(), numBytes, nullptr, m_pixelShader.GetAddressOf());
-    if (FAILED(result))
+void ColorShaderClass::InitializeInstancedShader(ID3D11Device* device, PipelineCacheClass* pipelineCache, const ShaderLibraryClass::Bytecode& vertexShaderBytes,
+                                                 const ShaderLibraryClass::Bytecode& pixelShaderBytes)
+{
+    // Slot 0 is the same per vertex data as the plain layouts, slot 1 advances once per instance and holds an InstanceType.
+    const unsigned int instanceElements = 5;
+    D3D11_INPUT_ELEMENT_DESC polygonLayout[VertexFormatClass::MAX_ELEMENTS + instanceElements];
+    D3D11_INPUT_ELEMENT_DESC* instanceLayout = polygonLayout + VertexFormatClass::MAX_ELEMENTS;
+
+    // One element per row of the world matrix.
+    for (unsigned int row = 0; row < 4; row++)
     {
-        throw engine_exception("Couldn't create pixel shader, result code = ") << result;
+        instanceLayout[row].SemanticName = "WORLD";
+        instanceLayout[row].SemanticIndex = row;
+        instanceLayout[row].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        instanceLayout[row].InputSlot = 1;
+        instanceLayout[row].AlignedByteOffset = row == 0 ? 0 : D3D11_APPEND_ALIGNED_ELEMENT;
+        instanceLayout[row].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+        instanceLayout[row].InstanceDataStepRate = 1;
     }
 
-    // Now setup the layout of the data that goes into the shader.
-    // This setup needs to match the VertexType stucture in the ModelClass and in the shader.
-    D3D11_INPUT_ELEMENT_DESC polygonLayout[2];
-    polygonLayout[0].SemanticName = "POSITION";
-    polygonLayout[0].SemanticIndex = 0;
-    polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-    polygonLayout[0].InputSlot = 0;
-    polygonLayout[0].AlignedByteOffset = 0;
-    polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-    polygonLayout[0].InstanceDataStepRate = 0;
-
-    polygonLayout[1].SemanticName = "COLOR";
-    polygonLayout[1].SemanticIndex = 0;
-    polygonLayout[1].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-    polygonLayout[1].InputSlot = 0;
-    polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-    polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-    polygonLayout[1].InstanceDataStepRate = 0;
-
-    // Get a count of the elements in the layout.
-    unsigned int numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
-
-    // Create the vertex input layout.
-    //result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(),
-    //    vertexShaderBuffer->GetBufferSize(), &m_layout);
-    result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBytes.get(),
-        vertexShaderBytesSize, &m_layout);
-    if (FAILED(result))
+    instanceLayout[4].SemanticName = "INSTANCECOLOR";
+    instanceLayout[4].SemanticIndex = 0;
+    instanceLayout[4].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    instanceLayout[4].InputSlot = 1;
+    instanceLayout[4].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+    instanceLayout[4].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+    instanceLayout[4].InstanceDataStepRate = 1;
+
+    PipelineCacheClass::PipelineDesc pipelineDesc = PipelineCacheClass::GetDefaultDesc();
+    pipelineDesc.vertexShader = vertexShaderBytes;
+    pipelineDesc.pixelShader = pixelShaderBytes;
+    pipelineDesc.inputElements = polygonLayout;
+
+    for (int format = 0; format < VertexFormatClass::FORMAT_COUNT; format++)
     {
-        throw engine_exception("Couldn'y create input layout, result code = ") << result;
+        // The vertex elements go right in front of the instance elements; every format fills all MAX_ELEMENTS.
+        unsigned int numVertexElements = VertexFormatClass::GetInputLayout((VertexFormatClass::Format)format, polygonLayout);
+        if (numVertexElements != VertexFormatClass::MAX_ELEMENTS)
+        {
+            throw engine_exception("Vertex format doesn't fill the instanced input layout");
+        }
+
+        pipelineDesc.numInputElements = numVertexElements + instanceElements;
+        m_instancedPipelines[format] = pipelineCache->Create(pipelineDesc);
     }
 
-    // Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-    D3D11_BUFFER_DESC matrixBufferDesc;
-    matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-    matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-    matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    matrixBufferDesc.MiscFlags = 0;
-    matrixBufferDesc.StructureByteStride = 0;
-
-    // Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-    result = device->CreateBuffer(&matrixBufferDesc, NULL, m_matrixBuffer.GetAddressOf());
+    // The instance buffer is written as a ring so consecutive chunks don't stall on the GPU still reading the previous one.
+    D3D11_BUFFER_DESC instanceBufferDesc;
+    instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    instanceBufferDesc.ByteWidth = sizeof(InstanceType) * MAX_INSTANCES_PER_DRAW;
+    instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    instanceBufferDesc.MiscFlags = 0;
+    instanceBufferDesc.StructureByteStride = 0;
+
+    HRESULT result = device->CreateBuffer(&instanceBufferDesc, NULL, m_instanceBuffer.GetAddressOf());
     if (FAILED(result))
     {
-        throw engine_exception("Couldn't create buffer, result code = ") << result;
+        throw engine_exception("Couldn't create instance buffer, result code = ") << result;
     }
-}
 
-void ColorShaderClass::Render(ID3D11DeviceContext* deviceContext, const int indexCount, const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection)
-{
-    SetShaderParameters(deviceContext, world, view, projection);
-    RenderShader(deviceContext, indexCount);
+    m_instanceBufferOffset = 0;
 }
 
-void ColorShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection)
+void ColorShaderClass::SetFrameConstants(StateCacheClass* stateCache, const XMMATRIX& view, const XMMATRIX& projection)
 {
-    // Transpose the matrices to prepare them for the shader.
-    XMMATRIX worldMatrix = XMMatrixTranspose(world);
-    XMMATRIX viewMatrix = XMMatrixTranspose(view);
-    XMMATRIX projectionMatrix = XMMatrixTranspose(projection);
-
-    // Lock the constant buffer so it can be written to.
-    D3D11_MAPPED_SUBRESOURCE mappedResource;
-    HRESULT result = deviceContext->Map(m_matrixBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-    if (FAILED(result))
+    XMFLOAT4X4 viewMatrix, projectionMatrix;
+    XMStoreFloat4x4(&viewMatrix, XMMatrixTranspose(view));
+    XMStoreFloat4x4(&projectionMatrix, XMMatrixTranspose(projection));
+
+    // A camera that hasn't moved costs no upload at all.
+    bool unchanged = m_frameConstantsValid && memcmp(&viewMatrix, &m_frameView, sizeof(viewMatrix)) == 0
+                     && memcmp(&projectionMatrix, &m_frameProjection, sizeof(projectionMatrix)) == 0;
+    if (!unchanged)
     {
-        throw engine_exception("Couldn't lock constant buffer, result code = ") << result;
+        ID3D11DeviceContext* deviceContext = stateCache->GetDeviceContext();
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        HRESULT result = deviceContext->Map(m_frameBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+        if (FAILED(result))
+        {
+            throw engine_exception("Couldn't lock constant buffer, result code = ") << result;
+        }
+
+        FrameBufferType* dataPtr = (FrameBufferType*)mappedResource.pData;
+        dataPtr->view = XMLoadFloat4x4(&viewMatrix);
+        dataPtr->projection = XMLoadFloat4x4(&projectionMatrix);
+        deviceContext->Unmap(m_frameBuffer.Get(), 0);
+
+        m_frameView = viewMatrix;
+        m_frameProjection = projectionMatrix;
+        m_frameConstantsValid = true;
     }
 
-    // Get a pointer to the data in the constant buffer.
-    MatrixBufferType* dataPtr = (MatrixBufferType*)mappedResource.pData;
-
-    // Copy the matrices into the constant buffer.
-    dataPtr->world = worldMatrix;
-    dataPtr->view = viewMatrix;
-    dataPtr->projection = projectionMatrix;
+    stateCache->VSSetConstantBuffers(0, 1, m_frameBuffer.GetAddressOf());
+}
 
-    // Unlock the constant buffer.
-    deviceContext->Unmap(m_matrixBuffer.Get(), 0);
+void ColorShaderClass::SetFrameConstants(ConstantBufferRingClass* constantRing, const XMMATRIX& view, const XMMATRIX& projection)
+{
+    FrameBufferType frameConstants;
+    frameConstants.view = XMMatrixTranspose(view);
+    frameConstants.projection = XMMatrixTranspose(projection);
+    constantRing->VSSetConstants(0, &frameConstants, sizeof(frameConstants));
+}
 
-    // Finally set the constant buffer as buffer zero in the vertex shader with the updated values.
-    deviceContext->VSSetConstantBuffers(0, 1, m_matrixBuffer.GetAddressOf());
+void ColorShaderClass::Render(StateCacheClass* stateCache, ConstantBufferRingClass* constantRing, const int indexCount,
+                              const VertexFormatClass::Quantization& quantization, const XMMATRIX& world)
+{
+    SetShaderParameters(constantRing, quantization, world);
+    RenderShader(stateCache, quantization.format, indexCount);
 }
 
-void ColorShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, int indexCount)
+void ColorShaderClass::RenderInstanced(StateCacheClass* stateCache, ConstantBufferRingClass* constantRing, const int indexCount,
+                                       const VertexFormatClass::Quantization& quantization, const InstanceType* instances, const unsigned int instanceCount)
 {
-    // Set the vertex input layout.
-    deviceContext->IASetInputLayout(m_layout.Get());
+    PROFILE_FUNCTION();
 
-    // Set the vertex and pixel shaders that will be used to render this triangle.
-    deviceContext->VSSetShader(m_vertexShader.Get(), NULL, 0);
-    deviceContext->PSSetShader(m_pixelShader.Get(), NULL, 0);
+    ID3D11DeviceContext* deviceContext = stateCache->GetDeviceContext();
 
-    // Render the triangle.
-    deviceContext->DrawIndexed(indexCount, 0, 0);
-}
+    // Only the dequantization is per draw, and every chunk shares it.
+    ModelBufferType modelConstants;
+    modelConstants.positionScale = quantization.positionScale;
+    modelConstants.positionBias = quantization.positionBias;
+    constantRing->VSSetConstants(1, &modelConstants, sizeof(modelConstants));
 
-unique_ptr<byte[]> ColorShaderClass::LoadFile(WCHAR* fileName, unsigned int& numBytes)
-{
-    ifstream file;
-    file.open(fileName, ios::binary);
+    stateCache->SetPipelineState(m_instancedPipelines[quantization.format]);
+
+    // The instance buffer stays bound at offset zero; each chunk picks its place in the ring with StartInstanceLocation.
+    unsigned int stride = sizeof(InstanceType);
+    unsigned int offset = 0;
+    stateCache->IASetVertexBuffers(1, 1, m_instanceBuffer.GetAddressOf(), &stride, &offset);
 
-    if (!file.is_open())
+    unsigned int drawn = 0;
+    while (drawn < instanceCount)
     {
-        throw engine_exception("Couldn't open file ") << fileName;
+        unsigned int count = min(instanceCount - drawn, MAX_INSTANCES_PER_DRAW);
+
+        // Append behind the data already in flight and only discard the buffer when the chunk doesn't fit.
+        D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+        if (m_instanceBufferOffset + count > MAX_INSTANCES_PER_DRAW)
+        {
+            mapType = D3D11_MAP_WRITE_DISCARD;
+            m_instanceBufferOffset = 0;
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        HRESULT result = deviceContext->Map(m_instanceBuffer.Get(), 0, mapType, 0, &mappedResource);
+        if (FAILED(result))
+        {
+            throw engine_exception("Couldn't lock instance buffer, result code = ") << result;
+        }
+
+        memcpy((InstanceType*)mappedResource.pData + m_instanceBufferOffset, instances + drawn, count * sizeof(InstanceType));
+        deviceContext->Unmap(m_instanceBuffer.Get(), 0);
+
+        stateCache->DrawIndexedInstanced(indexCount, count, 0, 0, m_instanceBufferOffset);
+
+        m_instanceBufferOffset += count;
+        drawn += count;
     }
+}
 
-    file.seekg(0, ios::end);
-    int size = (int)file.tellg();
-    file.seekg(0, ios::beg);
+void ColorShaderClass::SetShaderParameters(ConstantBufferRingClass* constantRing, const VertexFormatClass::Quantization& quantization, const XMMATRIX& world)
+{
+    PROFILE_FUNCTION();
 
-    unique_ptr<byte[]> bytes = unique_ptr<byte[]>(new byte[size]);
-    
-    file.read(reinterpret_cast<char*>(bytes.get()), size);
+    // View and projection are already in the frame buffer, so a draw only uploads its world matrix and dequantization.
+    ObjectBufferType objectConstants;
+    unsigned int size = WriteObjectConstants(&objectConstants, quantization, world);
+    constantRing->VSSetConstants(1, &objectConstants, size);
+}
 
-    numBytes = size;
-    return bytes;
+unsigned int ColorShaderClass::WriteObjectConstants(void* destination, const VertexFormatClass::Quantization& quantization, const XMMATRIX& world)
+{
+    ObjectBufferType* objectConstants = (ObjectBufferType*)destination;
+    objectConstants->world = XMMatrixTranspose(world);
+    objectConstants->positionScale = quantization.positionScale;
+    objectConstants->positionBias = quantization.positionBias;
+    return sizeof(ObjectBufferType);
+}
+
+void ColorShaderClass::RenderShader(StateCacheClass* stateCache, const VertexFormatClass::Format format, int indexCount)
+{
+    // Set the input layout, shaders and fixed function state that will be used to render this triangle.
+    stateCache->SetPipelineState(m_pipelines[format]);
+
+    // Render the triangle.
+    stateCache->DrawIndexed(indexCount, 0, 0);
 }
@@ -1,7 +1,10 @@
 #pragma once
 #include "engine.h"
-#include "D3DCompiler.h"
-#include <fstream>
+#include "statecacheclass.h"
+#include "constantbufferringclass.h"
+#include "vertexformatclass.h"
+#include "shaderlibraryclass.h"
+#include "pipelinecacheclass.h"
 #include <vector>
 
 using namespace Microsoft::WRL;
@@ -15,29 +18,80 @@ public:
 
     ~ColorShaderClass();
 
-    void Initialize(ID3D11Device* device, HWND hwnd);
+    // Loads the pixel, vertex and instanced vertex shaders from the library one after another, and gets every vertex format
+    // a plain and an instanced pipeline state from the cache, over its default fixed function state. GraphicsClass runs it
+    // on a background thread while the rest of the scene is set up.
+    void Initialize(ID3D11Device* device, PipelineCacheClass* pipelineCache, ShaderLibraryClass* shaderLibrary);
 
-    void Render(ID3D11DeviceContext* deviceContext, const int indexCount, const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection);
+    // Uploads view and projection, which both shaders share, and binds them to slot 0. Call it before drawing; repeated
+    // calls with the same matrices skip the upload.
+    void SetFrameConstants(StateCacheClass* stateCache, const XMMATRIX& view, const XMMATRIX& projection);
+
+    // Uploads view and projection through the ring to slot 0 instead. Deferred contexts use this, as the shared frame
+    // buffer can only be mapped from one thread.
+    void SetFrameConstants(ConstantBufferRingClass* constantRing, const XMMATRIX& view, const XMMATRIX& projection);
+
+    // The quantization selects the input layout for the bound vertex buffer and supplies its dequantization constants.
+    // The per object constants go through the ring to slot 1.
+    void Render(StateCacheClass* stateCache, ConstantBufferRingClass* constantRing, const int indexCount,
+                const VertexFormatClass::Quantization& quantization, const XMMATRIX& world);
+
+    // Writes the per object constants for slot 1 to destination as the vertex shader reads them (transposed world
+    // matrix, then dequantization) and returns their size in bytes. destination must be 16 byte aligned.
+    static unsigned int WriteObjectConstants(void* destination, const VertexFormatClass::Quantization& quantization, const XMMATRIX& world);
+
+    // Per instance vertex data for input slot 1. The world matrix isn't transposed; the shader rebuilds it from rows.
+    struct InstanceType
+    {
+        XMFLOAT4X4 world;
+        XMFLOAT4 color;
+    };
+
+    // Draws instanceCount copies of the bound mesh with DrawIndexedInstanced, split into chunks that fit the instance buffer.
+    void RenderInstanced(StateCacheClass* stateCache, ConstantBufferRingClass* constantRing, const int indexCount,
+                         const VertexFormatClass::Quantization& quantization, const InstanceType* instances, const unsigned int instanceCount);
 
 private:
-    struct MatrixBufferType
+    static const unsigned int MAX_INSTANCES_PER_DRAW = 8192;
+
+    struct FrameBufferType
     {
-        XMMATRIX world;
         XMMATRIX view;
         XMMATRIX projection;
     };
 
-    ComPtr<ID3D11VertexShader> m_vertexShader;
-    ComPtr<ID3D11PixelShader> m_pixelShader;
-    ComPtr<ID3D11InputLayout> m_layout;
-    ComPtr<ID3D11Buffer> m_matrixBuffer;
+    struct ObjectBufferType
+    {
+        XMMATRIX world;
+        XMFLOAT4 positionScale;
+        XMFLOAT4 positionBias;
+    };
+
+    struct ModelBufferType
+    {
+        XMFLOAT4 positionScale;
+        XMFLOAT4 positionBias;
+    };
+
+    const PipelineCacheClass::PipelineState* m_pipelines[VertexFormatClass::FORMAT_COUNT];
+
+    // The transposed matrices last uploaded to the frame buffer.
+    ComPtr<ID3D11Buffer> m_frameBuffer;
+    XMFLOAT4X4 m_frameView, m_frameProjection;
+    bool m_frameConstantsValid;
+
+    const PipelineCacheClass::PipelineState* m_instancedPipelines[VertexFormatClass::FORMAT_COUNT];
+    ComPtr<ID3D11Buffer> m_instanceBuffer;
+    unsigned int m_instanceBufferOffset;
 
-    void InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* vertexShaderFileName, WCHAR* pixelShaderFileName);
+    void InitializeShader(ID3D11Device* device, PipelineCacheClass* pipelineCache, const ShaderLibraryClass::Bytecode& vertexShaderBytes,
+                          const ShaderLibraryClass::Bytecode& pixelShaderBytes);
 
-    void SetShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection);
+    void InitializeInstancedShader(ID3D11Device* device, PipelineCacheClass* pipelineCache, const ShaderLibraryClass::Bytecode& vertexShaderBytes,
+                                   const ShaderLibraryClass::Bytecode& pixelShaderBytes);
 
-    void RenderShader(ID3D11DeviceContext* deviceContext, int indexCount);
+    void SetShaderParameters(ConstantBufferRingClass* constantRing, const VertexFormatClass::Quantization& quantization, const XMMATRIX& world);
 
-    unique_ptr<byte[]> LoadFile(WCHAR* fileName, unsigned int& numBytes);
+    void RenderShader(StateCacheClass* stateCache, const VertexFormatClass::Format format, int indexCount);
 };
 
@@ -0,0 +1,170 @@
+#include "commandlistclass.h"
+
+DEFINE_POOL_ALLOCATION(CommandListClass, CommandListClass::MAX_LISTS_PER_FRAME)
+
+CommandListClass::CommandListClass()
+{
+    m_currentShader = nullptr;
+    m_drawCount = 0;
+    m_recording = false;
+    XMStoreFloat4x4(&m_view, XMMatrixIdentity());
+    XMStoreFloat4x4(&m_projection, XMMatrixIdentity());
+}
+
+CommandListClass::~CommandListClass()
+{
+}
+
+void CommandListClass::Initialize(ID3D11Device* device)
+{
+    if (device == nullptr)
+    {
+        return;
+    }
+
+    HRESULT result = device->CreateDeferredContext(0, m_deferredContext.ReleaseAndGetAddressOf());
+    if (FAILED(result))
+    {
+        throw engine_exception("Couldn't create deferred context, result code = ") << result;
+    }
+
+    m_stateCache = unique_ptr<StateCacheClass>(new StateCacheClass());
+    m_stateCache->Initialize(m_deferredContext.Get());
+    m_constantRing = unique_ptr<ConstantBufferRingClass>(new ConstantBufferRingClass());
+    m_constantRing->Initialize(device, m_stateCache.get(), CONSTANT_RING_SIZE);
+}
+
+void CommandListClass::Begin(D3DClass* d3d)
+{
+    if (m_recording)
+    {
+        throw engine_exception("Command list is already recording");
+    }
+
+    m_commands.Clear();
+    m_commandList.Reset();
+    m_currentShader = nullptr;
+    m_drawCount = 0;
+    m_recording = true;
+
+    if (m_deferredContext)
+    {
+        // The first map of a dynamic buffer in a deferred context has to discard, which the ring does after BeginFrame.
+        m_stateCache->Invalidate();
+        m_constantRing->BeginFrame();
+        d3d->BindOutputState(m_stateCache.get());
+    }
+}
+
+void CommandListClass::SetFrameConstants(const XMMATRIX& view, const XMMATRIX& projection)
+{
+    XMStoreFloat4x4(&m_view, view);
+    XMStoreFloat4x4(&m_projection, projection);
+
+    if (m_deferredContext)
+    {
+        // Uploaded again by the next draw, whatever its shader.
+        m_currentShader = nullptr;
+        return;
+    }
+
+    m_commands.SetFrameConstants(m_view, m_projection);
+}
+
+void CommandListClass::Draw(ModelClass* model, ColorShaderClass* shader, const XMMATRIX& world, const unsigned int lod)
+{
+    m_drawCount++;
+
+    if (m_deferredContext)
+    {
+        // The shader's own frame buffer is shared by every thread, so each list uploads view and projection through its ring.
+        if (shader != m_currentShader)
+        {
+            shader->SetFrameConstants(m_constantRing.get(), XMLoadFloat4x4(&m_view), XMLoadFloat4x4(&m_projection));
+            m_currentShader = shader;
+        }
+
+        model->Render(m_stateCache.get(), lod);
+        shader->Render(m_stateCache.get(), m_constantRing.get(), model->GetIndexCount(lod), model->GetQuantization(), world);
+        return;
+    }
+
+    m_commands.Draw(model, shader, world, lod);
+}
+
+void CommandListClass::End()
+{
+    PROFILE_FUNCTION();
+
+    if (!m_recording)
+    {
+        throw engine_exception("Command list isn't recording");
+    }
+    m_recording = false;
+
+    if (m_deferredContext)
+    {
+        // The context is reset to default state, so nothing leaks from one recording into the next.
+        HRESULT result = m_deferredContext->FinishCommandList(FALSE, m_commandList.ReleaseAndGetAddressOf());
+        if (FAILED(result))
+        {
+            throw engine_exception("Couldn't finish command list, result code = ") << result;
+        }
+    }
+}
+
+void CommandListClass::Execute(D3DClass* d3d)
+{
+    PROFILE_FUNCTION();
+
+    if (m_recording)
+    {
+        throw engine_exception("Command list is still recording");
+    }
+
+    if (m_deferredContext)
+    {
+        if (m_commandList)
+        {
+            d3d->ExecuteCommandList(m_commandList.Get());
+            m_commandList.Reset();
+        }
+        return;
+    }
+
+    SoftwareRasterizerClass* rasterizer = d3d->GetSoftwareRasterizer();
+    if (rasterizer == nullptr)
+    {
+        throw engine_exception("A CPU command list needs the software renderer to execute on");
+    }
+
+    XMFLOAT4X4 view = m_view, projection = m_projection;
+    Replay([rasterizer, &view, &projection](const Command& command)
+    {
+        if (command.type == CommandStreamClass::COMMAND_SET_FRAME_CONSTANTS)
+        {
+            view = command.matrices[0];
+            projection = command.matrices[1];
+        }
+        else
+        {
+            command.model->Render(rasterizer, XMLoadFloat4x4(&command.matrices[0]), XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection),
+                                  command.lod);
+        }
+    });
+}
+
+void CommandListClass::Replay(const function<void(const Command&)>& consumer)
+{
+    m_commands.Replay(consumer);
+}
+
+bool CommandListClass::IsDeferred()
+{
+    return m_deferredContext.Get() != nullptr;
+}
+
+unsigned int CommandListClass::GetDrawCount()
+{
+    return m_drawCount;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "engine.h"
+#include "d3dclass.h"
+#include "modelclass.h"
+#include "colorshaderclass.h"
+#include "commandstreamclass.h"
+#include <vector>
+#include <functional>
+
+using namespace std;
+using namespace DirectX;
+using namespace Microsoft::WRL;
+
+// Draws recorded on one thread for execution on the immediate context later, in whatever order the caller picks. With a
+// D3D11 device the draws go straight into a deferred context with its own state cache and constant ring, and End bakes
+// them into an ID3D11CommandList. Without one (the software renderer) they are kept as a CommandStreamClass, which Execute
+// replays on the rasterizer and Replay hands to any other consumer. One thread records a list at a time; different lists
+// can be recorded at the same time.
+class CommandListClass
+{
+public:
+    // Most lists a frame records; frames split their draws over at most this many, however many threads there are.
+    static const unsigned int MAX_LISTS_PER_FRAME = 64;
+
+    typedef CommandStreamClass::Command Command;
+
+    CommandListClass();
+
+    ~CommandListClass();
+
+    DECLARE_POOL_ALLOCATION();
+
+    // A null device records a CPU command stream.
+    void Initialize(ID3D11Device* device);
+
+    // Drops the previous recording and starts a new one. Deferred contexts start out with default state, so the output
+    // state is bound from the D3D class; it may be null for a CPU stream.
+    void Begin(D3DClass* d3d);
+
+    // Sets view and projection for the draws that follow.
+    void SetFrameConstants(const XMMATRIX& view, const XMMATRIX& projection);
+
+    void Draw(ModelClass* model, ColorShaderClass* shader, const XMMATRIX& world, const unsigned int lod = 0);
+
+    void End();
+
+    // Runs the recording on the immediate context, or on the software rasterizer for a CPU stream. Call it on the render
+    // thread after End.
+    void Execute(D3DClass* d3d);
+
+    // Calls consumer for every command of a CPU stream in recording order.
+    void Replay(const function<void(const Command&)>& consumer);
+
+    bool IsDeferred();
+
+    unsigned int GetDrawCount();
+
+private:
+    // Each deferred context uploads its own per draw constants, so they don't contend for the immediate context's ring.
+    static const unsigned int CONSTANT_RING_SIZE = 1024 * 1024;
+
+    ComPtr<ID3D11DeviceContext> m_deferredContext;
+    ComPtr<ID3D11CommandList> m_commandList;
+    unique_ptr<StateCacheClass> m_stateCache;
+    unique_ptr<ConstantBufferRingClass> m_constantRing;
+
+    CommandStreamClass m_commands;
+
+    XMFLOAT4X4 m_view, m_projection;
+    ColorShaderClass* m_currentShader;
+    unsigned int m_drawCount;
+    bool m_recording;
+};
@@ -0,0 +1,101 @@
+#include "commandstreamclass.h"
+
+void CommandStreamClass::Clear()
+{
+    m_commands.clear();
+}
+
+void CommandStreamClass::SetFrameConstants(const XMFLOAT4X4& view, const XMFLOAT4X4& projection)
+{
+    Command command;
+    command.type = COMMAND_SET_FRAME_CONSTANTS;
+    command.model = nullptr;
+    command.shader = nullptr;
+    command.lod = 0;
+    command.matrices[0] = view;
+    command.matrices[1] = projection;
+    m_commands.push_back(command);
+}
+
+void CommandStreamClass::Draw(ModelClass* model, ColorShaderClass* shader, const XMMATRIX& world, const unsigned int lod)
+{
+    Command command;
+    command.type = COMMAND_DRAW;
+    command.model = model;
+    command.shader = shader;
+    command.lod = lod;
+    XMStoreFloat4x4(&command.matrices[0], world);
+    m_commands.push_back(command);
+}
+
+void CommandStreamClass::Replay(const function<void(const Command&)>& consumer) const
+{
+    for (const Command& command : m_commands)
+    {
+        consumer(command);
+    }
+}
+
+void CommandStreamClass::Validate(JobSystemClass* jobSystem)
+{
+    // Every draw gets a unique number, stored in the world matrix's translation; the models are never dereferenced, so
+    // any pointer will do to tell the streams' draws apart.
+    const unsigned int streamCount = 37;
+    const unsigned int drawsPerStream = 500;
+    vector<CommandStreamClass> streams(streamCount);
+    vector<unsigned int> drawCounts(streamCount);
+
+    // Uneven stream sizes make the jobs finish out of order.
+    jobSystem->ParallelFor(streamCount, 1, [&streams, &drawCounts](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            CommandStreamClass& stream = streams[i];
+            XMFLOAT4X4 view, projection;
+            XMStoreFloat4x4(&view, XMMatrixTranslation((float)i, 0.0f, 0.0f));
+            XMStoreFloat4x4(&projection, XMMatrixIdentity());
+            stream.Clear();
+            stream.SetFrameConstants(view, projection);
+            drawCounts[i] = drawsPerStream * ((i * 7) % 5 + 1) / 5;
+            for (unsigned int draw = 0; draw < drawCounts[i]; draw++)
+            {
+                stream.Draw((ModelClass*)(size_t)(i + 1), nullptr, XMMatrixTranslation((float)draw, (float)i, 0.0f), draw % 3);
+            }
+        }
+    });
+
+    // Check every command against what stream i recorded, in stream order.
+    unsigned int expectedDraw = 0, totalDraws = 0;
+    for (unsigned int i = 0; i < streamCount; i++)
+    {
+        expectedDraw = 0;
+        bool frameSet = false;
+        streams[i].Replay([i, &expectedDraw, &frameSet, &totalDraws](const Command& command)
+        {
+            if (command.type == COMMAND_SET_FRAME_CONSTANTS)
+            {
+                if (frameSet || expectedDraw != 0 || command.matrices[0].m[3][0] != (float)i)
+                {
+                    throw engine_exception("Command stream validation: unexpected frame constants in stream ") << i;
+                }
+                frameSet = true;
+                return;
+            }
+
+            if (!frameSet || command.model != (ModelClass*)(size_t)(i + 1) || command.matrices[0].m[3][0] != (float)expectedDraw
+                || command.matrices[0].m[3][1] != (float)i || command.lod != expectedDraw % 3)
+            {
+                throw engine_exception("Command stream validation: draw ") << expectedDraw << " of stream " << i << " is out of order";
+            }
+            expectedDraw++;
+            totalDraws++;
+        });
+
+        if (expectedDraw != drawCounts[i])
+        {
+            throw engine_exception("Command stream validation: stream ") << i << " replayed " << expectedDraw << " of " << drawCounts[i] << " draws";
+        }
+    }
+
+    LOG_INFO("Command stream validation passed: {} streams, {} draws replayed in order", streamCount, totalDraws);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "engine_core.h"
+#include "jobsystemclass.h"
+#include <vector>
+#include <functional>
+
+using namespace std;
+using namespace DirectX;
+
+class ModelClass;
+class ColorShaderClass;
+
+// The draws of a CPU command list, kept in recording order for whoever replays them. Models and shaders are only carried
+// through, never dereferenced, so the stream builds and is tested without D3D.
+class CommandStreamClass
+{
+public:
+    enum CommandType
+    {
+        COMMAND_SET_FRAME_CONSTANTS,
+        COMMAND_DRAW
+    };
+
+    // One entry of the stream. Frame constants carry view and projection, draws carry the world matrix in matrices[0]
+    // and the model's level of detail in lod.
+    struct Command
+    {
+        CommandType type;
+        ModelClass* model;
+        ColorShaderClass* shader;
+        XMFLOAT4X4 matrices[2];
+        unsigned int lod;
+    };
+
+    void Clear();
+
+    void SetFrameConstants(const XMFLOAT4X4& view, const XMFLOAT4X4& projection);
+
+    void Draw(ModelClass* model, ColorShaderClass* shader, const XMMATRIX& world, const unsigned int lod);
+
+    // Calls consumer for every command in recording order.
+    void Replay(const function<void(const Command&)>& consumer) const;
+
+    // Records streams of uneven length on the job system in parallel, replays them and checks they come out in stream
+    // order with nothing lost or reordered. Throws on a mismatch.
+    static void Validate(JobSystemClass* jobSystem);
+
+private:
+    vector<Command> m_commands;
+};
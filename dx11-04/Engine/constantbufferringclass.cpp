@@ -0,0 +1,130 @@
+#include "constantbufferringclass.h"
+
+ConstantBufferRingClass::ConstantBufferRingClass()
+{
+    m_stateCache = nullptr;
+    m_size = m_offset = 0;
+    m_useOffsets = false;
+    m_discardPending = true;
+    m_mapCalls = m_discards = m_uploadedBytes = 0;
+    m_totalMapCalls = m_totalDiscards = m_totalUploadedBytes = 0;
+    m_frames = 0;
+}
+
+ConstantBufferRingClass::~ConstantBufferRingClass()
+{
+}
+
+void ConstantBufferRingClass::Initialize(ID3D11Device* device, StateCacheClass* stateCache, const unsigned int size)
+{
+    m_stateCache = stateCache;
+
+    // Both the offset binding and NO_OVERWRITE on a constant buffer are D3D11.1 options the driver has to report.
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+    ZeroMemory(&options, sizeof(options));
+    HRESULT result = device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+    m_useOffsets = SUCCEEDED(result) && options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer
+                   && stateCache->SupportsConstantBufferOffsets();
+
+    m_size = m_useOffsets ? max(size, MAX_ALLOCATION_SIZE) / ALLOCATION_ALIGNMENT * ALLOCATION_ALIGNMENT : MAX_ALLOCATION_SIZE;
+    m_offset = 0;
+    m_discardPending = true;
+
+    D3D11_BUFFER_DESC bufferDesc;
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = m_size;
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    bufferDesc.MiscFlags = 0;
+    bufferDesc.StructureByteStride = 0;
+
+    result = device->CreateBuffer(&bufferDesc, NULL, m_buffer.ReleaseAndGetAddressOf());
+    if (FAILED(result))
+    {
+        throw engine_exception("Couldn't create constant ring buffer, result code = ") << result;
+    }
+
+    LOG_INFO("Constant ring: {}, {} bytes", m_useOffsets ? "offset binding" : "discard per draw fallback", m_size);
+}
+
+void ConstantBufferRingClass::BeginFrame()
+{
+    m_discardPending = true;
+}
+
+void ConstantBufferRingClass::VSSetConstants(const unsigned int slot, const void* data, const unsigned int size)
+{
+    if (size > MAX_ALLOCATION_SIZE)
+    {
+        throw engine_exception("Constant allocation is too large: ") << size;
+    }
+
+    unsigned int alignedSize = (size + ALLOCATION_ALIGNMENT - 1) / ALLOCATION_ALIGNMENT * ALLOCATION_ALIGNMENT;
+
+    // Append behind the data already in flight; discard on the frame's first allocation or when the ring is full.
+    D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+    if (!m_useOffsets || m_discardPending || m_offset + alignedSize > m_size)
+    {
+        mapType = D3D11_MAP_WRITE_DISCARD;
+        m_offset = 0;
+        m_discardPending = false;
+        m_discards++;
+    }
+
+    ID3D11DeviceContext* deviceContext = m_stateCache->GetDeviceContext();
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    HRESULT result = deviceContext->Map(m_buffer.Get(), 0, mapType, 0, &mappedResource);
+    if (FAILED(result))
+    {
+        throw engine_exception("Couldn't lock constant ring buffer, result code = ") << result;
+    }
+
+    memcpy((unsigned char*)mappedResource.pData + m_offset, data, size);
+    deviceContext->Unmap(m_buffer.Get(), 0);
+    m_mapCalls++;
+    m_uploadedBytes += size;
+
+    if (m_useOffsets)
+    {
+        unsigned int firstConstant = m_offset / 16;
+        unsigned int numConstants = alignedSize / 16;
+        m_stateCache->VSSetConstantBuffers1(slot, 1, m_buffer.GetAddressOf(), &firstConstant, &numConstants);
+        m_offset += alignedSize;
+    }
+    else
+    {
+        m_stateCache->VSSetConstantBuffers(slot, 1, m_buffer.GetAddressOf());
+    }
+}
+
+void ConstantBufferRingClass::EndFrame()
+{
+    m_totalMapCalls += m_mapCalls;
+    m_totalDiscards += m_discards;
+    m_totalUploadedBytes += m_uploadedBytes;
+    m_mapCalls = m_discards = m_uploadedBytes = 0;
+
+    if (++m_frames == STATISTICS_FRAMES)
+    {
+        LOG_INFO("Constant ring: {} maps, {} discards, {} bytes per frame", (double)m_totalMapCalls / m_frames, (double)m_totalDiscards / m_frames,
+                 (double)m_totalUploadedBytes / m_frames);
+
+        m_totalMapCalls = m_totalDiscards = m_totalUploadedBytes = 0;
+        m_frames = 0;
+    }
+}
+
+bool ConstantBufferRingClass::UsesOffsets()
+{
+    return m_useOffsets;
+}
+
+unsigned int ConstantBufferRingClass::GetMapCalls()
+{
+    return m_mapCalls;
+}
+
+unsigned int ConstantBufferRingClass::GetUploadedBytes()
+{
+    return m_uploadedBytes;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "engine.h"
+#include "statecacheclass.h"
+
+using namespace std;
+using namespace Microsoft::WRL;
+
+// Per draw shader constants sub-allocated from one large dynamic constant buffer. Every allocation is appended behind
+// the previous one with MAP_WRITE_NO_OVERWRITE and bound at its offset with VSSetConstantBuffers1, so the driver doesn't
+// have to rename a buffer for every draw; the ring is discarded once per frame, on the first allocation after BeginFrame,
+// and again only if a frame fills it. Devices that can't offset constant buffers or map them NO_OVERWRITE fall back to
+// one small buffer that is discarded for every allocation.
+class ConstantBufferRingClass
+{
+public:
+    // VSSetConstantBuffers1 offsets and sizes are multiples of 16 constants of 16 bytes.
+    static const unsigned int ALLOCATION_ALIGNMENT = 256;
+    static const unsigned int MAX_ALLOCATION_SIZE = 4096;
+
+    ConstantBufferRingClass();
+
+    ~ConstantBufferRingClass();
+
+    void Initialize(ID3D11Device* device, StateCacheClass* stateCache, const unsigned int size);
+
+    void BeginFrame();
+
+    // Copies size bytes of constants into the ring and binds them to a vertex shader slot.
+    void VSSetConstants(const unsigned int slot, const void* data, const unsigned int size);
+
+    // Adds this frame's counters to the running totals and periodically writes the per frame averages to the log.
+    void EndFrame();
+
+    // False when the device forced the discard per allocation fallback.
+    bool UsesOffsets();
+
+    // Map calls and bytes of constants written so far this frame.
+    unsigned int GetMapCalls();
+
+    unsigned int GetUploadedBytes();
+
+private:
+    static const int STATISTICS_FRAMES = 120;
+
+    StateCacheClass* m_stateCache;
+    ComPtr<ID3D11Buffer> m_buffer;
+    unsigned int m_size;
+    unsigned int m_offset;
+    bool m_useOffsets;
+    bool m_discardPending;
+
+    unsigned int m_mapCalls, m_discards, m_uploadedBytes;
+    unsigned long long m_totalMapCalls, m_totalDiscards, m_totalUploadedBytes;
+    int m_frames;
+};
@@ -1,77 +1,103 @@
 #include "d3dclass.h"
 
-void* D3DClass::operator new (size_t size)
+namespace
 {
-    void* p = _aligned_malloc(size, 16);
-    if (p == 0)
-    {
-        throw std::bad_alloc();
-    }
-
-    return p;
+    // Room for 8192 draws of up to 256 bytes of constants before a frame has to discard the ring again.
+    const unsigned int CONSTANT_RING_SIZE = 2 * 1024 * 1024;
+
+    // A frame can stream up to half of each ring without waiting for the GPU on the next one.
+    const unsigned int STREAMING_VERTEX_BYTES = 16 * 1024 * 1024;
+    const unsigned int STREAMING_INDEX_BYTES = 4 * 1024 * 1024;
+
+#ifdef _WIN32
+    // Saved adapter, card and refresh rate, relative to the working directory like the shader cache.
+    const char* const DISPLAY_PROFILE_FILE = "display.profile";
+    // Most monitors have fewer modes than this, so one call to GetDisplayModeList usually lists them all.
+    const unsigned int MODE_LIST_GUESS = 256;
+#endif
+
+    // Refresh rate of the display the null device presents to.
+    const double SIMULATED_REFRESH_RATE = 60.0;
+
+    // Culling results and other per frame arrays for scenes of tens of thousands of objects.
+    const unsigned int FRAME_ALLOCATOR_SIZE = 4 * 1024 * 1024;
+    // Frames between two logs of the frame allocator's statistics.
+    const unsigned long long FRAME_ALLOCATOR_LOG_INTERVAL = 120;
 }
 
-void D3DClass::operator delete(void* p)
-{
-    D3DClass* d = static_cast<D3DClass*>(p);
-    _aligned_free(d);
-}
+DEFINE_POOL_ALLOCATION(D3DClass, 1)
 
 D3DClass::D3DClass()
 {
+    m_nullDevice = nullptr;
+    m_presentCounter = 0;
+    m_screenWidth = m_screenHeight = 0;
+    m_sceneCounter = 0;
+    m_sceneSeconds = 0.0;
 }
 
 D3DClass::~D3DClass()
 {
 }
 
-void D3DClass::Initialize(const int screenWidth, const int screenHeight, const bool vsync, const HWND hwnd,
-                          const bool fullscreen, const float screenDepth, const float screenNear)
+void D3DClass::Initialize(const int screenWidth, const int screenHeight, const SwapChainClass::Settings& presentSettings, const HWND hwnd,
+                          const bool fullscreen, const float screenDepth, const float screenNear, const Renderer renderer)
 {    
-    // Store the vsync setting.
-    m_vsync_enabled = vsync;
-
-    // Get DirectX graphics interface factory.
-    auto factory = GetIDXGIFactory();
-
-    // Use the factory to create an adapter for the primary graphics interface (video card).
-    auto adapter = GetPrimaryDisplayAdapter(factory);
-
-    // Obtain the primary adapter output, i.e. the main monitor.
-    auto monitor = GetMonitorForAdapter(0, adapter);
-
-    // Get the number of modes that fit the DXGI_FORMAT_R8G8B8A8_UNORM display format for the monitor.
-    unsigned int numModes;
-    auto displayModeList = GetDisplayModesForMonitor(monitor, numModes);
-    
-    // Now go through all the display modes and find the one that matches the screen width and height.
-    // When a match is found store the numerator and denominator of the refresh rate for that monitor.
-    unsigned int numerator, denominator;
-    GetRefreshRateForWindowSize(numModes, displayModeList, screenWidth, screenHeight, numerator, denominator);
+    PROFILE_FUNCTION();
 
-    GetVideoCardInformation(adapter);
+    m_frameAllocator = unique_ptr<LinearAllocatorClass>(new LinearAllocatorClass());
+    m_frameAllocator->Initialize("Frame allocator", FRAME_ALLOCATOR_SIZE, false);
+    m_screenWidth = screenWidth;
+    m_screenHeight = screenHeight;
 
-    std::stringstream oss;
-    oss << "Display Adapter = " << m_videoCardDescription << "\n";
-    oss << "Memory = " << m_videoCardMemory << "MB" << "\n";
-    oss << "Refresh Rate = " << numerator << " / " << denominator << "\n";
-    OutputDebugStringA(oss.str().c_str());
+    // The software renderer needs neither a DXGI adapter nor a D3D11 device, so it works on machines without a GPU.
+    if (renderer == RENDERER_SOFTWARE)
+    {
+        m_softwareRasterizer = unique_ptr<SoftwareRasterizerClass>(new SoftwareRasterizerClass());
+        m_softwareRasterizer->Initialize(screenWidth, screenHeight, hwnd);
+        CreateMatrices(screenWidth, screenHeight, screenDepth, screenNear);
+        return;
+    }
 
-    DXGI_SWAP_CHAIN_DESC swapChainDesc = SetSwapChainDescription(screenWidth, screenHeight, numerator, denominator, hwnd, fullscreen);
+    if (renderer == RENDERER_NULL)
+    {
+        NullDeviceClass::CreateDevice(m_device.ReleaseAndGetAddressOf(), m_deviceContext.ReleaseAndGetAddressOf());
+        m_nullDevice = static_cast<NullDeviceClass*>(m_device.Get());
+        strcpy_s(m_videoCardDescription, 128, "Null device");
+        m_videoCardMemory = 0;
+
+        // Frames are paced against a simulated display, which the CPU time of each frame is passed on to.
+        m_simulatedDisplay = unique_ptr<SwapChainClass::SimulatedDisplay>(new SwapChainClass::SimulatedDisplay());
+        m_simulatedDisplay->Initialize(SIMULATED_REFRESH_RATE, presentSettings.bufferCount);
+        m_swapChain = unique_ptr<SwapChainClass>(new SwapChainClass());
+        m_swapChain->Initialize(m_simulatedDisplay->GetTarget(), m_simulatedDisplay->GetClock(), presentSettings);
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        m_presentCounter = counter.QuadPart;
+    }
+    else
+    {
+#ifdef _WIN32
+        CreateHardwareDevice(screenWidth, screenHeight, hwnd, fullscreen, presentSettings);
+#else
+        throw engine_exception("There is no hardware renderer off Windows; use the null or software renderer");
+#endif
+    }
 
-    // Create the swap chain, device and device context member variables.
-    CreateSwapChainDeviceAndContext(swapChainDesc);
+    // All state from here on is bound through the cache so its shadow copy matches the context.
+    m_stateCache = unique_ptr<StateCacheClass>(new StateCacheClass());
+    m_stateCache->Initialize(m_deviceContext.Get());
+    m_constantRing = unique_ptr<ConstantBufferRingClass>(new ConstantBufferRingClass());
+    m_constantRing->Initialize(m_device.Get(), m_stateCache.get(), CONSTANT_RING_SIZE);
+    m_streamingGeometry = unique_ptr<StreamingGeometryClass>(new StreamingGeometryClass());
+    m_streamingGeometry->Initialize(m_device.Get(), m_stateCache.get(), STREAMING_VERTEX_BYTES, STREAMING_INDEX_BYTES, DXGI_FORMAT_R16_UINT);
+    m_pipelineCache = unique_ptr<PipelineCacheClass>(new PipelineCacheClass());
+    m_pipelineCache->Initialize(m_device.Get());
 
-    CreateRenderTargetView();
+    CreateRenderTargetView(screenWidth, screenHeight);
 
     CreateDepthBuffer(screenWidth, screenHeight);
 
-    // Initialize the description of the stencil state.
-    D3D11_DEPTH_STENCIL_DESC depthStencilDesc = SetDepthStencilDescription();
-
-    // Create the depth stencil state.
-    CreateDepthStencilState(depthStencilDesc);
-
     // Initialize the depth stencil view.
     D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc = CreateDepthStencilViewDescription();
 
@@ -80,26 +106,24 @@ void D3DClass::Initialize(const int screenWidth, const int screenHeight, const b
 
     // Bind the render target view and depth stencil buffer to the output render pipeline.
     //ID3D11RenderTargetView* renderTargetView_unsafe = m_renderTargetView.get();
-    m_deviceContext->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
-
-    // Setup the raster description which will determine how and what polygons will be drawn.
-    D3D11_RASTERIZER_DESC rasterDesc = SetRasterizerDescription();
-
-    // Create the rasterizer state based on description.
-    SetRasterizerState(rasterDesc);
+    m_stateCache->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
 
     // Setup the viewport for rendering.
-    D3D11_VIEWPORT viewport;
-    viewport.Width = (float)screenWidth;
-    viewport.Height = (float)screenHeight;
-    viewport.MinDepth = 0.0f;
-    viewport.MaxDepth = 1.0f;
-    viewport.TopLeftX = 0.0f;
-    viewport.TopLeftY = 0.0f;
+    m_viewport.Width = (float)screenWidth;
+    m_viewport.Height = (float)screenHeight;
+    m_viewport.MinDepth = 0.0f;
+    m_viewport.MaxDepth = 1.0f;
+    m_viewport.TopLeftX = 0.0f;
+    m_viewport.TopLeftY = 0.0f;
 
     // Create the viewport.
-    m_deviceContext->RSSetViewports(1, &viewport);
+    m_stateCache->RSSetViewports(1, &m_viewport);
 
+    CreateMatrices(screenWidth, screenHeight, screenDepth, screenNear);
+}
+
+void D3DClass::CreateMatrices(const int screenWidth, const int screenHeight, const float screenDepth, const float screenNear)
+{
     // Setup the projection matrix.
     float fieldOfView = (float)XM_PI / 4.0f;
     float screenAspect = (float)screenWidth / (float)screenHeight;
@@ -117,10 +141,14 @@ void D3DClass::Initialize(const int screenWidth, const int screenHeight, const b
 
 void D3DClass::Shutdown()
 {
-    // Before shutting down set to windowed mode or when you release the swap chain it will throw an exception.
+    if (m_softwareRasterizer)
+    {
+        m_softwareRasterizer->Shutdown();
+    }
+
     if (m_swapChain)
     {
-        m_swapChain->SetFullscreenState(false, NULL);
+        m_swapChain->Shutdown();
     }
 }
 
@@ -129,6 +157,26 @@ void D3DClass::BeginScene(float red, float green, float blue, float alpha)
 {
     float color[4];
 
+    if (m_softwareRasterizer)
+    {
+        m_softwareRasterizer->BeginScene(red, green, blue, alpha);
+        return;
+    }
+
+    m_constantRing->BeginFrame();
+
+    if (m_dynamicResolution)
+    {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        m_sceneCounter = counter.QuadPart;
+        if (m_gpuTimer)
+        {
+            unsigned long long frameNumber = m_gpuTimer->BeginFrame(m_deviceContext.Get());
+            m_frameScales[frameNumber % GpuTimerClass::FRAMES_IN_FLIGHT] = m_dynamicResolution->GetScale();
+        }
+    }
+
     // Setup the color to clear the buffer to.
     color[0] = red;
     color[1] = green;
@@ -144,16 +192,145 @@ void D3DClass::BeginScene(float red, float green, float blue, float alpha)
 
 void D3DClass::EndScene()
 {
-    // Present the back buffer to the screen since rendering is complete.
-    if (m_vsync_enabled)
+    // Nothing allocated during the frame is used after it, whichever renderer drew it.
+    m_frameAllocator->Reset();
+    if (m_frameAllocator->GetStatistics().resets % FRAME_ALLOCATOR_LOG_INTERVAL == 0)
+    {
+        m_frameAllocator->LogStatistics();
+    }
+
+    if (m_softwareRasterizer)
+    {
+        m_softwareRasterizer->EndScene();
+        return;
+    }
+
+    m_stateCache->EndFrame();
+    m_constantRing->EndFrame();
+
+    // The frame is timed up to Present, which may block on the display; its new scale goes with the next Present.
+    if (m_dynamicResolution)
     {
-        // Lock to screen refresh rate.
-        m_swapChain->Present(1, 0);
+        if (m_gpuTimer)
+        {
+            m_gpuTimer->EndFrame(m_deviceContext.Get());
+        }
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&counter);
+        m_sceneSeconds = (double)(counter.QuadPart - m_sceneCounter) / frequency.QuadPart;
+    }
+
+    // The null device's frame goes to the simulated display after the time it took, in its microseconds.
+    if (m_nullDevice)
+    {
+        m_nullDevice->EndFrame();
+
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&counter);
+        m_simulatedDisplay->Advance((counter.QuadPart - m_presentCounter) * 1000000 / frequency.QuadPart);
+        m_swapChain->Present();
+        QueryPerformanceCounter(&counter);
+        m_presentCounter = counter.QuadPart;
+    }
+    else
+    {
+        // Present the back buffer to the screen since rendering is complete.
+        m_swapChain->Present();
+    }
+
+    if (m_dynamicResolution)
+    {
+        UpdateResolutionScale();
+    }
+}
+
+bool D3DClass::EnableDynamicResolution(const DynamicResolutionClass::Settings& settings)
+{
+    if (!m_swapChain || !m_swapChain->SetSourceSize(m_screenWidth, m_screenHeight))
+    {
+        LOG_WARNING("Dynamic resolution: the swap chain can't stretch a smaller source, rendering at full resolution");
+        return false;
+    }
+
+    m_dynamicResolution = unique_ptr<DynamicResolutionClass>(new DynamicResolutionClass());
+    m_dynamicResolution->Initialize(settings);
+    m_gpuTimer = unique_ptr<GpuTimerClass>(new GpuTimerClass());
+    if (!m_gpuTimer->Initialize(m_device.Get()))
+    {
+        m_gpuTimer.reset();
+    }
+    SetResolutionScale(m_dynamicResolution->GetScale());
+
+    LOG_INFO("Dynamic resolution: {} ms budget, scale {} to {}, timed on the {}", settings.budget * 1000.0, settings.minimumScale,
+             settings.maximumScale, m_gpuTimer ? "GPU" : "CPU");
+    return true;
+}
+
+float D3DClass::GetResolutionScale()
+{
+    return m_dynamicResolution ? m_dynamicResolution->GetScale() : 1.0f;
+}
+
+float D3DClass::GetViewportHeight()
+{
+    return m_viewport.Height;
+}
+
+void D3DClass::SetResolutionScale(const float scale)
+{
+    unsigned int width = max((unsigned int)(m_screenWidth * scale + 0.5f), 1u);
+    unsigned int height = max((unsigned int)(m_screenHeight * scale + 0.5f), 1u);
+    m_viewport.Width = (float)width;
+    m_viewport.Height = (float)height;
+    m_stateCache->RSSetViewports(1, &m_viewport);
+    m_swapChain->SetSourceSize(width, height);
+}
+
+void D3DClass::UpdateResolutionScale()
+{
+    // GPU times come back a few frames late with the scale they were rendered at; CPU times are for this frame.
+    double frameSeconds;
+    float frameScale;
+    if (m_gpuTimer)
+    {
+        unsigned long long frameNumber = 0;
+        frameSeconds = m_gpuTimer->Collect(m_deviceContext.Get(), frameNumber);
+        frameScale = m_frameScales[frameNumber % GpuTimerClass::FRAMES_IN_FLIGHT];
     }
     else
     {
-        // Present as fast as possible.
-        m_swapChain->Present(0, 0);
+        frameSeconds = m_sceneSeconds;
+        frameScale = m_dynamicResolution->GetScale();
+    }
+
+    if (frameSeconds < 0.0)
+    {
+        return;
+    }
+
+    float scale = m_dynamicResolution->GetScale();
+    if (m_dynamicResolution->Update(frameSeconds, frameScale) != scale)
+    {
+        SetResolutionScale(m_dynamicResolution->GetScale());
+    }
+
+    if (m_dynamicResolution->HasNewStatistics())
+    {
+        const DynamicResolutionClass::Statistics& statistics = m_dynamicResolution->GetStatistics();
+        LOG_INFO("Dynamic resolution: scale {} (lowest {}), {} ms per frame, deviation {} ms against an estimated {} ms unscaled, {}% of "
+                 "the variance removed, {} frames over budget against an estimated {} unscaled", statistics.meanScale, statistics.minimumScale,
+                 statistics.meanFrameTime * 1000.0, statistics.frameTimeDeviation * 1000.0, statistics.unscaledFrameTimeDeviation * 1000.0,
+                 statistics.GetVarianceRemoved() * 100.0, statistics.framesOverBudget, statistics.unscaledFramesOverBudget);
+    }
+}
+
+void D3DClass::WaitForFrame()
+{
+    if (m_swapChain)
+    {
+        m_swapChain->WaitForFrame();
     }
 }
 
@@ -167,6 +344,60 @@ ID3D11DeviceContext* D3DClass::GetDeviceContext()
     return m_deviceContext.Get();
 }
 
+StateCacheClass* D3DClass::GetStateCache()
+{
+    return m_stateCache.get();
+}
+
+PipelineCacheClass* D3DClass::GetPipelineCache()
+{
+    return m_pipelineCache.get();
+}
+
+ConstantBufferRingClass* D3DClass::GetConstantRing()
+{
+    return m_constantRing.get();
+}
+
+StreamingGeometryClass* D3DClass::GetStreamingGeometry()
+{
+    return m_streamingGeometry.get();
+}
+
+LinearAllocatorClass* D3DClass::GetFrameAllocator()
+{
+    return m_frameAllocator.get();
+}
+
+SwapChainClass* D3DClass::GetSwapChain()
+{
+    return m_swapChain.get();
+}
+
+SoftwareRasterizerClass* D3DClass::GetSoftwareRasterizer()
+{
+    return m_softwareRasterizer.get();
+}
+
+NullDeviceClass* D3DClass::GetNullDevice()
+{
+    return m_nullDevice;
+}
+
+void D3DClass::BindOutputState(StateCacheClass* stateCache)
+{
+    stateCache->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
+    stateCache->RSSetViewports(1, &m_viewport);
+}
+
+void D3DClass::ExecuteCommandList(ID3D11CommandList* commandList)
+{
+    // Restoring the previous state would cost as much as setting it again, and most of it is reset by the next draws anyway.
+    m_deviceContext->ExecuteCommandList(commandList, FALSE);
+    m_stateCache->Invalidate();
+    BindOutputState(m_stateCache.get());
+}
+
 void D3DClass::GetProjectionMatrix(XMMATRIX& projectionMatrix)
 {
     projectionMatrix = m_projectionMatrix;
@@ -188,10 +419,12 @@ void D3DClass::GetVideoCardInfo(char* cardName, int& memory)
     memory = m_videoCardMemory;
 }
 
+#ifdef _WIN32
 IDXGI_FACTORY_COM_PTR D3DClass::GetIDXGIFactory()
 {
     IDXGI_FACTORY_COM_PTR factory;
-    HRESULT result = CreateDXGIFactory(__uuidof(IDXGIFactory), &factory);
+    // A DXGI 1.1 factory, since its adapters are the ones D3D11CreateDevice takes.
+    HRESULT result = CreateDXGIFactory1(__uuidof(IDXGIFactory1), &factory);
     if (FAILED(result))
     {
         throw engine_exception("Creation of DXGI Factory failed with result code = ") << result;
@@ -226,28 +459,32 @@ IDXGI_OUTPUT_COM_PTR D3DClass::GetMonitorForAdapter(UINT monitorNumber, const ID
 
 unique_ptr<DXGI_MODE_DESC[]> D3DClass::GetDisplayModesForMonitor(const IDXGI_OUTPUT_COM_PTR& monitor, unsigned int& numModes)
 {
-    // Get the number of modes that fit the DXGI_FORMAT_R8G8B8A8_UNORM display format for the adapter output (monitor).
-    //unsigned int numModes;
-    HRESULT result = monitor->GetDisplayModeList(DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_ENUM_MODES_INTERLACED, &numModes, NULL);
-    if (FAILED(result))
+    // List the modes that fit the DXGI_FORMAT_R8G8B8A8_UNORM display format for the adapter output (monitor) into a list
+    // big enough for most monitors. When there are more, count them and try again; the list can also grow in between.
+    numModes = MODE_LIST_GUESS;
+    for (;;)
     {
-        throw engine_exception("Getting number of modes for monitor failed with result code = ") << result;
-    }
+        unique_ptr<DXGI_MODE_DESC[]> displayModeList(new DXGI_MODE_DESC[numModes]);
+        HRESULT result = monitor->GetDisplayModeList(DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_ENUM_MODES_INTERLACED, &numModes, displayModeList.get());
+        if (result != DXGI_ERROR_MORE_DATA)
+        {
+            if (FAILED(result))
+            {
+                throw engine_exception("Getting disply mode list failed with result code = ") << result;
+            }
 
-    // Create a list to hold all the possible display modes for this monitor/video card combination.
-    unique_ptr<DXGI_MODE_DESC[]> displayModeList(new DXGI_MODE_DESC[numModes]);
+            return displayModeList;
+        }
 
-    // Now fill the display mode list structures.
-    result = monitor->GetDisplayModeList(DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_ENUM_MODES_INTERLACED, &numModes, displayModeList.get());
-    if (FAILED(result))
-    {
-        throw engine_exception("Getting disply mode list failed with result code = ") << result;
+        result = monitor->GetDisplayModeList(DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_ENUM_MODES_INTERLACED, &numModes, NULL);
+        if (FAILED(result))
+        {
+            throw engine_exception("Getting number of modes for monitor failed with result code = ") << result;
+        }
     }
-
-    return displayModeList;
 }
 
-void D3DClass::GetVideoCardInformation(const IDXGI_ADAPTER_COM_PTR& adapter)
+void D3DClass::GetVideoCardInformation(const IDXGI_ADAPTER_COM_PTR& adapter, char* description, int& memory)
 {
     // Get the adapter (video card) description.
     DXGI_ADAPTER_DESC adapterDesc;
@@ -258,121 +495,135 @@ void D3DClass::GetVideoCardInformation(const IDXGI_ADAPTER_COM_PTR& adapter)
     }
 
     // Store the dedicated video card memory in megabytes.
-    m_videoCardMemory = (int)(adapterDesc.DedicatedVideoMemory / 1024 / 1024);
+    memory = (int)(adapterDesc.DedicatedVideoMemory / 1024 / 1024);
 
     // Convert the name of the video card to a character array and store it.
     unsigned int stringLength;
-    int error = wcstombs_s(&stringLength, m_videoCardDescription, 128, adapterDesc.Description, 128);
+    int error = wcstombs_s(&stringLength, description, 128, adapterDesc.Description, 128);
     if (error != 0)
     {
         throw engine_exception("Couldn't write adapter description to char array");
     }
 }
 
-void D3DClass::GetRefreshRateForWindowSize(const unsigned int numModes, const unique_ptr<DXGI_MODE_DESC[]>& displayModeList,
-                                           const unsigned int screenWidth, const unsigned int screenHeight,
-                                           unsigned int& numerator, unsigned int& denominator)
+DisplayProfileClass::Enumerator D3DClass::GetDisplayEnumerator(const IDXGI_ADAPTER_COM_PTR& adapter, const IDXGI_OUTPUT_COM_PTR& monitor)
 {
-    for (unsigned int i = 0; i < numModes; i++)
+    DisplayProfileClass::Enumerator enumerator;
+    enumerator.identify = [adapter, monitor](DisplayProfileClass::Key& key)
     {
-        stringstream oss;
-        oss << "Display Mode: " << displayModeList[i].Width << ", " << displayModeList[i].Height << "\n";
-        OutputDebugStringA(oss.str().c_str());
-
-        if (displayModeList[i].Width == (unsigned int)screenWidth)
+        DXGI_ADAPTER_DESC adapterDesc;
+        HRESULT result = adapter->GetDesc(&adapterDesc);
+        if (FAILED(result))
         {
-            if (displayModeList[i].Height == (unsigned int)screenHeight)
-            {
-                numerator = displayModeList[i].RefreshRate.Numerator;
-                denominator = displayModeList[i].RefreshRate.Denominator;
-            }
+            throw engine_exception("Couldn't get adapter description from adapter");
         }
-    }
-}
-
-DXGI_SWAP_CHAIN_DESC D3DClass::SetSwapChainDescription(int unsigned screenWidth, int unsigned screenHeight, unsigned int numerator,
-    unsigned int denominator, HWND hwnd, bool fullscreen)
-{
-    DXGI_SWAP_CHAIN_DESC swapChainDesc;
-
-    // Initialize the swap chain description.
-    ZeroMemory(&swapChainDesc, sizeof(swapChainDesc));
+        key.adapterLuid = adapterDesc.AdapterLuid;
+        key.vendorId = adapterDesc.VendorId;
+        key.deviceId = adapterDesc.DeviceId;
 
-    // Set to a single back buffer.
-    swapChainDesc.BufferCount = 1;
-
-    // Set the width and height of the back buffer.
-    swapChainDesc.BufferDesc.Width = screenWidth;
-    swapChainDesc.BufferDesc.Height = screenHeight;
-
-    // Set regular 32-bit surface for the back buffer.
-    swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-
-    // Set the refresh rate of the back buffer.
-    if (m_vsync_enabled)
-    {
-        swapChainDesc.BufferDesc.RefreshRate.Numerator = numerator;
-        swapChainDesc.BufferDesc.RefreshRate.Denominator = denominator;
-    }
-    else
-    {
-        swapChainDesc.BufferDesc.RefreshRate.Numerator = 0;
-        swapChainDesc.BufferDesc.RefreshRate.Denominator = 1;
-    }
-
-    // Set the usage of the back buffer.
-    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-
-    // Set the handle for the window to render to.
-    swapChainDesc.OutputWindow = hwnd;
-
-    // Turn multisampling off.
-    swapChainDesc.SampleDesc.Count = 1;
-    swapChainDesc.SampleDesc.Quality = 0;
+        // The user mode driver version; an adapter that doesn't report one is keyed on the rest.
+        LARGE_INTEGER driverVersion;
+        if (SUCCEEDED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion)))
+        {
+            key.driverVersion = (unsigned long long)driverVersion.QuadPart;
+        }
 
-    // Set to full screen or windowed mode.
-    if (fullscreen)
+        DXGI_OUTPUT_DESC outputDesc;
+        result = monitor->GetDesc(&outputDesc);
+        if (FAILED(result))
+        {
+            throw engine_exception("Couldn't get output description, result code = ") << result;
+        }
+        memcpy(key.outputName, outputDesc.DeviceName, sizeof(key.outputName));
+        key.outputCoordinates = outputDesc.DesktopCoordinates;
+    };
+    enumerator.describeCard = [this, adapter](char* description, int& memory)
     {
-        swapChainDesc.Windowed = false;
-    }
-    else
+        GetVideoCardInformation(adapter, description, memory);
+    };
+    enumerator.enumerateModes = [this, monitor](unsigned int& numModes)
     {
-        swapChainDesc.Windowed = true;
-    }
+        return GetDisplayModesForMonitor(monitor, numModes);
+    };
+    return enumerator;
+}
 
-    // Set the scan line ordering and scaling to unspecified.
-    swapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-    swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+void D3DClass::CreateHardwareDevice(const int screenWidth, const int screenHeight, const HWND hwnd, const bool fullscreen,
+                                    const SwapChainClass::Settings& presentSettings)
+{
+    // Get DirectX graphics interface factory.
+    auto factory = GetIDXGIFactory();
 
-    // Discard the back buffer contents after presenting.
-    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+    // Use the factory to create an adapter for the primary graphics interface (video card).
+    auto adapter = GetPrimaryDisplayAdapter(factory);
 
-    // Don't set the advanced flags.
-    swapChainDesc.Flags = 0;
+    // Obtain the primary adapter output, i.e. the main monitor.
+    auto monitor = GetMonitorForAdapter(0, adapter);
 
-    return swapChainDesc;
+    // The card information and the refresh rate of the display mode that matches the window size. They come from the
+    // display profile cache unless the adapter, driver, monitor or window size changed since it was written.
+    DisplayProfileClass displayProfile;
+    displayProfile.Initialize(GetDisplayEnumerator(adapter, monitor), DISPLAY_PROFILE_FILE, screenWidth, screenHeight);
+    const DisplayProfileClass::Profile& profile = displayProfile.GetProfile();
+    strcpy_s(m_videoCardDescription, 128, profile.cardDescription);
+    m_videoCardMemory = profile.cardMemory;
+    unsigned int numerator = profile.mode.RefreshRate.Numerator;
+    unsigned int denominator = profile.mode.RefreshRate.Denominator;
+
+    LOG_INFO("Display profile {}", displayProfile.IsCached() ? "loaded from the cache" : "enumerated");
+    LOG_INFO("Display Adapter = {}", m_videoCardDescription);
+    LOG_INFO("Memory = {}MB", m_videoCardMemory);
+    LOG_INFO("Refresh Rate = {} / {}", numerator, denominator);
+
+    // Create the device and device context member variables on the adapter the profile describes.
+    CreateDeviceAndContext(adapter);
+
+    // The swap chain comes from the same adapter, stepped down to what the system supports.
+    m_swapChain = unique_ptr<SwapChainClass>(new SwapChainClass());
+    m_swapChain->Initialize(m_device.Get(), hwnd, screenWidth, screenHeight, profile.mode.RefreshRate, fullscreen, presentSettings);
 }
 
-void D3DClass::CreateSwapChainDeviceAndContext(const DXGI_SWAP_CHAIN_DESC& swapChainDesc)
+void D3DClass::CreateDeviceAndContext(const IDXGI_ADAPTER_COM_PTR& adapter)
 {
     // Set the feature level to DirectX 11.
     D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_0;
 
-    // Create the swap chain, Direct3D device, and Direct3D device context.
-    HRESULT result = D3D11CreateDeviceAndSwapChain(NULL, D3D_DRIVER_TYPE_HARDWARE, NULL, 0, &featureLevel, 1,
-        D3D11_SDK_VERSION, &swapChainDesc, &m_swapChain, &m_device, NULL, &m_deviceContext);
+    // Create the Direct3D device and device context. An explicit adapter needs the unknown driver type.
+    HRESULT result = D3D11CreateDevice(adapter.Get(), D3D_DRIVER_TYPE_UNKNOWN, NULL, 0, &featureLevel, 1,
+        D3D11_SDK_VERSION, &m_device, NULL, &m_deviceContext);
 
     if (FAILED(result))
     {
-        throw engine_exception("Could not create swap chain, device and device context, result code = ") << result;
+        throw engine_exception("Could not create device and device context, result code = ") << result;
     }
 }
+#endif
 
-void D3DClass::CreateRenderTargetView()
+void D3DClass::CreateRenderTargetView(const unsigned int screenWidth, const unsigned int screenHeight)
 {
     // Get the pointer to the back buffer.
     ComPtr<ID3D11Texture2D> backBufferPtr;
-    HRESULT result = m_swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), &backBufferPtr);
+    HRESULT result;
+#ifdef _WIN32
+    if (m_swapChain && m_swapChain->GetSwapChain())
+    {
+        result = m_swapChain->GetSwapChain()->GetBuffer(0, __uuidof(ID3D11Texture2D), &backBufferPtr);
+    }
+    else
+#endif
+    {
+        D3D11_TEXTURE2D_DESC backBufferDesc;
+        ZeroMemory(&backBufferDesc, sizeof(backBufferDesc));
+        backBufferDesc.Width = screenWidth;
+        backBufferDesc.Height = screenHeight;
+        backBufferDesc.MipLevels = 1;
+        backBufferDesc.ArraySize = 1;
+        backBufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        backBufferDesc.SampleDesc.Count = 1;
+        backBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+        backBufferDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+        result = m_device->CreateTexture2D(&backBufferDesc, NULL, &backBufferPtr);
+    }
     if (FAILED(result))
     {
         throw engine_exception("Could not obtain back buffer pointer, result code = ") << result;
@@ -413,47 +664,6 @@ void D3DClass::CreateDepthBuffer(const unsigned int screenWidth, const unsigned
     }
 }
 
-D3D11_DEPTH_STENCIL_DESC D3DClass::SetDepthStencilDescription()
-{
-    D3D11_DEPTH_STENCIL_DESC depthStencilDesc;
-    ZeroMemory(&depthStencilDesc, sizeof(depthStencilDesc));
-
-    // Set up the description of the stencil state.
-    depthStencilDesc.DepthEnable = true;
-    depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
-    depthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS;
-
-    depthStencilDesc.StencilEnable = true;
-    depthStencilDesc.StencilReadMask = 0xFF;
-    depthStencilDesc.StencilWriteMask = 0xFF;
-
-    // Stencil operations if pixel is front-facing.
-    depthStencilDesc.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
-    depthStencilDesc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_INCR;
-    depthStencilDesc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
-    depthStencilDesc.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
-
-    // Stencil operations if pixel is back-facing.
-    depthStencilDesc.BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
-    depthStencilDesc.BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_DECR;
-    depthStencilDesc.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
-    depthStencilDesc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
-
-    return depthStencilDesc;
-}
-
-void D3DClass::CreateDepthStencilState(D3D11_DEPTH_STENCIL_DESC& depthStencilDesc)
-{
-    HRESULT result = m_device->CreateDepthStencilState(&depthStencilDesc, &m_depthStencilState);
-    if (FAILED(result))
-    {
-        throw engine_exception("Could not create depth stencil state, result code = ") << result;
-    }
-
-    // Set the depth stencil state.
-    m_deviceContext->OMSetDepthStencilState(m_depthStencilState.Get(), 1);
-}
-
 D3D11_DEPTH_STENCIL_VIEW_DESC D3DClass::CreateDepthStencilViewDescription()
 {
     D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc;
@@ -475,32 +685,3 @@ void D3DClass::CreateDepthStencilView(D3D11_DEPTH_STENCIL_VIEW_DESC& depthStenci
         throw engine_exception("Couldn't create depth stencil view, result code = ") << result;
     }
 }
-
-D3D11_RASTERIZER_DESC D3DClass::SetRasterizerDescription()
-{
-    D3D11_RASTERIZER_DESC rasterDesc;
-    rasterDesc.AntialiasedLineEnable = false;
-    rasterDesc.CullMode = D3D11_CULL_BACK;
-    rasterDesc.DepthBias = 0;
-    rasterDesc.DepthBiasClamp = 0.0f;
-    rasterDesc.DepthClipEnable = true;
-    rasterDesc.FillMode = D3D11_FILL_SOLID;
-    rasterDesc.FrontCounterClockwise = false;
-    rasterDesc.MultisampleEnable = false;
-    rasterDesc.ScissorEnable = false;
-    rasterDesc.SlopeScaledDepthBias = 0.0f;
-
-    return rasterDesc;
-}
-
-void D3DClass::SetRasterizerState(D3D11_RASTERIZER_DESC& rasterDesc)
-{
-    HRESULT result = m_device->CreateRasterizerState(&rasterDesc, &m_rasterState);
-    if (FAILED(result))
-    {
-        throw engine_exception("Could not set rasterizer state, result code = ") << result;
-    }
-
-    // Now set the rasterizer state.
-    m_deviceContext->RSSetState(m_rasterState.Get());
-}
\ No newline at end of file
@@ -1,6 +1,18 @@
 #pragma once
 #include "engine.h"
 #include "engine_exception.h"
+#include "softwarerasterizerclass.h"
+#include "statecacheclass.h"
+#include "constantbufferringclass.h"
+#include "streaminggeometryclass.h"
+#include "nulldeviceclass.h"
+#include "displayprofileclass.h"
+#include "pipelinecacheclass.h"
+#include "swapchainclass.h"
+#include "dynamicresolutionclass.h"
+#include "gputimerclass.h"
+#include "linearallocatorclass.h"
+#include "poolallocatorclass.h"
 #include "wrl/client.h"
 
 using namespace std;
@@ -15,45 +27,101 @@ class ReleaseResource
 public:
     void operator()(T *s) const
     {
-        stringstream ss;
-        ss << "Releasing " << typeid(T).name() << " instance\n";
-        OutputDebugStringA(ss.str().c_str());
+        LOG_DEBUG("Releasing {} instance", typeid(T).name());
         s->Release();
     }
 };
 
-#define IDXGI_FACTORY_COM_PTR ComPtr<IDXGIFactory>
+#ifdef _WIN32
+#define IDXGI_FACTORY_COM_PTR ComPtr<IDXGIFactory1>
 #define IDXGI_ADAPTER_COM_PTR ComPtr<IDXGIAdapter>
 #define IDXGI_OUTPUT_COM_PTR ComPtr<IDXGIOutput>
-#define IDXGI_SWAP_CHAIN_COM_PTR ComPtr<IDXGISwapChain>
+#endif
 #define ID3D11_DEVICE_COM_PTR ComPtr<ID3D11Device>
 #define ID3D11_DEVICE_CONTEXT_COM_PTR ComPtr<ID3D11DeviceContext>
 #define ID3D11_RENDER_TARGET_VIEW_COM_PTR ComPtr<ID3D11RenderTargetView>
 #define ID3D11_TEXTURE_2D_COM_PTR ComPtr<ID3D11Texture2D>
-#define ID3D11_DEPTH_STENCIL_STATE_COM_PTR ComPtr<ID3D11DepthStencilState>
 #define ID3D11_DEPTH_STENCIL_VIEW_COM_PTR ComPtr<ID3D11DepthStencilView>
-#define ID3D11_RASTERIZER_STATE_COM_PTR ComPtr<ID3D11RasterizerState>
 
 class D3DClass
 {
 public:
+    enum Renderer
+    {
+        // A D3D11 device on the primary adapter presenting through a DXGI swap chain; Windows only.
+        RENDERER_HARDWARE,
+        // No D3D11 device is created and frames are rasterized on the CPU instead.
+        RENDERER_SOFTWARE,
+        // A recording null device without DXGI or a swap chain, for running frames headless; hwnd may be NULL.
+        RENDERER_NULL
+    };
+
     D3DClass();
     ~D3DClass();
 
-    void Initialize(const int screenWidth, const int screenHeight, const bool vsync, const HWND hwnd,
-                    const bool fullscreen, const float screenDepth, const float screenNear);
+    void Initialize(const int screenWidth, const int screenHeight, const SwapChainClass::Settings& presentSettings, const HWND hwnd,
+                    const bool fullscreen, const float screenDepth, const float screenNear, const Renderer renderer);
 
     void Shutdown();
 
     void BeginScene(float, float, float, float);
 
+    // Presents the frame, to a simulated display on the null device.
     void EndScene();
 
+    // Waits until the swap chain can take another frame; call it before input is sampled for the next one.
+    void WaitForFrame();
+
     // Return raw pointer for use outsie the object (but don't try to manage these pointers).
     ID3D11Device* GetDevice();
 
     ID3D11DeviceContext* GetDeviceContext();
 
+    // Redundant state filter in front of the device context; prefer this for binding state.
+    StateCacheClass* GetStateCache();
+
+    // Shared rasterizer, depth stencil and blend states, shaders and input layouts; see PipelineCacheClass::GetDefaultDesc
+    // for the fixed function state the tutorial draws with.
+    PipelineCacheClass* GetPipelineCache();
+
+    // Per draw shader constants; the ring is rewound every BeginScene.
+    ConstantBufferRingClass* GetConstantRing();
+
+    // Vertex and index rings for geometry generated each frame, with 16-bit indices.
+    StreamingGeometryClass* GetStreamingGeometry();
+
+    // nullptr for the software renderer.
+    SwapChainClass* GetSwapChain();
+
+    // Renders the scene into the top left of the back and depth buffers at a scale picked each frame from the GPU time of
+    // the frames, or the CPU time between BeginScene and EndScene where there are no timestamp queries, and has the swap
+    // chain stretch it over the window. False, leaving the full resolution, when the swap chain can't stretch.
+    bool EnableDynamicResolution(const DynamicResolutionClass::Settings& settings);
+
+    // The fraction of the window's width and height the next frame renders at; 1 without dynamic resolution.
+    float GetResolutionScale();
+
+    // Height in pixels of the viewport the scene renders into, at the resolution scale.
+    float GetViewportHeight();
+
+    // Scratch memory for the current frame, from any thread; it is reset at EndScene. Returns nullptr when the frame has
+    // used it all up.
+    LinearAllocatorClass* GetFrameAllocator();
+
+    // Returns nullptr unless the software renderer was selected at Initialize.
+    SoftwareRasterizerClass* GetSoftwareRasterizer();
+
+    // Returns nullptr unless the null device was selected at Initialize. Its frames end at EndScene.
+    NullDeviceClass* GetNullDevice();
+
+    // Binds the back buffer, depth buffer and viewport through the given cache, e.g. for a deferred context. Fixed function
+    // state comes with each draw's pipeline state.
+    void BindOutputState(StateCacheClass* stateCache);
+
+    // Runs a command list recorded on a deferred context. The immediate context is left in default state afterwards, so
+    // the state cache is invalidated and the output state bound again.
+    void ExecuteCommandList(ID3D11CommandList* commandList);
+
     void GetProjectionMatrix(XMMATRIX& projection);
 
     void GetWorldMatrix(XMMATRIX& world);
@@ -62,27 +130,46 @@ public:
 
     void GetVideoCardInfo(char* name, int& mbMemory);
 
-    // Operators for new and delete needed to set 16-byte alignment.
-    static void* operator new (size_t size);
-
-    static void operator delete (void* p);
+    // There is only ever one, from a pool that keeps it 16-byte aligned.
+    DECLARE_POOL_ALLOCATION();
 
 private:
-    bool m_vsync_enabled;
     int m_videoCardMemory;
     char m_videoCardDescription[128];
-    IDXGI_SWAP_CHAIN_COM_PTR m_swapChain;
+    unique_ptr<SwapChainClass> m_swapChain;
     ID3D11_DEVICE_COM_PTR m_device;
     ID3D11_DEVICE_CONTEXT_COM_PTR m_deviceContext;
     ID3D11_RENDER_TARGET_VIEW_COM_PTR m_renderTargetView;
     ID3D11_TEXTURE_2D_COM_PTR m_depthStencilBuffer;
-    ID3D11_DEPTH_STENCIL_STATE_COM_PTR m_depthStencilState;
     ID3D11_DEPTH_STENCIL_VIEW_COM_PTR m_depthStencilView;
-    ID3D11_RASTERIZER_STATE_COM_PTR m_rasterState;
+    D3D11_VIEWPORT m_viewport;
     XMMATRIX m_projectionMatrix;
     XMMATRIX m_worldMatrix;
     XMMATRIX m_orthoMatrix;
-
+    unique_ptr<SoftwareRasterizerClass> m_softwareRasterizer;
+    // Owned through m_device.
+    NullDeviceClass* m_nullDevice;
+    unique_ptr<SwapChainClass::SimulatedDisplay> m_simulatedDisplay;
+    // Performance counter at the null device's last present.
+    long long m_presentCounter;
+    unique_ptr<StateCacheClass> m_stateCache;
+    unique_ptr<PipelineCacheClass> m_pipelineCache;
+    unique_ptr<ConstantBufferRingClass> m_constantRing;
+    unique_ptr<StreamingGeometryClass> m_streamingGeometry;
+    unique_ptr<LinearAllocatorClass> m_frameAllocator;
+    unsigned int m_screenWidth, m_screenHeight;
+    unique_ptr<DynamicResolutionClass> m_dynamicResolution;
+    // nullptr when the device has no timestamp queries.
+    unique_ptr<GpuTimerClass> m_gpuTimer;
+    // Scale of each frame the GPU timer has in flight, by frame number.
+    float m_frameScales[GpuTimerClass::FRAMES_IN_FLIGHT];
+    // Performance counter at BeginScene, and the CPU time from there to Present.
+    long long m_sceneCounter;
+    double m_sceneSeconds;
+
+    void CreateMatrices(const int screenWidth, const int screenHeight, const float screenDepth, const float screenNear);
+
+#ifdef _WIN32
     IDXGI_FACTORY_COM_PTR GetIDXGIFactory();
 
     IDXGI_ADAPTER_COM_PTR GetPrimaryDisplayAdapter(const IDXGI_FACTORY_COM_PTR& factory);
@@ -91,30 +178,30 @@ private:
 
     unique_ptr<DXGI_MODE_DESC[]> GetDisplayModesForMonitor(const IDXGI_OUTPUT_COM_PTR& monitor, unsigned int& numModes);
 
-    void D3DClass::GetRefreshRateForWindowSize(const unsigned int numModes, const unique_ptr<DXGI_MODE_DESC[]>& displayModeList,
-                                               const unsigned int screenWidth, const unsigned int screenHeight,
-                                               unsigned int& numerator, unsigned int& denominator);
+    void GetVideoCardInformation(const IDXGI_ADAPTER_COM_PTR& adapter, char* description, int& memory);
 
-    void GetVideoCardInformation(const IDXGI_ADAPTER_COM_PTR& adapter);
+    // Enumerates the adapter and its monitor through DXGI for the display profile.
+    DisplayProfileClass::Enumerator GetDisplayEnumerator(const IDXGI_ADAPTER_COM_PTR& adapter, const IDXGI_OUTPUT_COM_PTR& monitor);
 
-    DXGI_SWAP_CHAIN_DESC SetSwapChainDescription(const unsigned int screenWidth, const unsigned int screenHeight, const unsigned int numerator,
-                                                 const unsigned int denominator, const HWND hwnd, const bool fullscreen);
+    void CreateDeviceAndContext(const IDXGI_ADAPTER_COM_PTR& adapter);
 
-    void CreateSwapChainDeviceAndContext(const DXGI_SWAP_CHAIN_DESC& swapChainDesc);
+    // Creates the device, context and swap chain on the primary adapter, with the window's refresh rate from the display profile.
+    void CreateHardwareDevice(const int screenWidth, const int screenHeight, const HWND hwnd, const bool fullscreen,
+                              const SwapChainClass::Settings& presentSettings);
+#endif
 
-    void CreateRenderTargetView();
+    // Renders into the swap chain's back buffer, or an offscreen one of the screen size when there is no swap chain.
+    void CreateRenderTargetView(const unsigned int screenWidth, const unsigned int screenHeight);
 
     void CreateDepthBuffer(const unsigned int screenWidth, const unsigned int screenHeight);
 
-    D3D11_DEPTH_STENCIL_DESC D3DClass::SetDepthStencilDescription();
-
-    void CreateDepthStencilState(D3D11_DEPTH_STENCIL_DESC& depthStencilDesc);
-
     D3D11_DEPTH_STENCIL_VIEW_DESC CreateDepthStencilViewDescription();
 
-    void CreateDepthStencilView(D3D11_DEPTH_STENCIL_VIEW_DESC& depthStencilViewDesc);
+    // Sizes the viewport and the swap chain's source to the scale of the window.
+    void SetResolutionScale(const float scale);
 
-    D3D11_RASTERIZER_DESC SetRasterizerDescription();
+    // Passes the time of a finished frame to the dynamic resolution controller and applies the scale it picks.
+    void UpdateResolutionScale();
 
-    void SetRasterizerState(D3D11_RASTERIZER_DESC& rasterDesc);
+    void CreateDepthStencilView(D3D11_DEPTH_STENCIL_VIEW_DESC& depthStencilViewDesc);
 };
\ No newline at end of file
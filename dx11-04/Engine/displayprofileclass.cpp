@@ -0,0 +1,238 @@
+#include "displayprofileclass.h"
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+    // 64-bit FNV-1a.
+    const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+    const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+    unsigned long long HashBytes(const void* data, const size_t size)
+    {
+        unsigned long long hash = FNV_OFFSET;
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * FNV_PRIME;
+        }
+        return hash;
+    }
+}
+
+DisplayProfileClass::DisplayProfileClass()
+{
+    ZeroMemory(&m_profile, sizeof(m_profile));
+    m_cached = false;
+}
+
+DisplayProfileClass::~DisplayProfileClass()
+{
+}
+
+void DisplayProfileClass::Initialize(const Enumerator& enumerator, const char* cacheFileName, const unsigned int screenWidth,
+                                     const unsigned int screenHeight)
+{
+    PROFILE_FUNCTION();
+
+    Key key;
+    ZeroMemory(&key, sizeof(key));
+    enumerator.identify(key);
+    key.screenWidth = screenWidth;
+    key.screenHeight = screenHeight;
+
+    m_cached = Load(cacheFileName, key);
+    if (m_cached)
+    {
+        return;
+    }
+
+    ZeroMemory(&m_profile, sizeof(m_profile));
+    m_profile.key = key;
+    enumerator.describeCard(m_profile.cardDescription, m_profile.cardMemory);
+    m_profile.cardDescription[sizeof(m_profile.cardDescription) - 1] = '\0';
+
+    unsigned int numModes = 0;
+    unique_ptr<DXGI_MODE_DESC[]> displayModeList = enumerator.enumerateModes(numModes);
+    unsigned int numerator = 0, denominator = 1;
+    GetRefreshRateForWindowSize(numModes, displayModeList, screenWidth, screenHeight, numerator, denominator);
+
+    m_profile.mode.Width = screenWidth;
+    m_profile.mode.Height = screenHeight;
+    m_profile.mode.RefreshRate.Numerator = numerator;
+    m_profile.mode.RefreshRate.Denominator = denominator;
+    m_profile.mode.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+    Save(cacheFileName);
+}
+
+const DisplayProfileClass::Profile& DisplayProfileClass::GetProfile()
+{
+    return m_profile;
+}
+
+bool DisplayProfileClass::IsCached()
+{
+    return m_cached;
+}
+
+void DisplayProfileClass::GetRefreshRateForWindowSize(const unsigned int numModes, const unique_ptr<DXGI_MODE_DESC[]>& displayModeList,
+                                                       const unsigned int screenWidth, const unsigned int screenHeight,
+                                                       unsigned int& numerator, unsigned int& denominator)
+{
+    for (unsigned int i = 0; i < numModes; i++)
+    {
+        LOG_DEBUG("Display Mode: {}, {}", displayModeList[i].Width, displayModeList[i].Height);
+
+        if (displayModeList[i].Width == (unsigned int)screenWidth)
+        {
+            if (displayModeList[i].Height == (unsigned int)screenHeight)
+            {
+                numerator = displayModeList[i].RefreshRate.Numerator;
+                denominator = displayModeList[i].RefreshRate.Denominator;
+            }
+        }
+    }
+}
+
+bool DisplayProfileClass::Load(const char* cacheFileName, const Key& key)
+{
+    ifstream file(cacheFileName, ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    CacheFile cache;
+    file.read((char*)&cache, sizeof(cache));
+    if (file.gcount() != sizeof(cache) || cache.magic != MAGIC || cache.version != VERSION)
+    {
+        LOG_INFO("Display profile cache is invalid and will be rebuilt");
+        return false;
+    }
+
+    if (cache.checksum != HashBytes(&cache.profile, sizeof(cache.profile)))
+    {
+        LOG_INFO("Display profile cache is damaged and will be rebuilt");
+        return false;
+    }
+
+    if (memcmp(&cache.profile.key, &key, sizeof(key)) != 0)
+    {
+        LOG_INFO("Display profile cache is for another adapter, driver or window size and will be rebuilt");
+        return false;
+    }
+
+    m_profile = cache.profile;
+    return true;
+}
+
+void DisplayProfileClass::Save(const char* cacheFileName)
+{
+    // Copied bytewise so the padding the checksum covers is the zeroed padding of m_profile.
+    CacheFile cache;
+    ZeroMemory(&cache, sizeof(cache));
+    cache.magic = MAGIC;
+    cache.version = VERSION;
+    memcpy(&cache.profile, &m_profile, sizeof(m_profile));
+    cache.checksum = HashBytes(&cache.profile, sizeof(cache.profile));
+
+    ofstream file(cacheFileName, ios::binary);
+    file.write((const char*)&cache, sizeof(cache));
+    if (!file)
+    {
+        LOG_WARNING("Couldn't write display profile cache {}", cacheFileName);
+    }
+}
+
+void DisplayProfileClass::Validate()
+{
+    const char* fileName = "display_profile_validation.tmp";
+    remove(fileName);
+
+    // An adapter with every size at two refresh rates, counting how often its modes are listed.
+    int enumerations = 0;
+    unsigned long long driverVersion = 0x001E00000000270FULL;
+    Enumerator enumerator;
+    enumerator.identify = [&driverVersion](Key& key)
+    {
+        key.adapterLuid.LowPart = 0x1234;
+        key.vendorId = 0x10DE;
+        key.deviceId = 0x2484;
+        key.driverVersion = driverVersion;
+        key.outputCoordinates.right = 1920;
+        key.outputCoordinates.bottom = 1080;
+        wcscpy_s(key.outputName, L"\\\\.\\DISPLAY1");
+    };
+    enumerator.describeCard = [](char* description, int& memory)
+    {
+        strcpy_s(description, 128, "Synthetic adapter");
+        memory = 8192;
+    };
+    enumerator.enumerateModes = [&enumerations](unsigned int& numModes)
+    {
+        enumerations++;
+        numModes = 64;
+        unique_ptr<DXGI_MODE_DESC[]> modes(new DXGI_MODE_DESC[numModes]);
+        for (unsigned int i = 0; i < numModes; i++)
+        {
+            ZeroMemory(&modes[i], sizeof(DXGI_MODE_DESC));
+            modes[i].Width = 640 + (i / 2) * 40;
+            modes[i].Height = 480 + (i / 2) * 30;
+            modes[i].RefreshRate.Numerator = i % 2 == 0 ? 60000 : 143856;
+            modes[i].RefreshRate.Denominator = 1000;
+            modes[i].Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        }
+        return modes;
+    };
+
+    // Each start: whether it should have come from the cache, and the refresh rate it should have found.
+    struct Start
+    {
+        unsigned int screenWidth;
+        unsigned int screenHeight;
+        bool cached;
+        unsigned int numerator;
+    };
+    auto check = [&](const Start& start, const char* what)
+    {
+        int before = enumerations;
+        DisplayProfileClass profile;
+        profile.Initialize(enumerator, fileName, start.screenWidth, start.screenHeight);
+        const Profile& result = profile.GetProfile();
+        bool enumerated = enumerations != before;
+        if (profile.IsCached() != start.cached || enumerated == start.cached || result.mode.RefreshRate.Numerator != start.numerator
+            || result.mode.Width != start.screenWidth || result.cardMemory != 8192 || strcmp(result.cardDescription, "Synthetic adapter") != 0)
+        {
+            remove(fileName);
+            throw engine_exception("Display profile validation: ") << what << " was " << (profile.IsCached() ? "cached" : "not cached")
+                                                                   << " with refresh rate " << result.mode.RefreshRate.Numerator;
+        }
+    };
+
+    Start first = { 1240, 930, false, 143856 };
+    check(first, "the first start");
+    Start second = { 1240, 930, true, 143856 };
+    check(second, "the second start");
+
+    driverVersion++;
+    check(first, "a start after a driver update");
+    check(second, "the start after that");
+
+    Start resized = { 1000, 750, false, 143856 };
+    check(resized, "a start with another window size");
+    Start unmatched = { 1001, 750, false, 0 };
+    check(unmatched, "a start with a size no mode has");
+
+    // Flip one byte of the saved card name.
+    {
+        fstream file(fileName, ios::binary | ios::in | ios::out);
+        file.seekp(offsetof(CacheFile, profile) + offsetof(Profile, cardDescription));
+        file.put('s');
+    }
+    check(unmatched, "a start with a damaged file");
+
+    remove(fileName);
+    LOG_INFO("Display profile validation passed");
+}
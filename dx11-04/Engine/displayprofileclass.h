@@ -0,0 +1,89 @@
+#pragma once
+#include "engine.h"
+#include <functional>
+#include <memory>
+
+using namespace std;
+
+// The card and display mode the swap chain is created with. Finding the refresh rate for the window size means listing
+// every display mode of the adapter's output, which is slow with some drivers and monitors. So the profile is saved to a
+// file keyed by the adapter's LUID and driver version, the output and the window size. Later starts only identify the
+// adapter and reuse the saved profile. The full enumeration runs again when the file is missing or damaged or the key
+// differs. All enumeration goes through an Enumerator, so synthetic adapters and mode lists can stand in for DXGI.
+class DisplayProfileClass
+{
+public:
+    // Everything a profile is only valid for. Compared bytewise, so fill it in over a zeroed one.
+    struct Key
+    {
+        LUID adapterLuid;
+        unsigned long long driverVersion;
+        unsigned int vendorId;
+        unsigned int deviceId;
+        WCHAR outputName[32];
+        RECT outputCoordinates;
+        unsigned int screenWidth;
+        unsigned int screenHeight;
+    };
+
+    struct Profile
+    {
+        Key key;
+        // The window size, with the matching mode's refresh rate or 0 / 1 (unspecified) when no mode matched.
+        DXGI_MODE_DESC mode;
+        char cardDescription[128];
+        int cardMemory; // Megabytes.
+    };
+
+    struct Enumerator
+    {
+        // Fills in the adapter and output fields of the key. Runs on every start, so it should be cheap.
+        function<void(Key& key)> identify;
+        // Writes up to 128 characters of the card's name and its dedicated memory in megabytes.
+        function<void(char* description, int& memory)> describeCard;
+        // Every mode of the output; the slow part the cache is there to skip.
+        function<unique_ptr<DXGI_MODE_DESC[]>(unsigned int& numModes)> enumerateModes;
+    };
+
+    DisplayProfileClass();
+
+    ~DisplayProfileClass();
+
+    // Loads the profile for the enumerator's adapter and the window size from the cache file. If that fails, enumerates it
+    // and rewrites the file. A file that can't be written only costs the next start the enumeration.
+    void Initialize(const Enumerator& enumerator, const char* cacheFileName, const unsigned int screenWidth, const unsigned int screenHeight);
+
+    const Profile& GetProfile();
+
+    // Whether Initialize took the profile from the cache file.
+    bool IsCached();
+
+    // Scans the display modes for the window size and returns its refresh rate; the numerator and denominator are left
+    // alone when no mode matches.
+    static void GetRefreshRateForWindowSize(const unsigned int numModes, const unique_ptr<DXGI_MODE_DESC[]>& displayModeList,
+                                            const unsigned int screenWidth, const unsigned int screenHeight,
+                                            unsigned int& numerator, unsigned int& denominator);
+
+    // Runs the cache against synthetic adapters in a temporary file. The first start must enumerate and the second reuse the
+    // file. A new driver, another window size or a damaged file must enumerate again. Throws on a failure.
+    static void Validate();
+
+private:
+    static const unsigned int MAGIC = 0x50505344; // "DSPP"
+    static const unsigned int VERSION = 1;
+
+    struct CacheFile
+    {
+        unsigned int magic;
+        unsigned int version;
+        unsigned long long checksum; // Of the profile.
+        Profile profile;
+    };
+
+    bool Load(const char* cacheFileName, const Key& key);
+
+    void Save(const char* cacheFileName);
+
+    Profile m_profile;
+    bool m_cached;
+};
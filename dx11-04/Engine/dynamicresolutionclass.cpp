@@ -0,0 +1,265 @@
+#include "dynamicresolutionclass.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using namespace std;
+
+const double DynamicResolutionClass::SCALE_STEP = 0.01;
+
+double DynamicResolutionClass::Statistics::GetVarianceRemoved() const
+{
+    double unscaledVariance = unscaledFrameTimeDeviation * unscaledFrameTimeDeviation;
+    return unscaledVariance > 0.0 ? 1.0 - frameTimeDeviation * frameTimeDeviation / unscaledVariance : 0.0;
+}
+
+DynamicResolutionClass::DynamicResolutionClass()
+{
+    Initialize(GetDefaultSettings());
+}
+
+DynamicResolutionClass::~DynamicResolutionClass()
+{
+}
+
+DynamicResolutionClass::Settings DynamicResolutionClass::GetDefaultSettings()
+{
+    Settings settings;
+    settings.budget = 0.9 / 60.0;
+    settings.fixedCost = 0.0;
+    settings.minimumScale = 0.5;
+    settings.maximumScale = 1.0;
+    settings.decreaseRate = 0.5;
+    settings.increaseRate = 0.1;
+    settings.smoothing = 0.1;
+    return settings;
+}
+
+void DynamicResolutionClass::Initialize(const Settings& settings)
+{
+    if (settings.budget <= 0.0 || settings.minimumScale <= 0.0 || settings.minimumScale > settings.maximumScale)
+    {
+        throw engine_exception("Dynamic resolution needs a positive budget and scales, not ") << settings.budget << " s and "
+                                                                                              << settings.minimumScale << " to " << settings.maximumScale;
+    }
+    if (settings.fixedCost < 0.0 || settings.fixedCost >= settings.budget)
+    {
+        throw engine_exception("Dynamic resolution needs a fixed cost under the budget, not ") << settings.fixedCost << " s against "
+                                                                                              << settings.budget << " s";
+    }
+
+    m_settings = settings;
+    m_scale = (float)settings.maximumScale;
+    m_cost = 0.0;
+    m_started = false;
+
+    m_frames = 0;
+    m_scaleSum = 0.0;
+    m_scaleMinimum = settings.maximumScale;
+    m_sum = m_sumOfSquares = m_unscaledSum = m_unscaledSumOfSquares = 0.0;
+    m_overBudget = m_unscaledOverBudget = 0;
+    m_statistics = Statistics();
+    m_newStatistics = false;
+}
+
+float DynamicResolutionClass::Update(const double frameSeconds, const float frameScale)
+{
+    if (frameSeconds <= 0.0 || frameScale <= 0.0f)
+    {
+        return m_scale;
+    }
+
+    Accumulate(frameSeconds, frameScale);
+
+    // A frame dearer than the estimate is believed straight away; cheaper ones have to keep it up before it counts.
+    double cost = max(frameSeconds - m_settings.fixedCost, 0.0) / ((double)frameScale * frameScale);
+    if (!m_started || cost > m_cost)
+    {
+        m_cost = cost;
+        m_started = true;
+    }
+    else
+    {
+        m_cost += m_settings.smoothing * (cost - m_cost);
+    }
+
+    double scaledBudget = m_settings.budget - m_settings.fixedCost;
+    double target = m_cost > 0.0 ? sqrt(scaledBudget / m_cost) : m_settings.maximumScale;
+    target = min(max(target, m_settings.minimumScale), m_settings.maximumScale);
+    double difference = target - m_scale;
+    double step = (difference < 0.0 ? m_settings.decreaseRate : m_settings.increaseRate) * difference;
+
+    // Small steps are rounded up so the scale gets there, except within a step of the target, where it stays put unless
+    // the target is a limit of the range.
+    if (fabs(difference) < SCALE_STEP)
+    {
+        bool atLimit = target == m_settings.minimumScale || target == m_settings.maximumScale;
+        step = atLimit ? difference : 0.0;
+    }
+    else if (fabs(step) < SCALE_STEP)
+    {
+        step = difference < 0.0 ? -SCALE_STEP : SCALE_STEP;
+    }
+
+    m_scale = (float)min(max(m_scale + step, m_settings.minimumScale), m_settings.maximumScale);
+    return m_scale;
+}
+
+float DynamicResolutionClass::GetScale()
+{
+    return m_scale;
+}
+
+bool DynamicResolutionClass::HasNewStatistics()
+{
+    bool newStatistics = m_newStatistics;
+    m_newStatistics = false;
+    return newStatistics;
+}
+
+const DynamicResolutionClass::Statistics& DynamicResolutionClass::GetStatistics()
+{
+    return m_statistics;
+}
+
+void DynamicResolutionClass::Accumulate(const double frameSeconds, const float frameScale)
+{
+    // Only the part of the frame that depends on the resolution is scaled up.
+    double fixedSeconds = min(frameSeconds, m_settings.fixedCost);
+    double unscaled = fixedSeconds + (frameSeconds - fixedSeconds) * (m_settings.maximumScale * m_settings.maximumScale) /
+                                     ((double)frameScale * frameScale);
+    m_scaleSum += frameScale;
+    m_scaleMinimum = min(m_scaleMinimum, (double)frameScale);
+    m_sum += frameSeconds;
+    m_sumOfSquares += frameSeconds * frameSeconds;
+    m_unscaledSum += unscaled;
+    m_unscaledSumOfSquares += unscaled * unscaled;
+    m_overBudget += frameSeconds > m_settings.budget ? 1 : 0;
+    m_unscaledOverBudget += unscaled > m_settings.budget ? 1 : 0;
+
+    if (++m_frames < STATISTICS_FRAMES)
+    {
+        return;
+    }
+
+    m_statistics.frames = m_frames;
+    m_statistics.meanScale = m_scaleSum / m_frames;
+    m_statistics.minimumScale = m_scaleMinimum;
+    m_statistics.meanFrameTime = m_sum / m_frames;
+    m_statistics.frameTimeDeviation = sqrt(max(m_sumOfSquares / m_frames - m_statistics.meanFrameTime * m_statistics.meanFrameTime, 0.0));
+    m_statistics.meanUnscaledFrameTime = m_unscaledSum / m_frames;
+    m_statistics.unscaledFrameTimeDeviation = sqrt(max(m_unscaledSumOfSquares / m_frames -
+                                                       m_statistics.meanUnscaledFrameTime * m_statistics.meanUnscaledFrameTime, 0.0));
+    m_statistics.framesOverBudget = m_overBudget;
+    m_statistics.unscaledFramesOverBudget = m_unscaledOverBudget;
+    m_newStatistics = true;
+
+    m_frames = 0;
+    m_scaleSum = 0.0;
+    m_scaleMinimum = m_settings.maximumScale;
+    m_sum = m_sumOfSquares = m_unscaledSum = m_unscaledSumOfSquares = 0.0;
+    m_overBudget = m_unscaledOverBudget = 0;
+}
+
+DynamicResolutionClass::Statistics DynamicResolutionClass::Validate()
+{
+    // Frames cost 1 ms whatever the resolution, plus a load at full resolution that scales with the pixels, with a few
+    // percent of noise. Their times come back three frames late, like GPU timestamps do.
+    const double fixedCost = 0.001;
+    const unsigned int delay = 3;
+    Settings settings = GetDefaultSettings();
+    settings.fixedCost = fixedCost;
+    unsigned int seed = 12345;
+    auto run = [&](DynamicResolutionClass& controller, const unsigned int frameCount, const function<double(unsigned int)>& load)
+    {
+        double pendingSeconds[delay];
+        float pendingScales[delay];
+        for (unsigned int frame = 0; frame < frameCount + delay; frame++)
+        {
+            unsigned int slot = frame % delay;
+            if (frame >= delay)
+            {
+                float next = controller.Update(pendingSeconds[slot], pendingScales[slot]);
+                if (next < settings.minimumScale || next > settings.maximumScale)
+                {
+                    throw engine_exception("Dynamic resolution validation: scale ") << next << " out of range";
+                }
+            }
+
+            if (frame < frameCount)
+            {
+                seed = seed * 1664525 + 1013904223;
+                double noise = 1.0 + ((double)(seed >> 16) / 65535.0 - 0.5) * 0.06;
+                float scale = controller.GetScale();
+                pendingSeconds[slot] = (fixedCost + load(frame) * scale * scale) * noise;
+                pendingScales[slot] = scale;
+            }
+        }
+    };
+
+    // A steady load half as much again as the budget settles just under it, with no more spread than the noise.
+    DynamicResolutionClass controller;
+    controller.Initialize(settings);
+    run(controller, 600, [](unsigned int) { return 0.024; });
+    const Statistics& steady = controller.GetStatistics();
+    if (steady.meanFrameTime > settings.budget || steady.meanFrameTime < 0.85 * settings.budget ||
+        steady.meanFrameTime + 2.0 * steady.frameTimeDeviation > 1.05 * settings.budget)
+    {
+        throw engine_exception("Dynamic resolution validation: a steady load settled at ") << steady.meanFrameTime * 1000.0 << " ms, deviation "
+                                                                                          << steady.frameTimeDeviation * 1000.0 << " ms";
+    }
+
+    // A light load gets back to full resolution.
+    run(controller, 240, [](unsigned int) { return 0.008; });
+    if (controller.GetScale() != (float)settings.maximumScale)
+    {
+        throw engine_exception("Dynamic resolution validation: a light load stayed at scale ") << controller.GetScale();
+    }
+
+    // A load that swells past the budget and back again goes over it on at most half the frames it would have unscaled;
+    // once settled on the budget, the noise alone puts about half the frames over it.
+    controller.Initialize(settings);
+    unsigned int overBudget = 0, unscaledOverBudget = 0;
+    for (unsigned int window = 0; window < 10; window++)
+    {
+        run(controller, STATISTICS_FRAMES, [window](unsigned int frame)
+        {
+            return 0.012 + 0.012 * sin(2.0 * 3.14159265358979 * (window * STATISTICS_FRAMES + frame) / 600.0);
+        });
+        overBudget += controller.GetStatistics().framesOverBudget;
+        unscaledOverBudget += controller.GetStatistics().unscaledFramesOverBudget;
+    }
+    if (overBudget * 2 > unscaledOverBudget)
+    {
+        throw engine_exception("Dynamic resolution validation: a swelling load had ") << overBudget << " frames over budget, "
+                                                                                       << unscaledOverBudget << " unscaled";
+    }
+
+    // Bursts of 30 frames at almost twice the budget every 90 frames; scaling should take out most of the variance, and
+    // some of the frames over budget despite the first few of each burst going out before their times come back.
+    controller.Initialize(settings);
+    auto spikeLoad = [](unsigned int frame) { return frame % 90 < 30 ? 0.028 : 0.010; };
+    run(controller, 720, spikeLoad);
+    Statistics spikes = controller.GetStatistics();
+    if (spikes.GetVarianceRemoved() < 0.6 || spikes.framesOverBudget >= spikes.unscaledFramesOverBudget)
+    {
+        throw engine_exception("Dynamic resolution validation: spikes kept ") << (1.0 - spikes.GetVarianceRemoved()) * 100.0 << "% of the variance and "
+                                                                             << spikes.framesOverBudget << " of " << spikes.unscaledFramesOverBudget
+                                                                             << " frames over budget";
+    }
+
+    // The unscaled estimate of the last window should be the time its frames would really have taken at full resolution,
+    // to within the noise, rather than the fixed cost scaled up with the rest.
+    double unscaledMean = 0.0;
+    for (unsigned int frame = 720 - STATISTICS_FRAMES; frame < 720; frame++)
+    {
+        unscaledMean += (fixedCost + spikeLoad(frame)) / STATISTICS_FRAMES;
+    }
+    if (fabs(spikes.meanUnscaledFrameTime - unscaledMean) > 0.02 * unscaledMean)
+    {
+        throw engine_exception("Dynamic resolution validation: estimated ") << spikes.meanUnscaledFrameTime * 1000.0 << " ms per frame unscaled, "
+                                                                           << unscaledMean * 1000.0 << " ms expected";
+    }
+
+    return spikes;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "engine_exception.h"
+
+// Picks the fraction of the back buffer the scene renders at from measured frame times, so a frame that goes over its
+// budget costs resolution instead of a dropped frame. The cost of a frame is taken to be a fixed part plus one that grows
+// with its pixels, i.e. the square of the scale. Rises in cost are taken at once and falls are smoothed, and the scale moves a damped step towards
+// the one that would fit the budget, faster down than up, so it doesn't hunt. Nothing here touches Windows or D3D, so the
+// controller can be driven by frame time traces anywhere.
+class DynamicResolutionClass
+{
+public:
+    struct Settings
+    {
+        // Seconds the frame should take, with some headroom below the refresh period.
+        double budget;
+        // Seconds of each timed frame that don't depend on the resolution, such as clears of the full back buffer and
+        // draw submission; only the rest is scaled. Must be under the budget.
+        double fixedCost;
+        double minimumScale;
+        double maximumScale;
+        // Fraction of the way to the scale that fits the budget moved each frame, when lowering and raising it.
+        double decreaseRate;
+        double increaseRate;
+        // Weight of each new frame in the cost estimate once cost is falling.
+        double smoothing;
+    };
+
+    // Over the last statistics window. The unscaled frame time is an estimate of what the frames would have taken at the
+    // maximum scale, from the same cost model, so it is only as good as the fixed cost in the settings.
+    struct Statistics
+    {
+        unsigned int frames;
+        double meanScale, minimumScale;
+        double meanFrameTime, frameTimeDeviation;
+        double meanUnscaledFrameTime, unscaledFrameTimeDeviation;
+        unsigned int framesOverBudget, unscaledFramesOverBudget;
+
+        // Fraction of the frame time variance that scaling removed.
+        double GetVarianceRemoved() const;
+    };
+
+    static const unsigned int STATISTICS_FRAMES = 120;
+
+    DynamicResolutionClass();
+
+    ~DynamicResolutionClass();
+
+    // Budget for 60 Hz, half to full resolution, with all of the frame scaling.
+    static Settings GetDefaultSettings();
+
+    // Starts at the maximum scale.
+    void Initialize(const Settings& settings);
+
+    // Takes the time of a frame rendered at frameScale, which is an earlier GetScale when times come back a few frames
+    // late, and returns the scale for the next one.
+    float Update(const double frameSeconds, const float frameScale);
+
+    float GetScale();
+
+    // True once per statistics window, when Update has just completed one.
+    bool HasNewStatistics();
+
+    const Statistics& GetStatistics();
+
+    // Runs the controller on synthetic traces with a known cost model: steady loads over and under budget, spikes and
+    // a slow swell. Checks that it settles on the budget, recovers full resolution, stays in range and estimates the
+    // unscaled frame time, and returns the statistics of the spike trace. Throws on a failure.
+    static Statistics Validate();
+
+private:
+    // Scale changes smaller than this are left out, so the viewport isn't changed for nothing.
+    static const double SCALE_STEP;
+
+    Settings m_settings;
+    float m_scale;
+    // Estimated seconds per frame at a scale of 1, less the fixed cost.
+    double m_cost;
+    bool m_started;
+
+    unsigned int m_frames;
+    double m_scaleSum, m_scaleMinimum;
+    double m_sum, m_sumOfSquares, m_unscaledSum, m_unscaledSumOfSquares;
+    unsigned int m_overBudget, m_unscaledOverBudget;
+    Statistics m_statistics;
+    bool m_newStatistics;
+
+    void Accumulate(const double frameSeconds, const float frameScale);
+};
@@ -6,7 +6,5 @@
 #include <dxgi.h>
 #include <d3dcommon.h>
 #include <d3d11.h>
-#include <DirectXMath.h>
-#include <memory>
 #include <client.h>
-#include "engine_exception.h"
\ No newline at end of file
+#include "engine_core.h"
\ No newline at end of file
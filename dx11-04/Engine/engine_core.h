@@ -0,0 +1,11 @@
+#pragma once
+
+// What the platform independent part of the engine is written against: DirectXMath, engine_exception, the log, the
+// profiler and the platform shim. Classes that include this rather than engine.h don't touch Windows or D3D, so they
+// also build into the tests and tools on Linux.
+#include "platform.h"
+#include <DirectXMath.h>
+#include <memory>
+#include "engine_exception.h"
+#include "profilerclass.h"
+#include "logclass.h"
@@ -1,4 +1,6 @@
 #include "engine_exception.h"
+#include "platform.h"
+#include <cstdio>
 
 engine_exception::engine_exception(const engine_exception& from) : runtime_error("")
 {
@@ -15,7 +17,69 @@ engine_exception::engine_exception(const char* message) : runtime_error("")
     this->m_Message += string(message);
 }
 
-const char* engine_exception::what() const
+const char* engine_exception::what() const throw()
 {
     return m_Message.c_str();
-}
\ No newline at end of file
+}
+
+engine_exception& engine_exception::operator<< (const char* text)
+{
+    m_Message += text;
+    return *this;
+}
+
+engine_exception& engine_exception::operator<< (const string& text)
+{
+    m_Message += text;
+    return *this;
+}
+
+engine_exception& engine_exception::operator<< (const int value)
+{
+    return *this << (long long)value;
+}
+
+engine_exception& engine_exception::operator<< (const unsigned int value)
+{
+    return *this << (unsigned long long)value;
+}
+
+engine_exception& engine_exception::operator<< (const long value)
+{
+    return *this << (long long)value;
+}
+
+engine_exception& engine_exception::operator<< (const unsigned long value)
+{
+    return *this << (unsigned long long)value;
+}
+
+engine_exception& engine_exception::operator<< (const long long value)
+{
+    char text[32];
+    sprintf_s(text, "%lld", value);
+    m_Message += text;
+    return *this;
+}
+
+engine_exception& engine_exception::operator<< (const unsigned long long value)
+{
+    char text[32];
+    sprintf_s(text, "%llu", value);
+    m_Message += text;
+    return *this;
+}
+
+engine_exception& engine_exception::operator<< (const float value)
+{
+    return *this << (double)value;
+}
+
+engine_exception& engine_exception::operator<< (const double value)
+{
+    // The same six significant digits a stream would write.
+    char text[32];
+    sprintf_s(text, "%g", value);
+    m_Message += text;
+    return *this;
+}
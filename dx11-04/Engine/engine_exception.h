@@ -11,7 +11,19 @@ public:
     engine_exception(const engine_exception& from);
     explicit engine_exception(const std::string& message);
     explicit engine_exception(const char* message);
-    const char* what() const override;
+    const char* what() const throw() override;
+
+    // Strings and numbers are appended directly; anything else goes through a stream.
+    engine_exception& operator<< (const char* text);
+    engine_exception& operator<< (const string& text);
+    engine_exception& operator<< (const int value);
+    engine_exception& operator<< (const unsigned int value);
+    engine_exception& operator<< (const long value);
+    engine_exception& operator<< (const unsigned long value);
+    engine_exception& operator<< (const long long value);
+    engine_exception& operator<< (const unsigned long long value);
+    engine_exception& operator<< (const float value);
+    engine_exception& operator<< (const double value);
 
     template<typename T>
     engine_exception& operator<< (const T& t)
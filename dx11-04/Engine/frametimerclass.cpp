@@ -0,0 +1,311 @@
+#include "frametimerclass.h"
+#include <thread>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    // Sleep can overshoot by a scheduler quantum, so it hands over to spinning this early. A waitable timer is accurate
+    // enough to need only an allowance for waking up.
+    const double SLEEP_MARGIN = 0.002;
+    const double TIMER_MARGIN = 0.0002;
+
+#ifdef _WIN32
+    // CREATE_WAITABLE_TIMER_HIGH_RESOLUTION arrived with Windows 10, after the SDK this builds against. Older systems
+    // refuse the flag and the timer falls back to Sleep.
+    const DWORD WAITABLE_TIMER_HIGH_RESOLUTION = 0x00000002;
+#endif
+}
+
+FrameTimerClass::FrameTimerClass()
+{
+    m_stepTicks = 1;
+    m_frameTicks = 0;
+    m_limiterMode = LIMITER_NONE;
+    m_frameStart = m_deadline = 0;
+    m_accumulator = 0;
+    m_lastFrameTicks = 0;
+    m_started = false;
+    m_sum = m_sumOfSquares = m_worst = 0.0;
+    m_totalSteps = 0;
+    m_frames = 0;
+    m_meanFrameTime = m_frameTimeDeviation = 0.0;
+}
+
+FrameTimerClass::~FrameTimerClass()
+{
+}
+
+FrameTimerClass::Clock FrameTimerClass::GetSystemClock()
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    long long ticksPerSecond = frequency.QuadPart;
+
+    Clock clock;
+    clock.frequency = ticksPerSecond;
+    clock.now = []()
+    {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    };
+    clock.sleep = [ticksPerSecond](long long ticks)
+    {
+        Sleep((DWORD)(ticks * 1000 / ticksPerSecond));
+    };
+
+#ifdef _WIN32
+    // High resolution timers arrived in Windows 10 1803; before that an ordinary timer is no better than Sleep.
+    HANDLE timer = CreateWaitableTimerExW(NULL, NULL, WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (timer == NULL)
+    {
+        LOG_INFO("Frame timer: no high resolution waitable timer, falling back to Sleep");
+        clock.wait = clock.sleep;
+        return clock;
+    }
+
+    shared_ptr<void> timerHandle(timer, CloseHandle);
+    clock.wait = [timerHandle, ticksPerSecond](long long ticks)
+    {
+        // A negative due time is relative, in 100 ns units.
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -(ticks * 10000000 / ticksPerSecond);
+        if (SetWaitableTimer(timerHandle.get(), &dueTime, 0, NULL, NULL, FALSE))
+        {
+            WaitForSingleObject(timerHandle.get(), INFINITE);
+        }
+    };
+#else
+    clock.wait = [ticksPerSecond](long long ticks)
+    {
+        this_thread::sleep_for(chrono::duration<double>((double)ticks / ticksPerSecond));
+    };
+#endif
+    return clock;
+}
+
+void FrameTimerClass::Initialize(const Clock& clock, const double updateRate, const double frameRateLimit, const LimiterMode limiterMode)
+{
+    if (updateRate <= 0.0)
+    {
+        throw engine_exception("Frame timer update rate must be positive, not ") << updateRate;
+    }
+
+    m_clock = clock;
+    m_stepTicks = max((long long)((double)clock.frequency / updateRate + 0.5), 1LL);
+    m_frameTicks = frameRateLimit > 0.0 ? (long long)((double)clock.frequency / frameRateLimit + 0.5) : 0;
+    m_limiterMode = m_frameTicks > 0 ? limiterMode : LIMITER_NONE;
+    m_accumulator = 0;
+    m_started = false;
+    m_sum = m_sumOfSquares = m_worst = 0.0;
+    m_totalSteps = 0;
+    m_frames = 0;
+}
+
+void FrameTimerClass::BeginFrame()
+{
+    long long now = m_clock.now();
+    if (!m_started)
+    {
+        m_frameStart = m_deadline = now;
+        m_lastFrameTicks = 0;
+        m_started = true;
+        return;
+    }
+
+    m_lastFrameTicks = now - m_frameStart;
+    m_frameStart = now;
+    m_accumulator += min(m_lastFrameTicks, MAX_CATCH_UP_STEPS * m_stepTicks);
+
+    double seconds = GetFrameTime();
+    m_sum += seconds;
+    m_sumOfSquares += seconds * seconds;
+    m_worst = max(m_worst, seconds);
+
+    if (++m_frames == STATISTICS_FRAMES)
+    {
+        m_meanFrameTime = m_sum / m_frames;
+        m_frameTimeDeviation = sqrt(max(m_sumOfSquares / m_frames - m_meanFrameTime * m_meanFrameTime, 0.0));
+
+        LOG_INFO("Frame pacing: {} ms mean, {} ms deviation, {} ms worst, {} updates per frame", m_meanFrameTime * 1000.0,
+                 m_frameTimeDeviation * 1000.0, m_worst * 1000.0, (double)m_totalSteps / m_frames);
+
+        m_sum = m_sumOfSquares = m_worst = 0.0;
+        m_totalSteps = 0;
+        m_frames = 0;
+    }
+}
+
+bool FrameTimerClass::Step()
+{
+    if (m_accumulator < m_stepTicks)
+    {
+        return false;
+    }
+
+    m_accumulator -= m_stepTicks;
+    m_totalSteps++;
+    return true;
+}
+
+double FrameTimerClass::GetTimestep()
+{
+    return (double)m_stepTicks / m_clock.frequency;
+}
+
+float FrameTimerClass::GetInterpolation()
+{
+    return (float)m_accumulator / (float)m_stepTicks;
+}
+
+void FrameTimerClass::EndFrame()
+{
+    PROFILE_FUNCTION();
+
+    if (m_limiterMode == LIMITER_NONE)
+    {
+        return;
+    }
+
+    // Frames are paced against a running deadline, so waking up a little late doesn't shift every frame after it. A
+    // frame that overran moves the deadline to now instead of rushing the next ones to catch up.
+    m_deadline += m_frameTicks;
+    if (m_clock.now() >= m_deadline)
+    {
+        m_deadline = m_clock.now();
+        return;
+    }
+
+    WaitUntil(m_deadline);
+}
+
+void FrameTimerClass::WaitUntil(const long long deadline)
+{
+    long long remaining = deadline - m_clock.now();
+    if (m_limiterMode == LIMITER_WAITABLE_TIMER)
+    {
+        long long margin = (long long)(TIMER_MARGIN * m_clock.frequency);
+        if (remaining > margin)
+        {
+            m_clock.wait(remaining - margin);
+        }
+    }
+    else
+    {
+        long long margin = (long long)(SLEEP_MARGIN * m_clock.frequency);
+        if (remaining > margin)
+        {
+            m_clock.sleep(remaining - margin);
+        }
+    }
+
+    // Spin out the rest.
+    while (m_clock.now() < deadline)
+    {
+        this_thread::yield();
+    }
+}
+
+double FrameTimerClass::GetFrameTime()
+{
+    return (double)m_lastFrameTicks / m_clock.frequency;
+}
+
+double FrameTimerClass::GetMeanFrameTime()
+{
+    return m_meanFrameTime;
+}
+
+double FrameTimerClass::GetFrameTimeDeviation()
+{
+    return m_frameTimeDeviation;
+}
+
+void FrameTimerClass::Validate()
+{
+    // A microsecond clock that ticks on every read, so spinning terminates. Sleep overshoots by a millisecond and the
+    // timer by 0.1 ms, and both are counted to check the limiter picked the right one.
+    long long time = 0;
+    int sleeps = 0, waits = 0;
+    Clock clock;
+    clock.frequency = 1000000;
+    clock.now = [&time]() { return time++; };
+    clock.sleep = [&time, &sleeps](long long ticks) { time += ticks + 1000; sleeps++; };
+    clock.wait = [&time, &waits](long long ticks) { time += ticks + 100; waits++; };
+
+    // Unlimited: every tick of frame time turns into steps or stays in the accumulator, whatever the frame costs.
+    FrameTimerClass timer;
+    timer.Initialize(clock, 60.0, 0.0, LIMITER_SLEEP_SPIN);
+    unsigned int seed = 12345;
+    long long elapsed = 0, steps = 0;
+    timer.BeginFrame();
+    long long start = timer.m_frameStart;
+    for (int frame = 0; frame < 1000; frame++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        time += 3000 + (seed >> 16) % 40000;
+        timer.EndFrame();
+        timer.BeginFrame();
+        while (timer.Step())
+        {
+            steps++;
+        }
+
+        float interpolation = timer.GetInterpolation();
+        if (interpolation < 0.0f || interpolation >= 1.0f)
+        {
+            throw engine_exception("Frame timer validation: interpolation out of range, ") << interpolation;
+        }
+    }
+    elapsed = timer.m_frameStart - start;
+    if (steps * timer.m_stepTicks + timer.m_accumulator != elapsed || sleeps != 0 || waits != 0)
+    {
+        throw engine_exception("Frame timer validation: ") << steps << " steps for " << elapsed << " us of unlimited frames";
+    }
+
+    // A one second hitch is caught up on for at most MAX_CATCH_UP_STEPS steps.
+    time += 1000000;
+    timer.BeginFrame();
+    steps = 0;
+    while (timer.Step())
+    {
+        steps++;
+    }
+    if (steps > MAX_CATCH_UP_STEPS)
+    {
+        throw engine_exception("Frame timer validation: caught up on a hitch with ") << steps << " steps";
+    }
+
+    // Limited to 100 Hz, frames cheaper than the limit are held to 10 ms, and dearer ones run at their own pace.
+    const LimiterMode modes[2] = { LIMITER_SLEEP_SPIN, LIMITER_WAITABLE_TIMER };
+    const long long frameCosts[2] = { 3000, 15000 };
+    for (int mode = 0; mode < 2; mode++)
+    {
+        for (int cost = 0; cost < 2; cost++)
+        {
+            sleeps = waits = 0;
+            timer.Initialize(clock, 60.0, 100.0, modes[mode]);
+            for (int frame = 0; frame <= STATISTICS_FRAMES; frame++)
+            {
+                timer.BeginFrame();
+                while (timer.Step())
+                {
+                }
+                time += frameCosts[cost];
+                timer.EndFrame();
+            }
+
+            double expected = max(frameCosts[cost], 10000LL) / 1000000.0;
+            bool limited = frameCosts[cost] < 10000;
+            bool usedExpectedWait = modes[mode] == LIMITER_SLEEP_SPIN ? waits == 0 && (sleeps > 0) == limited : sleeps == 0 && (waits > 0) == limited;
+            if (fabs(timer.GetMeanFrameTime() - expected) > 0.00001 || timer.GetFrameTimeDeviation() > 0.00001 || !usedExpectedWait)
+            {
+                throw engine_exception("Frame timer validation: limiter mode ") << (int)modes[mode] << " paced " << frameCosts[cost] << " us frames at "
+                                                                                << timer.GetMeanFrameTime() * 1000000.0 << " us";
+            }
+        }
+    }
+
+    LOG_INFO("Frame timer validation passed");
+}
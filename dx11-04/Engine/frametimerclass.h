@@ -0,0 +1,90 @@
+#pragma once
+#include "engine_core.h"
+#include <functional>
+
+using namespace std;
+
+// Fixed timestep clock for the main loop. BeginFrame measures the time since the previous frame and adds it to an
+// accumulator that Step drains one simulation step at a time, so the simulation advances at the same rate whatever the
+// frame rate; GetInterpolation says how far the renderer is between the last two steps. EndFrame then holds the loop to
+// the frame rate limit, either on a high resolution waitable timer or by sleeping most of the way and spinning the rest.
+// All timing goes through a Clock, so the pacing can be driven by a fake one.
+class FrameTimerClass
+{
+public:
+    enum LimiterMode
+    {
+        LIMITER_NONE,
+        LIMITER_WAITABLE_TIMER,
+        LIMITER_SLEEP_SPIN
+    };
+
+    // Times are in ticks of frequency per second. sleep may wake up to a scheduler quantum late; wait should be accurate
+    // to well under a millisecond.
+    struct Clock
+    {
+        function<long long()> now;
+        function<void(long long)> sleep;
+        function<void(long long)> wait;
+        long long frequency;
+    };
+
+    FrameTimerClass();
+
+    ~FrameTimerClass();
+
+    // QueryPerformanceCounter with Sleep, and a high resolution waitable timer where Windows has them; elsewhere waiting
+    // is a nanosecond sleep_for.
+    static Clock GetSystemClock();
+
+    // A frame rate limit of zero leaves pacing to the caller (e.g. vsync).
+    void Initialize(const Clock& clock, const double updateRate, const double frameRateLimit, const LimiterMode limiterMode);
+
+    void BeginFrame();
+
+    // True while a whole simulation step is waiting; every call consumes one.
+    bool Step();
+
+    // Seconds per simulation step.
+    double GetTimestep();
+
+    // Fraction of a step between the last simulation state and now, in [0, 1).
+    float GetInterpolation();
+
+    // Waits out the rest of the frame when there is a frame rate limit and writes the pacing statistics periodically.
+    void EndFrame();
+
+    // Seconds between the last two BeginFrame calls.
+    double GetFrameTime();
+
+    // Mean and standard deviation of the frame time over the last statistics window, in seconds.
+    double GetMeanFrameTime();
+
+    double GetFrameTimeDeviation();
+
+    // Steps a fake clock through frames of varying cost and checks the step count, interpolation and limiter. Throws on a failure.
+    static void Validate();
+
+private:
+    static const int STATISTICS_FRAMES = 120;
+    // Longest hitch the simulation catches up on, in steps; time beyond it is dropped rather than stepped through.
+    static const int MAX_CATCH_UP_STEPS = 8;
+
+    Clock m_clock;
+    long long m_stepTicks;
+    long long m_frameTicks;
+    LimiterMode m_limiterMode;
+
+    long long m_frameStart;
+    long long m_deadline;
+    long long m_accumulator;
+    long long m_lastFrameTicks;
+    bool m_started;
+
+    double m_sum, m_sumOfSquares, m_worst;
+    int m_totalSteps;
+    int m_frames;
+    double m_meanFrameTime, m_frameTimeDeviation;
+
+    void WaitUntil(const long long deadline);
+};
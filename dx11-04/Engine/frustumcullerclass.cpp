@@ -0,0 +1,416 @@
+#include "frustumcullerclass.h"
+#include "engine_core.h"
+
+namespace
+{
+    // The few vector operations the batched tests need, BATCH_SIZE lanes wide.
+#ifdef __AVX__
+    typedef __m256 FloatBatch;
+
+    inline FloatBatch Load(const float* values) { return _mm256_loadu_ps(values); }
+    inline FloatBatch Splat(const float value) { return _mm256_set1_ps(value); }
+    inline FloatBatch Add(const FloatBatch a, const FloatBatch b) { return _mm256_add_ps(a, b); }
+    inline FloatBatch Mul(const FloatBatch a, const FloatBatch b) { return _mm256_mul_ps(a, b); }
+    inline FloatBatch And(const FloatBatch a, const FloatBatch b) { return _mm256_and_ps(a, b); }
+    inline FloatBatch GreaterEqual(const FloatBatch a, const FloatBatch b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    inline FloatBatch AllTrue() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+    inline unsigned int MoveMask(const FloatBatch a) { return (unsigned int)_mm256_movemask_ps(a); }
+#else
+    typedef __m128 FloatBatch;
+
+    inline FloatBatch Load(const float* values) { return _mm_loadu_ps(values); }
+    inline FloatBatch Splat(const float value) { return _mm_set1_ps(value); }
+    inline FloatBatch Add(const FloatBatch a, const FloatBatch b) { return _mm_add_ps(a, b); }
+    inline FloatBatch Mul(const FloatBatch a, const FloatBatch b) { return _mm_mul_ps(a, b); }
+    inline FloatBatch And(const FloatBatch a, const FloatBatch b) { return _mm_and_ps(a, b); }
+    inline FloatBatch GreaterEqual(const FloatBatch a, const FloatBatch b) { return _mm_cmpge_ps(a, b); }
+    inline FloatBatch AllTrue() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+    inline unsigned int MoveMask(const FloatBatch a) { return (unsigned int)_mm_movemask_ps(a); }
+#endif
+
+    // Appends base + lane for every set bit. All BATCH_SIZE slots are written and the count only advances past the
+    // visible ones, which avoids a branch per object; the caller's array is padded so the extra writes stay in bounds.
+    inline unsigned int Compact(unsigned int* visible, unsigned int visibleCount, const unsigned int base, const unsigned int bits)
+    {
+        for (unsigned int lane = 0; lane < FrustumCullerClass::BATCH_SIZE; lane++)
+        {
+            visible[visibleCount] = base + lane;
+            visibleCount += (bits >> lane) & 1;
+        }
+        return visibleCount;
+    }
+
+    // Clears the bits of padding lanes in the last batch.
+    inline unsigned int TailMask(const unsigned int base, const unsigned int count)
+    {
+        unsigned int remaining = count - base;
+        return remaining >= FrustumCullerClass::BATCH_SIZE ? ~0u : (1u << remaining) - 1;
+    }
+
+    void GrowTo(vector<float>& values, const unsigned int count)
+    {
+        if (values.size() < count)
+        {
+            values.resize(count, 0.0f);
+        }
+    }
+
+    unsigned int RoundUpToBatch(const unsigned int count)
+    {
+        return (count + FrustumCullerClass::BATCH_SIZE - 1) / FrustumCullerClass::BATCH_SIZE * FrustumCullerClass::BATCH_SIZE;
+    }
+
+    float Random(unsigned int& seed)
+    {
+        seed = seed * 1664525 + 1013904223;
+        return (float)(seed >> 8) / 16777216.0f;
+    }
+}
+
+FrustumCullerClass::FrustumCullerClass()
+{
+    m_sphereCount = m_boxCount = 0;
+    for (int i = 0; i < 6; i++)
+    {
+        m_planes[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+}
+
+FrustumCullerClass::~FrustumCullerClass()
+{
+}
+
+void FrustumCullerClass::SetFrustum(const XMMATRIX& view, const XMMATRIX& projection)
+{
+    // With row vectors clip = v * M, so the planes come from the columns of M: -w <= x <= w, -w <= y <= w, 0 <= z <= w.
+    XMMATRIX columns = XMMatrixTranspose(XMMatrixMultiply(view, projection));
+
+    XMVECTOR planes[6];
+    planes[0] = XMVectorAdd(columns.r[3], columns.r[0]);      // Left.
+    planes[1] = XMVectorSubtract(columns.r[3], columns.r[0]); // Right.
+    planes[2] = XMVectorAdd(columns.r[3], columns.r[1]);      // Bottom.
+    planes[3] = XMVectorSubtract(columns.r[3], columns.r[1]); // Top.
+    planes[4] = columns.r[2];                                 // Near.
+    planes[5] = XMVectorSubtract(columns.r[3], columns.r[2]); // Far.
+
+    // Normalized planes give true distances, which the sphere radii are compared against.
+    for (int i = 0; i < 6; i++)
+    {
+        XMStoreFloat4(&m_planes[i], XMPlaneNormalize(planes[i]));
+    }
+}
+
+void FrustumCullerClass::Clear()
+{
+    m_sphereCount = m_boxCount = 0;
+    m_sphereX.clear();
+    m_sphereY.clear();
+    m_sphereZ.clear();
+    m_sphereRadius.clear();
+    m_boxX.clear();
+    m_boxY.clear();
+    m_boxZ.clear();
+    m_boxExtentX.clear();
+    m_boxExtentY.clear();
+    m_boxExtentZ.clear();
+}
+
+void FrustumCullerClass::Reserve(const unsigned int sphereCount, const unsigned int boxCount)
+{
+    unsigned int spheres = RoundUpToBatch(sphereCount);
+    m_sphereX.reserve(spheres);
+    m_sphereY.reserve(spheres);
+    m_sphereZ.reserve(spheres);
+    m_sphereRadius.reserve(spheres);
+
+    unsigned int boxes = RoundUpToBatch(boxCount);
+    m_boxX.reserve(boxes);
+    m_boxY.reserve(boxes);
+    m_boxZ.reserve(boxes);
+    m_boxExtentX.reserve(boxes);
+    m_boxExtentY.reserve(boxes);
+    m_boxExtentZ.reserve(boxes);
+}
+
+unsigned int FrustumCullerClass::AddSphere(const XMFLOAT3& center, const float radius)
+{
+    // The arrays always hold whole batches so the last one can be loaded without a scalar tail.
+    unsigned int padded = RoundUpToBatch(m_sphereCount + 1);
+    GrowTo(m_sphereX, padded);
+    GrowTo(m_sphereY, padded);
+    GrowTo(m_sphereZ, padded);
+    GrowTo(m_sphereRadius, padded);
+
+    m_sphereX[m_sphereCount] = center.x;
+    m_sphereY[m_sphereCount] = center.y;
+    m_sphereZ[m_sphereCount] = center.z;
+    m_sphereRadius[m_sphereCount] = radius;
+    return m_sphereCount++;
+}
+
+unsigned int FrustumCullerClass::AddBox(const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+    unsigned int padded = RoundUpToBatch(m_boxCount + 1);
+    GrowTo(m_boxX, padded);
+    GrowTo(m_boxY, padded);
+    GrowTo(m_boxZ, padded);
+    GrowTo(m_boxExtentX, padded);
+    GrowTo(m_boxExtentY, padded);
+    GrowTo(m_boxExtentZ, padded);
+
+    m_boxX[m_boxCount] = center.x;
+    m_boxY[m_boxCount] = center.y;
+    m_boxZ[m_boxCount] = center.z;
+    m_boxExtentX[m_boxCount] = extents.x;
+    m_boxExtentY[m_boxCount] = extents.y;
+    m_boxExtentZ[m_boxCount] = extents.z;
+    return m_boxCount++;
+}
+
+unsigned int FrustumCullerClass::CullSpheres(unsigned int* visible)
+{
+    PROFILE_FUNCTION();
+
+    // Planes are splatted into locals rather than kept as members; a heap allocated object is only 8 byte aligned on Win32.
+    FloatBatch planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int i = 0; i < 6; i++)
+    {
+        planeX[i] = Splat(m_planes[i].x);
+        planeY[i] = Splat(m_planes[i].y);
+        planeZ[i] = Splat(m_planes[i].z);
+        planeW[i] = Splat(m_planes[i].w);
+    }
+
+    unsigned int visibleCount = 0;
+    for (unsigned int base = 0; base < m_sphereCount; base += BATCH_SIZE)
+    {
+        FloatBatch x = Load(&m_sphereX[base]);
+        FloatBatch y = Load(&m_sphereY[base]);
+        FloatBatch z = Load(&m_sphereZ[base]);
+        FloatBatch negativeRadius = Mul(Load(&m_sphereRadius[base]), Splat(-1.0f));
+
+        // Visible unless the centre is more than a radius behind one of the planes.
+        FloatBatch inside = AllTrue();
+        for (int i = 0; i < 6; i++)
+        {
+            FloatBatch distance = Add(Add(Add(Mul(planeX[i], x), Mul(planeY[i], y)), Mul(planeZ[i], z)), planeW[i]);
+            inside = And(inside, GreaterEqual(distance, negativeRadius));
+        }
+
+        unsigned int bits = MoveMask(inside) & TailMask(base, m_sphereCount);
+        visibleCount = Compact(visible, visibleCount, base, bits);
+    }
+    return visibleCount;
+}
+
+unsigned int FrustumCullerClass::CullBoxes(unsigned int* visible)
+{
+    PROFILE_FUNCTION();
+
+    FloatBatch planeX[6], planeY[6], planeZ[6], planeW[6];
+    FloatBatch absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+    for (int i = 0; i < 6; i++)
+    {
+        planeX[i] = Splat(m_planes[i].x);
+        planeY[i] = Splat(m_planes[i].y);
+        planeZ[i] = Splat(m_planes[i].z);
+        planeW[i] = Splat(m_planes[i].w);
+        absPlaneX[i] = Splat(fabsf(m_planes[i].x));
+        absPlaneY[i] = Splat(fabsf(m_planes[i].y));
+        absPlaneZ[i] = Splat(fabsf(m_planes[i].z));
+    }
+
+    FloatBatch zero = Splat(0.0f);
+    unsigned int visibleCount = 0;
+    for (unsigned int base = 0; base < m_boxCount; base += BATCH_SIZE)
+    {
+        FloatBatch x = Load(&m_boxX[base]);
+        FloatBatch y = Load(&m_boxY[base]);
+        FloatBatch z = Load(&m_boxZ[base]);
+        FloatBatch extentX = Load(&m_boxExtentX[base]);
+        FloatBatch extentY = Load(&m_boxExtentY[base]);
+        FloatBatch extentZ = Load(&m_boxExtentZ[base]);
+
+        // The box reaches |n| . extents along the plane normal, so it is outside once the centre is further behind than that.
+        FloatBatch inside = AllTrue();
+        for (int i = 0; i < 6; i++)
+        {
+            FloatBatch distance = Add(Add(Add(Mul(planeX[i], x), Mul(planeY[i], y)), Mul(planeZ[i], z)), planeW[i]);
+            FloatBatch reach = Add(Add(Mul(absPlaneX[i], extentX), Mul(absPlaneY[i], extentY)), Mul(absPlaneZ[i], extentZ));
+            inside = And(inside, GreaterEqual(Add(distance, reach), zero));
+        }
+
+        unsigned int bits = MoveMask(inside) & TailMask(base, m_boxCount);
+        visibleCount = Compact(visible, visibleCount, base, bits);
+    }
+    return visibleCount;
+}
+
+unsigned int FrustumCullerClass::GetPaddedSphereCount()
+{
+    return RoundUpToBatch(m_sphereCount);
+}
+
+unsigned int FrustumCullerClass::GetPaddedBoxCount()
+{
+    return RoundUpToBatch(m_boxCount);
+}
+
+bool FrustumCullerClass::IsSphereVisible(const unsigned int index)
+{
+    // Same operations in the same order as the batched test, so the two agree exactly.
+    float negativeRadius = m_sphereRadius[index] * -1.0f;
+    for (int i = 0; i < 6; i++)
+    {
+        const XMFLOAT4& plane = m_planes[i];
+        float distance = plane.x * m_sphereX[index] + plane.y * m_sphereY[index] + plane.z * m_sphereZ[index] + plane.w;
+        if (!(distance >= negativeRadius))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FrustumCullerClass::IsBoxVisible(const unsigned int index)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        const XMFLOAT4& plane = m_planes[i];
+        float distance = plane.x * m_boxX[index] + plane.y * m_boxY[index] + plane.z * m_boxZ[index] + plane.w;
+        float reach = fabsf(plane.x) * m_boxExtentX[index] + fabsf(plane.y) * m_boxExtentY[index] + fabsf(plane.z) * m_boxExtentZ[index];
+        if (!(distance + reach >= 0.0f))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FrustumCullerClass::TransformBox(const XMFLOAT3& center, const XMFLOAT3& extents, const XMMATRIX& world, XMFLOAT3& worldCenter, XMFLOAT3& worldExtents)
+{
+    XMStoreFloat3(&worldCenter, XMVector3Transform(XMLoadFloat3(&center), world));
+
+    // Each world axis reaches as far as the absolute values of the rotated and scaled local axes add up to.
+    XMVECTOR reach = XMVectorMultiply(XMVectorAbs(world.r[0]), XMVectorReplicate(extents.x));
+    reach = XMVectorMultiplyAdd(XMVectorAbs(world.r[1]), XMVectorReplicate(extents.y), reach);
+    reach = XMVectorMultiplyAdd(XMVectorAbs(world.r[2]), XMVectorReplicate(extents.z), reach);
+    XMStoreFloat3(&worldExtents, reach);
+}
+
+bool FrustumCullerClass::Validate()
+{
+    const unsigned int objectCount = 10000;
+    const int viewCount = 64;
+    XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+
+    FrustumCullerClass culler;
+    culler.Reserve(objectCount, objectCount);
+    unsigned int seed = 54321;
+    for (unsigned int i = 0; i < objectCount; i++)
+    {
+        XMFLOAT3 center(Random(seed) * 400.0f - 200.0f, Random(seed) * 400.0f - 200.0f, Random(seed) * 400.0f - 200.0f);
+        culler.AddSphere(center, Random(seed) * 10.0f);
+        culler.AddBox(center, XMFLOAT3(Random(seed) * 10.0f, Random(seed) * 10.0f, Random(seed) * 10.0f));
+    }
+
+    vector<unsigned int> visible(max(culler.GetPaddedSphereCount(), culler.GetPaddedBoxCount()));
+    vector<unsigned int> expected;
+    bool passed = true;
+
+    // A box straddling the camera, one in front and one behind are the cases a plane sign error would break first.
+    FrustumCullerClass simple;
+    simple.SetFrustum(XMMatrixIdentity(), projection);
+    simple.AddBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+    simple.AddBox(XMFLOAT3(0.0f, 0.0f, 10.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+    simple.AddBox(XMFLOAT3(0.0f, 0.0f, -10.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+    simple.AddBox(XMFLOAT3(0.0f, 0.0f, 2000.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+    if (simple.CullBoxes(visible.data()) != 2 || visible[0] != 0 || visible[1] != 1)
+    {
+        LOG_ERROR("Frustum culler: simple scene gave the wrong result");
+        passed = false;
+    }
+
+    // Random views over the random scene, each compared against the one at a time tests.
+    for (int view = 0; view < viewCount && passed; view++)
+    {
+        XMVECTOR eye = XMVectorSet(Random(seed) * 200.0f - 100.0f, Random(seed) * 200.0f - 100.0f, Random(seed) * 200.0f - 100.0f, 1.0f);
+        XMVECTOR target = XMVectorSet(Random(seed) * 200.0f - 100.0f, Random(seed) * 200.0f - 100.0f, Random(seed) * 200.0f - 100.0f, 1.0f);
+        culler.SetFrustum(XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)), projection);
+
+        for (int kind = 0; kind < 2; kind++)
+        {
+            unsigned int visibleCount = kind == 0 ? culler.CullSpheres(visible.data()) : culler.CullBoxes(visible.data());
+
+            expected.clear();
+            for (unsigned int i = 0; i < objectCount; i++)
+            {
+                if (kind == 0 ? culler.IsSphereVisible(i) : culler.IsBoxVisible(i))
+                {
+                    expected.push_back(i);
+                }
+            }
+
+            if (visibleCount != expected.size() || !equal(expected.begin(), expected.end(), visible.begin()))
+            {
+                LOG_ERROR("Frustum culler: {} disagree with the reference in view {}", kind == 0 ? "spheres" : "boxes", view);
+                passed = false;
+            }
+        }
+    }
+
+    if (passed)
+    {
+        LOG_INFO("Frustum culler: {} wide tests match the reference over {} views", (unsigned int)BATCH_SIZE, viewCount);
+    }
+    return passed;
+}
+
+void FrustumCullerClass::Benchmark(const unsigned int boxCount)
+{
+    FrustumCullerClass culler;
+    culler.Reserve(0, boxCount);
+    unsigned int seed = 12345;
+    for (unsigned int i = 0; i < boxCount; i++)
+    {
+        XMFLOAT3 center(Random(seed) * 2000.0f - 1000.0f, Random(seed) * 200.0f - 100.0f, Random(seed) * 2000.0f - 1000.0f);
+        culler.AddBox(center, XMFLOAT3(Random(seed) * 5.0f, Random(seed) * 5.0f, Random(seed) * 5.0f));
+    }
+
+    XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, -10.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 100.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    culler.SetFrustum(view, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f));
+    vector<unsigned int> visible(culler.GetPaddedBoxCount());
+
+    const int runs = 10;
+    LARGE_INTEGER frequency, start, batched, reference;
+    QueryPerformanceFrequency(&frequency);
+
+    unsigned int visibleCount = 0;
+    QueryPerformanceCounter(&start);
+    for (int run = 0; run < runs; run++)
+    {
+        visibleCount = culler.CullBoxes(visible.data());
+    }
+    QueryPerformanceCounter(&batched);
+
+    unsigned int referenceCount = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        referenceCount = 0;
+        for (unsigned int i = 0; i < boxCount; i++)
+        {
+            if (culler.IsBoxVisible(i))
+            {
+                visible[referenceCount++] = i;
+            }
+        }
+    }
+    QueryPerformanceCounter(&reference);
+
+    double batchedSeconds = (double)(batched.QuadPart - start.QuadPart) / frequency.QuadPart / runs;
+    double referenceSeconds = (double)(reference.QuadPart - batched.QuadPart) / frequency.QuadPart / runs;
+
+    LOG_INFO("Frustum culling benchmark: {} boxes, {} visible (reference {}), {} wide {} ms ({} ns per box), scalar {} ms ({}x)", boxCount,
+             visibleCount, referenceCount, (unsigned int)BATCH_SIZE, batchedSeconds * 1000.0, batchedSeconds * 1e9 / boxCount, referenceSeconds * 1000.0,
+             referenceSeconds / batchedSeconds);
+}
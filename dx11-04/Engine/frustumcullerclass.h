@@ -0,0 +1,72 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <algorithm>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace DirectX;
+
+// View frustum culling of bounding spheres and axis aligned boxes. Bounds are kept in structure of arrays form so the
+// tests run on BATCH_SIZE objects at a time: four with SSE, or eight when the engine is built with AVX (/arch:AVX).
+// The cull functions write the indices of the visible objects, in order, to a caller supplied array.
+class FrustumCullerClass
+{
+public:
+#ifdef __AVX__
+    static const unsigned int BATCH_SIZE = 8;
+#else
+    static const unsigned int BATCH_SIZE = 4;
+#endif
+
+    FrustumCullerClass();
+
+    ~FrustumCullerClass();
+
+    // Extracts the six planes from view * projection (Gribb and Hartmann), normalized and pointing into the frustum.
+    void SetFrustum(const XMMATRIX& view, const XMMATRIX& projection);
+
+    void Clear();
+
+    void Reserve(const unsigned int sphereCount, const unsigned int boxCount);
+
+    // Both return the index the object will be reported as.
+    unsigned int AddSphere(const XMFLOAT3& center, const float radius);
+
+    unsigned int AddBox(const XMFLOAT3& center, const XMFLOAT3& extents);
+
+    // visible needs room for GetPaddedSphereCount() / GetPaddedBoxCount() entries; the return value is how many are used.
+    unsigned int CullSpheres(unsigned int* visible);
+
+    unsigned int CullBoxes(unsigned int* visible);
+
+    unsigned int GetPaddedSphereCount();
+
+    unsigned int GetPaddedBoxCount();
+
+    // One object at a time reference tests, what the batched versions must agree with.
+    bool IsSphereVisible(const unsigned int index);
+
+    bool IsBoxVisible(const unsigned int index);
+
+    // Transforms an object space box by world and returns the world space box that encloses it.
+    static void TransformBox(const XMFLOAT3& center, const XMFLOAT3& extents, const XMMATRIX& world, XMFLOAT3& worldCenter, XMFLOAT3& worldExtents);
+
+    // Checks the batched tests against the reference tests on random scenes and views; writes the result to the log.
+    static bool Validate();
+
+    static void Benchmark(const unsigned int boxCount);
+
+private:
+    XMFLOAT4 m_planes[6];
+
+    unsigned int m_sphereCount;
+    vector<float> m_sphereX, m_sphereY, m_sphereZ, m_sphereRadius;
+
+    unsigned int m_boxCount;
+    vector<float> m_boxX, m_boxY, m_boxZ, m_boxExtentX, m_boxExtentY, m_boxExtentZ;
+};
@@ -0,0 +1,82 @@
+#include "gputimerclass.h"
+
+GpuTimerClass::GpuTimerClass()
+{
+    m_frameNumber = 0;
+}
+
+GpuTimerClass::~GpuTimerClass()
+{
+}
+
+bool GpuTimerClass::Initialize(ID3D11Device* device)
+{
+    D3D11_QUERY_DESC disjointDesc;
+    disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+    disjointDesc.MiscFlags = 0;
+    D3D11_QUERY_DESC timestampDesc;
+    timestampDesc.Query = D3D11_QUERY_TIMESTAMP;
+    timestampDesc.MiscFlags = 0;
+
+    for (unsigned int i = 0; i < FRAMES_IN_FLIGHT; i++)
+    {
+        Frame& frame = m_frames[i];
+        frame.number = 0;
+        frame.pending = false;
+        if (FAILED(device->CreateQuery(&disjointDesc, frame.disjoint.ReleaseAndGetAddressOf())) ||
+            FAILED(device->CreateQuery(&timestampDesc, frame.begin.ReleaseAndGetAddressOf())) ||
+            FAILED(device->CreateQuery(&timestampDesc, frame.end.ReleaseAndGetAddressOf())))
+        {
+            return false;
+        }
+    }
+
+    m_frameNumber = 0;
+    return true;
+}
+
+unsigned long long GpuTimerClass::BeginFrame(ID3D11DeviceContext* context)
+{
+    Frame& frame = m_frames[m_frameNumber % FRAMES_IN_FLIGHT];
+    frame.number = m_frameNumber;
+    context->Begin(frame.disjoint.Get());
+    context->End(frame.begin.Get());
+    return m_frameNumber;
+}
+
+void GpuTimerClass::EndFrame(ID3D11DeviceContext* context)
+{
+    Frame& frame = m_frames[m_frameNumber % FRAMES_IN_FLIGHT];
+    context->End(frame.end.Get());
+    context->End(frame.disjoint.Get());
+    frame.pending = true;
+    m_frameNumber++;
+}
+
+double GpuTimerClass::Collect(ID3D11DeviceContext* context, unsigned long long& frameNumber)
+{
+    // The slot the next frame reuses holds the oldest one.
+    Frame& frame = m_frames[m_frameNumber % FRAMES_IN_FLIGHT];
+    if (!frame.pending)
+    {
+        return -1.0;
+    }
+    frame.pending = false;
+    frameNumber = frame.number;
+
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+    UINT64 begin, end;
+    if (context->GetData(frame.disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+        context->GetData(frame.begin.Get(), &begin, sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+        context->GetData(frame.end.Get(), &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+    {
+        return -1.0;
+    }
+
+    if (disjoint.Disjoint || disjoint.Frequency == 0 || end < begin)
+    {
+        return -1.0;
+    }
+
+    return (double)(end - begin) / (double)disjoint.Frequency;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "engine.h"
+
+using namespace std;
+using namespace Microsoft::WRL;
+
+// Measures how long the GPU takes over each frame with timestamp queries. Results are read back a few frames late, so the
+// CPU never waits for them; a frame whose results aren't in by the time its queries come round again, or whose clock was
+// disjoint, is dropped.
+class GpuTimerClass
+{
+public:
+    static const unsigned int FRAMES_IN_FLIGHT = 4;
+
+    GpuTimerClass();
+
+    ~GpuTimerClass();
+
+    // False when the device can't create timestamp queries, e.g. the null device.
+    bool Initialize(ID3D11Device* device);
+
+    // Returns the number of the frame, counting from 0.
+    unsigned long long BeginFrame(ID3D11DeviceContext* context);
+
+    void EndFrame(ID3D11DeviceContext* context);
+
+    // GPU seconds of the oldest frame still waiting to be read, FRAMES_IN_FLIGHT - 1 frames back, with its number; a
+    // negative value when it isn't available. Call it before BeginFrame.
+    double Collect(ID3D11DeviceContext* context, unsigned long long& frameNumber);
+
+private:
+    struct Frame
+    {
+        ComPtr<ID3D11Query> disjoint, begin, end;
+        unsigned long long number;
+        bool pending;
+    };
+
+    Frame m_frames[FRAMES_IN_FLIGHT];
+    unsigned long long m_frameNumber;
+};
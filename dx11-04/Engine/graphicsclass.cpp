@@ -1,40 +1,100 @@
 #include "graphicsclass.h"
 
-/*void* GraphicsClass::operator new (size_t size)
-{
-    void* p = _aligned_malloc(size, 16);
-    if (p == 0)
-    {
-        throw std::bad_alloc();
-    }
-
-    return p;
-}
-
-void GraphicsClass::operator delete(void* p)
-{
-    GraphicsClass* d = static_cast<GraphicsClass*>(p);
-    _aligned_free(d);
-}*/
+DEFINE_POOL_ALLOCATION(GraphicsClass, 2)
 
 GraphicsClass::GraphicsClass()
 {
+    m_JobSystem = nullptr;
+    m_Renderer = D3DClass::RENDERER_HARDWARE;
+    m_SpinAngle = m_PreviousSpinAngle = 0.0f;
+    m_HeapAllocations = 0;
 }
 
 GraphicsClass::~GraphicsClass()
 {
 }
 
-void GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
+void GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd, JobSystemClass* jobSystem, const D3DClass::Renderer renderer)
 {
+    m_JobSystem = jobSystem;
+    m_Renderer = renderer;
+
+    SwapChainClass::Settings presentSettings;
+    presentSettings.swapEffect = SWAP_EFFECT;
+    presentSettings.bufferCount = SWAP_CHAIN_BUFFERS;
+    presentSettings.maximumFrameLatency = MAX_FRAME_LATENCY;
+    presentSettings.waitable = WAIT_FOR_FRAME_LATENCY;
+    presentSettings.vsync = VSYNC_ENABLED;
+    presentSettings.allowTearing = ALLOW_TEARING;
+
     m_D3D = unique_ptr<D3DClass>(new D3DClass());
-    m_D3D->Initialize(screenWidth, screenHeight, VSYNC_ENABLED, hwnd, FULL_SCREEN, SCREEN_DEPTH, SCREEN_NEAR);
+    m_D3D->Initialize(screenWidth, screenHeight, presentSettings, hwnd, FULL_SCREEN, SCREEN_DEPTH, SCREEN_NEAR, m_Renderer);
+    // Only real frame times are fed back; the null device's are noise, and scaling on them would make its call logs and
+    // frame budgets differ from run to run.
+    if (DYNAMIC_RESOLUTION && m_Renderer == D3DClass::RENDERER_HARDWARE)
+    {
+        DynamicResolutionClass::Settings resolutionSettings = DynamicResolutionClass::GetDefaultSettings();
+        resolutionSettings.budget = FRAME_TIME_BUDGET;
+        resolutionSettings.fixedCost = FRAME_FIXED_COST;
+        resolutionSettings.minimumScale = MIN_RESOLUTION_SCALE;
+        m_D3D->EnableDynamicResolution(resolutionSettings);
+    }
+
+    // Shader device object creation runs in the background while the rest of the scene is set up.
+    // The software renderer runs the colour shaders itself, so there is nothing to create.
+    future<void> shadersLoaded;
+    if (m_Renderer != D3DClass::RENDERER_SOFTWARE)
+    {
+        m_ShaderLibrary = unique_ptr<ShaderLibraryClass>(new ShaderLibraryClass());
+        m_ShaderLibrary->Initialize();
+        m_ColorShader = unique_ptr<ColorShaderClass>(new ColorShaderClass());
+
+        ID3D11Device* device = m_D3D->GetDevice();
+        PipelineCacheClass* pipelineCache = m_D3D->GetPipelineCache();
+        shadersLoaded = async(launch::async, [this, device, pipelineCache]()
+        {
+            m_ColorShader->Initialize(device, pipelineCache, m_ShaderLibrary.get());
+        });
+    }
+
     m_Camera = unique_ptr<CameraClass>(new CameraClass());
     m_Camera->SetPosition({ 0.0f, 0.0f, -10.0f });
-    m_Model = unique_ptr<ModelClass>(new ModelClass());
-    m_Model->Initialize(m_D3D->GetDevice());
-    m_ColorShader = unique_ptr<ColorShaderClass>(new ColorShaderClass());
-    m_ColorShader->Initialize(m_D3D->GetDevice(), hwnd);
+    unique_ptr<ModelClass> model(new ModelClass());
+    if (MODEL_FILE[0] != '\0')
+    {
+        model->Initialize(m_D3D->GetDevice(), MODEL_FILE);
+    }
+    else
+    {
+        model->Initialize(m_D3D->GetDevice(), VERTEX_FORMAT);
+    }
+    m_Models.push_back(move(model));
+
+    // One entity at the origin draws the model.
+    m_Scene = unique_ptr<SceneClass>(new SceneClass());
+    m_Scene->Initialize(SCENE_CAPACITY);
+    m_ModelEntity = m_Scene->Create(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), XMFLOAT3(1.0f, 1.0f, 1.0f), 0);
+
+    m_RenderQueue = unique_ptr<RenderQueueClass>(new RenderQueueClass());
+    // Every entity can be visible at once; a queue that had to grow would allocate in the frame.
+    m_RenderQueue->Initialize(SCENE_CAPACITY);
+    m_FrustumCuller = unique_ptr<FrustumCullerClass>(new FrustumCullerClass());
+    m_LodSelector = unique_ptr<LodSelectorClass>(new LodSelectorClass());
+    LodSelectorClass::Settings lodSettings;
+    lodSettings.pixelError = LOD_PIXEL_ERROR;
+    lodSettings.hysteresis = LOD_HYSTERESIS;
+    m_LodSelector->Initialize(lodSettings);
+
+    // Rethrows anything the shader thread threw.
+    if (shadersLoaded.valid())
+    {
+        shadersLoaded.get();
+    }
+
+    if (RUN_BENCHMARKS)
+    {
+        RunBenchmarks();
+    }
 }
 
 void GraphicsClass::Shutdown()
@@ -42,26 +102,508 @@ void GraphicsClass::Shutdown()
     return;
 }
 
-bool GraphicsClass::Frame()
+void GraphicsClass::WaitForFrame()
 {
-    return Render();
+    m_D3D->WaitForFrame();
+}
+
+void GraphicsClass::Update(const float timestep)
+{
+    // Both angles are wrapped together so the blend between them never crosses the seam.
+    m_PreviousSpinAngle = m_SpinAngle;
+    m_SpinAngle += MODEL_SPIN_SPEED * timestep;
+    if (m_SpinAngle > XM_2PI)
+    {
+        m_SpinAngle -= XM_2PI;
+        m_PreviousSpinAngle -= XM_2PI;
+    }
 }
 
-bool GraphicsClass::Render()
+bool GraphicsClass::Frame(const float interpolation)
 {
+    return Render(interpolation);
+}
+
+bool GraphicsClass::Render(const float interpolation)
+{
+    PROFILE_FUNCTION();
+
+    XMFLOAT4 rotation;
+    float angle = m_PreviousSpinAngle + (m_SpinAngle - m_PreviousSpinAngle) * interpolation;
+    XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(0.0f, 0.0f, angle));
+    m_Scene->SetLocalTransform(m_ModelEntity, XMFLOAT3(0.0f, 0.0f, 0.0f), rotation, XMFLOAT3(1.0f, 1.0f, 1.0f));
+
     m_D3D->BeginScene(0.5f, 0.5f, 0.5f, 1.0f);
 
     m_Camera->Render();
 
-    XMMATRIX view, world, projection;
+    XMMATRIX view, projection;
     m_Camera->GetViewMatrix(view);
-    m_D3D->GetWorldMatrix(world);
     m_D3D->GetProjectionMatrix(projection);
 
-    m_Model->Render(m_D3D->GetDeviceContext());
+    m_Scene->UpdateTransforms(m_JobSystem);
+    unsigned int entityCount = m_Scene->GetCount();
+    const XMFLOAT4X4A* worlds = m_Scene->GetWorldMatrices();
+    const unsigned int* renderables = m_Scene->GetRenderables();
+
+    // Cull the world space bounds of every entity with render data against the camera before anything is recorded. The
+    // slot of every culled box and the visible boxes only live for the frame.
+    LinearAllocatorClass* frameAllocator = m_D3D->GetFrameAllocator();
+    unsigned int* culledSlots = frameAllocator->AllocateArray<unsigned int>(max(entityCount, 1u));
+    if (culledSlots == nullptr)
+    {
+        throw engine_exception("Frame allocator is out of memory culling entities: ") << entityCount;
+    }
+    unsigned int culledCount = 0;
+    m_FrustumCuller->SetFrustum(view, projection);
+    m_FrustumCuller->Clear();
+    for (unsigned int slot = 0; slot < entityCount; slot++)
+    {
+        if (renderables[slot] == SceneClass::NO_RENDERABLE)
+        {
+            continue;
+        }
+
+        XMFLOAT3 center, extents, worldCenter, worldExtents;
+        m_Models[renderables[slot]]->GetBounds(center, extents);
+        FrustumCullerClass::TransformBox(center, extents, XMLoadFloat4x4A(&worlds[slot]), worldCenter, worldExtents);
+        m_FrustumCuller->AddBox(worldCenter, worldExtents);
+        culledSlots[culledCount++] = slot;
+    }
+    unsigned int* visibleObjects = frameAllocator->AllocateArray<unsigned int>(max(m_FrustumCuller->GetPaddedBoxCount(), 1u));
+    if (visibleObjects == nullptr)
+    {
+        throw engine_exception("Frame allocator is out of memory culling entities: ") << entityCount;
+    }
+    unsigned int visibleCount = m_FrustumCuller->CullBoxes(visibleObjects);
+
+    // Record the frame's draws, keyed on the view space depth of each object's origin as a fraction of the far plane, at
+    // the level of detail picked from the distance to the centre of its bounds and the one it was drawn at last.
+    m_LodSelector->SetView(m_Camera->GetPosition(), projection, m_D3D->GetViewportHeight());
+    unsigned int* lods = m_Scene->GetLods();
+    m_RenderQueue->Reset();
+    for (unsigned int i = 0; i < visibleCount; i++)
+    {
+        unsigned int slot = culledSlots[visibleObjects[i]];
+        ModelClass* model = m_Models[renderables[slot]].get();
+        XMMATRIX world = XMLoadFloat4x4A(&worlds[slot]);
+        if (LOD_ENABLED)
+        {
+            XMFLOAT3 center, extents;
+            model->GetBounds(center, extents);
+            lods[slot] = m_LodSelector->Select(model->GetLods(), model->GetLodCount(), world, center, lods[slot]);
+        }
+        float depth = XMVectorGetZ(XMVector3Transform(world.r[3], view)) / SCREEN_DEPTH;
+        m_RenderQueue->Record(RenderQueueClass::MakeSortKey(0, 0, 0, depth), model, m_ColorShader.get(), world, lods[slot]);
+    }
 
-    m_ColorShader->Render(m_D3D->GetDeviceContext(), m_Model->GetIndexCount(), world, view, projection);
+    m_RenderQueue->Sort();
+
+    // Big frames are cut into contiguous runs of the sorted queue, one per thread, which execute in queue order.
+    unsigned int packetCount = m_RenderQueue->GetPacketCount();
+    unsigned int listCount = min((unsigned int)m_JobSystem->GetThreadCount(), packetCount / MIN_DRAWS_PER_COMMAND_LIST);
+    listCount = min(listCount, (unsigned int)CommandListClass::MAX_LISTS_PER_FRAME);
+    if (listCount > 1)
+    {
+        RenderQueueClass* renderQueue = m_RenderQueue.get();
+        RecordCommandLists(listCount, view, projection, [renderQueue, packetCount, listCount](unsigned int list, CommandListClass* commandList)
+        {
+            renderQueue->Submit(commandList, packetCount * list / listCount, packetCount * (list + 1) / listCount);
+        });
+    }
+    else
+    {
+        m_RenderQueue->Submit(m_D3D->GetStateCache(), m_D3D->GetConstantRing(), m_D3D->GetSoftwareRasterizer(), view, projection);
+    }
 
     m_D3D->EndScene();
     return true;
+}
+
+void GraphicsClass::RecordCommandLists(const unsigned int listCount, const XMMATRIX& view, const XMMATRIX& projection,
+                                       const function<void(unsigned int, CommandListClass*)>& record)
+{
+    PROFILE_FUNCTION();
+
+    if (listCount > CommandListClass::MAX_LISTS_PER_FRAME)
+    {
+        throw engine_exception("A frame can record at most ") << (unsigned int)CommandListClass::MAX_LISTS_PER_FRAME << " command lists, not " << listCount;
+    }
+
+    while (m_CommandLists.size() < listCount)
+    {
+        unique_ptr<CommandListClass> commandList(new CommandListClass());
+        commandList->Initialize(m_D3D->GetDevice());
+        m_CommandLists.push_back(move(commandList));
+    }
+
+    D3DClass* d3d = m_D3D.get();
+    vector<unique_ptr<CommandListClass>>& commandLists = m_CommandLists;
+    m_JobSystem->ParallelFor(listCount, 1, [d3d, &commandLists, &view, &projection, &record](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            CommandListClass* commandList = commandLists[i].get();
+            commandList->Begin(d3d);
+            commandList->SetFrameConstants(view, projection);
+            record(i, commandList);
+            commandList->End();
+        }
+    });
+
+    for (unsigned int i = 0; i < listCount; i++)
+    {
+        m_CommandLists[i]->Execute(d3d);
+    }
+}
+
+int GraphicsClass::CheckFrameBudgets()
+{
+    NullDeviceClass* nullDevice = m_D3D->GetNullDevice();
+    if (nullDevice == nullptr)
+    {
+        throw engine_exception("Frame budgets are only counted on the null device");
+    }
+
+    const NullDeviceClass::FrameStatistics& statistics = nullDevice->GetFrameStatistics();
+    float draws = (float)max(statistics.draws, 1u);
+    float stateChangesPerDraw = (float)statistics.stateChanges / draws;
+    float mapsPerDraw = (float)statistics.maps / draws;
+
+    // Everything allocated on the heap since the last check, which the first frame's initialization is part of.
+    unsigned long long heapAllocationCount = MemoryClass::GetHeapAllocationCount();
+    unsigned long long heapAllocations = heapAllocationCount - m_HeapAllocations;
+    m_HeapAllocations = heapAllocationCount;
+
+    int overBudget = 0;
+    if (stateChangesPerDraw > MAX_STATE_CHANGES_PER_DRAW)
+    {
+        LOG_WARNING("Over MAX_STATE_CHANGES_PER_DRAW: {} state changes per draw against {}", stateChangesPerDraw, MAX_STATE_CHANGES_PER_DRAW);
+        overBudget++;
+    }
+    if (mapsPerDraw > MAX_MAPS_PER_DRAW)
+    {
+        LOG_WARNING("Over MAX_MAPS_PER_DRAW: {} maps per draw against {}", mapsPerDraw, MAX_MAPS_PER_DRAW);
+        overBudget++;
+    }
+    if (statistics.creations > MAX_CREATIONS_PER_FRAME)
+    {
+        LOG_WARNING("Over MAX_CREATIONS_PER_FRAME: {} objects created against {}", statistics.creations, MAX_CREATIONS_PER_FRAME);
+        overBudget++;
+    }
+    if (heapAllocations > MAX_HEAP_ALLOCATIONS_PER_FRAME)
+    {
+        LOG_WARNING("Over MAX_HEAP_ALLOCATIONS_PER_FRAME: {} heap allocations against {}", heapAllocations, MAX_HEAP_ALLOCATIONS_PER_FRAME);
+        overBudget++;
+    }
+
+    LOG_INFO("Null device frame: {} draws, {} state changes and {} maps per draw, {} objects created, {} heap allocations{}", statistics.draws,
+             stateChangesPerDraw, mapsPerDraw, statistics.creations, heapAllocations, overBudget > 0 ? ", OVER BUDGET" : "");
+    if (overBudget > 0)
+    {
+        for (const NullDeviceClass::CallRecord& record : nullDevice->GetFrameLog())
+        {
+            LOG_INFO("{} {} {} {}", NullDeviceClass::GetCallName(record.call), record.arguments[0], record.arguments[1], record.arguments[2]);
+        }
+    }
+    return overBudget;
+}
+
+int GraphicsClass::RunHeadless(const int frameCount, const float timestep)
+{
+    JobSystemClass jobs;
+    jobs.Initialize(0);
+    unique_ptr<GraphicsClass> graphics(new GraphicsClass());
+    graphics->Initialize(HEADLESS_SCREEN_WIDTH, HEADLESS_SCREEN_HEIGHT, NULL, &jobs, D3DClass::RENDERER_NULL);
+
+    int overBudget = 0;
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        graphics->WaitForFrame();
+        graphics->Update(timestep);
+        graphics->Frame(1.0f);
+
+        // The first frame also counts everything created at initialization and binds all state for the first time.
+        int frameOverBudget = graphics->CheckFrameBudgets();
+        overBudget += frame > 0 ? frameOverBudget : 0;
+    }
+
+    graphics->Shutdown();
+    return overBudget;
+}
+
+void GraphicsClass::RunBenchmarks()
+{
+    RenderQueueClass::Benchmark(100000);
+    JobSystemClass::Benchmark(100000);
+    FrustumCullerClass::Benchmark(1000000);
+    SceneClass::Benchmark(100000, m_JobSystem);
+    SceneClass::Benchmark(1000000, m_JobSystem);
+    PipelineCacheClass::Validate();
+    LodSelectorClass::Benchmark(100000, 120);
+#ifdef _WIN32
+    MeshConverterClass::Benchmark(m_D3D->GetDevice(), 1024);
+#endif
+
+    if (m_Renderer != D3DClass::RENDERER_SOFTWARE)
+    {
+        BenchmarkInstancing(100000);
+        BenchmarkConstantUploads(10000);
+        BenchmarkStreaming(120);
+    }
+
+    BenchmarkCommandLists(100000);
+}
+
+void GraphicsClass::BenchmarkInstancing(const unsigned int instanceCount)
+{
+    XMMATRIX view, projection;
+    m_Camera->Render();
+    m_Camera->GetViewMatrix(view);
+    m_D3D->GetProjectionMatrix(projection);
+
+    // Lay the copies out on a grid so both paths transform the same matrices.
+    unique_ptr<ColorShaderClass::InstanceType[]> instances(new ColorShaderClass::InstanceType[instanceCount]);
+    unsigned int side = (unsigned int)ceil(sqrt((double)instanceCount));
+    for (unsigned int i = 0; i < instanceCount; i++)
+    {
+        XMMATRIX world = XMMatrixTranslation((float)(i % side) * 3.0f, (float)(i / side) * 3.0f, 0.0f);
+        XMStoreFloat4x4(&instances[i].world, world);
+        instances[i].color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    }
+
+    StateCacheClass* stateCache = m_D3D->GetStateCache();
+    ModelClass* model = m_Models[0].get();
+    ConstantBufferRingClass* constantRing = m_D3D->GetConstantRing();
+    ID3D11DeviceContext* deviceContext = m_D3D->GetDeviceContext();
+    m_ColorShader->SetFrameConstants(stateCache, view, projection);
+
+    LARGE_INTEGER frequency, start, perDraw, instanced;
+    QueryPerformanceFrequency(&frequency);
+
+    // Flush between the runs so neither pays for the other's queued work.
+    deviceContext->Flush();
+    QueryPerformanceCounter(&start);
+    for (unsigned int i = 0; i < instanceCount; i++)
+    {
+        model->Render(stateCache);
+        m_ColorShader->Render(stateCache, constantRing, model->GetIndexCount(), model->GetQuantization(), XMLoadFloat4x4(&instances[i].world));
+    }
+    deviceContext->Flush();
+    QueryPerformanceCounter(&perDraw);
+
+    model->Render(stateCache);
+    m_ColorShader->RenderInstanced(stateCache, constantRing, model->GetIndexCount(), model->GetQuantization(), instances.get(), instanceCount);
+    deviceContext->Flush();
+    QueryPerformanceCounter(&instanced);
+
+    double perDrawSeconds = (double)(perDraw.QuadPart - start.QuadPart) / frequency.QuadPart;
+    double instancedSeconds = (double)(instanced.QuadPart - perDraw.QuadPart) / frequency.QuadPart;
+
+    LOG_INFO("Instancing benchmark: {} instances, per draw {} ms, instanced {} ms ({}x)", instanceCount, perDrawSeconds * 1000.0,
+             instancedSeconds * 1000.0, perDrawSeconds / instancedSeconds);
+}
+
+void GraphicsClass::BenchmarkConstantUploads(const unsigned int drawCount)
+{
+    XMMATRIX view, projection;
+    m_Camera->Render();
+    m_Camera->GetViewMatrix(view);
+    m_D3D->GetProjectionMatrix(projection);
+
+    StateCacheClass* stateCache = m_D3D->GetStateCache();
+    ModelClass* model = m_Models[0].get();
+    ConstantBufferRingClass* constantRing = m_D3D->GetConstantRing();
+    ID3D11DeviceContext* deviceContext = m_D3D->GetDeviceContext();
+    const VertexFormatClass::Quantization& quantization = model->GetQuantization();
+
+    // The old layout: world, view, projection and dequantization in one buffer, discarded and rewritten for every draw.
+    struct CombinedBufferType
+    {
+        XMMATRIX world;
+        XMMATRIX view;
+        XMMATRIX projection;
+        XMFLOAT4 positionScale;
+        XMFLOAT4 positionBias;
+    };
+
+    D3D11_BUFFER_DESC combinedBufferDesc;
+    combinedBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    combinedBufferDesc.ByteWidth = sizeof(CombinedBufferType);
+    combinedBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    combinedBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    combinedBufferDesc.MiscFlags = 0;
+    combinedBufferDesc.StructureByteStride = 0;
+
+    ComPtr<ID3D11Buffer> combinedBuffer;
+    HRESULT result = m_D3D->GetDevice()->CreateBuffer(&combinedBufferDesc, NULL, combinedBuffer.GetAddressOf());
+    if (FAILED(result))
+    {
+        throw engine_exception("Couldn't create buffer, result code = ") << result;
+    }
+
+    // One untimed draw binds the model and the plain shaders for both runs.
+    model->Render(stateCache);
+    m_ColorShader->SetFrameConstants(stateCache, view, projection);
+    m_ColorShader->Render(stateCache, constantRing, model->GetIndexCount(), quantization, XMMatrixIdentity());
+
+    LARGE_INTEGER frequency, start, combined, split;
+    QueryPerformanceFrequency(&frequency);
+
+    deviceContext->Flush();
+    QueryPerformanceCounter(&start);
+    for (unsigned int i = 0; i < drawCount; i++)
+    {
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        result = deviceContext->Map(combinedBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+        if (FAILED(result))
+        {
+            throw engine_exception("Couldn't lock constant buffer, result code = ") << result;
+        }
+
+        CombinedBufferType* dataPtr = (CombinedBufferType*)mappedResource.pData;
+        dataPtr->world = XMMatrixTranspose(XMMatrixTranslation((float)i, 0.0f, 0.0f));
+        dataPtr->view = XMMatrixTranspose(view);
+        dataPtr->projection = XMMatrixTranspose(projection);
+        dataPtr->positionScale = quantization.positionScale;
+        dataPtr->positionBias = quantization.positionBias;
+        deviceContext->Unmap(combinedBuffer.Get(), 0);
+
+        stateCache->VSSetConstantBuffers(1, 1, combinedBuffer.GetAddressOf());
+        stateCache->DrawIndexed(model->GetIndexCount(), 0, 0);
+    }
+    deviceContext->Flush();
+    QueryPerformanceCounter(&combined);
+
+    // The split path, as one frame of the render queue would issue it.
+    constantRing->BeginFrame();
+    unsigned int mapCalls = constantRing->GetMapCalls();
+    unsigned int uploadedBytes = constantRing->GetUploadedBytes();
+    m_ColorShader->SetFrameConstants(stateCache, view, projection);
+    for (unsigned int i = 0; i < drawCount; i++)
+    {
+        m_ColorShader->Render(stateCache, constantRing, model->GetIndexCount(), quantization, XMMatrixTranslation((float)i, 0.0f, 0.0f));
+    }
+    deviceContext->Flush();
+    QueryPerformanceCounter(&split);
+
+    // The frame constants are one more map of view and projection.
+    mapCalls = constantRing->GetMapCalls() - mapCalls + 1;
+    uploadedBytes = constantRing->GetUploadedBytes() - uploadedBytes + 2 * sizeof(XMFLOAT4X4);
+
+    double combinedSeconds = (double)(combined.QuadPart - start.QuadPart) / frequency.QuadPart;
+    double splitSeconds = (double)(split.QuadPart - combined.QuadPart) / frequency.QuadPart;
+
+    LOG_INFO("Constant upload benchmark: {} draws per frame", drawCount);
+    LOG_INFO("  discard per draw: {} maps, {} bytes, {} ms", drawCount, drawCount * sizeof(CombinedBufferType), combinedSeconds * 1000.0);
+    LOG_INFO("  {}: {} maps, {} bytes, {} ms ({}x)", constantRing->UsesOffsets() ? "constant ring" : "constant ring (discard fallback)", mapCalls,
+             uploadedBytes, splitSeconds * 1000.0, combinedSeconds / splitSeconds);
+}
+
+void GraphicsClass::BenchmarkStreaming(const unsigned int frameCount)
+{
+    // Every frame regenerates spanCount ribbons of 128 segments, about 7 MB of vertices and 1.5 MB of indices.
+    const unsigned int spanCount = 1024;
+    const unsigned int segments = 128;
+    const unsigned int vertexCount = (segments + 1) * 2;
+    const unsigned int indexCount = segments * 6;
+    typedef VertexFormatClass::VertexType VertexType;
+
+    StreamingGeometryClass* streaming = m_D3D->GetStreamingGeometry();
+    atomic<unsigned int> failed(0);
+    unsigned long long streamedBytes = 0;
+
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+
+    for (unsigned int frame = 0; frame < frameCount; frame++)
+    {
+        streaming->Begin();
+        m_JobSystem->ParallelFor(spanCount, 16, [streaming, frame, &failed](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; i++)
+            {
+                StreamingGeometryClass::Span span;
+                if (!streaming->Allocate(vertexCount, sizeof(VertexType), indexCount, span))
+                {
+                    failed++;
+                    continue;
+                }
+
+                // A wavy ribbon along x, two vertices per segment boundary.
+                VertexType* vertices = (VertexType*)span.vertices;
+                for (unsigned int segment = 0; segment <= segments; segment++)
+                {
+                    float x = (float)segment * 0.1f;
+                    float y = sinf(x + (float)(frame + i) * 0.05f);
+                    vertices[segment * 2].position = XMFLOAT3(x, y, (float)i);
+                    vertices[segment * 2].color = XMFLOAT4(1.0f, 0.5f, 0.0f, 1.0f);
+                    vertices[segment * 2 + 1].position = XMFLOAT3(x, y + 0.1f, (float)i);
+                    vertices[segment * 2 + 1].color = XMFLOAT4(1.0f, 0.5f, 0.0f, 1.0f);
+                }
+
+                unsigned short* indices = (unsigned short*)span.indices;
+                for (unsigned int segment = 0; segment < segments; segment++)
+                {
+                    unsigned short first = (unsigned short)(segment * 2);
+                    indices[segment * 6 + 0] = first;
+                    indices[segment * 6 + 1] = first + 1;
+                    indices[segment * 6 + 2] = first + 2;
+                    indices[segment * 6 + 3] = first + 2;
+                    indices[segment * 6 + 4] = first + 1;
+                    indices[segment * 6 + 5] = first + 3;
+                }
+            }
+        });
+        streamedBytes += streaming->GetStreamedBytes();
+        streaming->End();
+    }
+    QueryPerformanceCounter(&end);
+
+    double seconds = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+    double megabytes = (double)streamedBytes / (1024.0 * 1024.0);
+
+    LOG_INFO("Streaming benchmark: {} threads, {} MB per frame, {} ms per frame, {} MB/s, {} failed allocations", m_JobSystem->GetThreadCount(),
+             megabytes / frameCount, seconds * 1000.0 / frameCount, megabytes / seconds, failed.load());
+}
+
+void GraphicsClass::BenchmarkCommandLists(const unsigned int drawCount)
+{
+    XMMATRIX view, projection;
+    m_Camera->Render();
+    m_Camera->GetViewMatrix(view);
+    m_D3D->GetProjectionMatrix(projection);
+
+    // The same grid of copies as the instancing benchmark, cut into equal runs of consecutive draws.
+    ModelClass* model = m_Models[0].get();
+    ColorShaderClass* shader = m_ColorShader.get();
+    unsigned int side = (unsigned int)ceil(sqrt((double)drawCount));
+    unsigned int threadCount = min((unsigned int)m_JobSystem->GetThreadCount(), (unsigned int)CommandListClass::MAX_LISTS_PER_FRAME);
+    double seconds[2];
+
+    for (int run = 0; run < 2; run++)
+    {
+        unsigned int listCount = run == 0 ? 1 : threadCount;
+
+        LARGE_INTEGER frequency, start, end;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&start);
+
+        RecordCommandLists(listCount, view, projection, [model, shader, side, drawCount, listCount](unsigned int list, CommandListClass* commandList)
+        {
+            unsigned int last = drawCount * (list + 1) / listCount;
+            for (unsigned int i = drawCount * list / listCount; i < last; i++)
+            {
+                commandList->Draw(model, shader, XMMatrixTranslation((float)(i % side) * 3.0f, (float)(i / side) * 3.0f, 0.0f));
+            }
+        });
+
+        QueryPerformanceCounter(&end);
+        seconds[run] = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+    }
+
+    LOG_INFO("Command list benchmark: {} draws, {}, 1 list {} ms, {} lists {} ms ({}x)", drawCount,
+             m_CommandLists[0]->IsDeferred() ? "deferred contexts" : "CPU streams", seconds[0] * 1000.0, threadCount, seconds[1] * 1000.0,
+             seconds[0] / seconds[1]);
 }
\ No newline at end of file
@@ -5,11 +5,62 @@
 #include "cameraclass.h"
 #include "modelclass.h"
 #include "colorshaderclass.h"
+#include "shaderlibraryclass.h"
+#include "jobsystemclass.h"
+#include "renderqueueclass.h"
+#include "meshconverterclass.h"
+#include "frustumcullerclass.h"
+#include "sceneclass.h"
+#include "commandlistclass.h"
+#include "lodselectorclass.h"
+#include <future>
 
 using namespace std;
 
 const bool FULL_SCREEN = false;
 const bool VSYNC_ENABLED = true;
+// Flip model presentation with the CPU at most MAX_FRAME_LATENCY frames ahead of the display. With the waitable object the
+// loop waits for the swap chain before it samples input instead of in Present. Uncapped frames tear where the system allows it.
+const SwapChainClass::SwapEffect SWAP_EFFECT = SwapChainClass::SWAP_FLIP_DISCARD;
+const unsigned int SWAP_CHAIN_BUFFERS = 3;
+const unsigned int MAX_FRAME_LATENCY = 1;
+const bool WAIT_FOR_FRAME_LATENCY = true;
+const bool ALLOW_TEARING = true;
+// Render the scene at a fraction of the window picked each frame to fit FRAME_TIME_BUDGET seconds, stretched over the
+// window by the swap chain. Swap chains that can't stretch stay at full resolution, and the null device never scales.
+const bool DYNAMIC_RESOLUTION = true;
+const double FRAME_TIME_BUDGET = 0.9 / 60.0;
+// Seconds of the timed scene that don't shrink with the resolution; the rest is taken to scale with the pixels.
+const double FRAME_FIXED_COST = 0.0;
+const double MIN_RESOLUTION_SCALE = 0.5;
+const D3DClass::Renderer RENDERER = D3DClass::RENDERER_HARDWARE;
+// Run the subsystem benchmarks at startup and write the results to the log.
+const bool RUN_BENCHMARKS = false;
+// Vertex format of the built in triangle; mesh files carry the format they were converted to.
+const VertexFormatClass::Format VERTEX_FORMAT = VertexFormatClass::VERTEX_UNORM16_RGBA8;
+// A .mesh file made with "MeshTool -convert"; empty draws the built in triangle.
+const char* const MODEL_FILE = "";
+// Most entities the scene can hold.
+const unsigned int SCENE_CAPACITY = 65536;
+// Draw each entity at the coarsest level of detail of its model whose error covers at most LOD_PIXEL_ERROR pixels, only
+// moving to a coarser one once its error is LOD_HYSTERESIS of that under, so entities near a switch don't pop.
+const bool LOD_ENABLED = true;
+const float LOD_PIXEL_ERROR = 1.0f;
+const float LOD_HYSTERESIS = 0.25f;
+// Frames with fewer draws per job system thread than this are recorded on the render thread alone.
+const unsigned int MIN_DRAWS_PER_COMMAND_LIST = 256;
+// Radians per second the model turns about the view axis.
+const float MODEL_SPIN_SPEED = 0.5f;
+// Frames and screen size of "Engine.exe -headless" and RunHeadless.
+const int HEADLESS_FRAMES = 120;
+const int HEADLESS_SCREEN_WIDTH = 800;
+const int HEADLESS_SCREEN_HEIGHT = 600;
+// Budgets "Engine.exe -headless" holds every frame on the null device to, after the first.
+const float MAX_STATE_CHANGES_PER_DRAW = 4.0f;
+const float MAX_MAPS_PER_DRAW = 2.0f;
+const unsigned int MAX_CREATIONS_PER_FRAME = 0;
+// Heap allocations on every thread but the log writer; the frame loop uses the frame allocator and pools instead.
+const unsigned long long MAX_HEAP_ALLOCATIONS_PER_FRAME = 0;
 const float SCREEN_DEPTH = 1000.0f;
 const float SCREEN_NEAR = 0.1f;
 
@@ -20,21 +71,70 @@ public:
 
     ~GraphicsClass();
 
-    void Initialize(int screenWidth, int screenHeight, HWND hwnd);
+    // The job system is owned by SystemClass and must outlive the graphics object.
+    void Initialize(int screenWidth, int screenHeight, HWND hwnd, JobSystemClass* jobSystem, const D3DClass::Renderer renderer);
 
     void Shutdown();
 
-    bool Frame();
+    // Blocks until the swap chain can take the next frame; call it before input is sampled.
+    void WaitForFrame();
 
-    // Operators for new and delete needed to set 16-byte alignment.
-    //static void* operator new (size_t size);
+    // Advances the simulation by one fixed step.
+    void Update(const float timestep);
 
-    //static void operator delete (void* p);
+    // Renders the scene at interpolation (0 to 1) of the way from the previous simulation step to the latest one.
+    bool Frame(const float interpolation);
+
+    // Calls record for every list index in [0, listCount) on the job system threads, each with its own command list that
+    // already has view and projection set, then executes the lists on the immediate context in index order. The frame
+    // comes out the same however the jobs were scheduled. Only call it from the render thread, between BeginScene and EndScene.
+    void RecordCommandLists(const unsigned int listCount, const XMMATRIX& view, const XMMATRIX& projection,
+                            const function<void(unsigned int, CommandListClass*)>& record);
+
+    // Compares the calls of the last frame on the null device with the budgets above and writes them to the log,
+    // with every call of the frame when it is over. Returns the number of budgets it went over.
+    int CheckFrameBudgets();
+
+    // Renders frameCount frames on the null device, without a window or GPU, a simulation step of timestep apart. Returns
+    // how many budgets the frames after the first went over in all; the first also counts initialization.
+    static int RunHeadless(const int frameCount, const float timestep);
+
+    // SystemClass has up to two alive while it replaces the one from its constructor.
+    DECLARE_POOL_ALLOCATION();
 
 private:
-    bool Render();
+    bool Render(const float interpolation);
     unique_ptr<D3DClass> m_D3D;
     unique_ptr<CameraClass> m_Camera;
-    unique_ptr<ModelClass> m_Model;
+    // Render data for the scene's entities, indexed by their renderable.
+    vector<unique_ptr<ModelClass>> m_Models;
+    unique_ptr<SceneClass> m_Scene;
+    EntityHandle m_ModelEntity;
+    // Simulation state of the last two steps, which rendering blends between.
+    float m_SpinAngle, m_PreviousSpinAngle;
+    unique_ptr<ShaderLibraryClass> m_ShaderLibrary;
     unique_ptr<ColorShaderClass> m_ColorShader;
+    unique_ptr<RenderQueueClass> m_RenderQueue;
+    unique_ptr<FrustumCullerClass> m_FrustumCuller;
+    unique_ptr<LodSelectorClass> m_LodSelector;
+    // Kept between frames so their deferred contexts and constant rings are reused.
+    vector<unique_ptr<CommandListClass>> m_CommandLists;
+    JobSystemClass* m_JobSystem;
+    D3DClass::Renderer m_Renderer;
+    // MemoryClass::GetHeapAllocationCount at the last CheckFrameBudgets.
+    unsigned long long m_HeapAllocations;
+
+    void RunBenchmarks();
+
+    // Compares the CPU cost of submitting instanceCount copies of the model one draw at a time against the instanced path.
+    void BenchmarkInstancing(const unsigned int instanceCount);
+
+    // Compares the per draw constant uploads of one buffer discarded for every draw against the frame/object split.
+    void BenchmarkConstantUploads(const unsigned int drawCount);
+
+    // Streams ribbons of generated geometry from every job system thread for a number of frames and reports MB/s.
+    void BenchmarkStreaming(const unsigned int frameCount);
+
+    // Records drawCount draws into one command list and then split over every job system thread, and reports the speedup.
+    void BenchmarkCommandLists(const unsigned int drawCount);
 };
@@ -0,0 +1,399 @@
+#include "jobsystemclass.h"
+
+namespace
+{
+    const int SPINS_BEFORE_SLEEP = 64;
+
+    THREAD_LOCAL JobSystemClass* t_jobSystem = nullptr;
+    THREAD_LOCAL int t_workerIndex = -1;
+}
+
+JobSystemClass::WorkStealingDeque::WorkStealingDeque() : m_top(0), m_bottom(0)
+{
+    for (unsigned int i = 0; i < MAX_JOBS_PER_WORKER; i++)
+    {
+        m_jobs[i].store(nullptr, memory_order_relaxed);
+    }
+}
+
+bool JobSystemClass::WorkStealingDeque::Push(Job* job)
+{
+    long long bottom = m_bottom.load(memory_order_relaxed);
+    long long top = m_top.load(memory_order_acquire);
+    if (bottom - top >= (long long)MAX_JOBS_PER_WORKER)
+    {
+        return false;
+    }
+
+    m_jobs[bottom & (MAX_JOBS_PER_WORKER - 1)].store(job, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    m_bottom.store(bottom + 1, memory_order_relaxed);
+    return true;
+}
+
+JobSystemClass::Job* JobSystemClass::WorkStealingDeque::Pop()
+{
+    long long bottom = m_bottom.load(memory_order_relaxed) - 1;
+    m_bottom.store(bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long top = m_top.load(memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        // Empty; undo the reservation.
+        m_bottom.store(bottom + 1, memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = m_jobs[bottom & (MAX_JOBS_PER_WORKER - 1)].load(memory_order_relaxed);
+    if (top == bottom)
+    {
+        // Last job, race the thieves for it.
+        if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+        {
+            job = nullptr;
+        }
+        m_bottom.store(bottom + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystemClass::Job* JobSystemClass::WorkStealingDeque::Steal()
+{
+    long long top = m_top.load(memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long bottom = m_bottom.load(memory_order_acquire);
+
+    if (top >= bottom)
+    {
+        return nullptr;
+    }
+
+    Job* job = m_jobs[top & (MAX_JOBS_PER_WORKER - 1)].load(memory_order_relaxed);
+    if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+    {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystemClass::JobSystemClass() : m_queuedJobs(0), m_sleepingWorkers(0), m_shuttingDown(false)
+{
+    m_previousSystem = nullptr;
+}
+
+JobSystemClass::~JobSystemClass()
+{
+    Shutdown();
+}
+
+void JobSystemClass::Initialize(int threadCount)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = max((int)thread::hardware_concurrency(), 1);
+    }
+
+    m_shuttingDown = false;
+    for (int i = 0; i < threadCount; i++)
+    {
+        unique_ptr<Worker> worker(new Worker());
+        worker->nextJob = 0;
+        worker->stealSeed = 2654435761u * (i + 1);
+        m_workers.push_back(move(worker));
+    }
+
+    // The calling thread is worker 0; remember whichever system it belonged to before so Shutdown can hand it back.
+    m_previousSystem = t_jobSystem;
+    t_jobSystem = this;
+    t_workerIndex = 0;
+
+    for (int i = 1; i < threadCount; i++)
+    {
+        m_threads.push_back(thread(&JobSystemClass::WorkerThread, this, i));
+    }
+}
+
+void JobSystemClass::Shutdown()
+{
+    if (m_workers.empty())
+    {
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(m_sleepMutex);
+        m_shuttingDown = true;
+    }
+    m_wakeUp.notify_all();
+
+    for (auto& worker : m_threads)
+    {
+        worker.join();
+    }
+    m_threads.clear();
+    m_workers.clear();
+
+    if (t_jobSystem == this)
+    {
+        t_jobSystem = m_previousSystem;
+        t_workerIndex = m_previousSystem != nullptr ? 0 : -1;
+    }
+}
+
+void JobSystemClass::Run(const function<void()>& work, JobCounter& counter)
+{
+    int workerIndex = GetWorkerIndex();
+    if (workerIndex < 0)
+    {
+        throw engine_exception("Jobs can only be started from the job system's threads");
+    }
+
+    // The next slot may still hold a queued job, or one a thief is running; then do the work now without touching it.
+    Worker& worker = *m_workers[workerIndex];
+    Job* job = &worker.jobs[worker.nextJob & (MAX_JOBS_PER_WORKER - 1)];
+    if (job->taken.load(memory_order_acquire))
+    {
+        work();
+        return;
+    }
+
+    worker.nextJob++;
+    job->work = work;
+    job->counter = &counter;
+    job->taken.store(true, memory_order_relaxed);
+    counter.value.fetch_add(1, memory_order_relaxed);
+
+    // A free slot means fewer than MAX_JOBS_PER_WORKER jobs are queued, so the push always fits.
+    m_queuedJobs.fetch_add(1);
+    worker.deque.Push(job);
+
+    // Sleeping workers register before checking the queue, so either they see this job or we see them.
+    if (m_sleepingWorkers.load() > 0)
+    {
+        lock_guard<mutex> lock(m_sleepMutex);
+        m_wakeUp.notify_one();
+    }
+}
+
+void JobSystemClass::Wait(JobCounter& counter)
+{
+    int workerIndex = GetWorkerIndex();
+    while (counter.value.load(memory_order_acquire) > 0)
+    {
+        Job* job = workerIndex >= 0 ? FindJob(workerIndex) : nullptr;
+        if (job != nullptr)
+        {
+            Execute(job);
+        }
+        else
+        {
+            this_thread::yield();
+        }
+    }
+}
+
+void JobSystemClass::ParallelFor(const unsigned int count, const unsigned int grainSize, const function<void(unsigned int, unsigned int)>& body)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // A few batches per worker leaves room for stealing to even out uneven batches.
+    unsigned int grain = max(grainSize, 1u);
+    unsigned int batches = min((count + grain - 1) / grain, (unsigned int)m_workers.size() * 4);
+    unsigned int batchSize = (count + batches - 1) / batches;
+
+    JobCounter counter;
+    for (unsigned int begin = 0; begin < count; begin += batchSize)
+    {
+        unsigned int end = min(begin + batchSize, count);
+        Run([&body, begin, end]() { body(begin, end); }, counter);
+    }
+    Wait(counter);
+}
+
+int JobSystemClass::GetThreadCount()
+{
+    return (int)m_workers.size();
+}
+
+void JobSystemClass::WorkerThread(const int workerIndex)
+{
+    t_jobSystem = this;
+    t_workerIndex = workerIndex;
+
+    int spins = 0;
+    while (!m_shuttingDown.load())
+    {
+        Job* job = FindJob(workerIndex);
+        if (job != nullptr)
+        {
+            Execute(job);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < SPINS_BEFORE_SLEEP)
+        {
+            this_thread::yield();
+            continue;
+        }
+
+        m_sleepingWorkers.fetch_add(1);
+        {
+            unique_lock<mutex> lock(m_sleepMutex);
+            m_wakeUp.wait(lock, [this]() { return m_queuedJobs.load() > 0 || m_shuttingDown.load(); });
+        }
+        m_sleepingWorkers.fetch_sub(1);
+        spins = 0;
+    }
+}
+
+int JobSystemClass::GetWorkerIndex()
+{
+    return t_jobSystem == this ? t_workerIndex : -1;
+}
+
+JobSystemClass::Job* JobSystemClass::FindJob(const int workerIndex)
+{
+    Worker& worker = *m_workers[workerIndex];
+    Job* job = worker.deque.Pop();
+
+    // Our own deque is empty, so try the others starting from a random victim.
+    if (job == nullptr && m_workers.size() > 1)
+    {
+        worker.stealSeed = worker.stealSeed * 1664525 + 1013904223;
+        unsigned int workerCount = (unsigned int)m_workers.size();
+        unsigned int first = (worker.stealSeed >> 16) % workerCount;
+        for (unsigned int i = 0; i < workerCount && job == nullptr; i++)
+        {
+            unsigned int victim = (first + i) % workerCount;
+            if (victim != (unsigned int)workerIndex)
+            {
+                job = m_workers[victim]->deque.Steal();
+            }
+        }
+    }
+
+    if (job != nullptr)
+    {
+        m_queuedJobs.fetch_sub(1);
+    }
+    return job;
+}
+
+void JobSystemClass::Execute(Job* job)
+{
+    job->work();
+    job->work = nullptr;
+
+    // The slot can be refilled as soon as it is released, so read the counter first.
+    JobCounter* counter = job->counter;
+    job->taken.store(false, memory_order_release);
+    counter->value.fetch_sub(1, memory_order_release);
+}
+
+void JobSystemClass::Validate()
+{
+    const unsigned int jobCount = 3 * MAX_JOBS_PER_WORKER;
+    const unsigned int nestedJobs = 4;
+    vector<atomic<int>> runs(jobCount * (1 + nestedJobs));
+    for (auto& run : runs)
+    {
+        run.store(0);
+    }
+
+    JobSystemClass jobSystem;
+    jobSystem.Initialize(4);
+
+    // Every 64th job sleeps, long enough for the others to lap the slot ring while a thief still runs it.
+    JobCounter counter;
+    for (unsigned int i = 0; i < jobCount; i++)
+    {
+        jobSystem.Run([&jobSystem, &runs, &counter, i, jobCount, nestedJobs]()
+        {
+            runs[i].fetch_add(1);
+            if (i % 64 == 0)
+            {
+                Sleep(1);
+            }
+            for (unsigned int j = 0; j < nestedJobs; j++)
+            {
+                unsigned int nested = jobCount + i * nestedJobs + j;
+                jobSystem.Run([&runs, nested]() { runs[nested].fetch_add(1); }, counter);
+            }
+        }, counter);
+    }
+    jobSystem.Wait(counter);
+
+    for (unsigned int i = 0; i < runs.size(); i++)
+    {
+        if (runs[i].load() != 1)
+        {
+            throw engine_exception("Job ") << i << " ran " << runs[i].load() << " times instead of once";
+        }
+    }
+    if (counter.value.load() != 0)
+    {
+        throw engine_exception("The job counter ended at ") << counter.value.load() << " instead of zero";
+    }
+}
+
+void JobSystemClass::Benchmark(const unsigned int objectCount)
+{
+    // Each object spins its transform a few times, roughly what an animation or physics update costs per object.
+    vector<XMFLOAT4X4> transforms(objectCount);
+    for (auto& transform : transforms)
+    {
+        XMStoreFloat4x4(&transform, XMMatrixIdentity());
+    }
+
+    auto update = [&transforms](unsigned int begin, unsigned int end)
+    {
+        XMMATRIX step = XMMatrixRotationRollPitchYaw(0.01f, 0.02f, 0.03f);
+        for (unsigned int i = begin; i < end; i++)
+        {
+            XMMATRIX world = XMLoadFloat4x4(&transforms[i]);
+            for (int iteration = 0; iteration < 64; iteration++)
+            {
+                world = XMMatrixMultiply(world, step);
+            }
+            XMStoreFloat4x4(&transforms[i], world);
+        }
+    };
+
+    const int frames = 20;
+    int maxThreads = max((int)thread::hardware_concurrency(), 1);
+    double singleThreadSeconds = 0.0;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    LOG_INFO("Job system benchmark: {} objects", objectCount);
+    for (int threads = 1; threads <= maxThreads; threads++)
+    {
+        JobSystemClass jobSystem;
+        jobSystem.Initialize(threads);
+
+        // One untimed frame wakes the workers up.
+        jobSystem.ParallelFor(objectCount, 64, update);
+
+        LARGE_INTEGER start, end;
+        QueryPerformanceCounter(&start);
+        for (int frame = 0; frame < frames; frame++)
+        {
+            jobSystem.ParallelFor(objectCount, 64, update);
+        }
+        QueryPerformanceCounter(&end);
+
+        double seconds = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart / frames;
+        if (threads == 1)
+        {
+            singleThreadSeconds = seconds;
+        }
+
+        LOG_INFO("  {} threads: {} ms per frame, speedup {}x", threads, seconds * 1000.0, singleThreadSeconds / seconds);
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "engine_core.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+
+// Counts the unfinished jobs started against it; Wait on it to depend on all of them.
+struct JobCounter
+{
+    atomic<int> value;
+
+    JobCounter() : value(0)
+    {
+    }
+};
+
+// Work-stealing task scheduler. Every worker owns a Chase-Lev deque: it pushes and pops jobs at the bottom, idle workers
+// steal from the top. The thread that calls Initialize is worker 0 and only runs jobs while it waits on a counter, so
+// the frame loop keeps its thread. Jobs may only be started from worker threads. Each worker has MAX_JOBS_PER_WORKER job
+// slots, recycled in order once the job in them has finished; while the next one is still taken Run does the work itself.
+class JobSystemClass
+{
+public:
+    static const unsigned int MAX_JOBS_PER_WORKER = 4096;
+
+    JobSystemClass();
+
+    ~JobSystemClass();
+
+    // A thread count of zero uses one worker per hardware thread.
+    void Initialize(int threadCount);
+
+    void Shutdown();
+
+    void Run(const function<void()>& work, JobCounter& counter);
+
+    // Runs queued jobs on this thread until every job started against counter has finished.
+    void Wait(JobCounter& counter);
+
+    // Calls body over [0, count) in batches of at least grainSize items spread over all workers, and returns when done.
+    void ParallelFor(const unsigned int count, const unsigned int grainSize, const function<void(unsigned int, unsigned int)>& body);
+
+    int GetThreadCount();
+
+    // Starts several times more jobs than a worker has slots, from worker 0 and from inside jobs, with slow jobs mixed in
+    // so stolen ones are still running when their slots come round again. Every job must run exactly once. Throws on a
+    // failure.
+    static void Validate();
+
+    // Times a synthetic per object workload with 1 to N workers and writes the speedups to the log.
+    static void Benchmark(const unsigned int objectCount);
+
+private:
+    struct Job
+    {
+        function<void()> work;
+        JobCounter* counter;
+        // Set by the owning worker when it fills the slot, cleared by whichever thread ran the job once it is done.
+        atomic<bool> taken;
+
+        Job() : counter(nullptr), taken(false)
+        {
+        }
+    };
+
+    // Lock free deque from "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013).
+    class WorkStealingDeque
+    {
+    public:
+        WorkStealingDeque();
+
+        bool Push(Job* job);
+
+        Job* Pop();
+
+        Job* Steal();
+
+    private:
+        atomic<Job*> m_jobs[MAX_JOBS_PER_WORKER];
+        atomic<long long> m_top;
+        atomic<long long> m_bottom;
+    };
+
+    struct Worker
+    {
+        WorkStealingDeque deque;
+        Job jobs[MAX_JOBS_PER_WORKER];
+        unsigned int nextJob;
+        unsigned int stealSeed;
+    };
+
+    vector<unique_ptr<Worker>> m_workers;
+    vector<thread> m_threads;
+    atomic<int> m_queuedJobs;
+    atomic<int> m_sleepingWorkers;
+    atomic<bool> m_shuttingDown;
+    mutex m_sleepMutex;
+    condition_variable m_wakeUp;
+    JobSystemClass* m_previousSystem;
+
+    void WorkerThread(const int workerIndex);
+
+    int GetWorkerIndex();
+
+    Job* FindJob(const int workerIndex);
+
+    void Execute(Job* job);
+};
@@ -0,0 +1,262 @@
+#include "linearallocatorclass.h"
+#include "poolallocatorclass.h"
+#include <algorithm>
+
+LinearAllocatorClass::LinearAllocatorClass() : m_offset(0), m_allocations(0), m_failures(0)
+{
+    m_name = "";
+    m_capacity = 0;
+    m_growable = false;
+    m_chunk = nullptr;
+    m_retired = 0;
+    m_resets = 0;
+    m_peak = 0;
+}
+
+LinearAllocatorClass::~LinearAllocatorClass()
+{
+    FreeChunks();
+}
+
+void LinearAllocatorClass::Initialize(const char* name, const size_t capacity, const bool growable)
+{
+    static_assert(sizeof(Chunk) <= CHUNK_HEADER_SIZE, "Chunk header doesn't fit in front of the data");
+
+    FreeChunks();
+    m_name = name;
+    m_capacity = capacity;
+    m_growable = growable;
+    m_retired = 0;
+    AddChunk(capacity);
+}
+
+unsigned char* LinearAllocatorClass::GetData(Chunk* chunk)
+{
+    return (unsigned char*)chunk + CHUNK_HEADER_SIZE;
+}
+
+void* LinearAllocatorClass::Allocate(const size_t size, const size_t alignment)
+{
+    m_allocations.fetch_add(1, memory_order_relaxed);
+
+    // Claim the block with a compare and swap, so threads sharing a fixed allocator never take a lock.
+    size_t offset = m_offset.load(memory_order_relaxed);
+    size_t begin, user, end;
+    for (;;)
+    {
+        size_t base = (size_t)GetData(m_chunk);
+#if ENGINE_MEMORY_GUARDS
+        begin = MemoryClass::AlignUp(offset, __alignof(BlockHeader));
+        user = MemoryClass::AlignUp(base + begin + sizeof(BlockHeader) + MemoryClass::GUARD_SIZE, alignment) - base;
+        end = user + size + MemoryClass::GUARD_SIZE;
+#else
+        begin = offset;
+        user = MemoryClass::AlignUp(base + begin, alignment) - base;
+        end = user + size;
+#endif
+        if (end > m_chunk->capacity)
+        {
+            if (!m_growable)
+            {
+                m_failures.fetch_add(1, memory_order_relaxed);
+                return nullptr;
+            }
+
+            AddChunk(size + alignment + sizeof(BlockHeader) + 2 * MemoryClass::GUARD_SIZE);
+            offset = 0;
+            continue;
+        }
+
+        if (m_offset.compare_exchange_weak(offset, end, memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    unsigned char* data = GetData(m_chunk);
+#if ENGINE_MEMORY_GUARDS
+    BlockHeader* header = (BlockHeader*)(data + begin);
+    header->userOffset = user;
+    header->size = size;
+    MemoryClass::FillGuard(data + user - MemoryClass::GUARD_SIZE);
+    MemoryClass::FillGuard(data + user + size);
+#endif
+    return data + user;
+}
+
+void LinearAllocatorClass::Reset()
+{
+    size_t offset = m_offset.load(memory_order_relaxed);
+    m_peak = max(m_peak, m_retired + offset);
+
+#if ENGINE_MEMORY_GUARDS
+    for (Chunk* chunk = m_chunk; chunk != nullptr; chunk = chunk->previous)
+    {
+        size_t used = chunk == m_chunk ? offset : chunk->used;
+        CheckBlocks(chunk, used);
+        memset(GetData(chunk), MemoryClass::FREED_BYTE, used);
+    }
+#endif
+
+    while (m_chunk->previous != nullptr)
+    {
+        Chunk* previous = m_chunk->previous;
+        MemoryClass::FreeAligned(m_chunk);
+        m_chunk = previous;
+    }
+
+    m_offset.store(0, memory_order_relaxed);
+    m_retired = 0;
+    m_resets++;
+}
+
+LinearAllocatorClass::Statistics LinearAllocatorClass::GetStatistics()
+{
+    Statistics statistics;
+    statistics.capacity = m_capacity;
+    statistics.used = m_retired + m_offset.load(memory_order_relaxed);
+    statistics.peak = max(m_peak, statistics.used);
+    statistics.allocations = m_allocations.load(memory_order_relaxed);
+    statistics.failures = m_failures.load(memory_order_relaxed);
+    statistics.resets = m_resets;
+    return statistics;
+}
+
+void LinearAllocatorClass::LogStatistics()
+{
+    Statistics statistics = GetStatistics();
+    LOG_INFO("{}: {} KB of {} KB used, {} KB at most, {} allocations, {} failed", m_name, statistics.used / 1024.0, statistics.capacity / 1024.0,
+             statistics.peak / 1024.0, statistics.allocations, statistics.failures);
+}
+
+void LinearAllocatorClass::AddChunk(const size_t minimumCapacity)
+{
+    size_t capacity = max(m_capacity, minimumCapacity);
+    Chunk* chunk = (Chunk*)MemoryClass::AllocateAligned(CHUNK_HEADER_SIZE + capacity, CHUNK_ALIGNMENT);
+    chunk->previous = m_chunk;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+
+    if (m_chunk != nullptr)
+    {
+        m_chunk->used = m_offset.load(memory_order_relaxed);
+        m_retired += m_chunk->used;
+    }
+
+    m_chunk = chunk;
+    m_offset.store(0, memory_order_relaxed);
+}
+
+void LinearAllocatorClass::FreeChunks()
+{
+    while (m_chunk != nullptr)
+    {
+        Chunk* previous = m_chunk->previous;
+        MemoryClass::FreeAligned(m_chunk);
+        m_chunk = previous;
+    }
+}
+
+void LinearAllocatorClass::CheckBlocks(Chunk* chunk, const size_t used)
+{
+    unsigned char* data = GetData(chunk);
+    size_t begin = 0;
+    while (begin < used)
+    {
+        begin = MemoryClass::AlignUp(begin, __alignof(BlockHeader));
+        const BlockHeader* header = (const BlockHeader*)(data + begin);
+        MemoryClass::CheckGuard(data + header->userOffset - MemoryClass::GUARD_SIZE, m_name);
+        MemoryClass::CheckGuard(data + header->userOffset + header->size, m_name);
+        begin = header->userOffset + header->size + MemoryClass::GUARD_SIZE;
+    }
+}
+
+void LinearAllocatorClass::Validate()
+{
+    auto check = [](const bool passed, const char* what)
+    {
+        if (!passed)
+        {
+            throw engine_exception("Linear allocator validation: ") << what;
+        }
+    };
+
+    // A fixed allocator runs out, and after a reset hands out the same memory again.
+    LinearAllocatorClass fixed;
+    fixed.Initialize("Validation fixed", 4096, false);
+    void* first = fixed.Allocate(100, 16);
+    unsigned int blocks = 1;
+    while (fixed.Allocate(100, 16) != nullptr)
+    {
+        blocks++;
+    }
+    Statistics statistics = fixed.GetStatistics();
+    check(blocks > 1 && statistics.failures == 1 && statistics.allocations == blocks + 1, "a full fixed allocator didn't fail once");
+    fixed.Reset();
+    statistics = fixed.GetStatistics();
+    check(statistics.used == 0 && statistics.resets == 1 && statistics.peak > 0, "a reset didn't free every block");
+    check(fixed.Allocate(100, 16) == first, "a reset allocator didn't start from the front");
+
+    // A growing arena chains chunks, and keeps only its first over a reset.
+    LinearAllocatorClass arena;
+    arena.Initialize("Validation arena", 4096, true);
+    void* arenaFirst = arena.Allocate(100, 16);
+    for (unsigned int i = 0; i < 4 * blocks; i++)
+    {
+        check(arena.Allocate(100, 16) != nullptr, "a growing arena failed an allocation");
+    }
+    check(arena.GetStatistics().used > 4096, "a growing arena didn't chain another chunk");
+    arena.Reset();
+    check(arena.Allocate(100, 16) == arenaFirst, "a reset arena didn't go back to its first chunk");
+
+#if ENGINE_MEMORY_GUARDS
+    LinearAllocatorClass overrun;
+    overrun.Initialize("Validation overrun", 4096, false);
+    unsigned char* block = (unsigned char*)overrun.Allocate(32, 16);
+    block[32] = 0;
+    bool threw = false;
+    try
+    {
+        overrun.Reset();
+    }
+    catch (const engine_exception&)
+    {
+        threw = true;
+    }
+    check(threw, "resetting after a block was overrun didn't throw");
+#else
+    LOG_INFO("Linear allocator validation: built without ENGINE_MEMORY_GUARDS, so overruns aren't caught");
+#endif
+
+    // Frames that take their scratch memory from a frame allocator and their objects from a pool, once both have their
+    // memory, allocate nothing from the heap. The counter itself has to move for an allocation the heap does make.
+    LinearAllocatorClass frameAllocator;
+    frameAllocator.Initialize("Validation frame", 64 * 1024, false);
+    PoolAllocatorClass objects("Validation objects", 64, 16, 32);
+    objects.Free(objects.Allocate(64));
+    unsigned long long heapAllocations = MemoryClass::GetThreadHeapAllocationCount();
+    MemoryClass::FreeAligned(MemoryClass::AllocateAligned(64, 16));
+    check(MemoryClass::GetThreadHeapAllocationCount() == heapAllocations + 1, "a heap allocation wasn't counted");
+    heapAllocations++;
+
+    const unsigned int frameCount = 120;
+    for (unsigned int frame = 0; frame < frameCount; frame++)
+    {
+        float* scratch = frameAllocator.AllocateArray<float>(1024 + frame);
+        check(scratch != nullptr, "the frame allocator ran out");
+        scratch[0] = (float)frame;
+        void* live[32];
+        for (unsigned int i = 0; i < 32; i++)
+        {
+            live[i] = objects.Allocate(64);
+        }
+        for (unsigned int i = 0; i < 32; i++)
+        {
+            objects.Free(live[i]);
+        }
+        frameAllocator.Reset();
+    }
+    check(MemoryClass::GetThreadHeapAllocationCount() == heapAllocations, "the frame loop allocated from the heap");
+
+    LOG_INFO("Linear allocator validation passed: {} frames without a heap allocation", frameCount);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "engine_core.h"
+#include "memoryclass.h"
+#include <atomic>
+
+using namespace std;
+
+// Bump allocator: blocks are cut off the front of its memory and only freed all at once, by Reset. It serves as the
+// frame allocator, which D3DClass resets at EndScene, and as arenas for scratch memory while loading. A fixed allocator
+// owns one block of memory, returns nullptr when that is full and can be allocated from on any thread. A growing arena
+// chains another chunk instead and is for one thread at a time. With ENGINE_MEMORY_GUARDS every block is fenced by guard
+// bytes that Reset checks, and Reset fills the freed memory.
+class LinearAllocatorClass
+{
+public:
+    struct Statistics
+    {
+        size_t capacity; // Bytes in every chunk.
+        size_t used; // Bytes handed out since the last reset, including alignment and guards.
+        size_t peak; // Most bytes used between two resets.
+        unsigned long long allocations;
+        unsigned long long failures;
+        unsigned long long resets;
+    };
+
+    LinearAllocatorClass();
+
+    ~LinearAllocatorClass();
+
+    // capacity is the size of the fixed block, or of each chunk of a growing arena. The name is used in the statistics
+    // and guard errors and must outlive the allocator.
+    void Initialize(const char* name, const size_t capacity, const bool growable);
+
+    // Uninitialized memory, valid until the next Reset. alignment must be a power of two.
+    void* Allocate(const size_t size, const size_t alignment);
+
+    // Uninitialized space for count elements; only for types without constructors or destructors that matter.
+    template <class T>
+    T* AllocateArray(const size_t count)
+    {
+        return static_cast<T*>(Allocate(count * sizeof(T), __alignof(T)));
+    }
+
+    // Frees every block at once. A growing arena keeps its first chunk. Nothing may allocate during a reset.
+    void Reset();
+
+    Statistics GetStatistics();
+
+    void LogStatistics();
+
+    // Fills fixed and growing allocators and resets them, and with ENGINE_MEMORY_GUARDS overruns a block, which Reset must
+    // throw for. Then runs frames that only allocate from a frame allocator and a pool, which must not add a single heap
+    // allocation on the thread. Throws on a failure.
+    static void Validate();
+
+private:
+    // Each chunk of memory starts with one of these.
+    struct Chunk
+    {
+        Chunk* previous;
+        size_t capacity;
+        size_t used; // Set once the chunk is full and a newer one took over.
+    };
+
+    // In front of every block when guards are on, so Reset can walk the blocks and check their guards.
+    struct BlockHeader
+    {
+        size_t userOffset;
+        size_t size;
+    };
+
+    static const size_t CHUNK_ALIGNMENT = 64;
+    static const size_t CHUNK_HEADER_SIZE = 64;
+
+    const char* m_name;
+    size_t m_capacity;
+    bool m_growable;
+    Chunk* m_chunk;
+    // Into the current chunk's data.
+    atomic<size_t> m_offset;
+    // Bytes used in older chunks since the last reset.
+    size_t m_retired;
+    atomic<unsigned long long> m_allocations;
+    atomic<unsigned long long> m_failures;
+    unsigned long long m_resets;
+    size_t m_peak;
+
+    static unsigned char* GetData(Chunk* chunk);
+
+    void AddChunk(const size_t minimumCapacity);
+
+    void FreeChunks();
+
+    void CheckBlocks(Chunk* chunk, const size_t used);
+};
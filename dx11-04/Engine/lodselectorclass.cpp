@@ -0,0 +1,291 @@
+#include "lodselectorclass.h"
+#include "meshsimplifierclass.h"
+#include "frustumcullerclass.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+using namespace std;
+
+namespace
+{
+    typedef MeshSimplifierClass::VertexType VertexType;
+    typedef MeshFileClass::MeshFileLod Lod;
+
+    // The view the validation and benchmark select for: a 45 degree field of view at 1080p.
+    const float VIEW_FIELD_OF_VIEW = XM_PIDIV4;
+    const float VIEW_ASPECT_RATIO = 16.0f / 9.0f;
+    const float VIEW_HEIGHT = 1080.0f;
+    const float VIEW_NEAR = 0.1f;
+    const float VIEW_FAR = 1000.0f;
+
+    // Benchmark scene: rocks of about a unit radius SPACING apart, and a camera at walking speed that bobs back and forth further
+    // than it moves in a frame.
+    const unsigned int ROCK_RINGS = 64;
+    const unsigned int ROCK_SEGMENTS = 128;
+    const float ROCK_BUMPS = 0.08f;
+    const float SPACING = 4.0f;
+    const float CAMERA_HEIGHT = 6.0f;
+    const float CAMERA_SPEED = 0.05f;
+    const float CAMERA_BOB = 0.5f;
+    const float CAMERA_BOB_RATE = 0.2f;
+
+    float Random(unsigned int& seed)
+    {
+        seed = seed * 1664525 + 1013904223;
+        return (float)(seed >> 8) / 16777216.0f;
+    }
+
+    // A sphere of radius about 1 with bumps of ROCK_BUMPS in it, wound to face out.
+    void AddRock(vector<VertexType>& vertices, vector<unsigned int>& indices)
+    {
+        for (unsigned int ring = 0; ring <= ROCK_RINGS; ring++)
+        {
+            float theta = XM_PI * ring / ROCK_RINGS;
+            for (unsigned int segment = 0; segment <= ROCK_SEGMENTS; segment++)
+            {
+                float phi = XM_2PI * segment / ROCK_SEGMENTS;
+                float radius = 1.0f + ROCK_BUMPS * sinf(5.0f * theta) * cosf(7.0f * phi);
+                VertexType vertex;
+                vertex.position = XMFLOAT3(radius * sinf(theta) * cosf(phi), radius * cosf(theta), radius * sinf(theta) * sinf(phi));
+                vertex.color = XMFLOAT4(0.5f, 0.45f, 0.4f, 1.0f);
+                vertices.push_back(vertex);
+            }
+        }
+
+        for (unsigned int ring = 0; ring < ROCK_RINGS; ring++)
+        {
+            for (unsigned int segment = 0; segment < ROCK_SEGMENTS; segment++)
+            {
+                unsigned int a = ring * (ROCK_SEGMENTS + 1) + segment, b = a + 1, c = a + ROCK_SEGMENTS + 1, d = c + 1;
+                unsigned int quad[6] = { a, d, b, a, c, d };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    }
+}
+
+LodSelectorClass::LodSelectorClass()
+{
+    Initialize(GetDefaultSettings());
+    m_cameraPosition = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    m_pixelsPerUnit = 1.0f;
+}
+
+LodSelectorClass::~LodSelectorClass()
+{
+}
+
+LodSelectorClass::Settings LodSelectorClass::GetDefaultSettings()
+{
+    Settings settings;
+    settings.pixelError = 1.0f;
+    settings.hysteresis = 0.25f;
+    return settings;
+}
+
+void LodSelectorClass::Initialize(const Settings& settings)
+{
+    if (settings.pixelError <= 0.0f || settings.hysteresis < 0.0f || settings.hysteresis >= 1.0f)
+    {
+        throw engine_exception("LOD selection needs a positive pixel error and a hysteresis from 0 to under 1, not ") << settings.pixelError << " and "
+                                                                                                                       << settings.hysteresis;
+    }
+    m_settings = settings;
+}
+
+void LodSelectorClass::SetView(const XMFLOAT3& cameraPosition, const XMMATRIX& projection, const float viewportHeight)
+{
+    m_cameraPosition = cameraPosition;
+    m_pixelsPerUnit = XMVectorGetY(projection.r[1]) * viewportHeight * 0.5f;
+}
+
+float LodSelectorClass::GetProjectedSize(const XMFLOAT3& position, const float size)
+{
+    XMFLOAT3 offset(position.x - m_cameraPosition.x, position.y - m_cameraPosition.y, position.z - m_cameraPosition.z);
+    float distance = sqrtf(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+    return distance > 0.0f ? size * m_pixelsPerUnit / distance : FLT_MAX;
+}
+
+unsigned int LodSelectorClass::Select(const MeshFileClass::MeshFileLod* lods, const unsigned int lodCount, const XMMATRIX& world, const XMFLOAT3& center,
+                                      const unsigned int currentLod)
+{
+    if (lodCount <= 1)
+    {
+        return 0;
+    }
+
+    XMFLOAT3 position;
+    XMStoreFloat3(&position, XMVector3Transform(XMLoadFloat3(&center), world));
+    float scaleSquared = max(max(XMVectorGetX(XMVector3LengthSq(world.r[0])), XMVectorGetX(XMVector3LengthSq(world.r[1]))),
+                             XMVectorGetX(XMVector3LengthSq(world.r[2])));
+    float pixelsPerError = GetProjectedSize(position, sqrtf(scaleSquared));
+
+    // The coarsest LOD within the error.
+    unsigned int target = 0;
+    while (target + 1 < lodCount && lods[target + 1].error * pixelsPerError <= m_settings.pixelError)
+    {
+        target++;
+    }
+
+    unsigned int lod = min(currentLod, lodCount - 1);
+    if (target <= lod)
+    {
+        return target;
+    }
+
+    // Moving down only goes as far as LODs comfortably within it.
+    float coarserError = m_settings.pixelError * (1.0f - m_settings.hysteresis);
+    while (lod < target && lods[lod + 1].error * pixelsPerError <= coarserError)
+    {
+        lod++;
+    }
+    return lod;
+}
+
+void LodSelectorClass::Validate()
+{
+    const XMFLOAT3 origin(0.0f, 0.0f, 0.0f);
+    XMMATRIX projection = XMMatrixPerspectiveFovLH(VIEW_FIELD_OF_VIEW, VIEW_ASPECT_RATIO, VIEW_NEAR, VIEW_FAR);
+    Lod lods[5] = { { 0, 3072, 0.0f }, { 3072, 1536, 0.001f }, { 4608, 768, 0.002f }, { 5376, 384, 0.004f }, { 5760, 192, 0.008f } };
+    const unsigned int lodCount = 5;
+
+    LodSelectorClass selector, noHysteresis;
+    Settings settings = GetDefaultSettings();
+    selector.Initialize(settings);
+    settings.hysteresis = 0.0f;
+    noHysteresis.Initialize(settings);
+    selector.SetView(origin, projection, VIEW_HEIGHT);
+    noHysteresis.SetView(origin, projection, VIEW_HEIGHT);
+
+    // Something as tall as the frustum at its distance fills the viewport.
+    float distance = 10.0f;
+    float size = selector.GetProjectedSize(XMFLOAT3(0.0f, 0.0f, distance), 2.0f * distance * tanf(VIEW_FIELD_OF_VIEW * 0.5f));
+    if (fabsf(size - VIEW_HEIGHT) > VIEW_HEIGHT * 1e-3f)
+    {
+        throw engine_exception("LOD selector validation: the height of the frustum projected to ") << size << " pixels, not " << VIEW_HEIGHT;
+    }
+
+    // Going away from the camera the LOD starts full, only ever gets coarser, never has more than the error on screen and
+    // ends up at the coarsest. Twice the scale at twice the distance looks the same.
+    unsigned int lod = 0;
+    for (float z = 0.1f; z < VIEW_FAR; z *= 1.05f)
+    {
+        unsigned int next = selector.Select(lods, lodCount, XMMatrixTranslation(0.0f, 0.0f, z), origin, lod);
+        float pixels = lods[next].error * selector.GetProjectedSize(XMFLOAT3(0.0f, 0.0f, z), 1.0f);
+        unsigned int scaled = noHysteresis.Select(lods, lodCount, XMMatrixScaling(2.0f, 2.0f, 2.0f) * XMMatrixTranslation(0.0f, 0.0f, 2.0f * z), origin, 0);
+        unsigned int unscaled = noHysteresis.Select(lods, lodCount, XMMatrixTranslation(0.0f, 0.0f, z), origin, 0);
+        if ((z == 0.1f && next != 0) || next < lod || pixels > settings.pixelError || scaled != unscaled)
+        {
+            throw engine_exception("LOD selector validation: at ") << z << " LOD " << next << " after " << lod << ", " << pixels
+                                                                    << " pixels of error, " << scaled << " at twice the scale and distance against " << unscaled;
+        }
+        lod = next;
+    }
+    if (lod != lodCount - 1)
+    {
+        throw engine_exception("LOD selector validation: LOD ") << lod << " at the far plane, not " << lodCount - 1;
+    }
+
+    // A camera wobbling 2% either way of the distance where LOD 2 comes within the error.
+    distance = lods[2].error * selector.GetProjectedSize(XMFLOAT3(0.0f, 0.0f, 1.0f), 1.0f) / settings.pixelError;
+    unsigned int lodWith = 0, lodWithout = 0, switches = 0, switchesWithout = 0;
+    for (unsigned int frame = 0; frame < 100; frame++)
+    {
+        XMMATRIX world = XMMatrixTranslation(0.0f, 0.0f, distance * (frame % 2 == 0 ? 1.02f : 0.98f));
+        unsigned int with = selector.Select(lods, lodCount, world, origin, lodWith);
+        unsigned int without = noHysteresis.Select(lods, lodCount, world, origin, lodWithout);
+        switches += with != lodWith ? 1 : 0;
+        switchesWithout += without != lodWithout ? 1 : 0;
+        lodWith = with;
+        lodWithout = without;
+    }
+    if (switches > 2 || switchesWithout < 50)
+    {
+        throw engine_exception("LOD selector validation: a wobbling camera switched LODs ") << switches << " times, " << switchesWithout
+                                                                                              << " without hysteresis";
+    }
+}
+
+void LodSelectorClass::Benchmark(const unsigned int objectCount, const unsigned int frameCount)
+{
+    if (objectCount == 0 || frameCount < 2)
+    {
+        return;
+    }
+
+    vector<VertexType> vertices;
+    vector<unsigned int> indices, lodIndices;
+    vector<Lod> lods;
+    AddRock(vertices, indices);
+    MeshSimplifierClass::BuildLodChain(vertices, indices, lodIndices, lods);
+    unsigned int lodCount = (unsigned int)lods.size();
+    float rockRadius = 1.0f + ROCK_BUMPS;
+
+    // The rocks stand in rows going away from the camera, at random sizes.
+    unsigned int side = (unsigned int)ceil(sqrt((double)objectCount));
+    vector<XMFLOAT4X4> worlds(objectCount);
+    FrustumCullerClass culler;
+    culler.Reserve(objectCount, 0);
+    unsigned int seed = 12345;
+    for (unsigned int i = 0; i < objectCount; i++)
+    {
+        float scale = 0.5f + Random(seed) * 1.5f;
+        XMFLOAT3 position(((float)(i % side) - side * 0.5f) * SPACING, scale, (float)(i / side) * SPACING);
+        XMStoreFloat4x4(&worlds[i], XMMatrixScaling(scale, scale, scale) * XMMatrixTranslation(position.x, position.y, position.z));
+        culler.AddSphere(position, rockRadius * scale);
+    }
+    vector<unsigned int> visible(max(culler.GetPaddedSphereCount(), 1u));
+    vector<unsigned int> lodsWith(objectCount, 0), lodsWithout(objectCount, 0);
+
+    LodSelectorClass selector, noHysteresis;
+    Settings settings = GetDefaultSettings();
+    selector.Initialize(settings);
+    settings.hysteresis = 0.0f;
+    noHysteresis.Initialize(settings);
+    XMMATRIX projection = XMMatrixPerspectiveFovLH(VIEW_FIELD_OF_VIEW, VIEW_ASPECT_RATIO, VIEW_NEAR, VIEW_FAR);
+
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+    double selectSeconds = 0.0;
+    unsigned long long visibleObjects = 0, fullTriangles = 0, lodTriangles = 0, switches = 0, switchesWithout = 0;
+    const XMFLOAT3 origin(0.0f, 0.0f, 0.0f);
+    for (unsigned int frame = 0; frame < frameCount; frame++)
+    {
+        XMFLOAT3 eye(0.0f, CAMERA_HEIGHT, -SPACING + CAMERA_SPEED * frame + CAMERA_BOB * sinf(frame * CAMERA_BOB_RATE));
+        XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&eye), XMVectorSet(0.0f, -0.2f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        culler.SetFrustum(view, projection);
+        unsigned int visibleCount = culler.CullSpheres(visible.data());
+        visibleObjects += visibleCount;
+        selector.SetView(eye, projection, VIEW_HEIGHT);
+        noHysteresis.SetView(eye, projection, VIEW_HEIGHT);
+
+        QueryPerformanceCounter(&start);
+        for (unsigned int i = 0; i < visibleCount; i++)
+        {
+            unsigned int object = visible[i];
+            unsigned int lod = selector.Select(lods.data(), lodCount, XMLoadFloat4x4(&worlds[object]), origin, lodsWith[object]);
+            switches += frame > 0 && lod != lodsWith[object] ? 1 : 0;
+            lodsWith[object] = lod;
+            lodTriangles += lods[lod].indexCount / 3;
+        }
+        QueryPerformanceCounter(&end);
+        selectSeconds += (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+
+        for (unsigned int i = 0; i < visibleCount; i++)
+        {
+            unsigned int object = visible[i];
+            unsigned int lod = noHysteresis.Select(lods.data(), lodCount, XMLoadFloat4x4(&worlds[object]), origin, lodsWithout[object]);
+            switchesWithout += frame > 0 && lod != lodsWithout[object] ? 1 : 0;
+            lodsWithout[object] = lod;
+        }
+        fullTriangles += (unsigned long long)visibleCount * (lods[0].indexCount / 3);
+    }
+
+    double frames = frameCount;
+    LOG_INFO("LOD benchmark: {} rocks of {} triangles in {} LODs, {} visible per frame; {} triangles submitted per frame at full detail, {} with "
+             "LODs ({}x fewer); {} LOD switches per frame, {} without hysteresis; {} ms per frame selecting", objectCount, lods[0].indexCount / 3,
+             lodCount, visibleObjects / frameCount, fullTriangles / frameCount, lodTriangles / frameCount, (double)fullTriangles / max(lodTriangles, 1ull),
+             switches / (frames - 1.0), switchesWithout / (frames - 1.0), selectSeconds * 1000.0 / frames);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "engine.h"
+#include "meshfileclass.h"
+
+using namespace DirectX;
+
+// Picks the level of detail to draw an object at from how large the error of each of its LODs comes out on screen.
+// Under a perspective projection something size units across at distance d covers size * projection._22 / d of half the
+// viewport's height, so the selector works from the projection the scene is drawn with and the viewport height in
+// pixels. The coarsest LOD whose error covers at most pixelError pixels is drawn, except that an object only moves down
+// to a coarser LOD once that one is under pixelError by the hysteresis fraction; objects near a switching distance
+// would otherwise pop back and forth between two LODs as the camera wobbles. Moving up to a finer LOD is never held back.
+class LodSelectorClass
+{
+public:
+    struct Settings
+    {
+        // Pixels on screen a LOD's error may cover.
+        float pixelError;
+        // Fraction of pixelError a coarser LOD's error has to be under before an object moves down to it.
+        float hysteresis;
+    };
+
+    LodSelectorClass();
+
+    ~LodSelectorClass();
+
+    // A pixel of error, a quarter of it held back for hysteresis.
+    static Settings GetDefaultSettings();
+
+    void Initialize(const Settings& settings);
+
+    // Call once a frame before selecting, with the height in pixels the scene renders at.
+    void SetView(const XMFLOAT3& cameraPosition, const XMMATRIX& projection, const float viewportHeight);
+
+    // Pixels something size units across at position covers on screen.
+    float GetProjectedSize(const XMFLOAT3& position, const float size);
+
+    // lods are the object's, finest first, and center the object space point its distance is measured to, e.g. the centre
+    // of its bounds. Errors grow with the largest scale of world. currentLod is the one the object was drawn at last.
+    unsigned int Select(const MeshFileClass::MeshFileLod* lods, const unsigned int lodCount, const XMMATRIX& world, const XMFLOAT3& center,
+                        const unsigned int currentLod);
+
+    // Checks the projected size against the projection, that LODs get coarser with distance and scale but never over the
+    // error, and that a camera wobbling at a switching distance doesn't make objects pop. Throws on a failure.
+    static void Validate();
+
+    // Builds a LOD chain for a bumpy sphere, scatters objectCount copies over a plane and flies a bobbing camera over them
+    // for frameCount frames, culling them to the frustum. Writes the triangles submitted per frame at full detail and with
+    // LODs, and the LOD switches per frame with and without hysteresis, to the log.
+    static void Benchmark(const unsigned int objectCount, const unsigned int frameCount);
+
+private:
+    Settings m_settings;
+    XMFLOAT3 m_cameraPosition;
+    // Pixels one unit covers at a distance of one.
+    float m_pixelsPerUnit;
+};
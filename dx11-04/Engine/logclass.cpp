@@ -0,0 +1,484 @@
+#include "logclass.h"
+#include "memoryclass.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // Bytes in each thread's ring; a power of two.
+    const unsigned int RING_BYTES = 1 << 20;
+    // Longer string arguments are cut short.
+    const unsigned int MAX_STRING_LENGTH = 16384;
+    // The writer thread wakes up this often, or as soon as a ring passes half full.
+    const unsigned int WRITE_INTERVAL_MS = 10;
+
+    const char* const LEVEL_NAMES[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+
+    // Every record starts with this, followed by each argument's type byte and value. Strings are stored as their length
+    // and characters.
+    struct RecordHeader
+    {
+        const char* format;
+        long long time;
+        unsigned int size; // Of the whole record.
+        int level;
+    };
+
+    // Only the owning thread writes records and advances written; only the writer thread reads them and advances read.
+    struct ThreadBuffer
+    {
+        DWORD threadId;
+        atomic<unsigned long long> written;
+        atomic<unsigned long long> read;
+        atomic<unsigned long long> dropped;
+        unsigned long long reportedDrops;
+        unsigned char data[RING_BYTES];
+    };
+
+    // A record taken out of a ring, waiting to be written in time order.
+    struct PendingRecord
+    {
+        long long time;
+        DWORD threadId;
+        size_t offset; // Of its header in the drained bytes.
+    };
+
+    mutex g_buffersMutex;
+    vector<unique_ptr<ThreadBuffer>> g_buffers;
+
+    // Guards the state shared with the writer thread.
+    mutex g_writerMutex;
+    condition_variable g_wake;
+    condition_variable g_flushed;
+    thread g_writer;
+    bool g_running = false;
+    bool g_stop = false;
+    unsigned long long g_flushRequests = 0;
+    unsigned long long g_flushesDone = 0;
+
+    // Held while draining, so a flush without the writer thread can't race it.
+    mutex g_drainMutex;
+    atomic<unsigned int> g_sinks(0);
+    ofstream g_file;
+    long long g_frequency = 1;
+    long long g_origin = 0;
+
+    THREAD_LOCAL ThreadBuffer* t_buffer = nullptr;
+
+    long long Now()
+    {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    }
+
+    ThreadBuffer* GetThreadBuffer()
+    {
+        if (t_buffer == nullptr)
+        {
+            unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+            buffer->threadId = GetCurrentThreadId();
+            buffer->written = 0;
+            buffer->read = 0;
+            buffer->dropped = 0;
+            buffer->reportedDrops = 0;
+
+            lock_guard<mutex> lock(g_buffersMutex);
+            t_buffer = buffer.get();
+            g_buffers.push_back(move(buffer));
+        }
+
+        return t_buffer;
+    }
+
+    void Put(ThreadBuffer* buffer, unsigned long long& position, const void* data, const unsigned int size)
+    {
+        unsigned int offset = (unsigned int)(position & (RING_BYTES - 1));
+        unsigned int first = min(size, RING_BYTES - offset);
+        memcpy(buffer->data + offset, data, first);
+        memcpy(buffer->data, (const unsigned char*)data + first, size - first);
+        position += size;
+    }
+
+    void Get(const ThreadBuffer* buffer, unsigned long long& position, void* data, const unsigned int size)
+    {
+        unsigned int offset = (unsigned int)(position & (RING_BYTES - 1));
+        unsigned int first = min(size, RING_BYTES - offset);
+        memcpy(data, buffer->data + offset, first);
+        memcpy((unsigned char*)data + first, buffer->data, size - first);
+        position += size;
+    }
+
+    // The lock is skipped, so a wake can be missed while the writer is between draining and waiting; it then runs on its
+    // interval as usual.
+    void WakeWriter()
+    {
+        g_wake.notify_one();
+    }
+
+    void AppendArgument(string& line, const unsigned char*& argument)
+    {
+        char text[64];
+        unsigned char type = *argument++;
+        if (type == LogClass::ARGUMENT_STRING)
+        {
+            unsigned int length;
+            memcpy(&length, argument, sizeof(length));
+            line.append((const char*)argument + sizeof(length), length);
+            argument += sizeof(length) + length;
+            return;
+        }
+
+        unsigned long long value;
+        memcpy(&value, argument, sizeof(value));
+        argument += sizeof(value);
+        switch (type)
+        {
+        case LogClass::ARGUMENT_SIGNED:
+            sprintf_s(text, "%lld", (long long)value);
+            break;
+        case LogClass::ARGUMENT_UNSIGNED:
+            sprintf_s(text, "%llu", value);
+            break;
+        case LogClass::ARGUMENT_DOUBLE:
+        {
+            double doubleValue;
+            memcpy(&doubleValue, &value, sizeof(doubleValue));
+            sprintf_s(text, "%g", doubleValue);
+            break;
+        }
+        default:
+            sprintf_s(text, "0x%llx", value);
+            break;
+        }
+        line += text;
+    }
+
+    // Replaces each {} in the format with the next argument; arguments without a {} are left out.
+    void FormatRecord(string& line, const unsigned char* record)
+    {
+        RecordHeader header;
+        memcpy(&header, record, sizeof(header));
+        const unsigned char* argument = record + sizeof(header);
+        const unsigned char* end = record + header.size;
+
+        line.clear();
+        for (const char* c = header.format; *c != '\0'; c++)
+        {
+            if (c[0] == '{' && c[1] == '}' && argument < end)
+            {
+                AppendArgument(line, argument);
+                c++;
+                continue;
+            }
+            line += *c;
+        }
+    }
+
+    void WriteLine(const unsigned int sinks, const int level, const long long time, const DWORD threadId, string& line)
+    {
+        line += '\n';
+
+        // The file gets a time, thread and level column; the others only mark warnings and errors.
+        if ((sinks & LogClass::SINK_FILE) && g_file.is_open())
+        {
+            char prefix[64];
+            sprintf_s(prefix, "%12.6f %6lu %-7s ", (double)(time - g_origin) / g_frequency, (unsigned long)threadId, LEVEL_NAMES[level]);
+            g_file << prefix << line;
+        }
+
+        if (level >= LOG_LEVEL_WARNING)
+        {
+            line.insert(0, level == LOG_LEVEL_WARNING ? "Warning: " : "Error: ");
+        }
+        if (sinks & LogClass::SINK_DEBUGGER)
+        {
+            OutputDebugStringA(line.c_str());
+        }
+        if (sinks & LogClass::SINK_STDERR)
+        {
+            fputs(line.c_str(), stderr);
+        }
+    }
+
+    void Drain()
+    {
+        lock_guard<mutex> drainLock(g_drainMutex);
+        unsigned int sinks = g_sinks.load();
+
+        // Take every ring's records out first, so the producers get their space back before the slow part.
+        static vector<unsigned char> bytes;
+        static vector<PendingRecord> pending;
+        static string line;
+        bytes.clear();
+        pending.clear();
+        unsigned long long newDrops[2] = { 0, 0 };
+        DWORD dropThread = 0;
+        {
+            lock_guard<mutex> lock(g_buffersMutex);
+            for (auto& buffer : g_buffers)
+            {
+                unsigned long long read = buffer->read.load(memory_order_relaxed);
+                unsigned long long written = buffer->written.load(memory_order_acquire);
+                if (sinks == 0)
+                {
+                    buffer->read.store(written, memory_order_release);
+                    continue;
+                }
+
+                while (read < written)
+                {
+                    RecordHeader header;
+                    unsigned long long position = read;
+                    Get(buffer.get(), position, &header, sizeof(header));
+
+                    PendingRecord record = { header.time, buffer->threadId, bytes.size() };
+                    pending.push_back(record);
+                    bytes.resize(bytes.size() + header.size);
+                    position = read;
+                    Get(buffer.get(), position, &bytes[record.offset], header.size);
+                    read = position;
+                }
+                buffer->read.store(read, memory_order_release);
+
+                unsigned long long dropped = buffer->dropped.load(memory_order_relaxed);
+                if (dropped != buffer->reportedDrops)
+                {
+                    newDrops[0] += dropped - buffer->reportedDrops;
+                    newDrops[1]++;
+                    dropThread = buffer->threadId;
+                    buffer->reportedDrops = dropped;
+                }
+            }
+        }
+
+        // Each ring is already in time order; the sort interleaves the threads.
+        stable_sort(pending.begin(), pending.end(), [](const PendingRecord& a, const PendingRecord& b)
+        {
+            return a.time < b.time;
+        });
+
+        for (const PendingRecord& record : pending)
+        {
+            RecordHeader header;
+            memcpy(&header, &bytes[record.offset], sizeof(header));
+            FormatRecord(line, &bytes[record.offset]);
+            WriteLine(sinks, header.level, header.time, record.threadId, line);
+        }
+
+        if (newDrops[0] > 0)
+        {
+            char text[128];
+            sprintf_s(text, "Log: %llu records dropped on %llu threads (last %lu)", newDrops[0], newDrops[1], (unsigned long)dropThread);
+            line = text;
+            WriteLine(sinks, LOG_LEVEL_WARNING, Now(), GetCurrentThreadId(), line);
+        }
+
+        if (g_file.is_open())
+        {
+            g_file.flush();
+        }
+    }
+
+    void WriterThread()
+    {
+        // Formatting allocates now and then, off the frame.
+        MemoryClass::ExcludeThreadFromCount();
+
+        unique_lock<mutex> lock(g_writerMutex);
+        for (;;)
+        {
+            unsigned long long flushRequests = g_flushRequests;
+            bool stop = g_stop;
+            lock.unlock();
+            Drain();
+            lock.lock();
+
+            g_flushesDone = flushRequests;
+            g_flushed.notify_all();
+            if (stop)
+            {
+                return;
+            }
+
+            if (g_flushRequests == g_flushesDone && !g_stop)
+            {
+                g_wake.wait_for(lock, chrono::milliseconds(WRITE_INTERVAL_MS));
+            }
+        }
+    }
+}
+
+void LogClass::Initialize(const unsigned int sinks, const char* fileName)
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    g_frequency = frequency.QuadPart;
+    g_origin = Now();
+
+    g_sinks = sinks;
+    if (sinks & SINK_FILE)
+    {
+        g_file.open(fileName);
+        if (!g_file.is_open())
+        {
+            g_sinks = sinks & ~SINK_FILE;
+            LOG_WARNING("Couldn't open log file {}", fileName);
+        }
+    }
+
+    lock_guard<mutex> lock(g_writerMutex);
+    g_stop = false;
+    g_running = true;
+    g_writer = thread(WriterThread);
+}
+
+void LogClass::Shutdown()
+{
+    {
+        lock_guard<mutex> lock(g_writerMutex);
+        if (!g_running)
+        {
+            return;
+        }
+        g_stop = true;
+    }
+
+    WakeWriter();
+    g_writer.join();
+
+    lock_guard<mutex> lock(g_writerMutex);
+    g_running = false;
+    g_file.close();
+}
+
+void LogClass::Flush()
+{
+    unique_lock<mutex> lock(g_writerMutex);
+    if (!g_running)
+    {
+        lock.unlock();
+        Drain();
+        return;
+    }
+
+    unsigned long long request = ++g_flushRequests;
+    WakeWriter();
+    g_flushed.wait(lock, [request]()
+    {
+        return g_flushesDone >= request;
+    });
+}
+
+void LogClass::SetSinks(const unsigned int sinks)
+{
+    g_sinks = sinks;
+}
+
+unsigned int LogClass::GetSinks()
+{
+    return g_sinks;
+}
+
+unsigned long long LogClass::GetDroppedCount()
+{
+    lock_guard<mutex> lock(g_buffersMutex);
+
+    unsigned long long dropped = 0;
+    for (auto& buffer : g_buffers)
+    {
+        dropped += buffer->dropped.load(memory_order_relaxed);
+    }
+    return dropped;
+}
+
+void LogClass::WriteRecord(const int level, const char* format, const Argument* arguments, const unsigned int count)
+{
+    RecordHeader header;
+    header.format = format;
+    header.size = sizeof(RecordHeader);
+    header.level = level;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        header.size += 1 + (arguments[i].type == ARGUMENT_STRING ? sizeof(unsigned int) + arguments[i].length : sizeof(unsigned long long));
+    }
+
+    ThreadBuffer* buffer = GetThreadBuffer();
+    unsigned long long position = buffer->written.load(memory_order_relaxed);
+    unsigned long long used = position - buffer->read.load(memory_order_acquire);
+    if (used + header.size > RING_BYTES)
+    {
+        buffer->dropped.store(buffer->dropped.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        WakeWriter();
+        return;
+    }
+
+    header.time = Now();
+    unsigned int offset = (unsigned int)(position & (RING_BYTES - 1));
+    if (offset + header.size <= RING_BYTES)
+    {
+        // The usual case: the record doesn't wrap, so it's written straight into the ring.
+        unsigned char* out = buffer->data + offset;
+        memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            *out++ = (unsigned char)arguments[i].type;
+            if (arguments[i].type == ARGUMENT_STRING)
+            {
+                memcpy(out, &arguments[i].length, sizeof(unsigned int));
+                memcpy(out + sizeof(unsigned int), arguments[i].stringValue, arguments[i].length);
+                out += sizeof(unsigned int) + arguments[i].length;
+            }
+            else
+            {
+                memcpy(out, &arguments[i].unsignedValue, sizeof(unsigned long long));
+                out += sizeof(unsigned long long);
+            }
+        }
+        position += header.size;
+    }
+    else
+    {
+        Put(buffer, position, &header, sizeof(header));
+        for (unsigned int i = 0; i < count; i++)
+        {
+            unsigned char type = (unsigned char)arguments[i].type;
+            Put(buffer, position, &type, 1);
+            if (arguments[i].type == ARGUMENT_STRING)
+            {
+                Put(buffer, position, &arguments[i].length, sizeof(unsigned int));
+                Put(buffer, position, arguments[i].stringValue, arguments[i].length);
+            }
+            else
+            {
+                Put(buffer, position, &arguments[i].unsignedValue, sizeof(unsigned long long));
+            }
+        }
+    }
+    buffer->written.store(position, memory_order_release);
+
+    // Wake the writer as soon as the ring passes half full rather than waiting out its interval.
+    if (used < RING_BYTES / 2 && used + header.size >= RING_BYTES / 2)
+    {
+        WakeWriter();
+    }
+}
+
+LogClass::Argument LogClass::MakeString(const char* value, const size_t length)
+{
+    Argument argument;
+    argument.type = ARGUMENT_STRING;
+    argument.length = (unsigned int)min(length, (size_t)MAX_STRING_LENGTH);
+    argument.stringValue = value;
+    return argument;
+}
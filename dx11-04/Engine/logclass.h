@@ -0,0 +1,172 @@
+#pragma once
+
+#include "platform.h"
+#include <string>
+#include <cstring>
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+// Log calls below this level are compiled out of the engine, arguments and all. Can also be set from the build.
+#ifndef ENGINE_LOG_LEVEL
+#define ENGINE_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Asynchronous structured logger. A log call copies the address of its format string, which identifies the message, and
+// its arguments in binary into the calling thread's ring buffer, taking no locks and allocating nothing. A background
+// thread formats the records in time order and writes them to the sinks. Format strings must be string literals and
+// use {} for each argument; string arguments are copied. Records that don't fit in a full ring are dropped and counted.
+class LogClass
+{
+public:
+    enum Sink
+    {
+        SINK_DEBUGGER = 1,
+        SINK_STDERR = 2,
+        SINK_FILE = 4
+    };
+
+    // How each argument is stored in a record.
+    enum ArgumentType
+    {
+        ARGUMENT_SIGNED,
+        ARGUMENT_UNSIGNED,
+        ARGUMENT_DOUBLE,
+        ARGUMENT_POINTER,
+        ARGUMENT_STRING
+    };
+
+    // Starts the writer thread. fileName is only used with SINK_FILE. Records logged before this are kept for it.
+    static void Initialize(const unsigned int sinks, const char* fileName);
+
+    // Writes everything logged so far and stops the writer thread.
+    static void Shutdown();
+
+    // Returns once everything logged before the call has been written.
+    static void Flush();
+
+    // Records still queued are written to the new sinks; flush first to keep them out.
+    static void SetSinks(const unsigned int sinks);
+
+    static unsigned int GetSinks();
+
+    // Records dropped on every thread so far because their ring was full.
+    static unsigned long long GetDroppedCount();
+
+    template <typename... Args>
+    static void Write(const int level, const char* format, const Args&... args)
+    {
+        const Argument arguments[sizeof...(Args) + 1] = { MakeArgument(args)... };
+        WriteRecord(level, format, arguments, (unsigned int)sizeof...(Args));
+    }
+
+private:
+    struct Argument
+    {
+        ArgumentType type;
+        unsigned int length; // Of a string argument.
+        union
+        {
+            long long signedValue;
+            unsigned long long unsignedValue;
+            double doubleValue;
+            const void* pointerValue;
+            const char* stringValue;
+        };
+    };
+
+    static void WriteRecord(const int level, const char* format, const Argument* arguments, const unsigned int count);
+
+    static Argument MakeArgument(const int value) { return MakeSigned(value); }
+    static Argument MakeArgument(const long value) { return MakeSigned(value); }
+    static Argument MakeArgument(const long long value) { return MakeSigned(value); }
+    static Argument MakeArgument(const unsigned int value) { return MakeUnsigned(value); }
+    static Argument MakeArgument(const unsigned long value) { return MakeUnsigned(value); }
+    static Argument MakeArgument(const unsigned long long value) { return MakeUnsigned(value); }
+
+    static Argument MakeArgument(const double value)
+    {
+        Argument argument;
+        argument.type = ARGUMENT_DOUBLE;
+        argument.doubleValue = value;
+        return argument;
+    }
+
+    static Argument MakeArgument(const void* value)
+    {
+        Argument argument;
+        argument.type = ARGUMENT_POINTER;
+        argument.pointerValue = value;
+        return argument;
+    }
+
+    static Argument MakeArgument(const char* value)
+    {
+        return MakeString(value != nullptr ? value : "(null)", value != nullptr ? strlen(value) : 6);
+    }
+
+    static Argument MakeArgument(const std::string& value)
+    {
+        return MakeString(value.c_str(), value.size());
+    }
+
+    static Argument MakeSigned(const long long value)
+    {
+        Argument argument;
+        argument.type = ARGUMENT_SIGNED;
+        argument.signedValue = value;
+        return argument;
+    }
+
+    static Argument MakeUnsigned(const unsigned long long value)
+    {
+        Argument argument;
+        argument.type = ARGUMENT_UNSIGNED;
+        argument.unsignedValue = value;
+        return argument;
+    }
+
+    static Argument MakeString(const char* value, const size_t length);
+};
+
+// Runs the log for its own lifetime, so everything is written however the scope is left.
+class LogSession
+{
+public:
+    LogSession(const unsigned int sinks, const char* fileName)
+    {
+        LogClass::Initialize(sinks, fileName);
+    }
+
+    ~LogSession()
+    {
+        LogClass::Shutdown();
+    }
+};
+
+#if ENGINE_LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LogClass::Write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...)
+#endif
+
+#if ENGINE_LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LogClass::Write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...)
+#endif
+
+#if ENGINE_LOG_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(...) LogClass::Write(LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...)
+#endif
+
+#if ENGINE_LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LogClass::Write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...)
+#endif
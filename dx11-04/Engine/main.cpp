@@ -1,20 +1,72 @@
 #include "systemclass.h"
+#include "benchmarkclass.h"
+#include "win32benchmarkclass.h"
 #include <memory>
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pScmdline, int iCmdshow)
 {
+    // Everything logged is written out before WinMain returns, whichever way it does.
+    LogSession log(LOG_SINKS, LOG_FILE);
+
+    // The mesh converter, optimizer and simplifier are run with the standalone MeshTool instead.
+    stringstream arguments(pScmdline);
+    string command, inputFileName;
+    arguments >> command >> inputFileName;
+
+    // "-benchmark [baseline]" runs the CPU microbenchmarks and compares them with a saved baseline, failing on regressions;
+    // "-benchmark-save baseline" stores the results as the new baseline.
+    if (command == "-benchmark" || command == "-benchmark-save")
+    {
+        try
+        {
+            vector<BenchmarkClass::Result> results = BenchmarkClass::RunAll();
+            vector<BenchmarkClass::Result> win32Results = Win32BenchmarkClass::RunAll();
+            results.insert(results.end(), win32Results.begin(), win32Results.end());
+            if (command == "-benchmark-save")
+            {
+                BenchmarkClass::SaveBaseline(inputFileName.c_str(), results);
+                return 0;
+            }
+
+            return !inputFileName.empty() && BenchmarkClass::CompareWithBaseline(inputFileName.c_str(), results) > 0 ? 1 : 0;
+        }
+        catch (engine_exception e)
+        {
+            LOG_ERROR("Benchmarks failed: {}", e.what());
+            return 1;
+        }
+    }
+
+    // "-headless [frames]" renders frames on the null device, without a window or GPU, and fails when a frame after the first
+    // goes over the call budgets in graphicsclass.h. The frames are paced against a simulated display. EngineTests runs the
+    // same frames on Linux as HeadlessFrames.
+    if (command == "-headless")
+    {
+        try
+        {
+            int frameCount = inputFileName.empty() ? HEADLESS_FRAMES : atoi(inputFileName.c_str());
+            return GraphicsClass::RunHeadless(frameCount, (float)(1.0 / UPDATE_RATE)) > 0 ? 1 : 0;
+        }
+        catch (engine_exception e)
+        {
+            LOG_ERROR("Headless run failed: {}", e.what());
+            return 1;
+        }
+    }
+
     std::unique_ptr<SystemClass> System(new SystemClass());
 
     try
     {
         System->Initialize();
         System->Run();
+
+        // Write everything the profiler still holds for chrome://tracing.
+        PROFILE_EXPORT("engine_trace.json");
     }
     catch (engine_exception e)
     {
-        stringstream oss;
-        oss << "Caught engine_exception: " << e.what() << "\n";
-        OutputDebugStringA(oss.str().c_str());
+        LOG_ERROR("Caught engine_exception: {}", e.what());
     }
 
     return 0;
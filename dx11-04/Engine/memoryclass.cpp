@@ -0,0 +1,103 @@
+#include "memoryclass.h"
+#include "engine_exception.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <new>
+
+using namespace std;
+
+namespace
+{
+    // Constant initialized, so allocations made while other globals are constructed are counted too.
+    atomic<unsigned long long> g_allocations(0);
+    THREAD_LOCAL unsigned long long t_allocations = 0;
+    THREAD_LOCAL bool t_excluded = false;
+
+    void CountAllocation()
+    {
+        if (!t_excluded)
+        {
+            g_allocations.fetch_add(1, memory_order_relaxed);
+        }
+        t_allocations++;
+    }
+}
+
+// Otherwise the same as the CRT's own operator new and delete.
+void* operator new(size_t size)
+{
+    CountAllocation();
+    void* p = malloc(size != 0 ? size : 1);
+    if (p == nullptr)
+    {
+        throw bad_alloc();
+    }
+
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
+
+unsigned long long MemoryClass::GetHeapAllocationCount()
+{
+    return g_allocations.load(memory_order_relaxed);
+}
+
+unsigned long long MemoryClass::GetThreadHeapAllocationCount()
+{
+    return t_allocations;
+}
+
+void MemoryClass::ExcludeThreadFromCount()
+{
+    t_excluded = true;
+}
+
+void* MemoryClass::AllocateAligned(const size_t size, const size_t alignment)
+{
+    CountAllocation();
+    void* p = _aligned_malloc(size != 0 ? size : 1, alignment);
+    if (p == nullptr)
+    {
+        throw bad_alloc();
+    }
+
+    return p;
+}
+
+void MemoryClass::FreeAligned(void* p)
+{
+    _aligned_free(p);
+}
+
+void MemoryClass::FillGuard(void* p)
+{
+    memset(p, GUARD_BYTE, GUARD_SIZE);
+}
+
+void MemoryClass::CheckGuard(const void* p, const char* allocatorName)
+{
+    const unsigned char* bytes = (const unsigned char*)p;
+    for (size_t i = 0; i < GUARD_SIZE; i++)
+    {
+        if (bytes[i] != GUARD_BYTE)
+        {
+            throw engine_exception("Memory guard overwritten in ") << allocatorName;
+        }
+    }
+}
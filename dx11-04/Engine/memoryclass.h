@@ -0,0 +1,49 @@
+#pragma once
+
+#include "platform.h"
+#include <cstddef>
+
+// Guard bytes around every allocator block, checked when blocks are freed or allocators reset, and freed memory filled
+// with a pattern. On in debug builds; can also be set from the build.
+#ifndef ENGINE_MEMORY_GUARDS
+#ifdef _DEBUG
+#define ENGINE_MEMORY_GUARDS 1
+#else
+#define ENGINE_MEMORY_GUARDS 0
+#endif
+#endif
+
+// The engine's general heap. Global operator new and delete are replaced to count allocations per thread and in total,
+// so benchmarks and the headless frame budgets can hold code to zero allocations. The allocators get their backing memory
+// here too. Everything the frame loop needs comes from LinearAllocatorClass and PoolAllocatorClass instead.
+class MemoryClass
+{
+public:
+    static const unsigned char GUARD_BYTE = 0xFD;
+    static const unsigned char FREED_BYTE = 0xDD;
+    static const size_t GUARD_SIZE = 16;
+
+    // Heap allocations made so far on every thread, and on this thread.
+    static unsigned long long GetHeapAllocationCount();
+
+    static unsigned long long GetThreadHeapAllocationCount();
+
+    // Leaves the calling thread's allocations out of GetHeapAllocationCount, for background threads that aren't part of
+    // the frame, like the log writer.
+    static void ExcludeThreadFromCount();
+
+    // Counted like operator new. Throws when the heap is out of memory; alignment must be a power of two.
+    static void* AllocateAligned(const size_t size, const size_t alignment);
+
+    static void FreeAligned(void* p);
+
+    static void FillGuard(void* p);
+
+    // Throws, naming the allocator, when the guard at p was overwritten.
+    static void CheckGuard(const void* p, const char* allocatorName);
+
+    static size_t AlignUp(const size_t value, const size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+};
@@ -0,0 +1,641 @@
+#include "meshconverterclass.h"
+#ifdef _WIN32
+#include "modelclass.h"
+#endif
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cfloat>
+#include <cstdio>
+
+namespace
+{
+    typedef MeshConverterClass::VertexType VertexType;
+
+    const XMFLOAT4 DEFAULT_COLOR(1.0f, 1.0f, 1.0f, 1.0f);
+
+    // Reads the whole file with a terminating zero so the text parsers can run strtod straight over it.
+    vector<char> ReadWholeFile(const char* fileName)
+    {
+        ifstream file(fileName, ios::binary);
+        if (!file.is_open())
+        {
+            throw engine_exception("Couldn't open file ") << fileName;
+        }
+
+        file.seekg(0, ios::end);
+        size_t size = (size_t)file.tellg();
+        file.seekg(0, ios::beg);
+
+        vector<char> bytes(size + 1);
+        file.read(bytes.data(), size);
+        bytes[size] = '\0';
+        return bytes;
+    }
+
+    // Converts a right handed, counter clockwise polygon to clockwise triangles; z is flipped when the vertices are read.
+    void AddPolygon(const unsigned int* polygon, const unsigned int count, vector<unsigned int>& indices)
+    {
+        for (unsigned int i = 1; i + 1 < count; i++)
+        {
+            indices.push_back(polygon[0]);
+            indices.push_back(polygon[i + 1]);
+            indices.push_back(polygon[i]);
+        }
+    }
+
+    enum PlyType
+    {
+        PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64
+    };
+
+    struct PlyProperty
+    {
+        string name;
+        PlyType type;
+        bool isList;
+        PlyType countType;
+    };
+
+    struct PlyElement
+    {
+        string name;
+        unsigned int count;
+        vector<PlyProperty> properties;
+    };
+
+    PlyType ParsePlyType(const string& name)
+    {
+        const char* names[] = { "char", "uchar", "short", "ushort", "int", "uint", "float", "double" };
+        const char* sizedNames[] = { "int8", "uint8", "int16", "uint16", "int32", "uint32", "float32", "float64" };
+        for (int i = 0; i < 8; i++)
+        {
+            if (name == names[i] || name == sizedNames[i])
+            {
+                return (PlyType)i;
+            }
+        }
+        throw engine_exception("Unknown PLY property type ") << name;
+    }
+
+    // Pulls property values out of the body of an ascii or binary little endian PLY file.
+    class PlyReader
+    {
+    public:
+        PlyReader(const char* begin, const char* end, const bool binary) : m_cursor(begin), m_end(end), m_binary(binary)
+        {
+        }
+
+        double Read(const PlyType type)
+        {
+            if (!m_binary)
+            {
+                char* next;
+                double value = strtod(m_cursor, &next);
+                if (next == m_cursor)
+                {
+                    throw engine_exception("Truncated or malformed PLY body");
+                }
+                m_cursor = next;
+                return value;
+            }
+
+            const unsigned int sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+            if ((size_t)(m_end - m_cursor) < sizes[type])
+            {
+                throw engine_exception("Truncated PLY body");
+            }
+
+            double value = 0.0;
+            switch (type)
+            {
+            case PLY_INT8: value = *(const signed char*)m_cursor; break;
+            case PLY_UINT8: value = *(const unsigned char*)m_cursor; break;
+            case PLY_INT16: { short v; memcpy(&v, m_cursor, 2); value = v; break; }
+            case PLY_UINT16: { unsigned short v; memcpy(&v, m_cursor, 2); value = v; break; }
+            case PLY_INT32: { int v; memcpy(&v, m_cursor, 4); value = v; break; }
+            case PLY_UINT32: { unsigned int v; memcpy(&v, m_cursor, 4); value = v; break; }
+            case PLY_FLOAT32: { float v; memcpy(&v, m_cursor, 4); value = v; break; }
+            case PLY_FLOAT64: { memcpy(&value, m_cursor, 8); break; }
+            }
+            m_cursor += sizes[type];
+            return value;
+        }
+
+    private:
+        const char* m_cursor;
+        const char* m_end;
+        bool m_binary;
+    };
+
+#ifdef _WIN32
+    ComPtr<ID3D11Buffer> CreateStaticBuffer(ID3D11Device* device, const unsigned int bindFlags, const void* data, const unsigned int byteWidth)
+    {
+        D3D11_BUFFER_DESC bufferDesc;
+        bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+        bufferDesc.ByteWidth = byteWidth;
+        bufferDesc.BindFlags = bindFlags;
+        bufferDesc.CPUAccessFlags = 0;
+        bufferDesc.MiscFlags = 0;
+        bufferDesc.StructureByteStride = 0;
+
+        D3D11_SUBRESOURCE_DATA subresourceData;
+        subresourceData.pSysMem = data;
+        subresourceData.SysMemPitch = 0;
+        subresourceData.SysMemSlicePitch = 0;
+
+        ComPtr<ID3D11Buffer> buffer;
+        HRESULT result = device->CreateBuffer(&bufferDesc, &subresourceData, buffer.GetAddressOf());
+        if (FAILED(result))
+        {
+            throw engine_exception("Creation of buffer failed with result code = ") << result;
+        }
+        return buffer;
+    }
+#endif
+}
+
+void MeshConverterClass::Convert(const char* inputFileName, const char* outputFileName, const VertexFormatClass::Format format)
+{
+    string extension = inputFileName;
+    extension = extension.substr(min(extension.size(), extension.find_last_of('.')));
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    vector<VertexType> vertices;
+    vector<unsigned int> indices;
+    if (extension == ".obj")
+    {
+        LoadObj(inputFileName, vertices, indices);
+    }
+    else if (extension == ".ply")
+    {
+        LoadPly(inputFileName, vertices, indices);
+    }
+    else if (extension == ".mesh")
+    {
+        LoadMesh(inputFileName, vertices, indices);
+    }
+    else
+    {
+        throw engine_exception("Can't convert ") << inputFileName << ", only .obj, .ply and .mesh are supported";
+    }
+
+    WriteWithLods(outputFileName, vertices, indices, format);
+
+    LOG_INFO("Converted {} to {}: {} vertices, {} triangles as {}", inputFileName, outputFileName, vertices.size(), indices.size() / 3,
+             VertexFormatClass::GetName(format));
+}
+
+void MeshConverterClass::Optimize(const char* inputFileName, const char* outputFileName)
+{
+    vector<VertexType> vertices;
+    vector<unsigned int> indices;
+    VertexFormatClass::Format format = LoadMesh(inputFileName, vertices, indices);
+    WriteWithLods(outputFileName, vertices, indices, format);
+
+    LOG_INFO("Optimized {} to {}: {} vertices, {} triangles as {}", inputFileName, outputFileName, vertices.size(), indices.size() / 3,
+             VertexFormatClass::GetName(format));
+}
+
+void MeshConverterClass::Simplify(const char* inputFileName, const char* outputFileName, const float ratio)
+{
+    if (!(ratio > 0.0f && ratio <= 1.0f))
+    {
+        throw engine_exception("Can't simplify to a ratio of ") << ratio << ", it has to be over 0 and at most 1";
+    }
+
+    vector<VertexType> vertices;
+    vector<unsigned int> indices, simplified;
+    VertexFormatClass::Format format = LoadMesh(inputFileName, vertices, indices);
+    unsigned int targetIndexCount = (unsigned int)(indices.size() / 3 * ratio) * 3;
+    float error = MeshSimplifierClass::Simplify(vertices.data(), (unsigned int)vertices.size(), indices.data(), (unsigned int)indices.size(),
+                                                targetIndexCount, FLT_MAX, simplified);
+    WriteWithLods(outputFileName, vertices, simplified, format);
+
+    LOG_INFO("Simplified {} to {}: {} triangles to {} with error {}, {} vertices left", inputFileName, outputFileName, indices.size() / 3,
+             simplified.size() / 3, error, vertices.size());
+}
+
+void MeshConverterClass::LoadObj(const char* fileName, vector<VertexType>& vertices, vector<unsigned int>& indices)
+{
+    vector<char> text = ReadWholeFile(fileName);
+    vector<unsigned int> polygon;
+
+    vertices.clear();
+    indices.clear();
+
+    // Only positions and the common "v x y z r g b" colour extension are used; texture coordinates and normals are skipped.
+    const char* line = text.data();
+    while (*line != '\0')
+    {
+        const char* lineEnd = strchr(line, '\n');
+        if (lineEnd == nullptr)
+        {
+            lineEnd = line + strlen(line);
+        }
+
+        if (line[0] == 'v' && (line[1] == ' ' || line[1] == '\t'))
+        {
+            char* cursor = (char*)line + 1;
+            float values[7] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+            for (int i = 0; i < 6; i++)
+            {
+                char* next;
+                float value = strtof(cursor, &next);
+                if (next == cursor || next > lineEnd)
+                {
+                    break;
+                }
+                values[i] = value;
+                cursor = next;
+            }
+
+            VertexType vertex;
+            vertex.position = XMFLOAT3(values[0], values[1], -values[2]);
+            vertex.color = XMFLOAT4(values[3], values[4], values[5], values[6]);
+            vertices.push_back(vertex);
+        }
+        else if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t'))
+        {
+            // Each corner is v, v/vt, v//vn or v/vt/vn; negative indices count back from the newest vertex.
+            polygon.clear();
+            char* cursor = (char*)line + 1;
+            while (true)
+            {
+                char* next;
+                long index = strtol(cursor, &next, 10);
+                if (next == cursor || next > lineEnd)
+                {
+                    break;
+                }
+
+                long resolved = index < 0 ? (long)vertices.size() + index : index - 1;
+                if (resolved < 0 || resolved >= (long)vertices.size())
+                {
+                    throw engine_exception("OBJ face index out of range in ") << fileName;
+                }
+                polygon.push_back((unsigned int)resolved);
+
+                while (next < lineEnd && *next != ' ' && *next != '\t')
+                {
+                    next++;
+                }
+                cursor = next;
+            }
+
+            AddPolygon(polygon.data(), (unsigned int)polygon.size(), indices);
+        }
+
+        line = *lineEnd == '\0' ? lineEnd : lineEnd + 1;
+    }
+}
+
+void MeshConverterClass::LoadPly(const char* fileName, vector<VertexType>& vertices, vector<unsigned int>& indices)
+{
+    vector<char> bytes = ReadWholeFile(fileName);
+    const char* data = bytes.data();
+    size_t size = bytes.size() - 1;
+
+    const char* headerEnd = strstr(data, "end_header");
+    if (strncmp(data, "ply", 3) != 0 || headerEnd == nullptr)
+    {
+        throw engine_exception("Not a PLY file: ") << fileName;
+    }
+
+    const char* body = strchr(headerEnd, '\n');
+    body = body == nullptr ? data + size : body + 1;
+
+    // Parse the header into its elements and their properties.
+    stringstream header(string(data, headerEnd));
+    vector<PlyElement> elements;
+    bool binary = false;
+    string line;
+    while (getline(header, line))
+    {
+        stringstream tokens(line);
+        string keyword;
+        tokens >> keyword;
+
+        if (keyword == "format")
+        {
+            string format;
+            tokens >> format;
+            if (format == "binary_little_endian")
+            {
+                binary = true;
+            }
+            else if (format != "ascii")
+            {
+                throw engine_exception("Unsupported PLY format ") << format;
+            }
+        }
+        else if (keyword == "element")
+        {
+            PlyElement element;
+            tokens >> element.name >> element.count;
+            elements.push_back(element);
+        }
+        else if (keyword == "property" && !elements.empty())
+        {
+            PlyProperty property;
+            string type;
+            tokens >> type;
+            property.isList = type == "list";
+            if (property.isList)
+            {
+                string countType;
+                tokens >> countType >> type;
+                property.countType = ParsePlyType(countType);
+            }
+            property.type = ParsePlyType(type);
+            tokens >> property.name;
+            elements.back().properties.push_back(property);
+        }
+    }
+
+    vertices.clear();
+    indices.clear();
+
+    PlyReader reader(body, data + size, binary);
+    vector<unsigned int> polygon;
+    for (auto& element : elements)
+    {
+        bool isVertex = element.name == "vertex";
+        bool isFace = element.name == "face";
+        if (isVertex)
+        {
+            vertices.reserve(element.count);
+        }
+
+        for (unsigned int i = 0; i < element.count; i++)
+        {
+            VertexType vertex;
+            vertex.position = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            vertex.color = DEFAULT_COLOR;
+            polygon.clear();
+
+            for (auto& property : element.properties)
+            {
+                if (property.isList)
+                {
+                    unsigned int count = (unsigned int)reader.Read(property.countType);
+                    bool isIndices = isFace && (property.name == "vertex_indices" || property.name == "vertex_index");
+                    for (unsigned int j = 0; j < count; j++)
+                    {
+                        double value = reader.Read(property.type);
+                        if (isIndices)
+                        {
+                            polygon.push_back((unsigned int)value);
+                        }
+                    }
+                    continue;
+                }
+
+                double value = reader.Read(property.type);
+                if (!isVertex)
+                {
+                    continue;
+                }
+
+                // Integer colours are 0-255, floating point ones are already normalized.
+                float channel = (float)(property.type >= PLY_FLOAT32 ? value : value / 255.0);
+                if (property.name == "x") vertex.position.x = (float)value;
+                else if (property.name == "y") vertex.position.y = (float)value;
+                else if (property.name == "z") vertex.position.z = -(float)value;
+                else if (property.name == "red") vertex.color.x = channel;
+                else if (property.name == "green") vertex.color.y = channel;
+                else if (property.name == "blue") vertex.color.z = channel;
+                else if (property.name == "alpha") vertex.color.w = channel;
+            }
+
+            if (isVertex)
+            {
+                vertices.push_back(vertex);
+            }
+            else if (isFace)
+            {
+                for (auto index : polygon)
+                {
+                    if (index >= vertices.size())
+                    {
+                        throw engine_exception("PLY face index out of range in ") << fileName;
+                    }
+                }
+                AddPolygon(polygon.data(), (unsigned int)polygon.size(), indices);
+            }
+        }
+    }
+}
+
+VertexFormatClass::Format MeshConverterClass::LoadMesh(const char* fileName, vector<VertexType>& vertices, vector<unsigned int>& indices)
+{
+    MeshFileClass meshFile;
+    meshFile.Open(fileName);
+    VertexFormatClass::Quantization quantization = meshFile.GetQuantization();
+
+    vertices.resize(meshFile.GetVertexCount());
+    VertexFormatClass::Decode(quantization, meshFile.GetVertices(), meshFile.GetVertexCount(), vertices.data());
+
+    // Coarser LODs are left behind; they are built again from the full model.
+    const MeshFileClass::MeshFileLod& lod = meshFile.GetLod(0);
+    if (meshFile.GetIndexStride() == sizeof(unsigned short))
+    {
+        const unsigned short* shortIndices = (const unsigned short*)meshFile.GetIndices() + lod.indexOffset;
+        indices.assign(shortIndices, shortIndices + lod.indexCount);
+    }
+    else
+    {
+        const unsigned int* longIndices = (const unsigned int*)meshFile.GetIndices() + lod.indexOffset;
+        indices.assign(longIndices, longIndices + lod.indexCount);
+    }
+
+    return quantization.format;
+}
+
+void MeshConverterClass::WriteWithLods(const char* fileName, vector<VertexType>& vertices, vector<unsigned int>& indices,
+                                       const VertexFormatClass::Format format)
+{
+    // The vertices are ordered for the full model; every coarser LOD uses a subset of them.
+    MeshOptimizerClass::Optimize(vertices, indices, VertexFormatClass::GetStride(format));
+
+    vector<unsigned int> lodIndices;
+    vector<MeshFileClass::MeshFileLod> lods;
+    MeshSimplifierClass::BuildLodChain(vertices, indices, lodIndices, lods);
+    Write(fileName, vertices, lodIndices, lods, format, true);
+}
+
+void MeshConverterClass::Write(const char* fileName, const vector<VertexType>& vertices, const vector<unsigned int>& indices,
+                               const vector<MeshFileClass::MeshFileLod>& lods, const VertexFormatClass::Format format, const bool optimized)
+{
+    if (lods.size() > MeshFileClass::MAX_LODS)
+    {
+        throw engine_exception("Can't write ") << lods.size() << " LODs, a mesh file holds " << MeshFileClass::MAX_LODS;
+    }
+
+    MeshFileClass::MeshFileHeader header = MeshFileClass::MeshFileHeader();
+    header.magic = MeshFileClass::MAGIC;
+    header.version = MeshFileClass::VERSION;
+    header.vertexFormat = format;
+    header.vertexStride = VertexFormatClass::GetStride(format);
+    header.indexStride = VertexFormatClass::GetIndexStride((unsigned int)vertices.size());
+    header.vertexCount = (unsigned int)vertices.size();
+    header.indexCount = (unsigned int)indices.size();
+    header.flags = optimized ? MeshFileClass::FLAG_OPTIMIZED : 0;
+    header.lodCount = (unsigned int)lods.size();
+
+    // The LOD table sits between the header and the vertex section.
+    const unsigned long long alignment = MeshFileClass::SECTION_ALIGNMENT;
+    unsigned long long vertexBytes = (unsigned long long)vertices.size() * header.vertexStride;
+    unsigned long long lodBytes = lods.size() * sizeof(MeshFileClass::MeshFileLod);
+    header.vertexOffset = (sizeof(header) + lodBytes + alignment - 1) / alignment * alignment;
+    header.indexOffset = (header.vertexOffset + vertexBytes + alignment - 1) / alignment * alignment;
+
+    // Object space bounds, kept in the header so culling doesn't have to walk the vertices; they are also the quantization range.
+    VertexFormatClass::ComputeBounds(vertices.data(), (unsigned int)vertices.size(), header.boundsMin, header.boundsMax);
+    VertexFormatClass::Quantization quantization = VertexFormatClass::GetQuantization(format, header.boundsMin, header.boundsMax);
+
+    vector<unsigned char> packedVertices((size_t)vertexBytes);
+    VertexFormatClass::Encode(quantization, vertices.data(), (unsigned int)vertices.size(), packedVertices.data());
+
+    vector<unsigned short> shortIndices;
+    if (header.indexStride == sizeof(unsigned short))
+    {
+        shortIndices.assign(indices.begin(), indices.end());
+    }
+    const char* indexData = shortIndices.empty() ? (const char*)indices.data() : (const char*)shortIndices.data();
+
+    ofstream file(fileName, ios::binary);
+    if (!file.is_open())
+    {
+        throw engine_exception("Couldn't create file ") << fileName;
+    }
+
+    const char padding[MeshFileClass::SECTION_ALIGNMENT] = {};
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)lods.data(), lodBytes);
+    file.write(padding, header.vertexOffset - sizeof(header) - lodBytes);
+    file.write((const char*)packedVertices.data(), vertexBytes);
+    file.write(padding, header.indexOffset - header.vertexOffset - vertexBytes);
+    file.write(indexData, indices.size() * header.indexStride);
+
+    if (!file.good())
+    {
+        throw engine_exception("Couldn't write file ") << fileName;
+    }
+}
+
+void MeshConverterClass::Validate()
+{
+    const char* fileName = "mesh_validation.mesh";
+    auto check = [fileName](const bool passed, const char* what)
+    {
+        if (!passed)
+        {
+            remove(fileName);
+            throw engine_exception("Mesh converter validation: ") << what;
+        }
+    };
+
+    vector<VertexType> vertices(4);
+    for (unsigned int corner = 0; corner < 4; corner++)
+    {
+        vertices[corner].position = XMFLOAT3((float)(corner & 1), (float)(corner >> 1), 0.0f);
+        vertices[corner].color = XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f);
+    }
+    vector<unsigned int> indices = { 0, 2, 3, 0, 3, 1 };
+
+    // Float vertices come back exactly, and the indices narrowed to 16 bits come back the same.
+    Write(fileName, vertices, indices, vector<MeshFileClass::MeshFileLod>(), VertexFormatClass::VERTEX_FLOAT, false);
+    vector<VertexType> loadedVertices;
+    vector<unsigned int> loadedIndices;
+    LoadMesh(fileName, loadedVertices, loadedIndices);
+    check(loadedIndices == indices, "the indices changed on the way through the file");
+    check(loadedVertices.size() == vertices.size() && memcmp(loadedVertices.data(), vertices.data(), vertices.size() * sizeof(VertexType)) == 0,
+          "the vertices changed on the way through the file");
+
+    // The same file with the last index one past the vertices.
+    indices.back() = (unsigned int)vertices.size();
+    Write(fileName, vertices, indices, vector<MeshFileClass::MeshFileLod>(), VertexFormatClass::VERTEX_FLOAT, false);
+    bool refused = false;
+    try
+    {
+        MeshFileClass meshFile;
+        meshFile.Open(fileName);
+    }
+    catch (const engine_exception&)
+    {
+        refused = true;
+    }
+    check(refused, "a mesh file with an index past its vertices was opened");
+    remove(fileName);
+}
+
+#ifdef _WIN32
+void MeshConverterClass::Benchmark(ID3D11Device* device, const unsigned int gridSize)
+{
+    const char* objFileName = "mesh_benchmark.obj";
+    const char* meshFileName = "mesh_benchmark.mesh";
+
+    // Generate the source model; quads are triangulated by the loader like any other polygon.
+    {
+        ofstream obj(objFileName);
+        if (!obj.is_open())
+        {
+            throw engine_exception("Couldn't create file ") << objFileName;
+        }
+
+        for (unsigned int y = 0; y <= gridSize; y++)
+        {
+            for (unsigned int x = 0; x <= gridSize; x++)
+            {
+                obj << "v " << (float)x / gridSize << " " << (float)y / gridSize << " 0\n";
+            }
+        }
+        for (unsigned int y = 0; y < gridSize; y++)
+        {
+            for (unsigned int x = 0; x < gridSize; x++)
+            {
+                unsigned int corner = y * (gridSize + 1) + x + 1;
+                obj << "f " << corner << " " << corner + 1 << " " << corner + gridSize + 2 << " " << corner + gridSize + 1 << "\n";
+            }
+        }
+    }
+    // Full float vertices, so the two paths upload the same amount of data.
+    Convert(objFileName, meshFileName, VertexFormatClass::VERTEX_FLOAT);
+
+    LARGE_INTEGER frequency, start, parsed, mapped;
+    QueryPerformanceFrequency(&frequency);
+
+    // Both files were just written, so this compares warm page cache loads.
+    QueryPerformanceCounter(&start);
+    unsigned int triangles;
+    {
+        vector<VertexType> vertices;
+        vector<unsigned int> indices;
+        LoadObj(objFileName, vertices, indices);
+        if (device != nullptr)
+        {
+            CreateStaticBuffer(device, D3D11_BIND_VERTEX_BUFFER, vertices.data(), (unsigned int)(vertices.size() * sizeof(VertexType)));
+            CreateStaticBuffer(device, D3D11_BIND_INDEX_BUFFER, indices.data(), (unsigned int)(indices.size() * sizeof(unsigned int)));
+        }
+        triangles = (unsigned int)indices.size() / 3;
+    }
+    QueryPerformanceCounter(&parsed);
+
+    {
+        ModelClass model;
+        model.Initialize(device, meshFileName);
+    }
+    QueryPerformanceCounter(&mapped);
+
+    DeleteFileA(objFileName);
+    DeleteFileA(meshFileName);
+
+    double parseSeconds = (double)(parsed.QuadPart - start.QuadPart) / frequency.QuadPart;
+    double mapSeconds = (double)(mapped.QuadPart - parsed.QuadPart) / frequency.QuadPart;
+
+    LOG_INFO("Mesh load benchmark: {} triangles{}, OBJ parse {} ms, mapped .mesh {} ms ({}x)", triangles,
+             device == nullptr ? " (no buffers created)" : "", parseSeconds * 1000.0, mapSeconds * 1000.0, parseSeconds / mapSeconds);
+}
+#endif
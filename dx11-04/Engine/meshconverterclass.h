@@ -0,0 +1,59 @@
+#pragma once
+#include "engine.h"
+#include "meshfileclass.h"
+#include "meshoptimizerclass.h"
+#include "meshsimplifierclass.h"
+#include <vector>
+
+using namespace std;
+
+// Offline conversion of OBJ and PLY (ascii or binary little endian) models to the binary .mesh format read by
+// MeshFileClass. Run it with the standalone tool: MeshTool -convert input.obj output.mesh [vertex format]
+// Meshes are welded and reordered by MeshOptimizerClass on the way, and get a chain of LODs from MeshSimplifierClass.
+// .mesh files from before either can be brought up to date with: MeshTool -optimize input.mesh output.mesh
+// and a mesh can be cut down to a fraction of its triangles with: MeshTool -simplify input.mesh output.mesh [ratio]
+// Only the load benchmark needs Windows and D3D.
+//
+// Both input formats are right handed with counter clockwise front faces, so z is negated and every triangle's winding
+// is reversed to match the left handed, clockwise front face convention of the renderer. Polygons are fan triangulated.
+class MeshConverterClass
+{
+public:
+    typedef VertexFormatClass::VertexType VertexType;
+
+    // Picks the loader from the input file's extension; .mesh files are read back too.
+    static void Convert(const char* inputFileName, const char* outputFileName, const VertexFormatClass::Format format);
+
+    // Optimizes a .mesh file and rebuilds its LOD chain, keeping its vertex format.
+    static void Optimize(const char* inputFileName, const char* outputFileName);
+
+    // Simplifies the full model of a .mesh file to ratio of its triangles and builds a LOD chain from there, keeping its
+    // vertex format.
+    static void Simplify(const char* inputFileName, const char* outputFileName, const float ratio);
+
+    static void LoadObj(const char* fileName, vector<VertexType>& vertices, vector<unsigned int>& indices);
+
+    static void LoadPly(const char* fileName, vector<VertexType>& vertices, vector<unsigned int>& indices);
+
+    // Decodes the vertices, which are only as precise as the file's format, and widens the full model's indices to 32 bits.
+    static VertexFormatClass::Format LoadMesh(const char* fileName, vector<VertexType>& vertices, vector<unsigned int>& indices);
+
+    // Quantizes the vertices to format against their bounds and narrows the indices to 16 bits when the vertex count allows.
+    // lods are runs of indices; with none the file has one LOD of all of them. optimized sets MeshFileClass::FLAG_OPTIMIZED.
+    static void Write(const char* fileName, const vector<VertexType>& vertices, const vector<unsigned int>& indices,
+                      const vector<MeshFileClass::MeshFileLod>& lods, const VertexFormatClass::Format format, const bool optimized);
+
+    // Writes a quad as a .mesh file and reads it back, then checks that a file with an index past its vertices is refused
+    // by MeshFileClass::Open. Throws on a failure.
+    static void Validate();
+
+#ifdef _WIN32
+    // Writes a gridSize x gridSize quad grid as OBJ, converts it and times parsing the OBJ into vertex and index buffers
+    // against mapping the .mesh file into a ModelClass. A null device times the loads without creating buffers.
+    static void Benchmark(ID3D11Device* device, const unsigned int gridSize);
+#endif
+
+private:
+    // Optimizes the mesh, builds its LOD chain and writes them out as optimized.
+    static void WriteWithLods(const char* fileName, vector<VertexType>& vertices, vector<unsigned int>& indices, const VertexFormatClass::Format format);
+};
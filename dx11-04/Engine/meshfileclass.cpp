@@ -0,0 +1,222 @@
+#include "meshfileclass.h"
+#include <algorithm>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(MeshFileClass::MeshFileHeader) == 80, "MeshFileHeader is part of the file format");
+static_assert(sizeof(MeshFileClass::MeshFileLod) == 12, "MeshFileLod is part of the file format");
+
+MeshFileClass::MeshFileClass()
+{
+#ifdef _WIN32
+    m_file = INVALID_HANDLE_VALUE;
+    m_mapping = NULL;
+#else
+    m_file = -1;
+    m_size = 0;
+#endif
+    m_view = nullptr;
+    m_header = nullptr;
+    m_lods = nullptr;
+}
+
+MeshFileClass::~MeshFileClass()
+{
+    Close();
+}
+
+void MeshFileClass::Open(const char* fileName)
+{
+    Close();
+
+#ifdef _WIN32
+    m_file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        throw engine_exception("Couldn't open mesh file ") << fileName;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart < (long long)sizeof(MeshFileHeader))
+    {
+        Close();
+        throw engine_exception("Mesh file is too small: ") << fileName;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping == NULL)
+    {
+        Close();
+        throw engine_exception("Couldn't create file mapping for ") << fileName << ", error = " << GetLastError();
+    }
+
+    m_view = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_view == nullptr)
+    {
+        Close();
+        throw engine_exception("Couldn't map view of ") << fileName << ", error = " << GetLastError();
+    }
+    unsigned long long size = (unsigned long long)fileSize.QuadPart;
+#else
+    m_file = open(fileName, O_RDONLY);
+    if (m_file < 0)
+    {
+        throw engine_exception("Couldn't open mesh file ") << fileName;
+    }
+
+    struct stat status;
+    if (fstat(m_file, &status) != 0 || status.st_size < (off_t)sizeof(MeshFileHeader))
+    {
+        Close();
+        throw engine_exception("Mesh file is too small: ") << fileName;
+    }
+
+    void* view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+    if (view == MAP_FAILED)
+    {
+        Close();
+        throw engine_exception("Couldn't map ") << fileName << ", errno = " << errno;
+    }
+    m_view = (const unsigned char*)view;
+    m_size = (size_t)status.st_size;
+    unsigned long long size = (unsigned long long)m_size;
+#endif
+
+    // Validate the header against the mapping before anything trusts its offsets.
+    const MeshFileHeader* header = (const MeshFileHeader*)m_view;
+    unsigned long long vertexBytes = (unsigned long long)header->vertexStride * header->vertexCount;
+    unsigned long long indexBytes = (unsigned long long)header->indexStride * header->indexCount;
+    bool valid = header->magic == MAGIC && header->version == VERSION
+        && header->vertexFormat < VertexFormatClass::FORMAT_COUNT
+        && header->vertexStride == VertexFormatClass::GetStride((VertexFormatClass::Format)header->vertexFormat)
+        && (header->indexStride == sizeof(unsigned short) || header->indexStride == sizeof(unsigned int))
+        && header->vertexOffset % SECTION_ALIGNMENT == 0 && header->indexOffset % SECTION_ALIGNMENT == 0
+        && header->vertexOffset <= size && vertexBytes <= size - header->vertexOffset
+        && header->indexOffset <= size && indexBytes <= size - header->indexOffset
+        && header->lodCount <= MAX_LODS && sizeof(MeshFileHeader) + header->lodCount * sizeof(MeshFileLod) <= header->vertexOffset;
+    if (!valid)
+    {
+        Close();
+        throw engine_exception("Not a version ") << VERSION << " mesh file: " << fileName;
+    }
+
+    // Every LOD has to be whole triangles inside the index section.
+    const MeshFileLod* lods = (const MeshFileLod*)(m_view + sizeof(MeshFileHeader));
+    for (unsigned int lod = 0; lod < header->lodCount; lod++)
+    {
+        if (lods[lod].indexCount % 3 != 0 || lods[lod].indexOffset > header->indexCount || lods[lod].indexCount > header->indexCount - lods[lod].indexOffset)
+        {
+            Close();
+            throw engine_exception("LOD ") << lod << " is outside the index section of mesh file " << fileName;
+        }
+    }
+
+    // Nothing downstream bounds checks the indices, so one past the vertices would have the optimizer and the rasterizers
+    // read outside them.
+    const unsigned char* indices = m_view + header->indexOffset;
+    unsigned int vertexCount = header->vertexCount;
+    for (unsigned int index = 0; index < header->indexCount; index++)
+    {
+        unsigned int value = header->indexStride == sizeof(unsigned short) ? ((const unsigned short*)indices)[index] : ((const unsigned int*)indices)[index];
+        if (value >= vertexCount)
+        {
+            Close();
+            throw engine_exception("Index ") << index << " of mesh file " << fileName << " is " << value << ", past its " << vertexCount << " vertices";
+        }
+    }
+
+    m_header = header;
+    m_lods = header->lodCount > 0 ? lods : &m_wholeLod;
+    m_wholeLod.indexOffset = 0;
+    m_wholeLod.indexCount = header->indexCount;
+    m_wholeLod.error = 0.0f;
+}
+
+void MeshFileClass::Close()
+{
+#ifdef _WIN32
+    if (m_view != nullptr)
+    {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+    if (m_mapping != NULL)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = NULL;
+    }
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (m_view != nullptr)
+    {
+        munmap((void*)m_view, m_size);
+        m_view = nullptr;
+        m_size = 0;
+    }
+    if (m_file >= 0)
+    {
+        close(m_file);
+        m_file = -1;
+    }
+#endif
+    m_header = nullptr;
+    m_lods = nullptr;
+}
+
+const void* MeshFileClass::GetVertices()
+{
+    return m_view + m_header->vertexOffset;
+}
+
+const void* MeshFileClass::GetIndices()
+{
+    return m_view + m_header->indexOffset;
+}
+
+unsigned int MeshFileClass::GetVertexCount()
+{
+    return m_header->vertexCount;
+}
+
+unsigned int MeshFileClass::GetIndexCount()
+{
+    return m_header->indexCount;
+}
+
+unsigned int MeshFileClass::GetLodCount()
+{
+    return max(m_header->lodCount, 1u);
+}
+
+const MeshFileClass::MeshFileLod& MeshFileClass::GetLod(const unsigned int lod)
+{
+    if (lod >= GetLodCount())
+    {
+        throw engine_exception("Mesh file has no LOD ") << lod;
+    }
+    return m_lods[lod];
+}
+
+unsigned int MeshFileClass::GetIndexStride()
+{
+    return m_header->indexStride;
+}
+
+VertexFormatClass::Quantization MeshFileClass::GetQuantization()
+{
+    return VertexFormatClass::GetQuantization((VertexFormatClass::Format)m_header->vertexFormat, m_header->boundsMin, m_header->boundsMax);
+}
+
+const MeshFileClass::MeshFileHeader& MeshFileClass::GetHeader()
+{
+    return *m_header;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "engine.h"
+#include "vertexformatclass.h"
+
+using namespace std;
+using namespace DirectX;
+
+// Read only memory mapping of a binary .mesh file, as written by MeshConverterClass. The vertex and index sections are
+// stored exactly as the GPU wants them, so they can be handed to CreateBuffer straight from the mapping. Off Windows the
+// file is mapped with mmap, for the tools and tests.
+//
+// Layout (little endian): an 80 byte MeshFileHeader, lodCount MeshFileLods, then the vertex section and the index section,
+// each starting on a SECTION_ALIGNMENT boundary. Vertices are in the header's vertexFormat, quantized against the header
+// bounds, and indices are 16 or 32 bits wide. Each LOD is a run of the index section over the same vertices, the full
+// model first. Readers reject any other version rather than guess at the layout. The flags and lodCount were reserved
+// and zero before there were any, so older files read as having no flags and the whole index section as their one LOD.
+class MeshFileClass
+{
+public:
+    static const unsigned int MAGIC = 0x4853454D; // "MESH"
+    static const unsigned int VERSION = 2;
+    static const unsigned int SECTION_ALIGNMENT = 64;
+
+    // The vertices and indices are in the order MeshOptimizerClass leaves them in.
+    static const unsigned int FLAG_OPTIMIZED = 1;
+
+    // Levels of detail a file can hold, the full model included.
+    static const unsigned int MAX_LODS = 8;
+
+    struct MeshFileHeader
+    {
+        unsigned int magic;
+        unsigned int version;
+        unsigned int vertexFormat;
+        unsigned int vertexStride;
+        unsigned int indexStride;
+        unsigned int vertexCount;
+        unsigned int indexCount;
+        unsigned int flags;
+        unsigned long long vertexOffset;
+        unsigned long long indexOffset;
+        XMFLOAT3 boundsMin;
+        XMFLOAT3 boundsMax;
+        unsigned int lodCount;
+        unsigned int reserved1;
+    };
+
+    // Indices are counted in indices, not bytes. error is how far, in object space units, the level's surface may be off
+    // the full model's; MeshSimplifierClass measures it.
+    struct MeshFileLod
+    {
+        unsigned int indexOffset;
+        unsigned int indexCount;
+        float error;
+    };
+
+    MeshFileClass();
+
+    ~MeshFileClass();
+
+    // Throws when the file isn't a valid mesh: a wrong version, sections or LODs outside the file, or an index past the
+    // vertices.
+    void Open(const char* fileName);
+
+    void Close();
+
+    // Vertices in GetQuantization().format.
+    const void* GetVertices();
+
+    // GetIndexStride() bytes per index.
+    const void* GetIndices();
+
+    unsigned int GetVertexCount();
+
+    // Indices of every LOD together.
+    unsigned int GetIndexCount();
+
+    // At least 1.
+    unsigned int GetLodCount();
+
+    const MeshFileLod& GetLod(const unsigned int lod);
+
+    unsigned int GetIndexStride();
+
+    VertexFormatClass::Quantization GetQuantization();
+
+    const MeshFileHeader& GetHeader();
+
+private:
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#else
+    int m_file;
+    size_t m_size;
+#endif
+    const unsigned char* m_view;
+    const MeshFileHeader* m_header;
+    const MeshFileLod* m_lods;
+    // Stands in for the table of files without one.
+    MeshFileLod m_wholeLod;
+};
@@ -0,0 +1,772 @@
+#include "meshoptimizerclass.h"
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <functional>
+
+const float MeshOptimizerClass::OVERDRAW_THRESHOLD = 1.05f;
+
+namespace
+{
+    typedef MeshOptimizerClass::VertexType VertexType;
+
+    const unsigned int NO_INDEX = 0xFFFFFFFF;
+
+    // Forsyth's tuning: the last triangle's vertices score a flat 0.75 so the next triangle doesn't just reuse them,
+    // older ones decay with their position, and vertices with few triangles left get a boost so no lone triangles are
+    // left behind.
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    // Overdraw is measured on a square of this many pixels a side.
+    const unsigned int OVERDRAW_RESOLUTION = 256;
+
+    // The memory side of vertex fetch: 4 KB of 64 byte lines.
+    const unsigned int FETCH_LINE_SIZE = 64;
+    const unsigned int FETCH_CACHE_LINES = 64;
+
+    // Every step indexes per vertex tables with the indices, so one past the vertices would write outside them.
+    void CheckIndices(const unsigned int* indices, const unsigned int indexCount, const unsigned int vertexCount)
+    {
+        for (unsigned int i = 0; i < indexCount; i++)
+        {
+            if (indices[i] >= vertexCount)
+            {
+                throw engine_exception("Mesh optimizer: index ") << i << " is " << indices[i] << ", past the " << vertexCount << " vertices";
+            }
+        }
+    }
+
+    float Random(unsigned int& seed)
+    {
+        seed = seed * 1664525 + 1013904223;
+        return (float)(seed >> 8) / 16777216.0f;
+    }
+
+    float ScoreVertex(const int cachePosition, const unsigned int remaining)
+    {
+        if (remaining == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else
+            {
+                const float scale = 1.0f / (MeshOptimizerClass::OPTIMIZATION_CACHE_SIZE - 3);
+                score = powf(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+            }
+        }
+        return score + VALENCE_BOOST_SCALE * powf((float)remaining, -VALENCE_BOOST_POWER);
+    }
+
+    // A FIFO cache of entries numbered 0 to count - 1. Each entry remembers when it was last loaded, so a lookup and a
+    // reset are constant time.
+    class FifoCache
+    {
+    public:
+        FifoCache(const unsigned int count, const unsigned int size) : m_loaded(count, 0), m_time(size + 1), m_size(size)
+        {
+        }
+
+        // Returns 1 on a miss, which loads the entry.
+        unsigned int Access(const unsigned int entry)
+        {
+            if (m_time - m_loaded[entry] < m_size)
+            {
+                return 0;
+            }
+            m_loaded[entry] = ++m_time;
+            return 1;
+        }
+
+        void Reset()
+        {
+            m_time += m_size + 1;
+        }
+
+    private:
+        vector<unsigned int> m_loaded;
+        unsigned int m_time;
+        unsigned int m_size;
+    };
+
+    XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+    }
+
+    // Points out of the front face of a clockwise triangle, twice as long as its area.
+    XMFLOAT3 TriangleNormal(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c)
+    {
+        XMFLOAT3 ab = Subtract(b, a), ac = Subtract(c, a);
+        return XMFLOAT3(ab.y * ac.z - ab.z * ac.y, ab.z * ac.x - ab.x * ac.z, ab.x * ac.y - ab.y * ac.x);
+    }
+
+    // Rotates a position so the view looks along +z; views 0 to 5 look along +x, -x, +y, -y, +z and -z.
+    XMFLOAT3 RotateToView(const XMFLOAT3& p, const unsigned int view)
+    {
+        switch (view)
+        {
+        case 0: return XMFLOAT3(-p.z, p.y, p.x);
+        case 1: return XMFLOAT3(p.z, p.y, -p.x);
+        case 2: return XMFLOAT3(p.x, -p.z, p.y);
+        case 3: return XMFLOAT3(p.x, p.z, -p.y);
+        case 4: return p;
+        default: return XMFLOAT3(-p.x, p.y, -p.z);
+        }
+    }
+
+    float EdgeFunction(const XMFLOAT3& a, const XMFLOAT3& b, const float x, const float y)
+    {
+        return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+    }
+
+    // Draws the front faces in order with a less than depth test, orthographically along one axis, and adds up the
+    // pixels shaded and the pixels covered.
+    void RasterizeOverdraw(const VertexType* vertices, const unsigned int vertexCount, const unsigned int* indices, const unsigned int indexCount,
+                           const unsigned int view, vector<float>& depth, unsigned long long& shaded, unsigned long long& covered)
+    {
+        XMFLOAT3 boundsMin, boundsMax;
+        VertexFormatClass::ComputeBounds(vertices, vertexCount, boundsMin, boundsMax);
+        boundsMin = RotateToView(boundsMin, view);
+        boundsMax = RotateToView(boundsMax, view);
+        float minX = min(boundsMin.x, boundsMax.x), minY = min(boundsMin.y, boundsMax.y);
+        float extent = max(max(fabsf(boundsMax.x - boundsMin.x), fabsf(boundsMax.y - boundsMin.y)), FLT_MIN);
+        float scale = (OVERDRAW_RESOLUTION - 1) / extent;
+
+        fill(depth.begin(), depth.end(), FLT_MAX);
+        for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+        {
+            XMFLOAT3 p[3];
+            for (unsigned int j = 0; j < 3; j++)
+            {
+                XMFLOAT3 rotated = RotateToView(vertices[indices[i + j]].position, view);
+                p[j] = XMFLOAT3((rotated.x - minX) * scale, (rotated.y - minY) * scale, rotated.z);
+            }
+
+            // Clockwise front faces have a negative area with y up; turn them counter clockwise for the edge functions.
+            float area = EdgeFunction(p[0], p[1], p[2].x, p[2].y);
+            if (area >= 0.0f)
+            {
+                continue;
+            }
+            swap(p[1], p[2]);
+            area = -area;
+
+            int x0 = max((int)floorf(min(min(p[0].x, p[1].x), p[2].x)), 0);
+            int x1 = min((int)ceilf(max(max(p[0].x, p[1].x), p[2].x)), (int)OVERDRAW_RESOLUTION - 1);
+            int y0 = max((int)floorf(min(min(p[0].y, p[1].y), p[2].y)), 0);
+            int y1 = min((int)ceilf(max(max(p[0].y, p[1].y), p[2].y)), (int)OVERDRAW_RESOLUTION - 1);
+            for (int y = y0; y <= y1; y++)
+            {
+                for (int x = x0; x <= x1; x++)
+                {
+                    float sampleX = x + 0.5f, sampleY = y + 0.5f;
+                    float w0 = EdgeFunction(p[1], p[2], sampleX, sampleY);
+                    float w1 = EdgeFunction(p[2], p[0], sampleX, sampleY);
+                    float w2 = EdgeFunction(p[0], p[1], sampleX, sampleY);
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                    {
+                        continue;
+                    }
+
+                    float z = (w0 * p[0].z + w1 * p[1].z + w2 * p[2].z) / area;
+                    float& pixel = depth[y * OVERDRAW_RESOLUTION + x];
+                    if (z < pixel)
+                    {
+                        covered += pixel == FLT_MAX ? 1 : 0;
+                        pixel = z;
+                        shaded++;
+                    }
+                }
+            }
+        }
+    }
+
+    // Each triangle rotated to start at its smallest vertex, keeping the winding, and the triangles sorted, so two index
+    // buffers draw the same triangles exactly when these match.
+    vector<VertexType> GetCanonicalTriangles(const vector<VertexType>& vertices, const vector<unsigned int>& indices)
+    {
+        auto less = [](const VertexType& a, const VertexType& b)
+        {
+            return memcmp(&a, &b, sizeof(VertexType)) < 0;
+        };
+
+        vector<VertexType> triangles;
+        vector<unsigned int> order;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const VertexType* corners[3] = { &vertices[indices[i]], &vertices[indices[i + 1]], &vertices[indices[i + 2]] };
+            unsigned int first = less(*corners[1], *corners[0]) ? 1 : 0;
+            first = less(*corners[2], *corners[first]) ? 2 : first;
+            for (unsigned int j = 0; j < 3; j++)
+            {
+                triangles.push_back(*corners[(first + j) % 3]);
+            }
+            order.push_back((unsigned int)order.size());
+        }
+
+        sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b)
+        {
+            return memcmp(&triangles[a * 3], &triangles[b * 3], sizeof(VertexType) * 3) < 0;
+        });
+        vector<VertexType> sorted;
+        sorted.reserve(triangles.size());
+        for (auto triangle : order)
+        {
+            sorted.insert(sorted.end(), triangles.begin() + triangle * 3, triangles.begin() + triangle * 3 + 3);
+        }
+        return sorted;
+    }
+
+    bool SameTriangles(const vector<VertexType>& a, const vector<VertexType>& b)
+    {
+        return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(VertexType)) == 0);
+    }
+
+    void AddSphere(const XMFLOAT3& center, const float radius, const unsigned int rings, const unsigned int segments,
+                   vector<VertexType>& vertices, vector<unsigned int>& indices)
+    {
+        unsigned int base = (unsigned int)vertices.size();
+        for (unsigned int ring = 0; ring <= rings; ring++)
+        {
+            float theta = XM_PI * ring / rings;
+            for (unsigned int segment = 0; segment <= segments; segment++)
+            {
+                float phi = XM_2PI * segment / segments;
+                VertexType vertex;
+                vertex.position = XMFLOAT3(center.x + radius * sinf(theta) * cosf(phi), center.y + radius * cosf(theta),
+                                           center.z + radius * sinf(theta) * sinf(phi));
+                vertex.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+                vertices.push_back(vertex);
+            }
+        }
+
+        for (unsigned int ring = 0; ring < rings; ring++)
+        {
+            for (unsigned int segment = 0; segment < segments; segment++)
+            {
+                unsigned int a = base + ring * (segments + 1) + segment, b = a + 1, c = a + segments + 1, d = c + 1;
+                unsigned int quad[2][3] = { { a, b, d }, { a, d, c } };
+                for (auto& triangle : quad)
+                {
+                    // Wound to face out, whichever way the parameterization turns.
+                    XMFLOAT3 normal = TriangleNormal(vertices[triangle[0]].position, vertices[triangle[1]].position, vertices[triangle[2]].position);
+                    XMFLOAT3 outward = Subtract(vertices[triangle[0]].position, center);
+                    if (normal.x * outward.x + normal.y * outward.y + normal.z * outward.z < 0.0f)
+                    {
+                        swap(triangle[1], triangle[2]);
+                    }
+                    indices.insert(indices.end(), triangle, triangle + 3);
+                }
+            }
+        }
+    }
+}
+
+unsigned int MeshOptimizerClass::WeldVertices(vector<VertexType>& vertices, vector<unsigned int>& indices)
+{
+    struct VertexHash
+    {
+        size_t operator()(const VertexType& vertex) const
+        {
+            // FNV-1a over the bytes, which are all position and colour.
+            const unsigned char* bytes = (const unsigned char*)&vertex;
+            unsigned int hash = 2166136261u;
+            for (size_t i = 0; i < sizeof(VertexType); i++)
+            {
+                hash = (hash ^ bytes[i]) * 16777619u;
+            }
+            return hash;
+        }
+    };
+    struct VertexEqual
+    {
+        bool operator()(const VertexType& a, const VertexType& b) const
+        {
+            return memcmp(&a, &b, sizeof(VertexType)) == 0;
+        }
+    };
+
+    unordered_map<VertexType, unsigned int, VertexHash, VertexEqual> unique;
+    unique.reserve(vertices.size());
+    vector<unsigned int> remap(vertices.size());
+    unsigned int kept = 0;
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        auto inserted = unique.insert(make_pair(vertices[i], kept));
+        remap[i] = inserted.first->second;
+        if (inserted.second)
+        {
+            vertices[kept++] = vertices[i];
+        }
+    }
+
+    for (auto& index : indices)
+    {
+        index = remap[index];
+    }
+
+    unsigned int removed = (unsigned int)vertices.size() - kept;
+    vertices.resize(kept);
+    return removed;
+}
+
+void MeshOptimizerClass::OptimizeVertexCache(unsigned int* indices, const unsigned int indexCount, const unsigned int vertexCount)
+{
+    CheckIndices(indices, indexCount, vertexCount);
+
+    const unsigned int triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Triangles of each vertex not emitted yet, packed by vertex; remaining[v] of them are live.
+    vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int i = 0; i < triangleCount * 3; i++)
+    {
+        if (indices[i] >= vertexCount)
+        {
+            throw engine_exception("Mesh optimizer: index ") << indices[i] << " out of range for " << vertexCount << " vertices";
+        }
+        remaining[indices[i]]++;
+    }
+
+    vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    vector<unsigned int> adjacency(triangleCount * 3);
+    vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+    for (unsigned int i = 0; i < triangleCount * 3; i++)
+    {
+        adjacency[filled[indices[i]]++] = i / 3;
+    }
+
+    vector<int> cachePosition(vertexCount, -1);
+    vector<float> vertexScore(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        vertexScore[v] = ScoreVertex(-1, remaining[v]);
+    }
+
+    vector<float> triangleScore(triangleCount);
+    vector<bool> emitted(triangleCount, false);
+    unsigned int best = 0;
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        best = triangleScore[t] > triangleScore[best] ? t : best;
+    }
+
+    vector<unsigned int> output(triangleCount * 3);
+    unsigned int cache[OPTIMIZATION_CACHE_SIZE + 3];
+    unsigned int cacheCount = 0;
+    unsigned int nextUnemitted = 0;
+    for (unsigned int emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        // Nothing in the cache has triangles left, so start again from the first triangle not drawn.
+        if (best == NO_INDEX)
+        {
+            while (emitted[nextUnemitted])
+            {
+                nextUnemitted++;
+            }
+            best = nextUnemitted;
+        }
+
+        const unsigned int* triangle = indices + best * 3;
+        copy(triangle, triangle + 3, output.begin() + emittedCount * 3);
+        emitted[best] = true;
+
+        for (unsigned int j = 0; j < 3; j++)
+        {
+            unsigned int v = triangle[j];
+            unsigned int* first = &adjacency[offsets[v]];
+            unsigned int* last = first + remaining[v] - 1;
+            *find(first, last + 1, best) = *last;
+            remaining[v]--;
+        }
+
+        // The triangle's vertices go to the front of the cache, ahead of everything else in it.
+        unsigned int newCache[OPTIMIZATION_CACHE_SIZE + 3];
+        unsigned int newCount = 3;
+        copy(triangle, triangle + 3, newCache);
+        for (unsigned int i = 0; i < cacheCount; i++)
+        {
+            unsigned int v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                newCache[newCount++] = v;
+            }
+        }
+
+        for (unsigned int i = 0; i < newCount; i++)
+        {
+            unsigned int v = newCache[i];
+            cachePosition[v] = i < OPTIMIZATION_CACHE_SIZE ? (int)i : -1;
+            vertexScore[v] = ScoreVertex(cachePosition[v], remaining[v]);
+        }
+
+        // Only triangles of vertices whose score changed have new scores, and the next triangle is best taken from the cache.
+        best = NO_INDEX;
+        float bestScore = -FLT_MAX;
+        for (unsigned int i = 0; i < newCount; i++)
+        {
+            unsigned int v = newCache[i];
+            for (unsigned int k = offsets[v]; k < offsets[v] + remaining[v]; k++)
+            {
+                unsigned int t = adjacency[k];
+                triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                if (i < OPTIMIZATION_CACHE_SIZE && triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+
+        cacheCount = min(newCount, OPTIMIZATION_CACHE_SIZE);
+        copy(newCache, newCache + cacheCount, cache);
+    }
+
+    copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizerClass::OptimizeOverdraw(unsigned int* indices, const unsigned int indexCount, const VertexType* vertices,
+                                          const unsigned int vertexCount, const float threshold)
+{
+    CheckIndices(indices, indexCount, vertexCount);
+
+    const unsigned int triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+    {
+        return;
+    }
+
+    // Hard boundaries are where the cache order starts afresh, with all three vertices missing.
+    FifoCache cache(vertexCount, ANALYSIS_CACHE_SIZE);
+    vector<unsigned int> misses(triangleCount);
+    vector<unsigned int> hardClusters;
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        misses[t] = cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+        if (t == 0 || misses[t] == 3)
+        {
+            hardClusters.push_back(t);
+        }
+    }
+    hardClusters.push_back(triangleCount);
+
+    // Soft boundaries split them further, each as soon as the triangles since the last one have brought their ACMR, from
+    // a cold cache, down to threshold times that of the whole hard cluster.
+    vector<unsigned int> clusters;
+    for (size_t h = 0; h + 1 < hardClusters.size(); h++)
+    {
+        unsigned int start = hardClusters[h], end = hardClusters[h + 1];
+        unsigned int clusterMisses = 0;
+        for (unsigned int t = start; t < end; t++)
+        {
+            clusterMisses += misses[t];
+        }
+        float limit = threshold * clusterMisses / (end - start);
+
+        cache.Reset();
+        clusters.push_back(start);
+        unsigned int softStart = start, softMisses = 0;
+        for (unsigned int t = start; t + 1 < end; t++)
+        {
+            softMisses += cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+            if ((float)softMisses <= limit * (t + 1 - softStart))
+            {
+                clusters.push_back(t + 1);
+                cache.Reset();
+                softStart = t + 1;
+                softMisses = 0;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // Clusters facing away from the middle of the mesh are on its outside and occlude the others, so they go first.
+    XMFLOAT3 meshCentroid(0.0f, 0.0f, 0.0f);
+    float meshArea = 0.0f;
+    const size_t clusterCount = clusters.size() - 1;
+    vector<XMFLOAT3> centroids(clusterCount), normals(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        XMFLOAT3 centroid(0.0f, 0.0f, 0.0f), normal(0.0f, 0.0f, 0.0f);
+        float area = 0.0f;
+        for (unsigned int t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            const XMFLOAT3& a = vertices[indices[t * 3]].position;
+            const XMFLOAT3& b = vertices[indices[t * 3 + 1]].position;
+            const XMFLOAT3& d = vertices[indices[t * 3 + 2]].position;
+            XMFLOAT3 triangleNormal = TriangleNormal(a, b, d);
+            float triangleArea = sqrtf(triangleNormal.x * triangleNormal.x + triangleNormal.y * triangleNormal.y + triangleNormal.z * triangleNormal.z);
+            centroid.x += (a.x + b.x + d.x) * triangleArea;
+            centroid.y += (a.y + b.y + d.y) * triangleArea;
+            centroid.z += (a.z + b.z + d.z) * triangleArea;
+            normal.x += triangleNormal.x;
+            normal.y += triangleNormal.y;
+            normal.z += triangleNormal.z;
+            area += triangleArea;
+        }
+
+        meshCentroid.x += centroid.x;
+        meshCentroid.y += centroid.y;
+        meshCentroid.z += centroid.z;
+        meshArea += area;
+
+        float scale = area > 0.0f ? 1.0f / (3.0f * area) : 0.0f;
+        centroids[c] = XMFLOAT3(centroid.x * scale, centroid.y * scale, centroid.z * scale);
+        float length = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        float normalScale = length > 0.0f ? 1.0f / length : 0.0f;
+        normals[c] = XMFLOAT3(normal.x * normalScale, normal.y * normalScale, normal.z * normalScale);
+    }
+
+    float meshScale = meshArea > 0.0f ? 1.0f / (3.0f * meshArea) : 0.0f;
+    meshCentroid = XMFLOAT3(meshCentroid.x * meshScale, meshCentroid.y * meshScale, meshCentroid.z * meshScale);
+
+    vector<float> keys(clusterCount);
+    vector<unsigned int> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        XMFLOAT3 offset = Subtract(centroids[c], meshCentroid);
+        keys[c] = offset.x * normals[c].x + offset.y * normals[c].y + offset.z * normals[c].z;
+        order[c] = (unsigned int)c;
+    }
+    stable_sort(order.begin(), order.end(), [&keys](unsigned int a, unsigned int b) { return keys[a] > keys[b]; });
+
+    vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+    for (auto c : order)
+    {
+        output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+    }
+    copy(output.begin(), output.end(), indices);
+}
+
+unsigned int MeshOptimizerClass::OptimizeVertexFetch(void* vertices, const unsigned int vertexStride, const unsigned int vertexCount,
+                                                     unsigned int* indices, const unsigned int indexCount)
+{
+    CheckIndices(indices, indexCount, vertexCount);
+
+    vector<unsigned int> remap(vertexCount, NO_INDEX);
+    unsigned int used = 0;
+    for (unsigned int i = 0; i < indexCount; i++)
+    {
+        unsigned int& newIndex = remap[indices[i]];
+        if (newIndex == NO_INDEX)
+        {
+            newIndex = used++;
+        }
+        indices[i] = newIndex;
+    }
+
+    unsigned char* bytes = (unsigned char*)vertices;
+    vector<unsigned char> original(bytes, bytes + (size_t)vertexCount * vertexStride);
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        if (remap[v] != NO_INDEX)
+        {
+            memcpy(bytes + (size_t)remap[v] * vertexStride, original.data() + (size_t)v * vertexStride, vertexStride);
+        }
+    }
+    return used;
+}
+
+MeshOptimizerClass::Statistics MeshOptimizerClass::Analyze(const VertexType* vertices, const unsigned int vertexCount, const unsigned int vertexStride,
+                                                           const unsigned int* indices, const unsigned int indexCount)
+{
+    Statistics statistics;
+    statistics.vertices = vertexCount;
+    statistics.triangles = indexCount / 3;
+
+    // Every post-transform cache miss fetches the vertex, through a cache of memory lines.
+    FifoCache vertexCache(vertexCount, ANALYSIS_CACHE_SIZE);
+    unsigned long long vertexBytes = (unsigned long long)vertexCount * vertexStride;
+    FifoCache lineCache((unsigned int)(vertexBytes / FETCH_LINE_SIZE + 2), FETCH_CACHE_LINES);
+    vector<bool> referenced(vertexCount, false);
+    unsigned int misses = 0, referencedCount = 0;
+    unsigned long long linesFetched = 0;
+    for (unsigned int i = 0; i < statistics.triangles * 3; i++)
+    {
+        unsigned int v = indices[i];
+        referencedCount += referenced[v] ? 0 : 1;
+        referenced[v] = true;
+        if (vertexCache.Access(v) == 0)
+        {
+            continue;
+        }
+
+        misses++;
+        unsigned long long start = (unsigned long long)v * vertexStride;
+        for (unsigned long long line = start / FETCH_LINE_SIZE; line <= (start + vertexStride - 1) / FETCH_LINE_SIZE; line++)
+        {
+            linesFetched += lineCache.Access((unsigned int)line);
+        }
+    }
+
+    statistics.acmr = statistics.triangles > 0 ? (float)misses / statistics.triangles : 0.0f;
+    statistics.atvr = referencedCount > 0 ? (float)misses / referencedCount : 0.0f;
+    statistics.overfetch = vertexBytes > 0 ? (float)(linesFetched * FETCH_LINE_SIZE) / vertexBytes : 0.0f;
+
+    unsigned long long shaded = 0, covered = 0;
+    vector<float> depth(OVERDRAW_RESOLUTION * OVERDRAW_RESOLUTION);
+    if (vertexCount > 0)
+    {
+        for (unsigned int view = 0; view < 6; view++)
+        {
+            RasterizeOverdraw(vertices, vertexCount, indices, statistics.triangles * 3, view, depth, shaded, covered);
+        }
+    }
+    statistics.overdraw = covered > 0 ? (float)shaded / covered : 0.0f;
+    return statistics;
+}
+
+void MeshOptimizerClass::Optimize(vector<VertexType>& vertices, vector<unsigned int>& indices, const unsigned int vertexStride)
+{
+    PROFILE_FUNCTION();
+
+    CheckIndices(indices.data(), (unsigned int)indices.size(), (unsigned int)vertices.size());
+    Statistics before = Analyze(vertices.data(), (unsigned int)vertices.size(), vertexStride, indices.data(), (unsigned int)indices.size());
+
+    unsigned int welded = WeldVertices(vertices, indices);
+    OptimizeVertexCache(indices.data(), (unsigned int)indices.size(), (unsigned int)vertices.size());
+    OptimizeOverdraw(indices.data(), (unsigned int)indices.size(), vertices.data(), (unsigned int)vertices.size(), OVERDRAW_THRESHOLD);
+    vertices.resize(OptimizeVertexFetch(vertices.data(), sizeof(VertexType), (unsigned int)vertices.size(), indices.data(), (unsigned int)indices.size()));
+
+    Statistics after = Analyze(vertices.data(), (unsigned int)vertices.size(), vertexStride, indices.data(), (unsigned int)indices.size());
+    LOG_INFO("Mesh optimizer: {} vertices welded, {} left unused; ACMR {} -> {}, ATVR {} -> {}, overdraw {} -> {}, overfetch {} -> {}", welded,
+             before.vertices - welded - after.vertices, before.acmr, after.acmr, before.atvr, after.atvr, before.overdraw, after.overdraw,
+             before.overfetch, after.overfetch);
+}
+
+void MeshOptimizerClass::Validate()
+{
+    const unsigned int vertexStride = VertexFormatClass::GetStride(VertexFormatClass::VERTEX_UNORM16_RGBA8);
+    unsigned int seed = 24680;
+
+    // A grid exported the way CAD tools tend to, with three vertices of its own for every triangle, in no useful order.
+    const unsigned int gridSize = 64;
+    vector<VertexType> vertices;
+    vector<unsigned int> indices;
+    for (unsigned int y = 0; y < gridSize; y++)
+    {
+        for (unsigned int x = 0; x < gridSize; x++)
+        {
+            XMFLOAT3 corners[4] = { XMFLOAT3((float)x, (float)y, 0.0f), XMFLOAT3((float)x, (float)y + 1.0f, 0.0f),
+                                    XMFLOAT3((float)x + 1.0f, (float)y + 1.0f, 0.0f), XMFLOAT3((float)x + 1.0f, (float)y, 0.0f) };
+            const unsigned int quad[6] = { 0, 1, 2, 0, 2, 3 };
+            for (auto corner : quad)
+            {
+                VertexType vertex;
+                vertex.position = corners[corner];
+                vertex.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+                indices.push_back((unsigned int)vertices.size());
+                vertices.push_back(vertex);
+            }
+        }
+    }
+    for (unsigned int t = (unsigned int)indices.size() / 3 - 1; t > 0; t--)
+    {
+        unsigned int other = min((unsigned int)(Random(seed) * (t + 1)), t);
+        swap_ranges(indices.begin() + t * 3, indices.begin() + t * 3 + 3, indices.begin() + other * 3);
+    }
+
+    vector<VertexType> triangles = GetCanonicalTriangles(vertices, indices);
+    Statistics exported = Analyze(vertices.data(), (unsigned int)vertices.size(), vertexStride, indices.data(), (unsigned int)indices.size());
+    WeldVertices(vertices, indices);
+    if (vertices.size() != (gridSize + 1) * (gridSize + 1))
+    {
+        throw engine_exception("Mesh optimizer validation: welding left ") << (unsigned int)vertices.size() << " vertices of a grid of "
+                                                                           << (gridSize + 1) * (gridSize + 1);
+    }
+
+    Statistics welded = Analyze(vertices.data(), (unsigned int)vertices.size(), vertexStride, indices.data(), (unsigned int)indices.size());
+    OptimizeVertexCache(indices.data(), (unsigned int)indices.size(), (unsigned int)vertices.size());
+    OptimizeOverdraw(indices.data(), (unsigned int)indices.size(), vertices.data(), (unsigned int)vertices.size(), OVERDRAW_THRESHOLD);
+    vertices.resize(OptimizeVertexFetch(vertices.data(), sizeof(VertexType), (unsigned int)vertices.size(), indices.data(), (unsigned int)indices.size()));
+    Statistics optimized = Analyze(vertices.data(), (unsigned int)vertices.size(), vertexStride, indices.data(), (unsigned int)indices.size());
+    LOG_INFO("Mesh optimizer validation, grid: ACMR {} exported, {} welded, {} optimized; ATVR {}; overfetch {} -> {}", exported.acmr, welded.acmr,
+             optimized.acmr, optimized.atvr, welded.overfetch, optimized.overfetch);
+
+    if (!SameTriangles(triangles, GetCanonicalTriangles(vertices, indices)))
+    {
+        throw engine_exception("Mesh optimizer validation: the grid's triangles changed");
+    }
+    // A regular grid can get to about 0.6 misses a triangle on an ideal cache of this size.
+    if (optimized.acmr > 0.8f || optimized.atvr > 1.4f || optimized.overfetch > welded.overfetch)
+    {
+        throw engine_exception("Mesh optimizer validation: the grid optimized to ACMR ") << optimized.acmr << ", ATVR " << optimized.atvr
+                                                                                         << ", overfetch " << optimized.overfetch;
+    }
+
+    // A sphere drawn before the one around it is hidden behind, but costs overdraw in every direction.
+    vertices.clear();
+    indices.clear();
+    AddSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.5f, 24, 48, vertices, indices);
+    AddSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f, 24, 48, vertices, indices);
+    triangles = GetCanonicalTriangles(vertices, indices);
+    Statistics nested = Analyze(vertices.data(), (unsigned int)vertices.size(), vertexStride, indices.data(), (unsigned int)indices.size());
+
+    OptimizeVertexCache(indices.data(), (unsigned int)indices.size(), (unsigned int)vertices.size());
+    Statistics cacheOrdered = Analyze(vertices.data(), (unsigned int)vertices.size(), vertexStride, indices.data(), (unsigned int)indices.size());
+    OptimizeOverdraw(indices.data(), (unsigned int)indices.size(), vertices.data(), (unsigned int)vertices.size(), OVERDRAW_THRESHOLD);
+    Statistics sorted = Analyze(vertices.data(), (unsigned int)vertices.size(), vertexStride, indices.data(), (unsigned int)indices.size());
+    LOG_INFO("Mesh optimizer validation, nested spheres: overdraw {} -> {}, ACMR {} -> {} for the cache order, {} sorted", nested.overdraw,
+             sorted.overdraw, nested.acmr, cacheOrdered.acmr, sorted.acmr);
+
+    if (!SameTriangles(triangles, GetCanonicalTriangles(vertices, indices)))
+    {
+        throw engine_exception("Mesh optimizer validation: the spheres' triangles changed");
+    }
+    if (sorted.overdraw > 1.05f || sorted.overdraw >= nested.overdraw || sorted.acmr > nested.acmr)
+    {
+        throw engine_exception("Mesh optimizer validation: nested spheres sorted to overdraw ") << sorted.overdraw << " from " << nested.overdraw
+                                                                                                << ", ACMR " << sorted.acmr;
+    }
+
+    // A mesh with an index past its vertices, as a corrupt file would have, is refused by every step.
+    vertices.resize(3);
+    indices.assign({ 0, 1, 3 });
+    const function<void()> steps[] =
+    {
+        [&]() { OptimizeVertexCache(indices.data(), (unsigned int)indices.size(), (unsigned int)vertices.size()); },
+        [&]() { OptimizeOverdraw(indices.data(), (unsigned int)indices.size(), vertices.data(), (unsigned int)vertices.size(), OVERDRAW_THRESHOLD); },
+        [&]() { OptimizeVertexFetch(vertices.data(), sizeof(VertexType), (unsigned int)vertices.size(), indices.data(), (unsigned int)indices.size()); },
+        [&]() { Optimize(vertices, indices, vertexStride); }
+    };
+    for (const function<void()>& step : steps)
+    {
+        bool refused = false;
+        try
+        {
+            step();
+        }
+        catch (const engine_exception&)
+        {
+            refused = true;
+        }
+        if (!refused)
+        {
+            throw engine_exception("Mesh optimizer validation: an index past the vertices was accepted");
+        }
+    }
+
+    LOG_INFO("Mesh optimizer validation passed");
+}
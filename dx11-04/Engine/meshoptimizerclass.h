@@ -0,0 +1,64 @@
+#pragma once
+#include "engine.h"
+#include "vertexformatclass.h"
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+
+// Reorders meshes for the GPU, offline in MeshConverterClass and at load for .mesh files that weren't. Duplicate vertices
+// are welded, triangles are ordered for the post-transform vertex cache (Forsyth's linear speed optimization), runs of
+// them are reordered so outward facing clusters draw first and cover what is behind them, and vertices are renumbered in
+// the order the indices first use them, so vertex fetch walks memory forwards. None of it changes what is drawn.
+//
+// Analyze measures the results: ACMR (cache misses per triangle) and ATVR (misses per vertex, 1 at best) on a FIFO
+// post-transform cache, overdraw (shaded pixels over covered ones, 1 at best) rasterized from the six axis directions,
+// and overfetch (bytes read from memory over the vertex buffer size, 1 at best).
+//
+// Every step throws on an index past the vertices, rather than reading and writing outside them.
+class MeshOptimizerClass
+{
+public:
+    typedef VertexFormatClass::VertexType VertexType;
+
+    // Vertices the Forsyth scores assume the cache holds, and the FIFO Analyze simulates, which is closer to hardware.
+    static const unsigned int OPTIMIZATION_CACHE_SIZE = 32;
+    static const unsigned int ANALYSIS_CACHE_SIZE = 16;
+    // ACMR, relative to the cache order, that Optimize lets OptimizeOverdraw spend.
+    static const float OVERDRAW_THRESHOLD;
+
+    struct Statistics
+    {
+        unsigned int vertices, triangles;
+        float acmr, atvr;
+        float overdraw;
+        float overfetch;
+    };
+
+    // Merges vertices with identical positions and colours and returns how many were removed. Vertices no triangle
+    // uses are kept; OptimizeVertexFetch drops them.
+    static unsigned int WeldVertices(vector<VertexType>& vertices, vector<unsigned int>& indices);
+
+    static void OptimizeVertexCache(unsigned int* indices, const unsigned int indexCount, const unsigned int vertexCount);
+
+    // Splits the cache ordered triangles into clusters where that costs at most threshold times their ACMR, and sorts the
+    // clusters front to back from outside the mesh. Run it after OptimizeVertexCache.
+    static void OptimizeOverdraw(unsigned int* indices, const unsigned int indexCount, const VertexType* vertices, const unsigned int vertexCount,
+                                 const float threshold);
+
+    // Renumbers the vertices in first use order and drops the unused ones; vertices may be in any format of vertexStride
+    // bytes. Returns the vertex count left.
+    static unsigned int OptimizeVertexFetch(void* vertices, const unsigned int vertexStride, const unsigned int vertexCount, unsigned int* indices,
+                                            const unsigned int indexCount);
+
+    // vertexStride is the size of the vertices in the format they are drawn in.
+    static Statistics Analyze(const VertexType* vertices, const unsigned int vertexCount, const unsigned int vertexStride,
+                              const unsigned int* indices, const unsigned int indexCount);
+
+    // Welds and runs all three optimizations, and logs the statistics before and after.
+    static void Optimize(vector<VertexType>& vertices, vector<unsigned int>& indices, const unsigned int vertexStride);
+
+    // Optimizes synthetic meshes, a shuffled and unwelded grid like a CAD export and a sphere drawn inside another, and
+    // checks that no triangle is lost or changed, that every metric improves and that out of range indices are refused. Throws on a failure.
+    static void Validate();
+};
@@ -0,0 +1,765 @@
+#include "meshsimplifierclass.h"
+#include "meshoptimizerclass.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+
+const float MeshSimplifierClass::LOD_RATIO = 0.5f;
+const float MeshSimplifierClass::LOD_MIN_REDUCTION = 0.8f;
+
+namespace
+{
+    typedef MeshSimplifierClass::VertexType VertexType;
+
+    // Planes across open borders weigh this much per squared edge length, against triangle planes weighing their area,
+    // so outlines are the last thing to give way.
+    const float BORDER_WEIGHT = 10.0f;
+
+    // Cosine of the furthest a collapse may turn any triangle it moves.
+    const float MAX_TURN_COSINE = 0.5f;
+
+    // Each pass of collapses goes on past the error of the cheapest PASS_FRACTION of the edges by PASS_ERROR_SCALE.
+    const float PASS_FRACTION = 0.25f;
+    const float PASS_ERROR_SCALE = 1.5f;
+
+    XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+    }
+
+    XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    // Twice the area along the normal; cross(b - a, c - a) faces out of a clockwise triangle in the renderer's convention.
+    XMFLOAT3 TriangleNormal(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c)
+    {
+        return Cross(Subtract(b, a), Subtract(c, a));
+    }
+
+    // Weighted sum of squared distances to a set of planes, p'Ap + 2b'p + c. weight is the triangle area the planes stand
+    // for, which errors are normalized by so they come out as distances.
+    struct Quadric
+    {
+        double a00, a01, a02, a11, a12, a22;
+        double b0, b1, b2;
+        double c;
+        double weight;
+    };
+
+    // normal has to be unit length; the plane is normal.p + distance = 0.
+    Quadric MakePlaneQuadric(const XMFLOAT3& normal, const float distance, const double weight)
+    {
+        double x = normal.x, y = normal.y, z = normal.z, d = distance;
+        Quadric quadric;
+        quadric.a00 = weight * x * x;
+        quadric.a01 = weight * x * y;
+        quadric.a02 = weight * x * z;
+        quadric.a11 = weight * y * y;
+        quadric.a12 = weight * y * z;
+        quadric.a22 = weight * z * z;
+        quadric.b0 = weight * x * d;
+        quadric.b1 = weight * y * d;
+        quadric.b2 = weight * z * d;
+        quadric.c = weight * d * d;
+        quadric.weight = weight;
+        return quadric;
+    }
+
+    void AddQuadric(Quadric& quadric, const Quadric& other)
+    {
+        quadric.a00 += other.a00;
+        quadric.a01 += other.a01;
+        quadric.a02 += other.a02;
+        quadric.a11 += other.a11;
+        quadric.a12 += other.a12;
+        quadric.a22 += other.a22;
+        quadric.b0 += other.b0;
+        quadric.b1 += other.b1;
+        quadric.b2 += other.b2;
+        quadric.c += other.c;
+        quadric.weight += other.weight;
+    }
+
+    // The RMS distance of position from the quadric's planes.
+    float GetQuadricError(const Quadric& quadric, const XMFLOAT3& position)
+    {
+        double x = position.x, y = position.y, z = position.z;
+        double cost = quadric.a00 * x * x + quadric.a11 * y * y + quadric.a22 * z * z + 2.0 * (quadric.a01 * x * y + quadric.a02 * x * z + quadric.a12 * y * z) +
+            2.0 * (quadric.b0 * x + quadric.b1 * y + quadric.b2 * z) + quadric.c;
+        cost = max(cost, 0.0);
+        return (float)sqrt(quadric.weight > 0.0 ? cost / quadric.weight : cost);
+    }
+
+    // The collapse state of one mesh, which can be run down to one triangle count and then on to a lower one, so a whole
+    // LOD chain comes from a single pass. Triangles index the first vertex at each position.
+    class EdgeCollapser
+    {
+    public:
+        EdgeCollapser(const VertexType* vertices, const unsigned int vertexCount, const unsigned int* indices, const unsigned int indexCount)
+            : m_vertices(vertices), m_triangleCount(0), m_error(0.0f)
+        {
+            if (indexCount % 3 != 0)
+            {
+                throw engine_exception("Can't simplify ") << indexCount << " indices, they aren't whole triangles";
+            }
+
+            // Vertices at the same position are simplified as the one with the lowest index.
+            vector<unsigned int> order(vertexCount);
+            for (unsigned int i = 0; i < vertexCount; i++)
+            {
+                order[i] = i;
+            }
+            // Compared as floats rather than bytes, so 0 and -0 are the same place.
+            auto less = [vertices](unsigned int a, unsigned int b)
+            {
+                const XMFLOAT3& p = vertices[a].position;
+                const XMFLOAT3& q = vertices[b].position;
+                return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+            };
+            sort(order.begin(), order.end(), [&less](unsigned int a, unsigned int b)
+            {
+                return less(a, b) || (!less(b, a) && a < b);
+            });
+            vector<unsigned int> canonical(vertexCount);
+            for (unsigned int i = 0; i < vertexCount; i++)
+            {
+                bool same = i > 0 && !less(order[i - 1], order[i]);
+                canonical[order[i]] = same ? canonical[order[i - 1]] : order[i];
+            }
+
+            Quadric zero;
+            memset(&zero, 0, sizeof(zero));
+            m_quadrics.assign(vertexCount, zero);
+            m_vertexTriangles.resize(vertexCount);
+
+            // Triangles that are degenerate once their corners are welded are dropped; the rest add their plane to their corners.
+            for (unsigned int i = 0; i < indexCount; i += 3)
+            {
+                if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount)
+                {
+                    throw engine_exception("Can't simplify a mesh with an index out of range at ") << i;
+                }
+
+                unsigned int corners[3] = { canonical[indices[i]], canonical[indices[i + 1]], canonical[indices[i + 2]] };
+                if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+                {
+                    continue;
+                }
+
+                unsigned int triangle = m_triangleCount++;
+                m_triangles.insert(m_triangles.end(), corners, corners + 3);
+                m_alive.push_back(true);
+
+                XMFLOAT3 normal = GetNormal(corners);
+                float length = sqrtf(Dot(normal, normal));
+                if (length > 0.0f)
+                {
+                    normal = XMFLOAT3(normal.x / length, normal.y / length, normal.z / length);
+                    Quadric plane = MakePlaneQuadric(normal, -Dot(normal, GetPosition(corners[0])), 0.5 * length);
+                    for (unsigned int corner : corners)
+                    {
+                        AddQuadric(m_quadrics[corner], plane);
+                    }
+                }
+
+                for (unsigned int corner : corners)
+                {
+                    m_vertexTriangles[corner].push_back(triangle);
+                }
+            }
+
+            // Sort the edges of every triangle so the ones they share come together.
+            vector<pair<unsigned long long, unsigned int>> edges;
+            edges.reserve(m_triangles.size());
+            for (unsigned int corner = 0; corner < m_triangles.size(); corner++)
+            {
+                edges.push_back(make_pair(GetEdgeKey(m_triangles[corner], m_triangles[GetNextCorner(corner)]), corner));
+            }
+            sort(edges.begin(), edges.end());
+
+            // Open edges get a plane through them at right angles to their triangle. Vertices on one border are kept on
+            // it; ones where borders meet, or on edges with more than two triangles, never move.
+            vector<unsigned int> borderEdges(vertexCount, 0);
+            vector<bool> locked(vertexCount, false);
+            for (size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+            {
+                while (end < edges.size() && edges[end].first == edges[begin].first)
+                {
+                    end++;
+                }
+
+                unsigned int corner = edges[begin].second;
+                unsigned int a = m_triangles[corner], b = m_triangles[GetNextCorner(corner)];
+                if (end - begin > 2)
+                {
+                    locked[a] = locked[b] = true;
+                }
+                if (end - begin != 1)
+                {
+                    continue;
+                }
+
+                borderEdges[a]++;
+                borderEdges[b]++;
+                XMFLOAT3 direction = Subtract(GetPosition(b), GetPosition(a));
+                XMFLOAT3 across = Cross(direction, GetNormal(&m_triangles[corner - corner % 3]));
+                float length = sqrtf(Dot(across, across));
+                if (length > 0.0f)
+                {
+                    across = XMFLOAT3(across.x / length, across.y / length, across.z / length);
+                    Quadric plane = MakePlaneQuadric(across, -Dot(across, GetPosition(a)), BORDER_WEIGHT * Dot(direction, direction));
+                    plane.weight = 0.0;
+                    AddQuadric(m_quadrics[a], plane);
+                    AddQuadric(m_quadrics[b], plane);
+                }
+            }
+
+            m_kinds.resize(vertexCount);
+            for (unsigned int vertex = 0; vertex < vertexCount; vertex++)
+            {
+                m_kinds[vertex] = locked[vertex] ? KIND_LOCKED : borderEdges[vertex] == 0 ? KIND_MANIFOLD : borderEdges[vertex] == 2 ? KIND_BORDER : KIND_LOCKED;
+            }
+            m_touched.resize(vertexCount);
+        }
+
+        // Collapses edges, cheapest first, until targetTriangles are left or the cheapest has an error over maxError.
+        // Returns the largest error of any collapse so far.
+        //
+        // Rather than keep a queue of every edge up to date, each pass sorts the edges by error and collapses the cheapest
+        // that don't share a vertex with one already collapsed in the pass, up to a limit set by the errors at the cheap
+        // end, so the order stays close to cheapest first at a fraction of the cost.
+        float Run(const unsigned int targetTriangles, const float maxError)
+        {
+            while (m_triangleCount > targetTriangles)
+            {
+                GatherCollapses(maxError);
+                if (m_collapses.empty())
+                {
+                    break;
+                }
+                sort(m_collapses.begin(), m_collapses.end());
+
+                float passLimit = m_collapses[(size_t)(m_collapses.size() * PASS_FRACTION)].error * PASS_ERROR_SCALE;
+                fill(m_touched.begin(), m_touched.end(), false);
+                unsigned int applied = 0;
+                for (const Collapse& collapse : m_collapses)
+                {
+                    if (m_triangleCount <= targetTriangles || (collapse.error > passLimit && applied > 0))
+                    {
+                        break;
+                    }
+
+                    // The errors of collapses next to one that was applied are out of date until the next pass.
+                    if (m_touched[collapse.from] || m_touched[collapse.to] || !CanCollapse(collapse.from, collapse.to))
+                    {
+                        continue;
+                    }
+
+                    Apply(collapse.from, collapse.to);
+                    m_touched[collapse.from] = m_touched[collapse.to] = true;
+                    m_error = max(m_error, collapse.error);
+                    applied++;
+                }
+
+                if (applied == 0)
+                {
+                    break;
+                }
+            }
+            return m_error;
+        }
+
+        unsigned int GetTriangleCount()
+        {
+            return m_triangleCount;
+        }
+
+        void Emit(vector<unsigned int>& indices)
+        {
+            indices.clear();
+            indices.reserve(m_triangleCount * 3);
+            for (unsigned int triangle = 0; triangle < m_alive.size(); triangle++)
+            {
+                if (m_alive[triangle])
+                {
+                    indices.insert(indices.end(), &m_triangles[triangle * 3], &m_triangles[triangle * 3] + 3);
+                }
+            }
+        }
+
+    private:
+        enum Kind
+        {
+            KIND_MANIFOLD,
+            KIND_BORDER,
+            KIND_LOCKED
+        };
+
+        // Moving from onto to.
+        struct Collapse
+        {
+            float error;
+            unsigned int from, to;
+
+            bool operator<(const Collapse& other) const
+            {
+                return error < other.error;
+            }
+        };
+
+        const VertexType* m_vertices;
+        vector<unsigned int> m_triangles;
+        vector<bool> m_alive;
+        unsigned int m_triangleCount;
+        vector<vector<unsigned int>> m_vertexTriangles;
+        vector<Quadric> m_quadrics;
+        vector<unsigned char> m_kinds;
+        float m_error;
+        vector<Collapse> m_collapses;
+        vector<bool> m_touched;
+        // Scratch for the neighbour lists, kept to save allocations.
+        vector<unsigned int> m_fromNeighbours, m_toNeighbours;
+
+        static unsigned long long GetEdgeKey(const unsigned int a, const unsigned int b)
+        {
+            return ((unsigned long long)min(a, b) << 32) | max(a, b);
+        }
+
+        static unsigned int GetNextCorner(const unsigned int corner)
+        {
+            return corner % 3 == 2 ? corner - 2 : corner + 1;
+        }
+
+        const XMFLOAT3& GetPosition(const unsigned int vertex)
+        {
+            return m_vertices[vertex].position;
+        }
+
+        XMFLOAT3 GetNormal(const unsigned int* corners)
+        {
+            return TriangleNormal(GetPosition(corners[0]), GetPosition(corners[1]), GetPosition(corners[2]));
+        }
+
+        bool HasCorner(const unsigned int triangle, const unsigned int vertex)
+        {
+            const unsigned int* corners = &m_triangles[triangle * 3];
+            return corners[0] == vertex || corners[1] == vertex || corners[2] == vertex;
+        }
+
+        unsigned int CountSharedTriangles(const unsigned int a, const unsigned int b)
+        {
+            unsigned int count = 0;
+            for (unsigned int triangle : m_vertexTriangles[a])
+            {
+                count += HasCorner(triangle, b) ? 1 : 0;
+            }
+            return count;
+        }
+
+        void GetNeighbours(const unsigned int vertex, vector<unsigned int>& neighbours)
+        {
+            neighbours.clear();
+            for (unsigned int triangle : m_vertexTriangles[vertex])
+            {
+                for (unsigned int corner = 0; corner < 3; corner++)
+                {
+                    if (m_triangles[triangle * 3 + corner] != vertex)
+                    {
+                        neighbours.push_back(m_triangles[triangle * 3 + corner]);
+                    }
+                }
+            }
+            sort(neighbours.begin(), neighbours.end());
+            neighbours.erase(unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        }
+
+        // False when from can't be moved onto to.
+        bool GetCollapse(const unsigned int from, const unsigned int to, Collapse& collapse)
+        {
+            // Border vertices only slide along their border.
+            if (m_kinds[from] == KIND_LOCKED || (m_kinds[from] == KIND_BORDER && CountSharedTriangles(from, to) != 1))
+            {
+                return false;
+            }
+
+            Quadric quadric = m_quadrics[from];
+            AddQuadric(quadric, m_quadrics[to]);
+            collapse.error = GetQuadricError(quadric, GetPosition(to));
+            collapse.from = from;
+            collapse.to = to;
+            return true;
+        }
+
+        // The cheaper way round of every edge that can be collapsed either way, within maxError.
+        void GatherCollapses(const float maxError)
+        {
+            m_collapses.clear();
+            for (unsigned int vertex = 0; vertex < m_vertexTriangles.size(); vertex++)
+            {
+                if (m_vertexTriangles[vertex].empty())
+                {
+                    continue;
+                }
+
+                GetNeighbours(vertex, m_fromNeighbours);
+                for (unsigned int neighbour : m_fromNeighbours)
+                {
+                    if (neighbour < vertex)
+                    {
+                        continue;
+                    }
+
+                    Collapse forward, backward;
+                    bool canForward = GetCollapse(vertex, neighbour, forward);
+                    bool canBackward = GetCollapse(neighbour, vertex, backward);
+                    if (canForward && (!canBackward || forward.error <= backward.error) && forward.error <= maxError)
+                    {
+                        m_collapses.push_back(forward);
+                    }
+                    else if (canBackward && (!canForward || backward.error < forward.error) && backward.error <= maxError)
+                    {
+                        m_collapses.push_back(backward);
+                    }
+                }
+            }
+        }
+
+        bool CanCollapse(const unsigned int from, const unsigned int to)
+        {
+            unsigned int shared = CountSharedTriangles(from, to);
+            if (shared == 0 || (m_kinds[from] == KIND_BORDER && shared != 1))
+            {
+                return false;
+            }
+
+            // The link condition: the two ends may only have the vertices across the edge's triangles in common, or the
+            // collapse pinches the surface into an edge with more than two triangles.
+            GetNeighbours(from, m_fromNeighbours);
+            GetNeighbours(to, m_toNeighbours);
+            unsigned int common = 0;
+            for (size_t i = 0, j = 0; i < m_fromNeighbours.size() && j < m_toNeighbours.size();)
+            {
+                if (m_fromNeighbours[i] == m_toNeighbours[j])
+                {
+                    common++;
+                    i++;
+                    j++;
+                }
+                else if (m_fromNeighbours[i] < m_toNeighbours[j])
+                {
+                    i++;
+                }
+                else
+                {
+                    j++;
+                }
+            }
+            if (common != shared)
+            {
+                return false;
+            }
+
+            // No triangle that survives may turn further than MAX_TURN_COSINE allows, which also stops them turning over or
+            // collapsing to a line.
+            for (unsigned int triangle : m_vertexTriangles[from])
+            {
+                if (HasCorner(triangle, to))
+                {
+                    continue;
+                }
+
+                unsigned int corners[3];
+                for (unsigned int corner = 0; corner < 3; corner++)
+                {
+                    unsigned int vertex = m_triangles[triangle * 3 + corner];
+                    corners[corner] = vertex == from ? to : vertex;
+                }
+                XMFLOAT3 before = GetNormal(&m_triangles[triangle * 3]);
+                XMFLOAT3 after = GetNormal(corners);
+                float turn = Dot(after, before);
+                if (turn <= 0.0f || turn * turn < MAX_TURN_COSINE * MAX_TURN_COSINE * Dot(after, after) * Dot(before, before))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void RemoveTriangle(const unsigned int vertex, const unsigned int triangle)
+        {
+            vector<unsigned int>& triangles = m_vertexTriangles[vertex];
+            auto found = find(triangles.begin(), triangles.end(), triangle);
+            if (found != triangles.end())
+            {
+                *found = triangles.back();
+                triangles.pop_back();
+            }
+        }
+
+        void Apply(const unsigned int from, const unsigned int to)
+        {
+            // The edge's triangles go, the rest of from's move over to to.
+            for (unsigned int triangle : m_vertexTriangles[from])
+            {
+                unsigned int* corners = &m_triangles[triangle * 3];
+                if (HasCorner(triangle, to))
+                {
+                    m_alive[triangle] = false;
+                    m_triangleCount--;
+                    for (unsigned int corner = 0; corner < 3; corner++)
+                    {
+                        if (corners[corner] != from)
+                        {
+                            RemoveTriangle(corners[corner], triangle);
+                        }
+                    }
+                    continue;
+                }
+
+                for (unsigned int corner = 0; corner < 3; corner++)
+                {
+                    corners[corner] = corners[corner] == from ? to : corners[corner];
+                }
+                m_vertexTriangles[to].push_back(triangle);
+            }
+            vector<unsigned int>().swap(m_vertexTriangles[from]);
+            AddQuadric(m_quadrics[to], m_quadrics[from]);
+        }
+    };
+
+    // A latitude and longitude sphere with a seam of duplicated vertices and a fan of duplicates at each pole, like most
+    // exported spheres. Wound to face out.
+    void AddSphere(const float radius, const unsigned int rings, const unsigned int segments, vector<VertexType>& vertices, vector<unsigned int>& indices)
+    {
+        unsigned int base = (unsigned int)vertices.size();
+        for (unsigned int ring = 0; ring <= rings; ring++)
+        {
+            float theta = XM_PI * ring / rings;
+            for (unsigned int segment = 0; segment <= segments; segment++)
+            {
+                float phi = XM_2PI * segment / segments;
+                VertexType vertex;
+                vertex.position = XMFLOAT3(radius * sinf(theta) * cosf(phi), radius * cosf(theta), radius * sinf(theta) * sinf(phi));
+                vertex.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+                vertices.push_back(vertex);
+            }
+        }
+
+        for (unsigned int ring = 0; ring < rings; ring++)
+        {
+            for (unsigned int segment = 0; segment < segments; segment++)
+            {
+                unsigned int a = base + ring * (segments + 1) + segment, b = a + 1, c = a + segments + 1, d = c + 1;
+                unsigned int quad[2][3] = { { a, b, d }, { a, d, c } };
+                for (auto& triangle : quad)
+                {
+                    XMFLOAT3 normal = TriangleNormal(vertices[triangle[0]].position, vertices[triangle[1]].position, vertices[triangle[2]].position);
+                    XMFLOAT3 outward = vertices[triangle[0]].position;
+                    if (Dot(normal, outward) < 0.0f)
+                    {
+                        swap(triangle[1], triangle[2]);
+                    }
+                    indices.insert(indices.end(), triangle, triangle + 3);
+                }
+            }
+        }
+    }
+
+    // A unit square of size x size quads on the z = 0 plane, facing -z.
+    void AddGrid(const unsigned int size, vector<VertexType>& vertices, vector<unsigned int>& indices)
+    {
+        for (unsigned int y = 0; y <= size; y++)
+        {
+            for (unsigned int x = 0; x <= size; x++)
+            {
+                VertexType vertex;
+                vertex.position = XMFLOAT3((float)x / size, (float)y / size, 0.0f);
+                vertex.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+                vertices.push_back(vertex);
+            }
+        }
+        for (unsigned int y = 0; y < size; y++)
+        {
+            for (unsigned int x = 0; x < size; x++)
+            {
+                unsigned int a = y * (size + 1) + x, b = a + 1, c = a + size + 1, d = c + 1;
+                unsigned int quad[6] = { a, c, d, a, d, b };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    }
+
+    // Throws unless every triangle indexes the vertex buffer, has an area and faces away from center, or along facing
+    // when it isn't zero. Returns the total area.
+    float CheckTriangles(const char* name, const vector<VertexType>& vertices, const unsigned int* indices, const unsigned int indexCount,
+                         const XMFLOAT3& center, const XMFLOAT3& facing)
+    {
+        bool useFacing = Dot(facing, facing) > 0.0f;
+        float area = 0.0f;
+        for (unsigned int i = 0; i < indexCount; i += 3)
+        {
+            if (indices[i] >= vertices.size() || indices[i + 1] >= vertices.size() || indices[i + 2] >= vertices.size())
+            {
+                throw engine_exception("Mesh simplifier validation: ") << name << " has an index out of range at " << i;
+            }
+
+            const XMFLOAT3& a = vertices[indices[i]].position;
+            XMFLOAT3 normal = TriangleNormal(a, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position);
+            float direction = Dot(normal, useFacing ? facing : Subtract(a, center));
+            if (Dot(normal, normal) <= 0.0f || direction <= 0.0f)
+            {
+                throw engine_exception("Mesh simplifier validation: ") << name << " has a degenerate or flipped triangle at " << i;
+            }
+            area += 0.5f * sqrtf(Dot(normal, normal));
+        }
+        return area;
+    }
+
+    // How far the triangles of a unit sphere reach inside it, at their centroids, which is near where they are furthest in.
+    float GetSphereDeviation(const vector<VertexType>& vertices, const unsigned int* indices, const unsigned int indexCount)
+    {
+        float deviation = 0.0f;
+        for (unsigned int i = 0; i < indexCount; i += 3)
+        {
+            const XMFLOAT3& a = vertices[indices[i]].position;
+            const XMFLOAT3& b = vertices[indices[i + 1]].position;
+            const XMFLOAT3& c = vertices[indices[i + 2]].position;
+            XMFLOAT3 centroid((a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f, (a.z + b.z + c.z) / 3.0f);
+            deviation = max(deviation, 1.0f - sqrtf(Dot(centroid, centroid)));
+        }
+        return deviation;
+    }
+}
+
+float MeshSimplifierClass::Simplify(const VertexType* vertices, const unsigned int vertexCount, const unsigned int* indices, const unsigned int indexCount,
+                                    const unsigned int targetIndexCount, const float maxError, vector<unsigned int>& result)
+{
+    PROFILE_FUNCTION();
+
+    EdgeCollapser collapser(vertices, vertexCount, indices, indexCount);
+    float error = collapser.Run(targetIndexCount / 3, maxError);
+    collapser.Emit(result);
+    return error;
+}
+
+void MeshSimplifierClass::BuildLodChain(const vector<VertexType>& vertices, const vector<unsigned int>& indices, vector<unsigned int>& lodIndices,
+                                        vector<Lod>& lods)
+{
+    PROFILE_FUNCTION();
+
+    unsigned int vertexCount = (unsigned int)vertices.size();
+    lodIndices.assign(indices.begin(), indices.end());
+    lods.clear();
+    Lod full = { 0, (unsigned int)indices.size(), 0.0f };
+    lods.push_back(full);
+
+    EdgeCollapser collapser(vertices.data(), vertexCount, indices.data(), (unsigned int)indices.size());
+    vector<unsigned int> level;
+    unsigned int previousTriangles = (unsigned int)indices.size() / 3;
+    while (lods.size() < MeshFileClass::MAX_LODS)
+    {
+        unsigned int targetTriangles = (unsigned int)(previousTriangles * LOD_RATIO);
+        if (targetTriangles < MIN_LOD_TRIANGLES)
+        {
+            break;
+        }
+
+        float error = collapser.Run(targetTriangles, FLT_MAX);
+        if (collapser.GetTriangleCount() > previousTriangles * LOD_MIN_REDUCTION)
+        {
+            break;
+        }
+
+        collapser.Emit(level);
+        MeshOptimizerClass::OptimizeVertexCache(level.data(), (unsigned int)level.size(), vertexCount);
+        MeshOptimizerClass::OptimizeOverdraw(level.data(), (unsigned int)level.size(), vertices.data(), vertexCount, MeshOptimizerClass::OVERDRAW_THRESHOLD);
+
+        Lod lod = { (unsigned int)lodIndices.size(), (unsigned int)level.size(), error };
+        lodIndices.insert(lodIndices.end(), level.begin(), level.end());
+        lods.push_back(lod);
+        previousTriangles = collapser.GetTriangleCount();
+    }
+
+    for (unsigned int lod = 0; lod < lods.size(); lod++)
+    {
+        LOG_INFO("Mesh simplifier: LOD {} {} triangles, error {}", lod, lods[lod].indexCount / 3, lods[lod].error);
+    }
+}
+
+void MeshSimplifierClass::Validate()
+{
+    const XMFLOAT3 origin(0.0f, 0.0f, 0.0f);
+
+    // A quarter of a sphere's triangles, and then a sixteenth: the counts are met, nothing is folded over, and the faces
+    // don't sink into the sphere much further than the error says, which grows as triangles go.
+    vector<VertexType> vertices;
+    vector<unsigned int> indices, quarter, sixteenth;
+    AddSphere(1.0f, 32, 64, vertices, indices);
+    unsigned int vertexCount = (unsigned int)vertices.size(), indexCount = (unsigned int)indices.size();
+    float quarterError = Simplify(vertices.data(), vertexCount, indices.data(), indexCount, indexCount / 4, FLT_MAX, quarter);
+    float sixteenthError = Simplify(vertices.data(), vertexCount, indices.data(), indexCount, indexCount / 16, FLT_MAX, sixteenth);
+    if (quarter.size() > indexCount / 4 || quarter.size() < indexCount / 5 || sixteenth.size() > indexCount / 16 || sixteenth.size() < indexCount / 20)
+    {
+        throw engine_exception("Mesh simplifier validation: a sphere of ") << indexCount / 3 << " triangles went to " << quarter.size() / 3 << " and "
+                                                                           << sixteenth.size() / 3;
+    }
+    CheckTriangles("the simplified sphere", vertices, quarter.data(), (unsigned int)quarter.size(), origin, XMFLOAT3(0.0f, 0.0f, 0.0f));
+    CheckTriangles("the simplified sphere", vertices, sixteenth.data(), (unsigned int)sixteenth.size(), origin, XMFLOAT3(0.0f, 0.0f, 0.0f));
+    float quarterDeviation = GetSphereDeviation(vertices, quarter.data(), (unsigned int)quarter.size());
+    float sixteenthDeviation = GetSphereDeviation(vertices, sixteenth.data(), (unsigned int)sixteenth.size());
+    if (!(quarterError > 0.0f && sixteenthError > quarterError) || quarterDeviation > 4.0f * quarterError || sixteenthDeviation > 4.0f * sixteenthError)
+    {
+        throw engine_exception("Mesh simplifier validation: sphere errors ") << quarterError << " and " << sixteenthError << " against deviations "
+                                                                           << quarterDeviation << " and " << sixteenthDeviation;
+    }
+
+    // A flat grid goes down to a handful of triangles without any error, covering the same square.
+    vector<VertexType> gridVertices;
+    vector<unsigned int> gridIndices, flat;
+    AddGrid(16, gridVertices, gridIndices);
+    float flatError = Simplify(gridVertices.data(), (unsigned int)gridVertices.size(), gridIndices.data(), (unsigned int)gridIndices.size(), 0, 1e-4f, flat);
+    float area = CheckTriangles("the simplified grid", gridVertices, flat.data(), (unsigned int)flat.size(), origin, XMFLOAT3(0.0f, 0.0f, -1.0f));
+    if (flat.size() / 3 > 8 || flatError > 1e-4f || fabsf(area - 1.0f) > 1e-4f)
+    {
+        throw engine_exception("Mesh simplifier validation: a flat grid went to ") << flat.size() / 3 << " triangles covering " << area
+                                                                                 << " with error " << flatError;
+    }
+
+    // A chain halves the triangles level by level, with growing errors, in contiguous runs of one index buffer.
+    vector<unsigned int> lodIndices;
+    vector<Lod> lods;
+    BuildLodChain(vertices, indices, lodIndices, lods);
+    if (lods.size() < 5 || lods[0].indexCount != indexCount)
+    {
+        throw engine_exception("Mesh simplifier validation: a sphere of ") << indexCount / 3 << " triangles got " << lods.size() << " LODs";
+    }
+    for (unsigned int lod = 1; lod < lods.size(); lod++)
+    {
+        const Lod& previous = lods[lod - 1];
+        const Lod& current = lods[lod];
+        if (current.indexOffset != previous.indexOffset + previous.indexCount || current.indexCount > previous.indexCount * LOD_RATIO ||
+            current.error < previous.error)
+        {
+            throw engine_exception("Mesh simplifier validation: LOD ") << lod << " has " << current.indexCount / 3 << " triangles and error "
+                                                                       << current.error << " after " << previous.indexCount / 3 << " and " << previous.error;
+        }
+        CheckTriangles("a LOD", vertices, lodIndices.data() + current.indexOffset, current.indexCount, origin, XMFLOAT3(0.0f, 0.0f, 0.0f));
+    }
+    if (lodIndices.size() != lods.back().indexOffset + lods.back().indexCount)
+    {
+        throw engine_exception("Mesh simplifier validation: the LOD chain has ") << lodIndices.size() << " indices, its LODs cover "
+                                                                               << lods.back().indexOffset + lods.back().indexCount;
+    }
+
+    LOG_INFO("Mesh simplifier validation: a sphere of {} triangles at a quarter has error {} and sinks {}, at a sixteenth {} and {}; a flat grid "
+             "goes to {} triangles; {} LODs down to {} triangles", indexCount / 3, quarterError, quarterDeviation, sixteenthError, sixteenthDeviation,
+             flat.size() / 3, lods.size(), lods.back().indexCount / 3);
+}
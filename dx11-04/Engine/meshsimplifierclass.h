@@ -0,0 +1,47 @@
+#pragma once
+#include "engine.h"
+#include "vertexformatclass.h"
+#include "meshfileclass.h"
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+
+// Quadric error metric mesh simplification (Garland and Heckbert) for the LOD chains MeshConverterClass builds at import.
+// Every triangle's plane, weighted by its area, is summed into a quadric at its corners, and edges are collapsed cheapest
+// first, the cost being how far the merged quadric puts the surviving vertex off the planes of the triangles it replaces.
+// Collapses are half edge ones, onto one of the two existing vertices, so every level indexes the same vertex buffer.
+// Open borders get extra planes across them so holes and outlines keep their shape, edges shared by more than two
+// triangles are never collapsed, and collapses that would fold a triangle over or pinch the surface are skipped.
+//
+// Vertices at the same position are simplified as one; the triangles keep the first of them, so colour seams blur in
+// the coarser levels.
+class MeshSimplifierClass
+{
+public:
+    typedef VertexFormatClass::VertexType VertexType;
+    typedef MeshFileClass::MeshFileLod Lod;
+
+    // Each level of a chain aims for this fraction of the triangles of the one before.
+    static const float LOD_RATIO;
+    // A chain stops before a level that would have fewer triangles than this, or that can't get under LOD_MIN_REDUCTION
+    // of the one before because the rest is locked.
+    static const unsigned int MIN_LOD_TRIANGLES = 64;
+    static const float LOD_MIN_REDUCTION;
+
+    // Collapses edges until at most targetIndexCount indices are left or the cheapest collapse would have an error over
+    // maxError, and writes the triangles that are left to result. Returns the error: the largest distance, in object
+    // space units, the surface was moved by any collapse, in the RMS sense of the quadrics.
+    static float Simplify(const VertexType* vertices, const unsigned int vertexCount, const unsigned int* indices, const unsigned int indexCount,
+                          const unsigned int targetIndexCount, const float maxError, vector<unsigned int>& result);
+
+    // Builds up to MeshFileClass::MAX_LODS levels into lodIndices, one after the other: indices as they are, then ever
+    // coarser ones from a single run of collapses, each reordered for the vertex cache and overdraw.
+    static void BuildLodChain(const vector<VertexType>& vertices, const vector<unsigned int>& indices, vector<unsigned int>& lodIndices,
+                              vector<Lod>& lods);
+
+    // Simplifies a sphere with seams, a flat grid and a chain of both, and checks triangle counts, that nothing is folded
+    // over or off the vertex buffer, that the reported error bounds how far the surface really moved and that flat
+    // surfaces keep their outline. Throws on a failure.
+    static void Validate();
+};
@@ -1,9 +1,24 @@
 #include "modelclass.h"
+#include "meshoptimizerclass.h"
 
 using namespace std;
 
+namespace
+{
+    // Room for alignment and guard bytes on top of what an arena's blocks hold.
+    const size_t ARENA_SLACK = 256;
+}
+
 ModelClass::ModelClass()
 {
+    m_vertices = nullptr;
+    m_indices = nullptr;
+    m_vertexData = nullptr;
+    m_indexData = nullptr;
+    m_vertexCount = m_indexCount = 0;
+    m_vertexStride = m_indexStride = 0;
+    m_boundsMin = m_boundsMax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    m_lodCount = 0;
 }
 
 
@@ -11,40 +26,191 @@ ModelClass::~ModelClass()
 {
 }
 
-void ModelClass::Initialize(ID3D11Device* device)
+void ModelClass::Initialize(ID3D11Device* device, const VertexFormatClass::Format format)
 {
-    D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-    D3D11_SUBRESOURCE_DATA vertexData, indexData;
-    HRESULT result;
-    
     m_vertexCount = 3;
     m_indexCount = 3;
+    m_lodCount = 1;
+    m_lods[0].indexOffset = 0;
+    m_lods[0].indexCount = m_indexCount;
+    m_lods[0].error = 0.0f;
+
+    AllocateGeometry();
 
     // Setup the vertex array.
-    unique_ptr<VertexType[]> vertices(new VertexType[m_vertexCount]);
-    vertices[0].position = XMFLOAT3(-1.0f, -1.0f, 0.0f);  // Bottom left.
-    vertices[0].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
-    vertices[1].position = XMFLOAT3(0.0f, 1.0f, 0.0f);  // Top middle.
-    vertices[1].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
-    vertices[2].position = XMFLOAT3(1.0f, -1.0f, 0.0f);  // Bottom right.
-    vertices[2].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+    m_vertices[0].position = XMFLOAT3(-1.0f, -1.0f, 0.0f);  // Bottom left.
+    m_vertices[0].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+    m_vertices[1].position = XMFLOAT3(0.0f, 1.0f, 0.0f);  // Top middle.
+    m_vertices[1].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+    m_vertices[2].position = XMFLOAT3(1.0f, -1.0f, 0.0f);  // Bottom right.
+    m_vertices[2].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
 
     // Setup the index array.
-    unique_ptr<unsigned long[]> indices(new unsigned long[m_indexCount]);
-    indices[0] = 0;  // Bottom left.
-    indices[1] = 1;  // Top middle.
-    indices[2] = 2;  // Bottom right.
-    
+    m_indices[0] = 0;  // Bottom left.
+    m_indices[1] = 1;  // Top middle.
+    m_indices[2] = 2;  // Bottom right.
+
+    m_vertexData = m_vertices;
+    m_indexData = m_indices;
+
+    VertexFormatClass::ComputeBounds(m_vertices, m_vertexCount, m_boundsMin, m_boundsMax);
+    m_quantization = VertexFormatClass::GetQuantization(format, m_boundsMin, m_boundsMax);
+    m_vertexStride = VertexFormatClass::GetStride(format);
+    m_indexStride = VertexFormatClass::GetIndexStride(m_vertexCount);
+
+    // The software renderer draws straight from the system memory copies.
+    if (device == nullptr)
+    {
+        return;
+    }
+
+    // Pack the vertices and indices into the formats the GPU will read, in scratch memory that is gone once the buffers
+    // have their copies.
+    LinearAllocatorClass scratch;
+    scratch.Initialize("Model packing scratch", m_vertexStride * m_vertexCount + sizeof(unsigned short) * m_indexCount + ARENA_SLACK, true);
+    void* packedVertices = scratch.Allocate(m_vertexStride * m_vertexCount, 16);
+    VertexFormatClass::Encode(m_quantization, m_vertices, m_vertexCount, packedVertices);
+
+    const void* indices = m_indices;
+    if (m_indexStride == sizeof(unsigned short))
+    {
+        unsigned short* shortIndices = scratch.AllocateArray<unsigned short>(m_indexCount);
+        copy(m_indices, m_indices + m_indexCount, shortIndices);
+        indices = shortIndices;
+    }
+
+    InitializeBuffers(device, packedVertices, indices);
+}
+
+void ModelClass::Initialize(ID3D11Device* device, const char* meshFileName)
+{
+    PROFILE_FUNCTION();
+
+    m_meshFile = unique_ptr<MeshFileClass>(new MeshFileClass());
+    m_meshFile->Open(meshFileName);
+    m_vertexCount = m_meshFile->GetVertexCount();
+    m_indexCount = m_meshFile->GetIndexCount();
+    m_quantization = m_meshFile->GetQuantization();
+    m_vertexStride = VertexFormatClass::GetStride(m_quantization.format);
+    m_indexStride = m_meshFile->GetIndexStride();
+    m_boundsMin = m_meshFile->GetHeader().boundsMin;
+    m_boundsMax = m_meshFile->GetHeader().boundsMax;
+    m_lodCount = m_meshFile->GetLodCount();
+    for (unsigned int lod = 0; lod < m_lodCount; lod++)
+    {
+        m_lods[lod] = m_meshFile->GetLod(lod);
+    }
+
+    // Files converted before the optimizer are reordered here, on copies that are gone once the model has its own.
+    const void* vertices = m_meshFile->GetVertices();
+    const void* indices = m_meshFile->GetIndices();
+    LinearAllocatorClass scratch;
+    if ((m_meshFile->GetHeader().flags & MeshFileClass::FLAG_OPTIMIZED) == 0)
+    {
+        OptimizeAtLoad(scratch, vertices, indices);
+        LOG_INFO("Model: {} was not optimized when converted and was reordered at load; run MeshTool -optimize on it", meshFileName);
+    }
+
+    // Once the GPU has its copy there is no reason to keep the file mapped.
+    if (device != nullptr)
+    {
+        InitializeBuffers(device, vertices, indices);
+        m_meshFile.reset();
+        return;
+    }
+
+    // The software renderer reads float vertices and 32-bit indices, so anything else is unpacked into system memory.
+    if (m_quantization.format == VertexFormatClass::VERTEX_FLOAT && m_indexStride == sizeof(unsigned int) && vertices == m_meshFile->GetVertices())
+    {
+        m_vertexData = (const VertexType*)vertices;
+        m_indexData = (const unsigned int*)indices;
+        return;
+    }
+
+    AllocateGeometry();
+    VertexFormatClass::Decode(m_quantization, vertices, m_vertexCount, m_vertices);
+
+    if (m_indexStride == sizeof(unsigned short))
+    {
+        const unsigned short* shortIndices = (const unsigned short*)indices;
+        copy(shortIndices, shortIndices + m_indexCount, m_indices);
+    }
+    else
+    {
+        memcpy(m_indices, indices, m_indexCount * sizeof(unsigned int));
+    }
+
+    m_vertexData = m_vertices;
+    m_indexData = m_indices;
+    m_meshFile.reset();
+}
+
+void ModelClass::OptimizeAtLoad(LinearAllocatorClass& scratch, const void*& vertices, const void*& indices)
+{
+    PROFILE_FUNCTION();
+
+    // Packed vertices are moved as they are; the decoded copy is only for the overdraw sort's positions.
+    size_t packedBytes = (size_t)m_vertexStride * m_vertexCount;
+    scratch.Initialize("Model optimization scratch", packedBytes + sizeof(VertexType) * m_vertexCount + (sizeof(unsigned int) + m_indexStride) * m_indexCount +
+                       ARENA_SLACK, true);
+    void* packedVertices = scratch.Allocate(packedBytes, 16);
+    memcpy(packedVertices, vertices, packedBytes);
+    VertexType* decodedVertices = scratch.AllocateArray<VertexType>(m_vertexCount);
+    VertexFormatClass::Decode(m_quantization, vertices, m_vertexCount, decodedVertices);
+
+    unsigned int* longIndices = scratch.AllocateArray<unsigned int>(m_indexCount);
+    if (m_indexStride == sizeof(unsigned short))
+    {
+        const unsigned short* shortIndices = (const unsigned short*)indices;
+        copy(shortIndices, shortIndices + m_indexCount, longIndices);
+    }
+    else
+    {
+        memcpy(longIndices, indices, m_indexCount * sizeof(unsigned int));
+    }
+
+    for (unsigned int lod = 0; lod < m_lodCount; lod++)
+    {
+        unsigned int* lodIndices = longIndices + m_lods[lod].indexOffset;
+        MeshOptimizerClass::OptimizeVertexCache(lodIndices, m_lods[lod].indexCount, m_vertexCount);
+        MeshOptimizerClass::OptimizeOverdraw(lodIndices, m_lods[lod].indexCount, decodedVertices, m_vertexCount, MeshOptimizerClass::OVERDRAW_THRESHOLD);
+    }
+    m_vertexCount = MeshOptimizerClass::OptimizeVertexFetch(packedVertices, m_vertexStride, m_vertexCount, longIndices, m_indexCount);
+
+    vertices = packedVertices;
+    indices = longIndices;
+    if (m_indexStride == sizeof(unsigned short))
+    {
+        unsigned short* shortIndices = scratch.AllocateArray<unsigned short>(m_indexCount);
+        copy(longIndices, longIndices + m_indexCount, shortIndices);
+        indices = shortIndices;
+    }
+}
+
+void ModelClass::AllocateGeometry()
+{
+    // Sized for both arrays, so the arena is a single allocation unless guards need more.
+    m_geometry.Initialize("Model geometry", sizeof(VertexType) * m_vertexCount + sizeof(unsigned int) * m_indexCount + ARENA_SLACK, true);
+    m_vertices = m_geometry.AllocateArray<VertexType>(m_vertexCount);
+    m_indices = m_geometry.AllocateArray<unsigned int>(m_indexCount);
+}
+
+void ModelClass::InitializeBuffers(ID3D11Device* device, const void* vertices, const void* indices)
+{
+    D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
+    D3D11_SUBRESOURCE_DATA vertexData, indexData;
+    HRESULT result;
+
     // Set up the description of the static vertex buffer.
     vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    vertexBufferDesc.ByteWidth = sizeof(VertexType)* m_vertexCount;
+    vertexBufferDesc.ByteWidth = m_vertexStride * m_vertexCount;
     vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
     vertexBufferDesc.CPUAccessFlags = 0;
     vertexBufferDesc.MiscFlags = 0;
     vertexBufferDesc.StructureByteStride = 0;
 
     // Give the subresource structure a pointer to the vertex data.
-    vertexData.pSysMem = vertices.get();
+    vertexData.pSysMem = vertices;
     vertexData.SysMemPitch = 0;
     vertexData.SysMemSlicePitch = 0;
 
@@ -57,14 +223,14 @@ void ModelClass::Initialize(ID3D11Device* device)
 
     // Set up the description of the static index buffer.
     indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDesc.ByteWidth = sizeof(unsigned long)* m_indexCount;
+    indexBufferDesc.ByteWidth = m_indexStride * m_indexCount;
     indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
     indexBufferDesc.CPUAccessFlags = 0;
     indexBufferDesc.MiscFlags = 0;
     indexBufferDesc.StructureByteStride = 0;
 
     // Give the subresource structure a pointer to the index data.
-    indexData.pSysMem = indices.get();
+    indexData.pSysMem = indices;
     indexData.SysMemPitch = 0;
     indexData.SysMemSlicePitch = 0;
 
@@ -74,25 +240,62 @@ void ModelClass::Initialize(ID3D11Device* device)
     {
         throw engine_exception("Creation of index buffer failed with result code = ") << result;
     }
+
+    // Report what the packed formats save over float vertices and 32-bit indices.
+    unsigned long long bytes = (unsigned long long)m_vertexStride * m_vertexCount + (unsigned long long)m_indexStride * m_indexCount;
+    unsigned long long unpackedBytes = (unsigned long long)sizeof(VertexType) * m_vertexCount + (unsigned long long)sizeof(unsigned int) * m_indexCount;
+    LOG_INFO("Model: {} {} vertices, {} {}-bit indices in {} LODs, {} bytes, {} bytes saved", m_vertexCount, VertexFormatClass::GetName(m_quantization.format),
+             m_indexCount, m_indexStride * 8, m_lodCount, bytes, unpackedBytes - bytes);
 }
 
-void ModelClass::Render(ID3D11DeviceContext* deviceContext)
+void ModelClass::Render(StateCacheClass* stateCache, const unsigned int lod)
 {
     // Set vertex buffer stride and offset.
-    unsigned int stride = sizeof(VertexType);
+    unsigned int stride = m_vertexStride;
     unsigned int offset = 0;
 
     // Set the vertex buffer to active in the input assembler so it can be rendered.
-    deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
+    stateCache->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
+
+    // Set the index buffer to active in the input assembler so it can be rendered, from the start of the LOD.
+    stateCache->IASetIndexBuffer(m_indexBuffer.Get(), VertexFormatClass::GetIndexFormat(m_indexStride), GetLod(lod).indexOffset * m_indexStride);
+
+    // The topology comes with the shader's pipeline state.
+}
+
+void ModelClass::Render(SoftwareRasterizerClass* rasterizer, const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection, const unsigned int lod)
+{
+    const MeshFileClass::MeshFileLod& range = GetLod(lod);
+    rasterizer->DrawIndexed(m_vertexData, sizeof(VertexType), m_vertexCount, m_indexData + range.indexOffset, range.indexCount, world, view, projection);
+}
+
+int ModelClass::GetIndexCount(const unsigned int lod)
+{
+    return GetLod(lod).indexCount;
+}
+
+unsigned int ModelClass::GetLodCount()
+{
+    return m_lodCount;
+}
+
+const MeshFileClass::MeshFileLod* ModelClass::GetLods()
+{
+    return m_lods;
+}
 
-    // Set the index buffer to active in the input assembler so it can be rendered.
-    deviceContext->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+const MeshFileClass::MeshFileLod& ModelClass::GetLod(const unsigned int lod)
+{
+    return m_lods[min(lod, m_lodCount - 1)];
+}
 
-    // Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+const VertexFormatClass::Quantization& ModelClass::GetQuantization()
+{
+    return m_quantization;
 }
 
-int ModelClass::GetIndexCount()
+void ModelClass::GetBounds(XMFLOAT3& center, XMFLOAT3& extents)
 {
-    return m_indexCount;
+    center = XMFLOAT3((m_boundsMin.x + m_boundsMax.x) * 0.5f, (m_boundsMin.y + m_boundsMax.y) * 0.5f, (m_boundsMin.z + m_boundsMax.z) * 0.5f);
+    extents = XMFLOAT3((m_boundsMax.x - m_boundsMin.x) * 0.5f, (m_boundsMax.y - m_boundsMin.y) * 0.5f, (m_boundsMax.z - m_boundsMin.z) * 0.5f);
 }
@@ -1,5 +1,11 @@
 #pragma once
 #include "engine.h"
+#include "softwarerasterizerclass.h"
+#include "statecacheclass.h"
+#include "meshfileclass.h"
+#include "linearallocatorclass.h"
+#include <vector>
+#include <algorithm>
 
 using namespace std;
 using namespace DirectX;
@@ -12,20 +18,64 @@ public:
 
     ~ModelClass();
 
-    void Initialize(ID3D11Device* device);
+    // Builds the built in triangle in the given vertex format. A null device (software renderer) keeps the geometry in
+    // system memory only.
+    void Initialize(ID3D11Device* device, const VertexFormatClass::Format format);
 
-    void Render(ID3D11DeviceContext* deviceContext);
+    // Loads a .mesh file written by MeshConverterClass, in whatever vertex format it was converted to. The buffers are
+    // created straight from the file mapping; the software renderer draws from the mapping too when the file holds float
+    // vertices and 32-bit indices, and from a decoded copy otherwise. Files written before the mesh optimizer are
+    // optimized on the way, from copies.
+    void Initialize(ID3D11Device* device, const char* meshFileName);
 
-    int GetIndexCount();
+    // Binds the buffers, with the index buffer starting at the given LOD. Draw GetIndexCount(lod) indices from 0.
+    void Render(StateCacheClass* stateCache, const unsigned int lod = 0);
+
+    void Render(SoftwareRasterizerClass* rasterizer, const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection, const unsigned int lod = 0);
+
+    int GetIndexCount(const unsigned int lod = 0);
+
+    // LOD 0 is the full model, and each one after it has fewer triangles and a larger error. The built in triangle and
+    // files converted before LODs have just the one.
+    unsigned int GetLodCount();
+
+    const MeshFileClass::MeshFileLod* GetLods();
+
+    // The vertex format and dequantization constants the shader needs for this model.
+    const VertexFormatClass::Quantization& GetQuantization();
+
+    // Object space bounding box, for culling.
+    void GetBounds(XMFLOAT3& center, XMFLOAT3& extents);
 
 private:
-    struct VertexType
-    {
-        XMFLOAT3 position;
-        XMFLOAT4 color;
-    };
+    typedef VertexFormatClass::VertexType VertexType;
 
     ComPtr<ID3D11Buffer> m_vertexBuffer, m_indexBuffer;
+    // System memory copies for the software renderer, from m_geometry.
+    VertexType* m_vertices;
+    unsigned int* m_indices;
+    LinearAllocatorClass m_geometry;
+    unique_ptr<MeshFileClass> m_meshFile;
+    const VertexType* m_vertexData;
+    const unsigned int* m_indexData;
     int m_vertexCount, m_indexCount;
+    unsigned int m_vertexStride, m_indexStride;
+    VertexFormatClass::Quantization m_quantization;
+    XMFLOAT3 m_boundsMin, m_boundsMax;
+    // Runs of the index buffer; m_indexCount covers them all.
+    MeshFileClass::MeshFileLod m_lods[MeshFileClass::MAX_LODS];
+    unsigned int m_lodCount;
+
+    // Sets up m_geometry with room for the vertices and indices and allocates them.
+    void AllocateGeometry();
+
+    // Runs the vertex cache and overdraw optimizations on every LOD and the vertex fetch one on them all, on copies of
+    // the file's vertices and indices in scratch, and points them at the copies.
+    void OptimizeAtLoad(LinearAllocatorClass& scratch, const void*& vertices, const void*& indices);
+
+    void InitializeBuffers(ID3D11Device* device, const void* vertices, const void* indices);
+
+    // Out of range LODs draw the coarsest one.
+    const MeshFileClass::MeshFileLod& GetLod(const unsigned int lod);
 };
 
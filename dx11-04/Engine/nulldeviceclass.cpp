@@ -0,0 +1,1412 @@
+#include "nulldeviceclass.h"
+
+namespace
+{
+    // Reference counting, private data and the owning device for everything the null device creates. Every object holds
+    // a reference to the device, as real device children do.
+    template <class Interface>
+    class NullObject : public Interface
+    {
+    public:
+        NullObject(NullDeviceClass* device)
+        {
+            m_device = device;
+            m_device->AddRef();
+            m_references = 1;
+            m_number = device->NextObjectNumber();
+        }
+
+        virtual ~NullObject()
+        {
+            m_device->Release();
+        }
+
+        unsigned int GetNumber()
+        {
+            return m_number;
+        }
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+        {
+            if (riid == __uuidof(IUnknown) || riid == __uuidof(ID3D11DeviceChild) || riid == __uuidof(Interface) || IsBaseInterface(riid))
+            {
+                AddRef();
+                *ppvObject = static_cast<Interface*>(this);
+                return S_OK;
+            }
+
+            *ppvObject = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        ULONG STDMETHODCALLTYPE AddRef() override
+        {
+            return ++m_references;
+        }
+
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            ULONG references = --m_references;
+            if (references == 0)
+            {
+                delete this;
+            }
+
+            return references;
+        }
+
+        void STDMETHODCALLTYPE GetDevice(ID3D11Device** ppDevice) override
+        {
+            m_device->AddRef();
+            *ppDevice = m_device;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData) override
+        {
+            *pDataSize = 0;
+            return DXGI_ERROR_NOT_FOUND;
+        }
+
+        // Debug names and the like are accepted and dropped.
+        HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT DataSize, const void* pData) override
+        {
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData) override
+        {
+            return S_OK;
+        }
+
+    protected:
+        NullDeviceClass* m_device;
+
+        // Interfaces between ID3D11DeviceChild and Interface, e.g. ID3D11Resource for a buffer.
+        virtual bool IsBaseInterface(REFIID riid)
+        {
+            return false;
+        }
+
+    private:
+        atomic<ULONG> m_references;
+        unsigned int m_number;
+    };
+
+    // An object that only keeps the description it was created with.
+    template <class Interface, class Desc>
+    class NullDescribedObject : public NullObject<Interface>
+    {
+    public:
+        NullDescribedObject(NullDeviceClass* device, const Desc& desc) : NullObject<Interface>(device)
+        {
+            m_desc = desc;
+        }
+
+        void STDMETHODCALLTYPE GetDesc(Desc* pDesc) override
+        {
+            *pDesc = m_desc;
+        }
+
+    protected:
+        Desc m_desc;
+    };
+
+    template <class Interface, class Desc>
+    class NullResource : public NullDescribedObject<Interface, Desc>
+    {
+    public:
+        NullResource(NullDeviceClass* device, const Desc& desc, const D3D11_RESOURCE_DIMENSION dimension) : NullDescribedObject<Interface, Desc>(device, desc)
+        {
+            m_dimension = dimension;
+            m_evictionPriority = 0;
+        }
+
+        void STDMETHODCALLTYPE GetType(D3D11_RESOURCE_DIMENSION* pResourceDimension) override
+        {
+            *pResourceDimension = m_dimension;
+        }
+
+        void STDMETHODCALLTYPE SetEvictionPriority(UINT EvictionPriority) override
+        {
+            m_evictionPriority = EvictionPriority;
+        }
+
+        UINT STDMETHODCALLTYPE GetEvictionPriority() override
+        {
+            return m_evictionPriority;
+        }
+
+    protected:
+        bool IsBaseInterface(REFIID riid) override
+        {
+            return riid == __uuidof(ID3D11Resource);
+        }
+
+    private:
+        D3D11_RESOURCE_DIMENSION m_dimension;
+        UINT m_evictionPriority;
+    };
+
+    // Buffers the CPU can write to get system memory behind them, so maps hand out somewhere real to write.
+    class NullBuffer : public NullResource<ID3D11Buffer, D3D11_BUFFER_DESC>
+    {
+    public:
+        NullBuffer(NullDeviceClass* device, const D3D11_BUFFER_DESC& desc) : NullResource<ID3D11Buffer, D3D11_BUFFER_DESC>(device, desc, D3D11_RESOURCE_DIMENSION_BUFFER)
+        {
+            if (desc.CPUAccessFlags != 0)
+            {
+                m_data.resize(desc.ByteWidth);
+            }
+        }
+
+        vector<unsigned char> m_data;
+    };
+
+    template <class Interface, class Desc>
+    class NullView : public NullDescribedObject<Interface, Desc>
+    {
+    public:
+        NullView(NullDeviceClass* device, const Desc& desc, ID3D11Resource* resource) : NullDescribedObject<Interface, Desc>(device, desc)
+        {
+            m_resource = resource;
+            m_resource->AddRef();
+        }
+
+        ~NullView()
+        {
+            m_resource->Release();
+        }
+
+        void STDMETHODCALLTYPE GetResource(ID3D11Resource** ppResource) override
+        {
+            m_resource->AddRef();
+            *ppResource = m_resource;
+        }
+
+    protected:
+        bool IsBaseInterface(REFIID riid) override
+        {
+            return riid == __uuidof(ID3D11View);
+        }
+
+    private:
+        ID3D11Resource* m_resource;
+    };
+
+    class NullCommandList : public NullObject<ID3D11CommandList>
+    {
+    public:
+        NullCommandList(NullDeviceClass* device, vector<NullDeviceClass::CallRecord>& records) : NullObject<ID3D11CommandList>(device)
+        {
+            m_records.swap(records);
+        }
+
+        UINT STDMETHODCALLTYPE GetContextFlags() override
+        {
+            return 0;
+        }
+
+        vector<NullDeviceClass::CallRecord> m_records;
+    };
+
+    template <class Interface>
+    unsigned int NumberOf(Interface* object)
+    {
+        return object != nullptr ? static_cast<NullObject<Interface>*>(object)->GetNumber() : 0;
+    }
+
+    template <class Interface>
+    unsigned int NumberOfFirst(Interface* const* objects, const UINT count)
+    {
+        return objects != nullptr && count > 0 ? NumberOf(objects[0]) : 0;
+    }
+
+    unsigned int NumberOfResource(ID3D11Resource* resource)
+    {
+        if (resource == nullptr)
+        {
+            return 0;
+        }
+
+        D3D11_RESOURCE_DIMENSION dimension;
+        resource->GetType(&dimension);
+        if (dimension == D3D11_RESOURCE_DIMENSION_BUFFER)
+        {
+            return NumberOf(static_cast<ID3D11Buffer*>(resource));
+        }
+        return NumberOf(static_cast<ID3D11Texture2D*>(resource));
+    }
+
+    template <class Interface>
+    void ClearBindings(Interface** objects, const UINT count)
+    {
+        if (objects != nullptr)
+        {
+            for (UINT i = 0; i < count; i++)
+            {
+                objects[i] = nullptr;
+            }
+        }
+    }
+}
+
+NullDeviceClass::NullDeviceClass()
+{
+    m_references = 1;
+    m_objectCount = 0;
+    m_immediateContext = new NullDeviceContextClass(this, false);
+}
+
+NullDeviceClass::~NullDeviceClass()
+{
+    delete m_immediateContext;
+}
+
+void NullDeviceClass::CreateDevice(ID3D11Device** device, ID3D11DeviceContext** immediateContext)
+{
+    NullDeviceClass* nullDevice = new NullDeviceClass();
+    *device = nullDevice;
+    nullDevice->GetImmediateContext(immediateContext);
+}
+
+unsigned int NullDeviceClass::NextObjectNumber()
+{
+    return ++m_objectCount;
+}
+
+HRESULT NullDeviceClass::QueryInterface(REFIID riid, void** ppvObject)
+{
+    if (riid == __uuidof(IUnknown) || riid == __uuidof(ID3D11Device))
+    {
+        AddRef();
+        *ppvObject = static_cast<ID3D11Device*>(this);
+        return S_OK;
+    }
+
+    *ppvObject = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG NullDeviceClass::AddRef()
+{
+    return ++m_references;
+}
+
+ULONG NullDeviceClass::Release()
+{
+    ULONG references = --m_references;
+    if (references == 0)
+    {
+        delete this;
+    }
+
+    return references;
+}
+
+HRESULT NullDeviceClass::CreateBuffer(const D3D11_BUFFER_DESC* pDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, ID3D11Buffer** ppBuffer)
+{
+    if (ppBuffer == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    NullBuffer* buffer = new NullBuffer(this, *pDesc);
+    if (pInitialData != nullptr && !buffer->m_data.empty())
+    {
+        memcpy(buffer->m_data.data(), pInitialData->pSysMem, pDesc->ByteWidth);
+    }
+
+    Record(CALL_CREATE_BUFFER, buffer->GetNumber(), pDesc->ByteWidth, pDesc->BindFlags);
+    *ppBuffer = buffer;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateTexture1D(const D3D11_TEXTURE1D_DESC* pDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, ID3D11Texture1D** ppTexture1D)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreateTexture2D(const D3D11_TEXTURE2D_DESC* pDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, ID3D11Texture2D** ppTexture2D)
+{
+    if (ppTexture2D == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    NullResource<ID3D11Texture2D, D3D11_TEXTURE2D_DESC>* texture = new NullResource<ID3D11Texture2D, D3D11_TEXTURE2D_DESC>(this, *pDesc, D3D11_RESOURCE_DIMENSION_TEXTURE2D);
+    Record(CALL_CREATE_TEXTURE_2D, texture->GetNumber(), pDesc->Width, pDesc->Height);
+    *ppTexture2D = texture;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateTexture3D(const D3D11_TEXTURE3D_DESC* pDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, ID3D11Texture3D** ppTexture3D)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreateShaderResourceView(ID3D11Resource* pResource, const D3D11_SHADER_RESOURCE_VIEW_DESC* pDesc, ID3D11ShaderResourceView** ppSRView)
+{
+    if (ppSRView == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC desc;
+    ZeroMemory(&desc, sizeof(desc));
+    NullView<ID3D11ShaderResourceView, D3D11_SHADER_RESOURCE_VIEW_DESC>* view =
+        new NullView<ID3D11ShaderResourceView, D3D11_SHADER_RESOURCE_VIEW_DESC>(this, pDesc != nullptr ? *pDesc : desc, pResource);
+    Record(CALL_CREATE_SHADER_RESOURCE_VIEW, view->GetNumber(), NumberOfResource(pResource), 0);
+    *ppSRView = view;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateUnorderedAccessView(ID3D11Resource* pResource, const D3D11_UNORDERED_ACCESS_VIEW_DESC* pDesc, ID3D11UnorderedAccessView** ppUAView)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreateRenderTargetView(ID3D11Resource* pResource, const D3D11_RENDER_TARGET_VIEW_DESC* pDesc, ID3D11RenderTargetView** ppRTView)
+{
+    if (ppRTView == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    D3D11_RENDER_TARGET_VIEW_DESC desc;
+    ZeroMemory(&desc, sizeof(desc));
+    NullView<ID3D11RenderTargetView, D3D11_RENDER_TARGET_VIEW_DESC>* view =
+        new NullView<ID3D11RenderTargetView, D3D11_RENDER_TARGET_VIEW_DESC>(this, pDesc != nullptr ? *pDesc : desc, pResource);
+    Record(CALL_CREATE_RENDER_TARGET_VIEW, view->GetNumber(), NumberOfResource(pResource), 0);
+    *ppRTView = view;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateDepthStencilView(ID3D11Resource* pResource, const D3D11_DEPTH_STENCIL_VIEW_DESC* pDesc, ID3D11DepthStencilView** ppDepthStencilView)
+{
+    if (ppDepthStencilView == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    D3D11_DEPTH_STENCIL_VIEW_DESC desc;
+    ZeroMemory(&desc, sizeof(desc));
+    NullView<ID3D11DepthStencilView, D3D11_DEPTH_STENCIL_VIEW_DESC>* view =
+        new NullView<ID3D11DepthStencilView, D3D11_DEPTH_STENCIL_VIEW_DESC>(this, pDesc != nullptr ? *pDesc : desc, pResource);
+    Record(CALL_CREATE_DEPTH_STENCIL_VIEW, view->GetNumber(), NumberOfResource(pResource), 0);
+    *ppDepthStencilView = view;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* pInputElementDescs, UINT NumElements, const void* pShaderBytecodeWithInputSignature,
+                                           SIZE_T BytecodeLength, ID3D11InputLayout** ppInputLayout)
+{
+    if (ppInputLayout == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    NullObject<ID3D11InputLayout>* inputLayout = new NullObject<ID3D11InputLayout>(this);
+    Record(CALL_CREATE_INPUT_LAYOUT, inputLayout->GetNumber(), NumElements, 0);
+    *ppInputLayout = inputLayout;
+    return S_OK;
+}
+
+// Bytecode is taken as it comes; nothing runs it.
+HRESULT NullDeviceClass::CreateVertexShader(const void* pShaderBytecode, SIZE_T BytecodeLength, ID3D11ClassLinkage* pClassLinkage, ID3D11VertexShader** ppVertexShader)
+{
+    if (ppVertexShader == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    NullObject<ID3D11VertexShader>* shader = new NullObject<ID3D11VertexShader>(this);
+    Record(CALL_CREATE_VERTEX_SHADER, shader->GetNumber(), (unsigned int)BytecodeLength, 0);
+    *ppVertexShader = shader;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateGeometryShader(const void* pShaderBytecode, SIZE_T BytecodeLength, ID3D11ClassLinkage* pClassLinkage, ID3D11GeometryShader** ppGeometryShader)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreateGeometryShaderWithStreamOutput(const void* pShaderBytecode, SIZE_T BytecodeLength, const D3D11_SO_DECLARATION_ENTRY* pSODeclaration,
+                                                              UINT NumEntries, const UINT* pBufferStrides, UINT NumStrides, UINT RasterizedStream,
+                                                              ID3D11ClassLinkage* pClassLinkage, ID3D11GeometryShader** ppGeometryShader)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreatePixelShader(const void* pShaderBytecode, SIZE_T BytecodeLength, ID3D11ClassLinkage* pClassLinkage, ID3D11PixelShader** ppPixelShader)
+{
+    if (ppPixelShader == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    NullObject<ID3D11PixelShader>* shader = new NullObject<ID3D11PixelShader>(this);
+    Record(CALL_CREATE_PIXEL_SHADER, shader->GetNumber(), (unsigned int)BytecodeLength, 0);
+    *ppPixelShader = shader;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateHullShader(const void* pShaderBytecode, SIZE_T BytecodeLength, ID3D11ClassLinkage* pClassLinkage, ID3D11HullShader** ppHullShader)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreateDomainShader(const void* pShaderBytecode, SIZE_T BytecodeLength, ID3D11ClassLinkage* pClassLinkage, ID3D11DomainShader** ppDomainShader)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreateComputeShader(const void* pShaderBytecode, SIZE_T BytecodeLength, ID3D11ClassLinkage* pClassLinkage, ID3D11ComputeShader** ppComputeShader)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreateClassLinkage(ID3D11ClassLinkage** ppLinkage)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreateBlendState(const D3D11_BLEND_DESC* pBlendStateDesc, ID3D11BlendState** ppBlendState)
+{
+    if (ppBlendState == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    NullDescribedObject<ID3D11BlendState, D3D11_BLEND_DESC>* state = new NullDescribedObject<ID3D11BlendState, D3D11_BLEND_DESC>(this, *pBlendStateDesc);
+    Record(CALL_CREATE_BLEND_STATE, state->GetNumber(), 0, 0);
+    *ppBlendState = state;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC* pDepthStencilDesc, ID3D11DepthStencilState** ppDepthStencilState)
+{
+    if (ppDepthStencilState == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    NullDescribedObject<ID3D11DepthStencilState, D3D11_DEPTH_STENCIL_DESC>* state =
+        new NullDescribedObject<ID3D11DepthStencilState, D3D11_DEPTH_STENCIL_DESC>(this, *pDepthStencilDesc);
+    Record(CALL_CREATE_DEPTH_STENCIL_STATE, state->GetNumber(), 0, 0);
+    *ppDepthStencilState = state;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateRasterizerState(const D3D11_RASTERIZER_DESC* pRasterizerDesc, ID3D11RasterizerState** ppRasterizerState)
+{
+    if (ppRasterizerState == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    NullDescribedObject<ID3D11RasterizerState, D3D11_RASTERIZER_DESC>* state =
+        new NullDescribedObject<ID3D11RasterizerState, D3D11_RASTERIZER_DESC>(this, *pRasterizerDesc);
+    Record(CALL_CREATE_RASTERIZER_STATE, state->GetNumber(), 0, 0);
+    *ppRasterizerState = state;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateSamplerState(const D3D11_SAMPLER_DESC* pSamplerDesc, ID3D11SamplerState** ppSamplerState)
+{
+    if (ppSamplerState == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    NullDescribedObject<ID3D11SamplerState, D3D11_SAMPLER_DESC>* state = new NullDescribedObject<ID3D11SamplerState, D3D11_SAMPLER_DESC>(this, *pSamplerDesc);
+    Record(CALL_CREATE_SAMPLER_STATE, state->GetNumber(), 0, 0);
+    *ppSamplerState = state;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CreateQuery(const D3D11_QUERY_DESC* pQueryDesc, ID3D11Query** ppQuery)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreatePredicate(const D3D11_QUERY_DESC* pPredicateDesc, ID3D11Predicate** ppPredicate)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreateCounter(const D3D11_COUNTER_DESC* pCounterDesc, ID3D11Counter** ppCounter)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CreateDeferredContext(UINT ContextFlags, ID3D11DeviceContext** ppDeferredContext)
+{
+    if (ppDeferredContext == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    Record(CALL_CREATE_DEFERRED_CONTEXT, ContextFlags, 0, 0);
+    *ppDeferredContext = new NullDeviceContextClass(this, true);
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::OpenSharedResource(HANDLE hResource, REFIID ReturnedInterface, void** ppResource)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT NullDeviceClass::CheckFormatSupport(DXGI_FORMAT Format, UINT* pFormatSupport)
+{
+    *pFormatSupport = 0xFFFFFFFF;
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::CheckMultisampleQualityLevels(DXGI_FORMAT Format, UINT SampleCount, UINT* pNumQualityLevels)
+{
+    *pNumQualityLevels = SampleCount == 1 ? 1 : 0;
+    return S_OK;
+}
+
+void NullDeviceClass::CheckCounterInfo(D3D11_COUNTER_INFO* pCounterInfo)
+{
+    ZeroMemory(pCounterInfo, sizeof(D3D11_COUNTER_INFO));
+}
+
+HRESULT NullDeviceClass::CheckCounter(const D3D11_COUNTER_DESC* pDesc, D3D11_COUNTER_TYPE* pType, UINT* pActiveCounters, LPSTR szName, UINT* pNameLength,
+                                      LPSTR szUnits, UINT* pUnitsLength, LPSTR szDescription, UINT* pDescriptionLength)
+{
+    return E_INVALIDARG;
+}
+
+// Multithreading is reported as native, but none of the D3D11.1 options are, so the engine takes its plain D3D11.0 paths.
+HRESULT NullDeviceClass::CheckFeatureSupport(D3D11_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize)
+{
+    if (Feature == D3D11_FEATURE_THREADING && FeatureSupportDataSize == sizeof(D3D11_FEATURE_DATA_THREADING))
+    {
+        D3D11_FEATURE_DATA_THREADING* threading = (D3D11_FEATURE_DATA_THREADING*)pFeatureSupportData;
+        threading->DriverConcurrentCreates = TRUE;
+        threading->DriverCommandLists = TRUE;
+        return S_OK;
+    }
+
+    if (Feature == D3D11_FEATURE_D3D11_OPTIONS && FeatureSupportDataSize == sizeof(D3D11_FEATURE_DATA_D3D11_OPTIONS))
+    {
+        ZeroMemory(pFeatureSupportData, FeatureSupportDataSize);
+        return S_OK;
+    }
+
+    return E_INVALIDARG;
+}
+
+HRESULT NullDeviceClass::GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData)
+{
+    *pDataSize = 0;
+    return DXGI_ERROR_NOT_FOUND;
+}
+
+HRESULT NullDeviceClass::SetPrivateData(REFGUID guid, UINT DataSize, const void* pData)
+{
+    return S_OK;
+}
+
+HRESULT NullDeviceClass::SetPrivateDataInterface(REFGUID guid, const IUnknown* pData)
+{
+    return S_OK;
+}
+
+D3D_FEATURE_LEVEL NullDeviceClass::GetFeatureLevel()
+{
+    return D3D_FEATURE_LEVEL_11_0;
+}
+
+UINT NullDeviceClass::GetCreationFlags()
+{
+    return 0;
+}
+
+HRESULT NullDeviceClass::GetDeviceRemovedReason()
+{
+    return S_OK;
+}
+
+void NullDeviceClass::GetImmediateContext(ID3D11DeviceContext** ppImmediateContext)
+{
+    m_immediateContext->AddRef();
+    *ppImmediateContext = m_immediateContext;
+}
+
+HRESULT NullDeviceClass::SetExceptionMode(UINT RaiseFlags)
+{
+    return S_OK;
+}
+
+UINT NullDeviceClass::GetExceptionMode()
+{
+    return 0;
+}
+
+NullDeviceContextClass::NullDeviceContextClass(NullDeviceClass* device, const bool deferred)
+{
+    m_device = device;
+    m_deferred = deferred;
+    m_references = deferred ? 1 : 0;
+
+    // The immediate context lives as long as the device; a deferred one keeps the device alive.
+    if (m_deferred)
+    {
+        m_device->AddRef();
+    }
+}
+
+NullDeviceContextClass::~NullDeviceContextClass()
+{
+    if (m_deferred)
+    {
+        m_device->Release();
+    }
+}
+
+void NullDeviceContextClass::Record(const NullDeviceClass::Call call, const unsigned int argument0, const unsigned int argument1, const unsigned int argument2)
+{
+    if (!m_deferred)
+    {
+        m_device->Record(call, argument0, argument1, argument2);
+        return;
+    }
+
+    NullDeviceClass::CallRecord record;
+    record.call = call;
+    record.arguments[0] = argument0;
+    record.arguments[1] = argument1;
+    record.arguments[2] = argument2;
+    m_log.push_back(record);
+}
+
+// There is no ID3D11DeviceContext1, so the state cache and constant ring fall back to their D3D11.0 paths.
+HRESULT NullDeviceContextClass::QueryInterface(REFIID riid, void** ppvObject)
+{
+    if (riid == __uuidof(IUnknown) || riid == __uuidof(ID3D11DeviceChild) || riid == __uuidof(ID3D11DeviceContext))
+    {
+        AddRef();
+        *ppvObject = static_cast<ID3D11DeviceContext*>(this);
+        return S_OK;
+    }
+
+    *ppvObject = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG NullDeviceContextClass::AddRef()
+{
+    if (!m_deferred)
+    {
+        return m_device->AddRef();
+    }
+
+    return ++m_references;
+}
+
+ULONG NullDeviceContextClass::Release()
+{
+    if (!m_deferred)
+    {
+        return m_device->Release();
+    }
+
+    ULONG references = --m_references;
+    if (references == 0)
+    {
+        delete this;
+    }
+
+    return references;
+}
+
+void NullDeviceContextClass::GetDevice(ID3D11Device** ppDevice)
+{
+    m_device->AddRef();
+    *ppDevice = m_device;
+}
+
+HRESULT NullDeviceContextClass::GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData)
+{
+    *pDataSize = 0;
+    return DXGI_ERROR_NOT_FOUND;
+}
+
+HRESULT NullDeviceContextClass::SetPrivateData(REFGUID guid, UINT DataSize, const void* pData)
+{
+    return S_OK;
+}
+
+HRESULT NullDeviceContextClass::SetPrivateDataInterface(REFGUID guid, const IUnknown* pData)
+{
+    return S_OK;
+}
+
+void NullDeviceContextClass::VSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+    Record(NullDeviceClass::CALL_VS_SET_CONSTANT_BUFFERS, StartSlot, NumBuffers, NumberOfFirst(ppConstantBuffers, NumBuffers));
+}
+
+void NullDeviceContextClass::PSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+    Record(NullDeviceClass::CALL_PS_SET_SHADER_RESOURCES, StartSlot, NumViews, NumberOfFirst(ppShaderResourceViews, NumViews));
+}
+
+void NullDeviceContextClass::PSSetShader(ID3D11PixelShader* pPixelShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+    Record(NullDeviceClass::CALL_PS_SET_SHADER, NumberOf(pPixelShader));
+}
+
+void NullDeviceContextClass::PSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+    Record(NullDeviceClass::CALL_PS_SET_SAMPLERS, StartSlot, NumSamplers, NumberOfFirst(ppSamplers, NumSamplers));
+}
+
+void NullDeviceContextClass::VSSetShader(ID3D11VertexShader* pVertexShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+    Record(NullDeviceClass::CALL_VS_SET_SHADER, NumberOf(pVertexShader));
+}
+
+void NullDeviceContextClass::DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation)
+{
+    Record(NullDeviceClass::CALL_DRAW_INDEXED, IndexCount, StartIndexLocation, (unsigned int)BaseVertexLocation);
+}
+
+void NullDeviceContextClass::Draw(UINT VertexCount, UINT StartVertexLocation)
+{
+    Record(NullDeviceClass::CALL_DRAW, VertexCount, StartVertexLocation);
+}
+
+HRESULT NullDeviceContextClass::Map(ID3D11Resource* pResource, UINT Subresource, D3D11_MAP MapType, UINT MapFlags, D3D11_MAPPED_SUBRESOURCE* pMappedResource)
+{
+    Record(NullDeviceClass::CALL_MAP, NumberOfResource(pResource), MapType, Subresource);
+
+    // Only buffers made for CPU access have memory to map.
+    D3D11_RESOURCE_DIMENSION dimension;
+    pResource->GetType(&dimension);
+    if (dimension != D3D11_RESOURCE_DIMENSION_BUFFER)
+    {
+        return E_INVALIDARG;
+    }
+
+    NullBuffer* buffer = static_cast<NullBuffer*>(static_cast<ID3D11Buffer*>(pResource));
+    if (buffer->m_data.empty())
+    {
+        return E_INVALIDARG;
+    }
+
+    pMappedResource->pData = buffer->m_data.data();
+    pMappedResource->RowPitch = pMappedResource->DepthPitch = (UINT)buffer->m_data.size();
+    return S_OK;
+}
+
+void NullDeviceContextClass::Unmap(ID3D11Resource* pResource, UINT Subresource)
+{
+    Record(NullDeviceClass::CALL_UNMAP, NumberOfResource(pResource), Subresource);
+}
+
+void NullDeviceContextClass::PSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+    Record(NullDeviceClass::CALL_PS_SET_CONSTANT_BUFFERS, StartSlot, NumBuffers, NumberOfFirst(ppConstantBuffers, NumBuffers));
+}
+
+void NullDeviceContextClass::IASetInputLayout(ID3D11InputLayout* pInputLayout)
+{
+    Record(NullDeviceClass::CALL_IA_SET_INPUT_LAYOUT, NumberOf(pInputLayout));
+}
+
+void NullDeviceContextClass::IASetVertexBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppVertexBuffers, const UINT* pStrides, const UINT* pOffsets)
+{
+    Record(NullDeviceClass::CALL_IA_SET_VERTEX_BUFFERS, StartSlot, NumBuffers, NumberOfFirst(ppVertexBuffers, NumBuffers));
+}
+
+void NullDeviceContextClass::IASetIndexBuffer(ID3D11Buffer* pIndexBuffer, DXGI_FORMAT Format, UINT Offset)
+{
+    Record(NullDeviceClass::CALL_IA_SET_INDEX_BUFFER, NumberOf(pIndexBuffer), Format, Offset);
+}
+
+void NullDeviceContextClass::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation)
+{
+    Record(NullDeviceClass::CALL_DRAW_INDEXED_INSTANCED, IndexCountPerInstance, InstanceCount, StartIndexLocation);
+}
+
+void NullDeviceContextClass::DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation)
+{
+    Record(NullDeviceClass::CALL_DRAW_INSTANCED, VertexCountPerInstance, InstanceCount, StartVertexLocation);
+}
+
+void NullDeviceContextClass::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology)
+{
+    Record(NullDeviceClass::CALL_IA_SET_PRIMITIVE_TOPOLOGY, Topology);
+}
+
+void NullDeviceContextClass::VSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+    Record(NullDeviceClass::CALL_VS_SET_SHADER_RESOURCES, StartSlot, NumViews, NumberOfFirst(ppShaderResourceViews, NumViews));
+}
+
+void NullDeviceContextClass::VSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+    Record(NullDeviceClass::CALL_VS_SET_SAMPLERS, StartSlot, NumSamplers, NumberOfFirst(ppSamplers, NumSamplers));
+}
+
+void NullDeviceContextClass::OMSetRenderTargets(UINT NumViews, ID3D11RenderTargetView* const* ppRenderTargetViews, ID3D11DepthStencilView* pDepthStencilView)
+{
+    Record(NullDeviceClass::CALL_OM_SET_RENDER_TARGETS, NumViews, NumberOfFirst(ppRenderTargetViews, NumViews), NumberOf(pDepthStencilView));
+}
+
+void NullDeviceContextClass::OMSetBlendState(ID3D11BlendState* pBlendState, const FLOAT BlendFactor[4], UINT SampleMask)
+{
+    Record(NullDeviceClass::CALL_OM_SET_BLEND_STATE, NumberOf(pBlendState), SampleMask);
+}
+
+void NullDeviceContextClass::OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState, UINT StencilRef)
+{
+    Record(NullDeviceClass::CALL_OM_SET_DEPTH_STENCIL_STATE, NumberOf(pDepthStencilState), StencilRef);
+}
+
+void NullDeviceContextClass::RSSetState(ID3D11RasterizerState* pRasterizerState)
+{
+    Record(NullDeviceClass::CALL_RS_SET_STATE, NumberOf(pRasterizerState));
+}
+
+void NullDeviceContextClass::RSSetViewports(UINT NumViewports, const D3D11_VIEWPORT* pViewports)
+{
+    Record(NullDeviceClass::CALL_RS_SET_VIEWPORTS, NumViewports, NumViewports > 0 ? (unsigned int)pViewports[0].Width : 0,
+           NumViewports > 0 ? (unsigned int)pViewports[0].Height : 0);
+}
+
+void NullDeviceContextClass::RSSetScissorRects(UINT NumRects, const D3D11_RECT* pRects)
+{
+    Record(NullDeviceClass::CALL_RS_SET_SCISSOR_RECTS, NumRects);
+}
+
+void NullDeviceContextClass::UpdateSubresource(ID3D11Resource* pDstResource, UINT DstSubresource, const D3D11_BOX* pDstBox, const void* pSrcData,
+                                               UINT SrcRowPitch, UINT SrcDepthPitch)
+{
+    Record(NullDeviceClass::CALL_UPDATE_SUBRESOURCE, NumberOfResource(pDstResource), DstSubresource);
+}
+
+void NullDeviceContextClass::ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView, const FLOAT ColorRGBA[4])
+{
+    Record(NullDeviceClass::CALL_CLEAR_RENDER_TARGET_VIEW, NumberOf(pRenderTargetView));
+}
+
+void NullDeviceContextClass::ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil)
+{
+    Record(NullDeviceClass::CALL_CLEAR_DEPTH_STENCIL_VIEW, NumberOf(pDepthStencilView), ClearFlags);
+}
+
+void NullDeviceContextClass::ExecuteCommandList(ID3D11CommandList* pCommandList, BOOL RestoreContextState)
+{
+    NullCommandList* commandList = static_cast<NullCommandList*>(pCommandList);
+    Record(NullDeviceClass::CALL_EXECUTE_COMMAND_LIST, commandList->GetNumber(), (unsigned int)commandList->m_records.size(), RestoreContextState);
+
+    if (!m_deferred)
+    {
+        m_device->Record(commandList->m_records);
+        return;
+    }
+    m_log.insert(m_log.end(), commandList->m_records.begin(), commandList->m_records.end());
+}
+
+void NullDeviceContextClass::ClearState()
+{
+    Record(NullDeviceClass::CALL_CLEAR_STATE);
+}
+
+void NullDeviceContextClass::Flush()
+{
+    Record(NullDeviceClass::CALL_FLUSH);
+}
+
+D3D11_DEVICE_CONTEXT_TYPE NullDeviceContextClass::GetType()
+{
+    return m_deferred ? D3D11_DEVICE_CONTEXT_DEFERRED : D3D11_DEVICE_CONTEXT_IMMEDIATE;
+}
+
+UINT NullDeviceContextClass::GetContextFlags()
+{
+    return 0;
+}
+
+HRESULT NullDeviceContextClass::FinishCommandList(BOOL RestoreDeferredContextState, ID3D11CommandList** ppCommandList)
+{
+    if (!m_deferred)
+    {
+        return E_INVALIDARG;
+    }
+
+    // The list ends with its own finish, so the frame log shows where each executed list stops.
+    NullCommandList* commandList = new NullCommandList(m_device, m_log);
+    NullDeviceClass::CallRecord record;
+    record.call = NullDeviceClass::CALL_FINISH_COMMAND_LIST;
+    record.arguments[0] = commandList->GetNumber();
+    record.arguments[1] = (unsigned int)commandList->m_records.size() + 1;
+    record.arguments[2] = RestoreDeferredContextState;
+    commandList->m_records.push_back(record);
+
+    if (ppCommandList == nullptr)
+    {
+        commandList->Release();
+        return S_OK;
+    }
+
+    *ppCommandList = commandList;
+    return S_OK;
+}
+
+void NullDeviceContextClass::GSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::GSSetShader(ID3D11GeometryShader* pShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::Begin(ID3D11Asynchronous* pAsync)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::End(ID3D11Asynchronous* pAsync)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+HRESULT NullDeviceContextClass::GetData(ID3D11Asynchronous* pAsync, void* pData, UINT DataSize, UINT GetDataFlags)
+{
+    return E_INVALIDARG;
+}
+
+void NullDeviceContextClass::SetPredication(ID3D11Predicate* pPredicate, BOOL PredicateValue)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::GSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::GSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::OMSetRenderTargetsAndUnorderedAccessViews(UINT NumRTVs, ID3D11RenderTargetView* const* ppRenderTargetViews, ID3D11DepthStencilView* pDepthStencilView,
+                                                                       UINT UAVStartSlot, UINT NumUAVs, ID3D11UnorderedAccessView* const* ppUnorderedAccessViews,
+                                                                       const UINT* pUAVInitialCounts)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::SOSetTargets(UINT NumBuffers, ID3D11Buffer* const* ppSOTargets, const UINT* pOffsets)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::DrawAuto()
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::DrawIndexedInstancedIndirect(ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::DrawInstancedIndirect(ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::DispatchIndirect(ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::CopySubresourceRegion(ID3D11Resource* pDstResource, UINT DstSubresource, UINT DstX, UINT DstY, UINT DstZ,
+                                                   ID3D11Resource* pSrcResource, UINT SrcSubresource, const D3D11_BOX* pSrcBox)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::CopyResource(ID3D11Resource* pDstResource, ID3D11Resource* pSrcResource)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::CopyStructureCount(ID3D11Buffer* pDstBuffer, UINT DstAlignedByteOffset, ID3D11UnorderedAccessView* pSrcView)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::ClearUnorderedAccessViewUint(ID3D11UnorderedAccessView* pUnorderedAccessView, const UINT Values[4])
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::ClearUnorderedAccessViewFloat(ID3D11UnorderedAccessView* pUnorderedAccessView, const FLOAT Values[4])
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::GenerateMips(ID3D11ShaderResourceView* pShaderResourceView)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::SetResourceMinLOD(ID3D11Resource* pResource, FLOAT MinLOD)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+FLOAT NullDeviceContextClass::GetResourceMinLOD(ID3D11Resource* pResource)
+{
+    return 0.0f;
+}
+
+void NullDeviceContextClass::ResolveSubresource(ID3D11Resource* pDstResource, UINT DstSubresource, ID3D11Resource* pSrcResource, UINT SrcSubresource, DXGI_FORMAT Format)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::HSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::HSSetShader(ID3D11HullShader* pHullShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::HSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::HSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::DSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::DSSetShader(ID3D11DomainShader* pDomainShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::DSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::DSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::CSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::CSSetUnorderedAccessViews(UINT StartSlot, UINT NumUAVs, ID3D11UnorderedAccessView* const* ppUnorderedAccessViews, const UINT* pUAVInitialCounts)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::CSSetShader(ID3D11ComputeShader* pComputeShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::CSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::CSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+    Record(NullDeviceClass::CALL_OTHER);
+}
+
+void NullDeviceContextClass::VSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+    ClearBindings(ppConstantBuffers, NumBuffers);
+}
+
+void NullDeviceContextClass::PSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+    ClearBindings(ppShaderResourceViews, NumViews);
+}
+
+void NullDeviceContextClass::PSGetShader(ID3D11PixelShader** ppPixelShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+    *ppPixelShader = nullptr;
+    if (pNumClassInstances != nullptr)
+    {
+        *pNumClassInstances = 0;
+    }
+}
+
+void NullDeviceContextClass::PSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+    ClearBindings(ppSamplers, NumSamplers);
+}
+
+void NullDeviceContextClass::VSGetShader(ID3D11VertexShader** ppVertexShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+    *ppVertexShader = nullptr;
+    if (pNumClassInstances != nullptr)
+    {
+        *pNumClassInstances = 0;
+    }
+}
+
+void NullDeviceContextClass::PSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+    ClearBindings(ppConstantBuffers, NumBuffers);
+}
+
+void NullDeviceContextClass::IAGetInputLayout(ID3D11InputLayout** ppInputLayout)
+{
+    *ppInputLayout = nullptr;
+}
+
+void NullDeviceContextClass::IAGetVertexBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppVertexBuffers, UINT* pStrides, UINT* pOffsets)
+{
+    ClearBindings(ppVertexBuffers, NumBuffers);
+    for (UINT i = 0; i < NumBuffers; i++)
+    {
+        if (pStrides != nullptr)
+        {
+            pStrides[i] = 0;
+        }
+        if (pOffsets != nullptr)
+        {
+            pOffsets[i] = 0;
+        }
+    }
+}
+
+void NullDeviceContextClass::IAGetIndexBuffer(ID3D11Buffer** pIndexBuffer, DXGI_FORMAT* Format, UINT* Offset)
+{
+    *pIndexBuffer = nullptr;
+    if (Format != nullptr)
+    {
+        *Format = DXGI_FORMAT_UNKNOWN;
+    }
+    if (Offset != nullptr)
+    {
+        *Offset = 0;
+    }
+}
+
+void NullDeviceContextClass::GSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+    ClearBindings(ppConstantBuffers, NumBuffers);
+}
+
+void NullDeviceContextClass::GSGetShader(ID3D11GeometryShader** ppGeometryShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+    *ppGeometryShader = nullptr;
+    if (pNumClassInstances != nullptr)
+    {
+        *pNumClassInstances = 0;
+    }
+}
+
+void NullDeviceContextClass::IAGetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY* pTopology)
+{
+    *pTopology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+}
+
+void NullDeviceContextClass::VSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+    ClearBindings(ppShaderResourceViews, NumViews);
+}
+
+void NullDeviceContextClass::VSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+    ClearBindings(ppSamplers, NumSamplers);
+}
+
+void NullDeviceContextClass::GetPredication(ID3D11Predicate** ppPredicate, BOOL* pPredicateValue)
+{
+    if (ppPredicate != nullptr)
+    {
+        *ppPredicate = nullptr;
+    }
+    if (pPredicateValue != nullptr)
+    {
+        *pPredicateValue = FALSE;
+    }
+}
+
+void NullDeviceContextClass::GSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+    ClearBindings(ppShaderResourceViews, NumViews);
+}
+
+void NullDeviceContextClass::GSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+    ClearBindings(ppSamplers, NumSamplers);
+}
+
+void NullDeviceContextClass::OMGetRenderTargets(UINT NumViews, ID3D11RenderTargetView** ppRenderTargetViews, ID3D11DepthStencilView** ppDepthStencilView)
+{
+    ClearBindings(ppRenderTargetViews, NumViews);
+    if (ppDepthStencilView != nullptr)
+    {
+        *ppDepthStencilView = nullptr;
+    }
+}
+
+void NullDeviceContextClass::OMGetRenderTargetsAndUnorderedAccessViews(UINT NumRTVs, ID3D11RenderTargetView** ppRenderTargetViews, ID3D11DepthStencilView** ppDepthStencilView,
+                                                                       UINT UAVStartSlot, UINT NumUAVs, ID3D11UnorderedAccessView** ppUnorderedAccessViews)
+{
+    OMGetRenderTargets(NumRTVs, ppRenderTargetViews, ppDepthStencilView);
+    ClearBindings(ppUnorderedAccessViews, NumUAVs);
+}
+
+void NullDeviceContextClass::OMGetBlendState(ID3D11BlendState** ppBlendState, FLOAT BlendFactor[4], UINT* pSampleMask)
+{
+    if (ppBlendState != nullptr)
+    {
+        *ppBlendState = nullptr;
+    }
+    if (BlendFactor != nullptr)
+    {
+        BlendFactor[0] = BlendFactor[1] = BlendFactor[2] = BlendFactor[3] = 1.0f;
+    }
+    if (pSampleMask != nullptr)
+    {
+        *pSampleMask = 0xFFFFFFFF;
+    }
+}
+
+void NullDeviceContextClass::OMGetDepthStencilState(ID3D11DepthStencilState** ppDepthStencilState, UINT* pStencilRef)
+{
+    if (ppDepthStencilState != nullptr)
+    {
+        *ppDepthStencilState = nullptr;
+    }
+    if (pStencilRef != nullptr)
+    {
+        *pStencilRef = 0;
+    }
+}
+
+void NullDeviceContextClass::SOGetTargets(UINT NumBuffers, ID3D11Buffer** ppSOTargets)
+{
+    ClearBindings(ppSOTargets, NumBuffers);
+}
+
+void NullDeviceContextClass::RSGetState(ID3D11RasterizerState** ppRasterizerState)
+{
+    *ppRasterizerState = nullptr;
+}
+
+void NullDeviceContextClass::RSGetViewports(UINT* pNumViewports, D3D11_VIEWPORT* pViewports)
+{
+    *pNumViewports = 0;
+}
+
+void NullDeviceContextClass::RSGetScissorRects(UINT* pNumRects, D3D11_RECT* pRects)
+{
+    *pNumRects = 0;
+}
+
+void NullDeviceContextClass::HSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+    ClearBindings(ppShaderResourceViews, NumViews);
+}
+
+void NullDeviceContextClass::HSGetShader(ID3D11HullShader** ppHullShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+    *ppHullShader = nullptr;
+    if (pNumClassInstances != nullptr)
+    {
+        *pNumClassInstances = 0;
+    }
+}
+
+void NullDeviceContextClass::HSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+    ClearBindings(ppSamplers, NumSamplers);
+}
+
+void NullDeviceContextClass::HSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+    ClearBindings(ppConstantBuffers, NumBuffers);
+}
+
+void NullDeviceContextClass::DSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+    ClearBindings(ppShaderResourceViews, NumViews);
+}
+
+void NullDeviceContextClass::DSGetShader(ID3D11DomainShader** ppDomainShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+    *ppDomainShader = nullptr;
+    if (pNumClassInstances != nullptr)
+    {
+        *pNumClassInstances = 0;
+    }
+}
+
+void NullDeviceContextClass::DSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+    ClearBindings(ppSamplers, NumSamplers);
+}
+
+void NullDeviceContextClass::DSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+    ClearBindings(ppConstantBuffers, NumBuffers);
+}
+
+void NullDeviceContextClass::CSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+    ClearBindings(ppShaderResourceViews, NumViews);
+}
+
+void NullDeviceContextClass::CSGetUnorderedAccessViews(UINT StartSlot, UINT NumUAVs, ID3D11UnorderedAccessView** ppUnorderedAccessViews)
+{
+    ClearBindings(ppUnorderedAccessViews, NumUAVs);
+}
+
+void NullDeviceContextClass::CSGetShader(ID3D11ComputeShader** ppComputeShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+    *ppComputeShader = nullptr;
+    if (pNumClassInstances != nullptr)
+    {
+        *pNumClassInstances = 0;
+    }
+}
+
+void NullDeviceContextClass::CSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+    ClearBindings(ppSamplers, NumSamplers);
+}
+
+void NullDeviceContextClass::CSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+    ClearBindings(ppConstantBuffers, NumBuffers);
+}
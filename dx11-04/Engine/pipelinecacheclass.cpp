@@ -0,0 +1,419 @@
+#include "pipelinecacheclass.h"
+#include "statecacheclass.h"
+#include "nulldeviceclass.h"
+#include <cstddef>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+    // 64-bit FNV-1a, continued from hash so pieces can be chained.
+    const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+    const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+    unsigned long long HashBytes(const void* data, const size_t size, unsigned long long hash = FNV_OFFSET)
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    // Descriptions are hashed bytewise, so they are compared bytewise too.
+    template <typename Desc>
+    bool SameBytes(const Desc& a, const Desc& b)
+    {
+        return memcmp(&a, &b, sizeof(Desc)) == 0;
+    }
+
+    // The key the compiler wrote into the bytecode; zero for a stage without a shader.
+    unsigned long long HashBytecode(const ShaderLibraryClass::Bytecode& bytecode)
+    {
+        return bytecode.data != nullptr ? bytecode.key : 0;
+    }
+}
+
+PipelineCacheClass::PipelineCacheClass()
+{
+    m_device = nullptr;
+}
+
+PipelineCacheClass::~PipelineCacheClass()
+{
+}
+
+void PipelineCacheClass::Initialize(ID3D11Device* device)
+{
+    m_device = device;
+}
+
+PipelineCacheClass::PipelineDesc PipelineCacheClass::GetDefaultDesc()
+{
+    PipelineDesc desc;
+    ZeroMemory(&desc, sizeof(desc));
+
+    desc.rasterizer.AntialiasedLineEnable = false;
+    desc.rasterizer.CullMode = D3D11_CULL_BACK;
+    desc.rasterizer.DepthBias = 0;
+    desc.rasterizer.DepthBiasClamp = 0.0f;
+    desc.rasterizer.DepthClipEnable = true;
+    desc.rasterizer.FillMode = D3D11_FILL_SOLID;
+    desc.rasterizer.FrontCounterClockwise = false;
+    desc.rasterizer.MultisampleEnable = false;
+    desc.rasterizer.ScissorEnable = false;
+    desc.rasterizer.SlopeScaledDepthBias = 0.0f;
+
+    desc.depthStencil.DepthEnable = true;
+    desc.depthStencil.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+    desc.depthStencil.DepthFunc = D3D11_COMPARISON_LESS;
+
+    desc.depthStencil.StencilEnable = true;
+    desc.depthStencil.StencilReadMask = 0xFF;
+    desc.depthStencil.StencilWriteMask = 0xFF;
+
+    // Stencil operations if pixel is front-facing.
+    desc.depthStencil.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+    desc.depthStencil.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_INCR;
+    desc.depthStencil.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+    desc.depthStencil.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+
+    // Stencil operations if pixel is back-facing.
+    desc.depthStencil.BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+    desc.depthStencil.BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_DECR;
+    desc.depthStencil.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+    desc.depthStencil.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+    desc.stencilRef = 1;
+
+    // The D3D11 default blend state: every render target written as is.
+    for (int i = 0; i < 8; i++)
+    {
+        D3D11_RENDER_TARGET_BLEND_DESC& target = desc.blend.RenderTarget[i];
+        target.BlendEnable = false;
+        target.SrcBlend = D3D11_BLEND_ONE;
+        target.DestBlend = D3D11_BLEND_ZERO;
+        target.BlendOp = D3D11_BLEND_OP_ADD;
+        target.SrcBlendAlpha = D3D11_BLEND_ONE;
+        target.DestBlendAlpha = D3D11_BLEND_ZERO;
+        target.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+        target.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        desc.blendFactor[i] = 1.0f;
+    }
+    desc.sampleMask = 0xFFFFFFFF;
+
+    desc.topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    return desc;
+}
+
+const PipelineCacheClass::PipelineState* PipelineCacheClass::Create(const PipelineDesc& desc)
+{
+    unsigned long long rasterizerHash = HashBytes(&desc.rasterizer, sizeof(desc.rasterizer));
+    unsigned long long depthStencilHash = HashBytes(&desc.depthStencil, sizeof(desc.depthStencil));
+    unsigned long long blendHash = HashBytes(&desc.blend, sizeof(desc.blend));
+    unsigned long long vertexShaderHash = HashBytecode(desc.vertexShader);
+    unsigned long long pixelShaderHash = HashBytecode(desc.pixelShader);
+
+    // A layout is only valid for the input signature it was created against, so the vertex shader is part of its key.
+    // Semantic names are hashed by their text, not their address.
+    unsigned long long inputLayoutHash = 0;
+    if (desc.numInputElements > 0)
+    {
+        inputLayoutHash = vertexShaderHash;
+        for (unsigned int i = 0; i < desc.numInputElements; i++)
+        {
+            const D3D11_INPUT_ELEMENT_DESC& element = desc.inputElements[i];
+            inputLayoutHash = HashBytes(element.SemanticName, strlen(element.SemanticName) + 1, inputLayoutHash);
+            inputLayoutHash = HashBytes(&element.SemanticIndex, sizeof(element) - offsetof(D3D11_INPUT_ELEMENT_DESC, SemanticIndex), inputLayoutHash);
+        }
+    }
+
+    const unsigned long long pieces[6] = { rasterizerHash, depthStencilHash, blendHash, vertexShaderHash, pixelShaderHash, inputLayoutHash };
+    unsigned long long hash = HashBytes(pieces, sizeof(pieces));
+    hash = HashBytes(&desc.stencilRef, sizeof(desc.stencilRef), hash);
+    hash = HashBytes(desc.blendFactor, sizeof(desc.blendFactor), hash);
+    hash = HashBytes(&desc.sampleMask, sizeof(desc.sampleMask), hash);
+    hash = HashBytes(&desc.topology, sizeof(desc.topology), hash);
+
+    lock_guard<mutex> lock(m_mutex);
+
+    // The pieces are looked up first, so the pipeline under the hash can be compared with what this description makes.
+    unique_ptr<PipelineState> pipeline(new PipelineState());
+    pipeline->hash = hash;
+    pipeline->rasterizerState = GetRasterizerState(desc.rasterizer, rasterizerHash);
+    pipeline->depthStencilState = GetDepthStencilState(desc.depthStencil, depthStencilHash);
+    pipeline->stencilRef = desc.stencilRef;
+    pipeline->blendState = GetBlendState(desc.blend, blendHash);
+    memcpy(pipeline->blendFactor, desc.blendFactor, sizeof(pipeline->blendFactor));
+    pipeline->sampleMask = desc.sampleMask;
+    pipeline->vertexShader = GetVertexShader(desc.vertexShader, vertexShaderHash);
+    pipeline->pixelShader = GetPixelShader(desc.pixelShader, pixelShaderHash);
+    pipeline->inputLayout = GetInputLayout(desc, inputLayoutHash);
+    pipeline->topology = desc.topology;
+
+    auto found = m_pipelines.find(hash);
+    if (found != m_pipelines.end())
+    {
+        const PipelineState& cached = *found->second;
+        bool same = cached.rasterizerState == pipeline->rasterizerState && cached.depthStencilState == pipeline->depthStencilState
+            && cached.stencilRef == pipeline->stencilRef && cached.blendState == pipeline->blendState
+            && memcmp(cached.blendFactor, pipeline->blendFactor, sizeof(cached.blendFactor)) == 0 && cached.sampleMask == pipeline->sampleMask
+            && cached.vertexShader == pipeline->vertexShader && cached.pixelShader == pipeline->pixelShader
+            && cached.inputLayout == pipeline->inputLayout && cached.topology == pipeline->topology;
+        if (!same)
+        {
+            throw engine_exception("Pipeline cache: two different pipeline states hash to ") << hash;
+        }
+        return found->second.get();
+    }
+
+    const PipelineState* result = pipeline.get();
+    m_pipelines[hash] = move(pipeline);
+
+    LOG_DEBUG("Pipeline state {} created; {} pipeline states share {} state objects", (unsigned long long)hash,
+              (unsigned int)m_pipelines.size(), (unsigned int)(m_rasterizerStates.size() + m_depthStencilStates.size() + m_blendStates.size()
+              + m_vertexShaders.size() + m_pixelShaders.size() + m_inputLayouts.size()));
+    return result;
+}
+
+template <typename Desc, typename Object, typename Equal, typename Creator>
+Object* PipelineCacheClass::FindOrCreate(unordered_map<unsigned long long, CachedObject<Desc, Object>>& cache, const unsigned long long hash,
+                                         const Desc& desc, const Equal& equal, const Creator& create, const char* what)
+{
+    auto found = cache.find(hash);
+    if (found != cache.end())
+    {
+        if (!equal(found->second.desc, desc))
+        {
+            throw engine_exception("Pipeline cache: two different ") << what << " descriptions hash to " << hash;
+        }
+        return found->second.object.Get();
+    }
+
+    CachedObject<Desc, Object> entry;
+    entry.desc = desc;
+    HRESULT result = create(entry.object.GetAddressOf());
+    if (FAILED(result))
+    {
+        throw engine_exception("Could not create ") << what << ", result code = " << result;
+    }
+
+    Object* object = entry.object.Get();
+    cache[hash] = move(entry);
+    return object;
+}
+
+ID3D11RasterizerState* PipelineCacheClass::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc, const unsigned long long hash)
+{
+    return FindOrCreate(m_rasterizerStates, hash, desc, SameBytes<D3D11_RASTERIZER_DESC>, [&](ID3D11RasterizerState** state)
+    {
+        return m_device->CreateRasterizerState(&desc, state);
+    }, "rasterizer state");
+}
+
+ID3D11DepthStencilState* PipelineCacheClass::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc, const unsigned long long hash)
+{
+    return FindOrCreate(m_depthStencilStates, hash, desc, SameBytes<D3D11_DEPTH_STENCIL_DESC>, [&](ID3D11DepthStencilState** state)
+    {
+        return m_device->CreateDepthStencilState(&desc, state);
+    }, "depth stencil state");
+}
+
+ID3D11BlendState* PipelineCacheClass::GetBlendState(const D3D11_BLEND_DESC& desc, const unsigned long long hash)
+{
+    return FindOrCreate(m_blendStates, hash, desc, SameBytes<D3D11_BLEND_DESC>, [&](ID3D11BlendState** state)
+    {
+        return m_device->CreateBlendState(&desc, state);
+    }, "blend state");
+}
+
+ID3D11VertexShader* PipelineCacheClass::GetVertexShader(const ShaderLibraryClass::Bytecode& bytecode, const unsigned long long hash)
+{
+    if (bytecode.data == nullptr)
+    {
+        return nullptr;
+    }
+
+    vector<unsigned char> bytes((const unsigned char*)bytecode.data, (const unsigned char*)bytecode.data + bytecode.size);
+    return FindOrCreate(m_vertexShaders, hash, bytes, equal_to<vector<unsigned char>>(), [&](ID3D11VertexShader** shader)
+    {
+        return m_device->CreateVertexShader(bytecode.data, bytecode.size, nullptr, shader);
+    }, "vertex shader");
+}
+
+ID3D11PixelShader* PipelineCacheClass::GetPixelShader(const ShaderLibraryClass::Bytecode& bytecode, const unsigned long long hash)
+{
+    if (bytecode.data == nullptr)
+    {
+        return nullptr;
+    }
+
+    vector<unsigned char> bytes((const unsigned char*)bytecode.data, (const unsigned char*)bytecode.data + bytecode.size);
+    return FindOrCreate(m_pixelShaders, hash, bytes, equal_to<vector<unsigned char>>(), [&](ID3D11PixelShader** shader)
+    {
+        return m_device->CreatePixelShader(bytecode.data, bytecode.size, nullptr, shader);
+    }, "pixel shader");
+}
+
+ID3D11InputLayout* PipelineCacheClass::GetInputLayout(const PipelineDesc& desc, const unsigned long long hash)
+{
+    if (desc.numInputElements == 0)
+    {
+        return nullptr;
+    }
+
+    if (desc.vertexShader.data == nullptr)
+    {
+        throw engine_exception("An input layout needs a vertex shader to match against");
+    }
+
+    // The vertex shader was looked up just before, so its object stands for its bytecode.
+    InputLayoutDesc layoutDesc;
+    layoutDesc.vertexShader = m_vertexShaders[HashBytecode(desc.vertexShader)].object.Get();
+    layoutDesc.elements.assign(desc.inputElements, desc.inputElements + desc.numInputElements);
+    for (D3D11_INPUT_ELEMENT_DESC& element : layoutDesc.elements)
+    {
+        layoutDesc.semanticNames.push_back(element.SemanticName);
+        element.SemanticName = nullptr;
+    }
+
+    auto equal = [](const InputLayoutDesc& a, const InputLayoutDesc& b)
+    {
+        return a.vertexShader == b.vertexShader && a.semanticNames == b.semanticNames && a.elements.size() == b.elements.size()
+            && memcmp(a.elements.data(), b.elements.data(), a.elements.size() * sizeof(D3D11_INPUT_ELEMENT_DESC)) == 0;
+    };
+    return FindOrCreate(m_inputLayouts, hash, layoutDesc, equal, [&](ID3D11InputLayout** layout)
+    {
+        return m_device->CreateInputLayout(desc.inputElements, desc.numInputElements, desc.vertexShader.data, desc.vertexShader.size, layout);
+    }, "input layout");
+}
+
+unsigned int PipelineCacheClass::GetPipelineCount()
+{
+    lock_guard<mutex> lock(m_mutex);
+    return (unsigned int)m_pipelines.size();
+}
+
+unsigned int PipelineCacheClass::GetStateObjectCount()
+{
+    lock_guard<mutex> lock(m_mutex);
+    return (unsigned int)(m_rasterizerStates.size() + m_depthStencilStates.size() + m_blendStates.size()
+                          + m_vertexShaders.size() + m_pixelShaders.size() + m_inputLayouts.size());
+}
+
+void PipelineCacheClass::Validate()
+{
+    ComPtr<ID3D11Device> device;
+    ComPtr<ID3D11DeviceContext> deviceContext;
+    NullDeviceClass::CreateDevice(device.GetAddressOf(), deviceContext.GetAddressOf());
+    NullDeviceClass* nullDevice = static_cast<NullDeviceClass*>(device.Get());
+
+    auto check = [](const bool passed, const char* what)
+    {
+        if (!passed)
+        {
+            throw engine_exception("Pipeline cache validation: ") << what;
+        }
+    };
+
+    // The null device takes any bytes for a shader, keyed by hand.
+    const char vertexShaderBytes[] = "vertex shader";
+    const char otherVertexShaderBytes[] = "another vertex shader";
+    const char pixelShaderBytes[] = "pixel shader";
+    D3D11_INPUT_ELEMENT_DESC elements[2] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+    };
+
+    PipelineCacheClass cache;
+    cache.Initialize(device.Get());
+
+    PipelineDesc desc = GetDefaultDesc();
+    desc.vertexShader.data = vertexShaderBytes;
+    desc.vertexShader.size = sizeof(vertexShaderBytes);
+    desc.vertexShader.key = 1;
+    desc.pixelShader.data = pixelShaderBytes;
+    desc.pixelShader.size = sizeof(pixelShaderBytes);
+    desc.pixelShader.key = 2;
+    desc.inputElements = elements;
+    desc.numInputElements = 2;
+    const PipelineState* solid = cache.Create(desc);
+
+    // The same description from other memory, down to the semantic names.
+    char positionName[] = "POSITION";
+    char colorName[] = "COLOR";
+    char vertexShaderCopy[sizeof(vertexShaderBytes)];
+    memcpy(vertexShaderCopy, vertexShaderBytes, sizeof(vertexShaderBytes));
+    D3D11_INPUT_ELEMENT_DESC elementsCopy[2] = { elements[0], elements[1] };
+    elementsCopy[0].SemanticName = positionName;
+    elementsCopy[1].SemanticName = colorName;
+    PipelineDesc copy = desc;
+    copy.vertexShader.data = vertexShaderCopy;
+    copy.inputElements = elementsCopy;
+    check(cache.Create(copy) == solid, "an identical description didn't return the same pipeline state");
+
+    PipelineDesc wireframeDesc = desc;
+    wireframeDesc.rasterizer.FillMode = D3D11_FILL_WIREFRAME;
+    const PipelineState* wireframe = cache.Create(wireframeDesc);
+    check(wireframe != solid && wireframe->rasterizerState != solid->rasterizerState, "a new fill mode didn't make a new rasterizer state");
+    check(wireframe->depthStencilState == solid->depthStencilState && wireframe->blendState == solid->blendState
+          && wireframe->vertexShader == solid->vertexShader && wireframe->pixelShader == solid->pixelShader
+          && wireframe->inputLayout == solid->inputLayout, "a new fill mode didn't share the other objects");
+
+    // Another vertex shader has another input signature, so it needs its own layout as well.
+    PipelineDesc otherDesc = desc;
+    otherDesc.vertexShader.data = otherVertexShaderBytes;
+    otherDesc.vertexShader.size = sizeof(otherVertexShaderBytes);
+    otherDesc.vertexShader.key = 3;
+    const PipelineState* other = cache.Create(otherDesc);
+    check(other->vertexShader != solid->vertexShader && other->inputLayout != solid->inputLayout && other->pixelShader == solid->pixelShader,
+          "another vertex shader didn't get its own shader and layout");
+
+    // Other bytes under a key already cached stand in for a hash collision, which has to throw rather than share.
+    const char collidingShaderBytes[] = "not the vertex shader";
+    PipelineDesc collidingDesc = desc;
+    collidingDesc.vertexShader.data = collidingShaderBytes;
+    collidingDesc.vertexShader.size = sizeof(collidingShaderBytes);
+    bool collided = false;
+    try
+    {
+        cache.Create(collidingDesc);
+    }
+    catch (const engine_exception&)
+    {
+        collided = true;
+    }
+    check(collided, "a description colliding with another's hash was handed its objects");
+
+    nullDevice->EndFrame();
+    check(cache.GetPipelineCount() == 3, "the cache holds a pipeline state more or less than the three descriptions");
+    check(cache.GetStateObjectCount() == 9 && nullDevice->GetFrameStatistics().creations == 9, "the cache created duplicate state objects");
+
+    // All seven pieces the first time, none for the same handle again, then only what differs.
+    StateCacheClass stateCache;
+    stateCache.Initialize(deviceContext.Get());
+    stateCache.SetPipelineState(solid);
+    nullDevice->EndFrame();
+    check(nullDevice->GetFrameStatistics().stateChanges == 7, "binding the first pipeline state didn't set all seven pieces");
+
+    stateCache.SetPipelineState(solid);
+    stateCache.SetPipelineState(wireframe);
+    nullDevice->EndFrame();
+    check(nullDevice->GetFrameStatistics().stateChanges == 1, "switching fill mode set more than the rasterizer state");
+
+    stateCache.SetPipelineState(other);
+    nullDevice->EndFrame();
+    check(nullDevice->GetFrameStatistics().stateChanges == 3, "switching to another vertex shader set more than shader, layout and rasterizer state");
+
+    // State set behind the handle's back must make the next bind of it check its pieces again.
+    stateCache.RSSetState(wireframe->rasterizerState);
+    stateCache.SetPipelineState(other);
+    nullDevice->EndFrame();
+    check(nullDevice->GetFrameStatistics().stateChanges == 2, "a handle wasn't bound again after its state was changed");
+
+    LOG_INFO("Pipeline cache validation passed");
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "engine.h"
+#include "shaderlibraryclass.h"
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Microsoft::WRL;
+
+// Creates pipeline states: the rasterizer, depth stencil and blend states, shaders, input layout and topology a draw
+// needs, bundled behind one immutable handle. Every piece is keyed by a hash of its description, so identical
+// descriptions share their D3D objects. A whole identical description returns the same handle. Each piece is kept with
+// the description it was created from, and a lookup whose description differs from the one under its hash throws
+// rather than handing back another description's objects. Bind handles with
+// StateCacheClass::SetPipelineState, which only touches the pieces that differ from the bound handle. Handles stay
+// valid for the cache's lifetime. Creation is thread safe.
+class PipelineCacheClass
+{
+public:
+    // Descriptions are hashed bytewise, padding included, so start from GetDefaultDesc() and change fields of that.
+    struct PipelineDesc
+    {
+        D3D11_RASTERIZER_DESC rasterizer;
+        D3D11_DEPTH_STENCIL_DESC depthStencil;
+        unsigned int stencilRef;
+        D3D11_BLEND_DESC blend;
+        float blendFactor[4];
+        unsigned int sampleMask;
+        // Empty bytecode (a null pointer) leaves the stage without a shader.
+        ShaderLibraryClass::Bytecode vertexShader;
+        ShaderLibraryClass::Bytecode pixelShader;
+        // Matched against the vertex shader's input signature. No elements means no input layout.
+        const D3D11_INPUT_ELEMENT_DESC* inputElements;
+        unsigned int numInputElements;
+        D3D11_PRIMITIVE_TOPOLOGY topology;
+    };
+
+    // Owned by the cache; compare handles by address.
+    struct PipelineState
+    {
+        unsigned long long hash;
+        ID3D11RasterizerState* rasterizerState;
+        ID3D11DepthStencilState* depthStencilState;
+        unsigned int stencilRef;
+        ID3D11BlendState* blendState;
+        float blendFactor[4];
+        unsigned int sampleMask;
+        ID3D11VertexShader* vertexShader;
+        ID3D11PixelShader* pixelShader;
+        ID3D11InputLayout* inputLayout;
+        D3D11_PRIMITIVE_TOPOLOGY topology;
+    };
+
+    PipelineCacheClass();
+
+    ~PipelineCacheClass();
+
+    void Initialize(ID3D11Device* device);
+
+    // Solid, back face culled triangle lists with depth testing, the stencil counting faces and blending off. No shaders.
+    static PipelineDesc GetDefaultDesc();
+
+    const PipelineState* Create(const PipelineDesc& desc);
+
+    // Distinct pipeline states and D3D objects created so far.
+    unsigned int GetPipelineCount();
+
+    unsigned int GetStateObjectCount();
+
+    // Creates overlapping descriptions on a null device and binds them. Identical descriptions must share handles and
+    // objects, a colliding hash must throw and binding must skip the pieces that didn't change. Throws on a failure.
+    static void Validate();
+
+private:
+    // A D3D object and what it was created from.
+    template <typename Desc, typename Object>
+    struct CachedObject
+    {
+        Desc desc;
+        ComPtr<Object> object;
+    };
+
+    // Semantic names are kept by their text; the elements' own name pointers are left null.
+    struct InputLayoutDesc
+    {
+        ID3D11VertexShader* vertexShader;
+        vector<string> semanticNames;
+        vector<D3D11_INPUT_ELEMENT_DESC> elements;
+    };
+
+    ID3D11Device* m_device;
+    mutex m_mutex;
+
+    unordered_map<unsigned long long, CachedObject<D3D11_RASTERIZER_DESC, ID3D11RasterizerState>> m_rasterizerStates;
+    unordered_map<unsigned long long, CachedObject<D3D11_DEPTH_STENCIL_DESC, ID3D11DepthStencilState>> m_depthStencilStates;
+    unordered_map<unsigned long long, CachedObject<D3D11_BLEND_DESC, ID3D11BlendState>> m_blendStates;
+    unordered_map<unsigned long long, CachedObject<vector<unsigned char>, ID3D11VertexShader>> m_vertexShaders;
+    unordered_map<unsigned long long, CachedObject<vector<unsigned char>, ID3D11PixelShader>> m_pixelShaders;
+    unordered_map<unsigned long long, CachedObject<InputLayoutDesc, ID3D11InputLayout>> m_inputLayouts;
+    unordered_map<unsigned long long, unique_ptr<PipelineState>> m_pipelines;
+
+    // Returns the object cached under hash when its description equals desc, creates it with create when there is none,
+    // and throws on a collision; called with m_mutex held.
+    template <typename Desc, typename Object, typename Equal, typename Creator>
+    static Object* FindOrCreate(unordered_map<unsigned long long, CachedObject<Desc, Object>>& cache, const unsigned long long hash, const Desc& desc,
+                                const Equal& equal, const Creator& create, const char* what);
+
+    // Each finds the object for a hash or creates it; called with m_mutex held.
+    ID3D11RasterizerState* GetRasterizerState(const D3D11_RASTERIZER_DESC& desc, const unsigned long long hash);
+
+    ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc, const unsigned long long hash);
+
+    ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& desc, const unsigned long long hash);
+
+    ID3D11VertexShader* GetVertexShader(const ShaderLibraryClass::Bytecode& bytecode, const unsigned long long hash);
+
+    ID3D11PixelShader* GetPixelShader(const ShaderLibraryClass::Bytecode& bytecode, const unsigned long long hash);
+
+    ID3D11InputLayout* GetInputLayout(const PipelineDesc& desc, const unsigned long long hash);
+};
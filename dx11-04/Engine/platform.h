@@ -0,0 +1,134 @@
+#pragma once
+
+// The few Windows calls the platform independent part of the engine makes, so that part also builds with GCC and Clang
+// for the tests and tools. On Windows this is windows.h; elsewhere the same names map onto the C++ library and POSIX.
+// Thread locals are declared THREAD_LOCAL, since Visual Studio 2013 only has them as __declspec(thread).
+#ifdef _WIN32
+
+#include <windows.h>
+
+#define THREAD_LOCAL __declspec(thread)
+
+#else
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <functional>
+#include <thread>
+#include <signal.h>
+
+#define THREAD_LOCAL __thread
+
+typedef unsigned long DWORD;
+typedef int BOOL;
+typedef void* HANDLE;
+
+#define TRUE 1
+#define FALSE 0
+
+// There are no windows to present to; headless code paths pass NULL.
+typedef void* HWND;
+
+typedef int LONG;
+typedef wchar_t WCHAR;
+
+struct LUID
+{
+    DWORD LowPart;
+    LONG HighPart;
+};
+
+struct RECT
+{
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+};
+
+struct LARGE_INTEGER
+{
+    long long QuadPart;
+};
+
+// Nanoseconds of the steady clock.
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER* counter)
+{
+    counter->QuadPart = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    return 1;
+}
+
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency)
+{
+    frequency->QuadPart = 1000000000;
+    return 1;
+}
+
+// Only used to tell threads apart in logs and traces.
+inline DWORD GetCurrentThreadId()
+{
+    return (DWORD)std::hash<std::thread::id>()(std::this_thread::get_id());
+}
+
+// There is no debugger output stream.
+inline void OutputDebugStringA(const char*)
+{
+}
+
+inline void Sleep(const DWORD milliseconds)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+}
+
+inline void* _aligned_malloc(const size_t size, const size_t alignment)
+{
+    void* p = nullptr;
+    return posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, size) == 0 ? p : nullptr;
+}
+
+inline void _aligned_free(void* p)
+{
+    free(p);
+}
+
+inline void ZeroMemory(void* destination, const size_t length)
+{
+    memset(destination, 0, length);
+}
+
+template <size_t size>
+int sprintf_s(char (&buffer)[size], const char* format, ...)
+{
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(buffer, size, format, arguments);
+    va_end(arguments);
+    return length;
+}
+
+// Truncates instead of failing on a short buffer, which the engine never hands them.
+inline int strcpy_s(char* destination, const size_t size, const char* source)
+{
+    strncpy(destination, source, size);
+    destination[size - 1] = '\0';
+    return 0;
+}
+
+template <size_t size>
+int wcscpy_s(wchar_t (&destination)[size], const wchar_t* source)
+{
+    wcsncpy(destination, source, size);
+    destination[size - 1] = L'\0';
+    return 0;
+}
+
+inline void __debugbreak()
+{
+    raise(SIGTRAP);
+}
+
+#endif
@@ -0,0 +1,231 @@
+#include "poolallocatorclass.h"
+#include <algorithm>
+#include <functional>
+
+PoolAllocatorClass::PoolAllocatorClass(const char* name, const size_t blockSize, const size_t alignment, const unsigned int capacity)
+{
+    m_name = name;
+    m_blockSize = max(blockSize, sizeof(void*));
+    m_alignment = max(alignment, __alignof(void*));
+#if ENGINE_MEMORY_GUARDS
+    m_userOffset = MemoryClass::AlignUp(MemoryClass::GUARD_SIZE, m_alignment);
+    m_stride = MemoryClass::AlignUp(m_userOffset + m_blockSize + MemoryClass::GUARD_SIZE, m_alignment);
+#else
+    m_userOffset = 0;
+    m_stride = MemoryClass::AlignUp(m_blockSize, m_alignment);
+#endif
+    m_capacity = capacity;
+    m_memory = nullptr;
+    m_freeList = nullptr;
+    m_live = m_peak = 0;
+    m_allocations = 0;
+}
+
+PoolAllocatorClass::~PoolAllocatorClass()
+{
+    if (m_memory != nullptr)
+    {
+        MemoryClass::FreeAligned(m_memory);
+    }
+}
+
+void PoolAllocatorClass::AllocateMemory()
+{
+    m_memory = (unsigned char*)MemoryClass::AllocateAligned(m_stride * m_capacity, m_alignment);
+
+#if ENGINE_MEMORY_GUARDS
+    // Every block starts out freed, between its guards.
+    memset(m_memory, MemoryClass::FREED_BYTE, m_stride * m_capacity);
+    for (unsigned int i = 0; i < m_capacity; i++)
+    {
+        MemoryClass::FillGuard(m_memory + i * m_stride + m_userOffset + m_blockSize);
+    }
+#endif
+
+    // Link the blocks in address order, so the first allocations are next to each other.
+    for (unsigned int i = m_capacity; i > 0; i--)
+    {
+        unsigned char* block = m_memory + (i - 1) * m_stride + m_userOffset;
+        *(void**)block = m_freeList;
+        m_freeList = block;
+    }
+}
+
+void* PoolAllocatorClass::Allocate(const size_t size)
+{
+    if (size > m_blockSize)
+    {
+        throw engine_exception("Allocation of ") << size << " bytes is too large for pool " << m_name;
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+
+    if (m_memory == nullptr)
+    {
+        AllocateMemory();
+    }
+
+    if (m_freeList == nullptr)
+    {
+        throw engine_exception("Pool ") << m_name << " is full at " << m_capacity << " blocks";
+    }
+
+    unsigned char* block = (unsigned char*)m_freeList;
+    m_freeList = *(void**)block;
+
+#if ENGINE_MEMORY_GUARDS
+    // Anything but the free list link written to a freed block was written after it was freed.
+    for (size_t i = sizeof(void*); i < m_blockSize; i++)
+    {
+        if (block[i] != MemoryClass::FREED_BYTE)
+        {
+            throw engine_exception("Freed block written to in pool ") << m_name;
+        }
+    }
+    MemoryClass::FillGuard(block - MemoryClass::GUARD_SIZE);
+#endif
+
+    m_live++;
+    m_peak = max(m_peak, m_live);
+    m_allocations++;
+    return block;
+}
+
+void PoolAllocatorClass::Free(void* p)
+{
+    if (p == nullptr)
+    {
+        return;
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+
+    unsigned char* block = (unsigned char*)p;
+    if (m_memory == nullptr || block < m_memory + m_userOffset || block >= m_memory + m_stride * m_capacity
+        || (size_t)(block - m_memory - m_userOffset) % m_stride != 0)
+    {
+        throw engine_exception("Block wasn't allocated from pool ") << m_name;
+    }
+
+#if ENGINE_MEMORY_GUARDS
+    // A freed block's front guard holds the freed pattern instead.
+    unsigned char* frontGuard = block - MemoryClass::GUARD_SIZE;
+    if (frontGuard[0] == MemoryClass::FREED_BYTE)
+    {
+        throw engine_exception("Block freed twice in pool ") << m_name;
+    }
+    MemoryClass::CheckGuard(frontGuard, m_name);
+    MemoryClass::CheckGuard(block + m_blockSize, m_name);
+    memset(frontGuard, MemoryClass::FREED_BYTE, MemoryClass::GUARD_SIZE);
+    memset(block, MemoryClass::FREED_BYTE, m_blockSize);
+#endif
+
+    *(void**)block = m_freeList;
+    m_freeList = block;
+    m_live--;
+}
+
+void PoolAllocatorClass::FreeFromDelete(void* p) throw()
+{
+    try
+    {
+        Free(p);
+    }
+    catch (const engine_exception& e)
+    {
+        LOG_ERROR("Deleting from pool {} failed: {}", m_name, e.what());
+        LogClass::Flush();
+#ifdef _DEBUG
+        __debugbreak();
+#endif
+        abort();
+    }
+}
+
+PoolAllocatorClass::Statistics PoolAllocatorClass::GetStatistics()
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Statistics statistics;
+    statistics.blockSize = m_blockSize;
+    statistics.capacity = m_capacity;
+    statistics.live = m_live;
+    statistics.peak = m_peak;
+    statistics.allocations = m_allocations;
+    return statistics;
+}
+
+void PoolAllocatorClass::LogStatistics()
+{
+    Statistics statistics = GetStatistics();
+    LOG_INFO("{}: {} of {} blocks of {} bytes in use, {} at most, {} allocations", m_name, statistics.live, statistics.capacity,
+             statistics.blockSize, statistics.peak, statistics.allocations);
+}
+
+void PoolAllocatorClass::Validate()
+{
+    auto check = [](const bool passed, const char* what)
+    {
+        if (!passed)
+        {
+            throw engine_exception("Pool allocator validation: ") << what;
+        }
+    };
+    auto throws = [](const function<void()>& misuse)
+    {
+        try
+        {
+            misuse();
+        }
+        catch (const engine_exception&)
+        {
+            return true;
+        }
+        return false;
+    };
+
+    // A full pool throws, and a freed block is handed out again.
+    const unsigned int capacity = 8;
+    PoolAllocatorClass pool("Validation pool", 48, 16, capacity);
+    void* blocks[capacity];
+    for (unsigned int i = 0; i < capacity; i++)
+    {
+        blocks[i] = pool.Allocate(48);
+        check(((size_t)blocks[i] & 15) == 0, "a block isn't aligned");
+    }
+    check(throws([&pool]() { pool.Allocate(48); }), "a full pool didn't throw");
+    check(throws([&pool]() { pool.Allocate(49); }), "an allocation larger than a block didn't throw");
+    pool.Free(blocks[3]);
+    check(pool.Allocate(48) == blocks[3], "a freed block wasn't reused");
+    for (unsigned int i = 0; i < capacity; i++)
+    {
+        pool.Free(blocks[i]);
+    }
+    Statistics statistics = pool.GetStatistics();
+    check(statistics.live == 0 && statistics.peak == capacity && statistics.allocations == capacity + 1, "the statistics are off");
+    int local = 0;
+    check(throws([&pool, &local]() { pool.Free(&local); }), "freeing a block of another allocator didn't throw");
+
+#if ENGINE_MEMORY_GUARDS
+    // Each misuse gets a pool of its own, since the block it throws on is lost to the pool.
+    PoolAllocatorClass overrunPool("Validation overrun pool", 48, 16, capacity);
+    unsigned char* overrun = (unsigned char*)overrunPool.Allocate(48);
+    overrun[48] = 0;
+    check(throws([&overrunPool, overrun]() { overrunPool.Free(overrun); }), "overrunning a block didn't throw");
+
+    PoolAllocatorClass doubleFreePool("Validation double free pool", 48, 16, capacity);
+    void* freedTwice = doubleFreePool.Allocate(48);
+    doubleFreePool.Free(freedTwice);
+    check(throws([&doubleFreePool, freedTwice]() { doubleFreePool.Free(freedTwice); }), "freeing a block twice didn't throw");
+
+    PoolAllocatorClass writeAfterFreePool("Validation write after free pool", 48, 16, capacity);
+    unsigned char* written = (unsigned char*)writeAfterFreePool.Allocate(48);
+    writeAfterFreePool.Free(written);
+    written[40] = 0;
+    check(throws([&writeAfterFreePool]() { writeAfterFreePool.Allocate(48); }), "writing to a freed block didn't throw");
+#else
+    LOG_INFO("Pool allocator validation: built without ENGINE_MEMORY_GUARDS, so misuse isn't caught");
+#endif
+
+    LOG_INFO("Pool allocator validation passed");
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "engine_core.h"
+#include "memoryclass.h"
+#include <mutex>
+#include <new>
+#include <utility>
+
+using namespace std;
+
+// Fixed size blocks from one allocation of capacity blocks, handed out and taken back through a free list. For engine
+// objects, which get their own pool with the POOL_ALLOCATION macros below. Allocation is thread safe and throws when
+// every block is in use. With ENGINE_MEMORY_GUARDS every block is fenced by guard bytes, checked when it is freed, and
+// freed blocks are filled, so overruns and double frees throw.
+class PoolAllocatorClass
+{
+public:
+    struct Statistics
+    {
+        size_t blockSize;
+        unsigned int capacity;
+        unsigned int live; // Blocks in use.
+        unsigned int peak; // Most blocks in use at once.
+        unsigned long long allocations;
+    };
+
+    // Set up by the constructor rather than Initialize so pools can be static members. The memory is only allocated on
+    // the first Allocate. The name must outlive the pool.
+    PoolAllocatorClass(const char* name, const size_t blockSize, const size_t alignment, const unsigned int capacity);
+
+    ~PoolAllocatorClass();
+
+    // size may be anything up to the block size.
+    void* Allocate(const size_t size);
+
+    void Free(void* p);
+
+    // Free for operator delete, which must not throw: a block Free rejects is logged and the process stops, in the
+    // debugger when there is one.
+    void FreeFromDelete(void* p) throw();
+
+    template <class T, class... Args>
+    T* New(Args&&... args)
+    {
+        return new (Allocate(sizeof(T))) T(forward<Args>(args)...);
+    }
+
+    template <class T>
+    void Delete(T* object)
+    {
+        if (object != nullptr)
+        {
+            object->~T();
+            Free(object);
+        }
+    }
+
+    Statistics GetStatistics();
+
+    void LogStatistics();
+
+    // Fills a pool and frees it again, and with ENGINE_MEMORY_GUARDS overruns a block, frees one twice and writes to one
+    // after freeing it: a full pool and each misuse must throw. Throws on a failure.
+    static void Validate();
+
+private:
+    const char* m_name;
+    size_t m_blockSize;
+    size_t m_alignment;
+    // Bytes from one block to the next, and from a block to its memory; the guards go in between.
+    size_t m_stride;
+    size_t m_userOffset;
+    unsigned int m_capacity;
+    unsigned char* m_memory;
+    // Free blocks are linked through their first bytes.
+    void* m_freeList;
+    unsigned int m_live;
+    unsigned int m_peak;
+    unsigned long long m_allocations;
+    mutex m_mutex;
+
+    void AllocateMemory();
+};
+
+// Gives a class operator new and delete that take its objects from its own pool of capacity blocks, 16 byte aligned for
+// XMMATRIX members. DECLARE_POOL_ALLOCATION goes in the public part of the class, DEFINE_POOL_ALLOCATION in its .cpp.
+#define DECLARE_POOL_ALLOCATION() \
+    static void* operator new(size_t size); \
+    static void operator delete(void* p); \
+    static PoolAllocatorClass s_pool
+
+#define DEFINE_POOL_ALLOCATION(ClassName, capacity) \
+    PoolAllocatorClass ClassName::s_pool(#ClassName, sizeof(ClassName), 16, capacity); \
+    void* ClassName::operator new(size_t size) { return s_pool.Allocate(size); } \
+    void ClassName::operator delete(void* p) { s_pool.FreeFromDelete(p); }
@@ -0,0 +1,229 @@
+#include "profilerclass.h"
+#include "logclass.h"
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const unsigned int RING_SIZE = 1 << 16;
+    const unsigned int MAX_DEPTH = 64;
+    const int STATISTICS_FRAMES = 120;
+
+    struct ZoneEvent
+    {
+        const char* name;
+        long long begin;
+        long long end;
+        unsigned int depth;
+    };
+
+    struct OpenZone
+    {
+        const char* name;
+        long long begin;
+    };
+
+    // Only the owning thread writes to a buffer; count is published after each event so other threads can read behind it.
+    struct ThreadBuffer
+    {
+        DWORD threadId;
+        unsigned int depth;
+        OpenZone stack[MAX_DEPTH];
+        ZoneEvent events[RING_SIZE];
+        atomic<unsigned long long> count;
+        unsigned long long aggregated;
+    };
+
+    struct ZoneStatistics
+    {
+        const char* name;
+        unsigned int depth;
+        long long totalTicks;
+        long long maxTicks;
+        unsigned long long calls;
+    };
+
+    mutex g_buffersMutex;
+    vector<unique_ptr<ThreadBuffer>> g_buffers;
+    vector<ZoneStatistics> g_statistics;
+    int g_statisticsFrames = 0;
+    long long g_frequency = 1;
+    long long g_origin = 0;
+
+    THREAD_LOCAL ThreadBuffer* t_buffer = nullptr;
+
+    long long Now()
+    {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    }
+
+    double TicksToMicroseconds(const long long ticks)
+    {
+        return (double)ticks * 1000000.0 / (double)g_frequency;
+    }
+
+    ThreadBuffer* GetThreadBuffer()
+    {
+        if (t_buffer == nullptr)
+        {
+            unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+            buffer->threadId = GetCurrentThreadId();
+            buffer->depth = 0;
+            buffer->count = 0;
+            buffer->aggregated = 0;
+
+            lock_guard<mutex> lock(g_buffersMutex);
+            t_buffer = buffer.get();
+            g_buffers.push_back(move(buffer));
+        }
+
+        return t_buffer;
+    }
+
+    void AddToStatistics(const ZoneEvent& event)
+    {
+        for (auto& zone : g_statistics)
+        {
+            if (zone.name == event.name && zone.depth == event.depth)
+            {
+                long long ticks = event.end - event.begin;
+                zone.totalTicks += ticks;
+                zone.maxTicks = max(zone.maxTicks, ticks);
+                zone.calls++;
+                return;
+            }
+        }
+
+        ZoneStatistics zone = { event.name, event.depth, event.end - event.begin, event.end - event.begin, 1 };
+        g_statistics.push_back(zone);
+    }
+}
+
+void ProfilerClass::Initialize()
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    g_frequency = frequency.QuadPart;
+    g_origin = Now();
+
+    LOG_INFO("Profiler zone overhead = {} ns", MeasureZoneOverhead(100000));
+}
+
+void ProfilerClass::BeginZone(const char* name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+
+    // Zones nested deeper than the stack are dropped rather than corrupting their parents.
+    if (buffer->depth < MAX_DEPTH)
+    {
+        buffer->stack[buffer->depth].name = name;
+        buffer->stack[buffer->depth].begin = Now();
+    }
+    buffer->depth++;
+}
+
+void ProfilerClass::EndZone()
+{
+    long long end = Now();
+    ThreadBuffer* buffer = t_buffer;
+
+    buffer->depth--;
+    if (buffer->depth < MAX_DEPTH)
+    {
+        unsigned long long index = buffer->count.load(memory_order_relaxed);
+        ZoneEvent& event = buffer->events[index & (RING_SIZE - 1)];
+        event.name = buffer->stack[buffer->depth].name;
+        event.begin = buffer->stack[buffer->depth].begin;
+        event.end = end;
+        event.depth = buffer->depth;
+        buffer->count.store(index + 1, memory_order_release);
+    }
+}
+
+void ProfilerClass::EndFrame()
+{
+    lock_guard<mutex> lock(g_buffersMutex);
+
+    for (auto& buffer : g_buffers)
+    {
+        // Anything older than one ring has already been overwritten.
+        unsigned long long count = buffer->count.load(memory_order_acquire);
+        unsigned long long first = max(buffer->aggregated, count > RING_SIZE ? count - RING_SIZE : 0);
+        for (unsigned long long i = first; i < count; i++)
+        {
+            AddToStatistics(buffer->events[i & (RING_SIZE - 1)]);
+        }
+        buffer->aggregated = count;
+    }
+
+    if (++g_statisticsFrames == STATISTICS_FRAMES)
+    {
+        LOG_INFO("Profiler: average per frame over {} frames", STATISTICS_FRAMES);
+        for (auto& zone : g_statistics)
+        {
+            LOG_INFO("{}{}: {} us, {} calls, max {} us", string(zone.depth * 2 + 2, ' '), zone.name,
+                     TicksToMicroseconds(zone.totalTicks) / STATISTICS_FRAMES, (double)zone.calls / STATISTICS_FRAMES, TicksToMicroseconds(zone.maxTicks));
+        }
+
+        g_statistics.clear();
+        g_statisticsFrames = 0;
+    }
+}
+
+void ProfilerClass::ExportChromeTrace(const char* fileName)
+{
+    ofstream file(fileName);
+    if (!file.is_open())
+    {
+        LOG_WARNING("Profiler couldn't open trace file {}", fileName);
+        return;
+    }
+
+    lock_guard<mutex> lock(g_buffersMutex);
+
+    // Complete ("X") events with microsecond timestamps; the viewer rebuilds the hierarchy from the nesting.
+    file << "{\"traceEvents\":[";
+    bool first = true;
+    for (auto& buffer : g_buffers)
+    {
+        unsigned long long count = buffer->count.load(memory_order_acquire);
+        unsigned long long begin = count > RING_SIZE ? count - RING_SIZE : 0;
+        for (unsigned long long i = begin; i < count; i++)
+        {
+            const ZoneEvent& event = buffer->events[i & (RING_SIZE - 1)];
+            file << (first ? "\n" : ",\n")
+                 << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                 << ",\"ts\":" << TicksToMicroseconds(event.begin - g_origin)
+                 << ",\"dur\":" << TicksToMicroseconds(event.end - event.begin) << "}";
+            first = false;
+        }
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+double ProfilerClass::MeasureZoneOverhead(const int iterations)
+{
+    // Make sure the buffer exists so its one-off allocation isn't counted.
+    ThreadBuffer* buffer = GetThreadBuffer();
+    unsigned long long before = buffer->count.load();
+
+    long long start = Now();
+    for (int i = 0; i < iterations; i++)
+    {
+        ProfileScope zone("ProfilerOverhead");
+    }
+    long long end = Now();
+
+    // Rewind so the calibration zones stay out of the frame statistics; this is meant to be called before any real zones.
+    buffer->count.store(before);
+
+    return TicksToMicroseconds(end - start) * 1000.0 / iterations;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "platform.h"
+
+// Comment this out to compile every profiler zone, frame marker and export out of the engine.
+#define ENGINE_PROFILING
+
+// Hierarchical CPU profiler. Each thread records completed zones into its own ring buffer so recording takes no locks;
+// zones are aggregated per frame by EndFrame and can be exported as Chrome trace JSON (chrome://tracing).
+// Zone names must be string literals, only the pointer is stored.
+class ProfilerClass
+{
+public:
+    static void Initialize();
+
+    static void BeginZone(const char* name);
+
+    static void EndZone();
+
+    // Aggregates the zones recorded since the previous call and periodically writes per zone averages to the log.
+    static void EndFrame();
+
+    static void ExportChromeTrace(const char* fileName);
+
+    // Times empty zones and returns the average cost of one zone in nanoseconds.
+    static double MeasureZoneOverhead(const int iterations);
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name)
+    {
+        ProfilerClass::BeginZone(name);
+    }
+
+    ~ProfileScope()
+    {
+        ProfilerClass::EndZone();
+    }
+};
+
+#ifdef ENGINE_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_INITIALIZE() ProfilerClass::Initialize()
+#define PROFILE_END_FRAME() ProfilerClass::EndFrame()
+#define PROFILE_EXPORT(fileName) ProfilerClass::ExportChromeTrace(fileName)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_INITIALIZE()
+#define PROFILE_END_FRAME()
+#define PROFILE_EXPORT(fileName)
+#endif
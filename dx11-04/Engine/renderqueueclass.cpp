@@ -0,0 +1,174 @@
+#include "renderqueueclass.h"
+
+RenderQueueClass::RenderQueueClass()
+{
+}
+
+RenderQueueClass::~RenderQueueClass()
+{
+}
+
+void RenderQueueClass::Initialize(const unsigned int packetCapacity)
+{
+    m_packets.reserve(packetCapacity);
+    m_keys.reserve(packetCapacity);
+    m_scratchKeys.reserve(packetCapacity);
+    m_order.reserve(packetCapacity);
+    m_scratchOrder.reserve(packetCapacity);
+}
+
+void RenderQueueClass::Reset()
+{
+    m_packets.clear();
+    m_keys.clear();
+    m_order.clear();
+}
+
+void RenderQueueClass::Record(const unsigned long long sortKey, ModelClass* model, ColorShaderClass* shader, const XMMATRIX& world, const unsigned int lod)
+{
+    DrawPacket packet;
+    packet.model = model;
+    packet.shader = shader;
+    XMStoreFloat4x4(&packet.world, world);
+    packet.lod = lod;
+
+    m_order.push_back((unsigned int)m_packets.size());
+    m_packets.push_back(packet);
+    m_keys.push_back(sortKey);
+}
+
+void RenderQueueClass::Sort()
+{
+    size_t count = m_keys.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    m_scratchKeys.resize(count);
+    m_scratchOrder.resize(count);
+
+    // Build all eight byte histograms in one pass over the keys.
+    unsigned int histograms[8][256];
+    ZeroMemory(histograms, sizeof(histograms));
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned long long key = m_keys[i];
+        for (int b = 0; b < 8; b++)
+        {
+            histograms[b][(key >> (b * 8)) & 0xFF]++;
+        }
+    }
+
+    // Stable LSD radix sort on (key, packet index) pairs, skipping bytes that are the same in every key.
+    for (int b = 0; b < 8; b++)
+    {
+        unsigned int* histogram = histograms[b];
+        if (histogram[(m_keys[0] >> (b * 8)) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        unsigned int offset = 0;
+        for (int i = 0; i < 256; i++)
+        {
+            unsigned int bucketSize = histogram[i];
+            histogram[i] = offset;
+            offset += bucketSize;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            unsigned int destination = histogram[(m_keys[i] >> (b * 8)) & 0xFF]++;
+            m_scratchKeys[destination] = m_keys[i];
+            m_scratchOrder[destination] = m_order[i];
+        }
+
+        m_keys.swap(m_scratchKeys);
+        m_order.swap(m_scratchOrder);
+    }
+}
+
+void RenderQueueClass::Submit(StateCacheClass* stateCache, ConstantBufferRingClass* constantRing, SoftwareRasterizerClass* rasterizer,
+                              const XMMATRIX& view, const XMMATRIX& projection)
+{
+    ColorShaderClass* currentShader = nullptr;
+    for (unsigned int index : m_order)
+    {
+        DrawPacket& packet = m_packets[index];
+        XMMATRIX world = XMLoadFloat4x4(&packet.world);
+
+        if (rasterizer)
+        {
+            packet.model->Render(rasterizer, world, view, projection, packet.lod);
+        }
+        else
+        {
+            // Packets are sorted by shader, so the frame constants are set once per shader run.
+            if (packet.shader != currentShader)
+            {
+                packet.shader->SetFrameConstants(stateCache, view, projection);
+                currentShader = packet.shader;
+            }
+
+            packet.model->Render(stateCache, packet.lod);
+            packet.shader->Render(stateCache, constantRing, packet.model->GetIndexCount(packet.lod), packet.model->GetQuantization(), world);
+        }
+    }
+}
+
+void RenderQueueClass::Submit(CommandListClass* commandList, const unsigned int begin, const unsigned int end)
+{
+    for (unsigned int i = begin; i < end; i++)
+    {
+        DrawPacket& packet = m_packets[m_order[i]];
+        commandList->Draw(packet.model, packet.shader, XMLoadFloat4x4(&packet.world), packet.lod);
+    }
+}
+
+unsigned int RenderQueueClass::GetPacketCount()
+{
+    return (unsigned int)m_packets.size();
+}
+
+unsigned long long RenderQueueClass::MakeSortKey(const unsigned int pass, const unsigned int shader, const unsigned int material, const float depth)
+{
+    float clampedDepth = min(max(depth, 0.0f), 1.0f);
+    unsigned long long depthBits = (unsigned long long)(clampedDepth * 16777215.0f);
+
+    return ((unsigned long long)(pass & 0xFF) << 56) |
+           ((unsigned long long)(shader & 0xFFF) << 44) |
+           ((unsigned long long)(material & 0xFFFFF) << 24) |
+           depthBits;
+}
+
+void RenderQueueClass::Benchmark(const unsigned int packetCount)
+{
+    RenderQueueClass queue;
+    queue.Initialize(packetCount);
+
+    // A cheap LCG gives keys spread over every field without pulling in <random>.
+    unsigned int seed = 12345;
+    XMMATRIX world = XMMatrixIdentity();
+
+    LARGE_INTEGER frequency, start, recorded, sorted;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+
+    for (unsigned int i = 0; i < packetCount; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        unsigned long long key = MakeSortKey(seed >> 30, (seed >> 18) & 0xFFF, (seed >> 4) & 0xFFFFF, (float)(seed & 0xFFFF) / 65535.0f);
+        queue.Record(key, nullptr, nullptr, world);
+    }
+    QueryPerformanceCounter(&recorded);
+
+    queue.Sort();
+    QueryPerformanceCounter(&sorted);
+
+    double recordSeconds = (double)(recorded.QuadPart - start.QuadPart) / frequency.QuadPart;
+    double sortSeconds = (double)(sorted.QuadPart - recorded.QuadPart) / frequency.QuadPart;
+
+    LOG_INFO("Render queue benchmark: {} packets, record {} ms ({} packets/sec), sort {} ms ({} packets/sec)", packetCount, recordSeconds * 1000.0,
+             packetCount / recordSeconds, sortSeconds * 1000.0, packetCount / sortSeconds);
+}
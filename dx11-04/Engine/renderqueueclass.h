@@ -0,0 +1,59 @@
+#pragma once
+#include "engine.h"
+#include "softwarerasterizerclass.h"
+#include "modelclass.h"
+#include "colorshaderclass.h"
+#include "commandlistclass.h"
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+
+// Draws are recorded into a linear packet buffer with a 64-bit sort key, radix sorted, then submitted in key order.
+// Key layout from the most significant bit: pass (8), shader (12), material (20), depth (24). Opaque passes sort
+// front-to-back for early-Z, so depth is the least significant field.
+class RenderQueueClass
+{
+public:
+    RenderQueueClass();
+
+    ~RenderQueueClass();
+
+    void Initialize(const unsigned int packetCapacity);
+
+    // Clears the packets recorded last frame; the buffers keep their capacity.
+    void Reset();
+
+    // lod is the model's level of detail to draw.
+    void Record(const unsigned long long sortKey, ModelClass* model, ColorShaderClass* shader, const XMMATRIX& world, const unsigned int lod = 0);
+
+    void Sort();
+
+    // Draws the packets in sorted order, on the software rasterizer if the D3D class has one.
+    void Submit(StateCacheClass* stateCache, ConstantBufferRingClass* constantRing, SoftwareRasterizerClass* rasterizer,
+                const XMMATRIX& view, const XMMATRIX& projection);
+
+    // Records the sorted packets [begin, end) into a command list, so a frame can be split into runs recorded in parallel.
+    void Submit(CommandListClass* commandList, const unsigned int begin, const unsigned int end);
+
+    unsigned int GetPacketCount();
+
+    // Depth is normalized view distance in [0, 1]; values outside are clamped.
+    static unsigned long long MakeSortKey(const unsigned int pass, const unsigned int shader, const unsigned int material, const float depth);
+
+    // Records and sorts packetCount synthetic packets and writes packets/sec to the log.
+    static void Benchmark(const unsigned int packetCount);
+
+private:
+    struct DrawPacket
+    {
+        ModelClass* model;
+        ColorShaderClass* shader;
+        XMFLOAT4X4 world;
+        unsigned int lod;
+    };
+
+    vector<DrawPacket> m_packets;
+    vector<unsigned long long> m_keys, m_scratchKeys;
+    vector<unsigned int> m_order, m_scratchOrder;
+};
@@ -0,0 +1,435 @@
+#include "sceneclass.h"
+
+namespace
+{
+    // Levels smaller than this are composed on the calling thread; spreading them costs more than it saves.
+    const unsigned int PARALLEL_LEVEL_SIZE = 4096;
+    const unsigned int UPDATE_GRAIN_SIZE = 1024;
+}
+
+const unsigned int SceneClass::NO_PARENT;
+const unsigned int SceneClass::NO_RENDERABLE;
+const unsigned int SceneClass::NO_SLOT;
+
+SceneClass::SceneClass()
+{
+    m_capacity = m_count = 0;
+    m_sortPending = false;
+}
+
+SceneClass::~SceneClass()
+{
+}
+
+void SceneClass::Initialize(const unsigned int capacity)
+{
+    m_capacity = capacity;
+    m_count = 0;
+    m_positions.Allocate(capacity);
+    m_rotations.Allocate(capacity);
+    m_scales.Allocate(capacity);
+    m_worlds.Allocate(capacity);
+    m_parents.reserve(capacity);
+    m_depths.reserve(capacity);
+    m_renderables.reserve(capacity);
+    m_lods.reserve(capacity);
+    m_slotHandles.reserve(capacity);
+    m_levelStarts.clear();
+    m_sortPending = false;
+}
+
+EntityHandle SceneClass::Create(const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale, const unsigned int renderable)
+{
+    return CreateInSlot(NO_PARENT, position, rotation, scale, renderable);
+}
+
+EntityHandle SceneClass::Create(const EntityHandle parent, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale,
+                                const unsigned int renderable)
+{
+    return CreateInSlot(GetSlot(parent), position, rotation, scale, renderable);
+}
+
+EntityHandle SceneClass::CreateInSlot(const unsigned int parentSlot, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale,
+                                      const unsigned int renderable)
+{
+    if (m_count == m_capacity)
+    {
+        throw engine_exception("Scene is full, capacity = ") << m_capacity;
+    }
+
+    EntityHandle handle;
+    if (!m_freeHandles.empty())
+    {
+        handle.index = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    else
+    {
+        handle.index = (unsigned int)m_handleSlots.size();
+        m_handleSlots.push_back(NO_SLOT);
+        m_handleGenerations.push_back(0);
+    }
+    handle.generation = m_handleGenerations[handle.index];
+
+    unsigned int slot = m_count++;
+    unsigned int depth = parentSlot == NO_PARENT ? 0 : m_depths[parentSlot] + 1;
+    m_handleSlots[handle.index] = slot;
+    m_slotHandles.push_back(handle.index);
+    m_parents.push_back(parentSlot);
+    m_depths.push_back(depth);
+    m_renderables.push_back(renderable);
+    m_lods.push_back(0);
+    m_positions[slot] = XMFLOAT4A(position.x, position.y, position.z, 1.0f);
+    m_rotations[slot] = XMFLOAT4A(rotation.x, rotation.y, rotation.z, rotation.w);
+    m_scales[slot] = XMFLOAT4A(scale.x, scale.y, scale.z, 0.0f);
+    XMStoreFloat4x4A(&m_worlds[slot], XMMatrixIdentity());
+
+    // Appending at the deepest level (or one deeper) keeps the slots sorted; anything shallower needs a re-sort.
+    if (!m_sortPending)
+    {
+        if (slot == 0)
+        {
+            m_levelStarts.assign(1, 0);
+        }
+        else if (depth == m_depths[slot - 1] + 1)
+        {
+            m_levelStarts.push_back(slot);
+        }
+        else if (depth < m_depths[slot - 1])
+        {
+            m_sortPending = true;
+        }
+    }
+    return handle;
+}
+
+void SceneClass::Destroy(const EntityHandle entity)
+{
+    unsigned int slot = GetSlot(entity);
+    if (m_sortPending)
+    {
+        Sort();
+        slot = GetSlot(entity);
+    }
+
+    // Sorted slots put descendants after their ancestors, so one pass from the entity finds the whole subtree.
+    vector<bool> removed(m_count, false);
+    removed[slot] = true;
+    for (unsigned int i = slot + 1; i < m_count; i++)
+    {
+        removed[i] = m_parents[i] != NO_PARENT && removed[m_parents[i]];
+    }
+
+    vector<unsigned int> order;
+    order.reserve(m_count);
+    for (unsigned int i = 0; i < m_count; i++)
+    {
+        if (!removed[i])
+        {
+            order.push_back(i);
+            continue;
+        }
+
+        unsigned int handleIndex = m_slotHandles[i];
+        m_handleSlots[handleIndex] = NO_SLOT;
+        m_handleGenerations[handleIndex]++;
+        m_freeHandles.push_back(handleIndex);
+    }
+
+    // Dropping slots keeps the survivors in depth order.
+    Permute(order, (unsigned int)order.size());
+    RebuildLevels();
+}
+
+void SceneClass::SetParent(const EntityHandle entity, const EntityHandle parent)
+{
+    unsigned int slot = GetSlot(entity);
+    unsigned int parentSlot = GetSlot(parent);
+
+    for (unsigned int ancestor = parentSlot; ancestor != NO_PARENT; ancestor = m_parents[ancestor])
+    {
+        if (ancestor == slot)
+        {
+            throw engine_exception("Can't parent an entity to itself or one of its descendants");
+        }
+    }
+
+    m_parents[slot] = parentSlot;
+    m_sortPending = true;
+}
+
+void SceneClass::ClearParent(const EntityHandle entity)
+{
+    unsigned int slot = GetSlot(entity);
+    m_parents[slot] = NO_PARENT;
+    m_sortPending = true;
+}
+
+bool SceneClass::IsValid(const EntityHandle entity)
+{
+    return entity.index < m_handleSlots.size() && m_handleGenerations[entity.index] == entity.generation && m_handleSlots[entity.index] != NO_SLOT;
+}
+
+unsigned int SceneClass::GetSlot(const EntityHandle entity)
+{
+    if (!IsValid(entity))
+    {
+        throw engine_exception("Stale or invalid entity handle, index = ") << entity.index;
+    }
+    return m_handleSlots[entity.index];
+}
+
+void SceneClass::SetLocalTransform(const EntityHandle entity, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale)
+{
+    unsigned int slot = GetSlot(entity);
+    m_positions[slot] = XMFLOAT4A(position.x, position.y, position.z, 1.0f);
+    m_rotations[slot] = XMFLOAT4A(rotation.x, rotation.y, rotation.z, rotation.w);
+    m_scales[slot] = XMFLOAT4A(scale.x, scale.y, scale.z, 0.0f);
+}
+
+void SceneClass::SetRenderable(const EntityHandle entity, const unsigned int renderable)
+{
+    unsigned int slot = GetSlot(entity);
+    m_renderables[slot] = renderable;
+    m_lods[slot] = 0;
+}
+
+XMMATRIX SceneClass::GetWorldMatrix(const EntityHandle entity)
+{
+    return XMLoadFloat4x4A(&m_worlds[GetSlot(entity)]);
+}
+
+void SceneClass::Sort()
+{
+    PROFILE_FUNCTION();
+
+    // After reparenting a parent can sit behind its children, so depths are found by walking up to the nearest known one.
+    vector<unsigned int> depths(m_count, NO_SLOT);
+    vector<unsigned int> chain;
+    unsigned int maxDepth = 0;
+    for (unsigned int i = 0; i < m_count; i++)
+    {
+        unsigned int slot = i;
+        while (depths[slot] == NO_SLOT && m_parents[slot] != NO_PARENT)
+        {
+            chain.push_back(slot);
+            slot = m_parents[slot];
+        }
+
+        unsigned int depth = depths[slot] != NO_SLOT ? depths[slot] : 0;
+        depths[slot] = depth;
+        while (!chain.empty())
+        {
+            depths[chain.back()] = ++depth;
+            chain.pop_back();
+        }
+        maxDepth = max(maxDepth, depths[i]);
+    }
+
+    // Stable counting sort by depth.
+    vector<unsigned int> levelStarts(maxDepth + 2, 0);
+    for (unsigned int i = 0; i < m_count; i++)
+    {
+        levelStarts[depths[i] + 1]++;
+    }
+    for (unsigned int depth = 1; depth < levelStarts.size(); depth++)
+    {
+        levelStarts[depth] += levelStarts[depth - 1];
+    }
+
+    vector<unsigned int> order(m_count);
+    vector<unsigned int> next(levelStarts.begin(), levelStarts.end() - 1);
+    for (unsigned int i = 0; i < m_count; i++)
+    {
+        order[next[depths[i]]++] = i;
+    }
+
+    m_depths.swap(depths);
+    Permute(order, m_count);
+    RebuildLevels();
+    m_sortPending = false;
+}
+
+void SceneClass::Permute(const vector<unsigned int>& order, const unsigned int count)
+{
+    vector<unsigned int> newSlots(m_count, NO_SLOT);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        newSlots[order[i]] = i;
+    }
+
+    AlignedArray<XMFLOAT4A> positions, rotations, scales;
+    AlignedArray<XMFLOAT4X4A> worlds;
+    positions.Allocate(m_capacity);
+    rotations.Allocate(m_capacity);
+    scales.Allocate(m_capacity);
+    worlds.Allocate(m_capacity);
+
+    vector<unsigned int> parents(count), depths(count), renderables(count), lods(count), slotHandles(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        unsigned int from = order[i];
+        positions[i] = m_positions[from];
+        rotations[i] = m_rotations[from];
+        scales[i] = m_scales[from];
+        worlds[i] = m_worlds[from];
+        parents[i] = m_parents[from] == NO_PARENT ? NO_PARENT : newSlots[m_parents[from]];
+        depths[i] = m_depths[from];
+        renderables[i] = m_renderables[from];
+        lods[i] = m_lods[from];
+        slotHandles[i] = m_slotHandles[from];
+        m_handleSlots[slotHandles[i]] = i;
+    }
+
+    m_positions.Swap(positions);
+    m_rotations.Swap(rotations);
+    m_scales.Swap(scales);
+    m_worlds.Swap(worlds);
+
+    // Assign rather than swap so the arrays keep the capacity Initialize reserved.
+    m_parents.assign(parents.begin(), parents.end());
+    m_depths.assign(depths.begin(), depths.end());
+    m_renderables.assign(renderables.begin(), renderables.end());
+    m_lods.assign(lods.begin(), lods.end());
+    m_slotHandles.assign(slotHandles.begin(), slotHandles.end());
+    m_count = count;
+}
+
+void SceneClass::RebuildLevels()
+{
+    m_levelStarts.clear();
+    for (unsigned int i = 0; i < m_count; i++)
+    {
+        if (i == 0 || m_depths[i] != m_depths[i - 1])
+        {
+            m_levelStarts.push_back(i);
+        }
+    }
+}
+
+void SceneClass::UpdateTransforms(JobSystemClass* jobSystem)
+{
+    PROFILE_FUNCTION();
+
+    if (m_sortPending)
+    {
+        Sort();
+    }
+
+    // Each level only reads the world matrices of the level above, which are complete by the time it starts.
+    for (unsigned int level = 0; level < m_levelStarts.size(); level++)
+    {
+        unsigned int begin = m_levelStarts[level];
+        unsigned int end = level + 1 < m_levelStarts.size() ? m_levelStarts[level + 1] : m_count;
+
+        if (jobSystem != nullptr && end - begin >= PARALLEL_LEVEL_SIZE)
+        {
+            jobSystem->ParallelFor(end - begin, UPDATE_GRAIN_SIZE, [this, begin](unsigned int first, unsigned int last)
+            {
+                UpdateRange(begin + first, begin + last);
+            });
+        }
+        else
+        {
+            UpdateRange(begin, end);
+        }
+    }
+}
+
+void SceneClass::UpdateRange(const unsigned int begin, const unsigned int end)
+{
+    const XMVECTOR identityR3 = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+    const XMVECTOR selectXYZ = XMVectorSelectControl(1, 1, 1, 0);
+
+    for (unsigned int i = begin; i < end; i++)
+    {
+        // Scale * rotation * translation, built directly: scale the rotation rows and drop the position in the last row.
+        XMVECTOR scale = XMLoadFloat4A(&m_scales[i]);
+        XMMATRIX world = XMMatrixRotationQuaternion(XMLoadFloat4A(&m_rotations[i]));
+        world.r[0] = XMVectorMultiply(world.r[0], XMVectorSplatX(scale));
+        world.r[1] = XMVectorMultiply(world.r[1], XMVectorSplatY(scale));
+        world.r[2] = XMVectorMultiply(world.r[2], XMVectorSplatZ(scale));
+        world.r[3] = XMVectorSelect(identityR3, XMLoadFloat4A(&m_positions[i]), selectXYZ);
+
+        unsigned int parent = m_parents[i];
+        if (parent != NO_PARENT)
+        {
+            world = XMMatrixMultiply(world, XMLoadFloat4x4A(&m_worlds[parent]));
+        }
+        XMStoreFloat4x4A(&m_worlds[i], world);
+    }
+}
+
+unsigned int SceneClass::GetCount()
+{
+    return m_count;
+}
+
+const XMFLOAT4X4A* SceneClass::GetWorldMatrices()
+{
+    return m_worlds.Get();
+}
+
+const unsigned int* SceneClass::GetRenderables()
+{
+    return m_renderables.data();
+}
+
+unsigned int* SceneClass::GetLods()
+{
+    return m_lods.data();
+}
+
+void SceneClass::Benchmark(const unsigned int objectCount, JobSystemClass* jobSystem)
+{
+    // A quarter of the objects are roots with a two deep chain and one more child each, like props with attachments.
+    SceneClass scene;
+    scene.Initialize(objectCount);
+    EntityHandle root, child;
+    for (unsigned int i = 0; i < objectCount; i++)
+    {
+        XMFLOAT3 position((float)(i % 1000), (float)(i / 1000), 0.0f);
+        XMFLOAT4 rotation;
+        XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(0.001f * i, 0.002f * i, 0.003f * i));
+        XMFLOAT3 scale(1.0f, 1.0f, 1.0f);
+
+        switch (i % 4)
+        {
+        case 0:
+            root = child = scene.Create(position, rotation, scale, NO_RENDERABLE);
+            break;
+        case 3:
+            scene.Create(root, position, rotation, scale, NO_RENDERABLE);
+            break;
+        default:
+            child = scene.Create(child, position, rotation, scale, NO_RENDERABLE);
+            break;
+        }
+    }
+
+    // The first update pays for sorting the hierarchy.
+    scene.UpdateTransforms(nullptr);
+
+    const int updates = 10;
+    LARGE_INTEGER frequency, start, single, parallel;
+    QueryPerformanceFrequency(&frequency);
+
+    QueryPerformanceCounter(&start);
+    for (int update = 0; update < updates; update++)
+    {
+        scene.UpdateTransforms(nullptr);
+    }
+    QueryPerformanceCounter(&single);
+    for (int update = 0; update < updates; update++)
+    {
+        scene.UpdateTransforms(jobSystem);
+    }
+    QueryPerformanceCounter(&parallel);
+
+    double singleSeconds = (double)(single.QuadPart - start.QuadPart) / frequency.QuadPart / updates;
+    double parallelSeconds = (double)(parallel.QuadPart - single.QuadPart) / frequency.QuadPart / updates;
+
+    LOG_INFO("Scene transform benchmark: {} objects, 1 thread {} ms ({}M/s), {} threads {} ms ({}M/s, {}x)", objectCount, singleSeconds * 1000.0,
+             objectCount / singleSeconds / 1e6, jobSystem->GetThreadCount(), parallelSeconds * 1000.0, objectCount / parallelSeconds / 1e6,
+             singleSeconds / parallelSeconds);
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include "engine.h"
+#include "jobsystemclass.h"
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+
+// Stable reference to a scene entity. The generation changes whenever an index is reused, so stale handles are caught.
+struct EntityHandle
+{
+    unsigned int index;
+    unsigned int generation;
+};
+
+// Structure of arrays store for the scene's entities. Local position, rotation (a quaternion) and scale, and the world
+// matrix composed from them, live in 16 byte aligned arrays indexed by slot. Slots are kept sorted by hierarchy depth,
+// so every parent comes before its children and UpdateTransforms is one linear pass, run level by level across the job
+// system. Structural changes (Destroy, SetParent, or creating an entity shallower than the last one) move slots, so
+// keep EntityHandles across frames and only use slot indices between two updates.
+class SceneClass
+{
+public:
+    static const unsigned int NO_PARENT = 0xFFFFFFFF;
+    static const unsigned int NO_RENDERABLE = 0xFFFFFFFF;
+
+    SceneClass();
+
+    ~SceneClass();
+
+    void Initialize(const unsigned int capacity);
+
+    // renderable indexes the caller's render data, or is NO_RENDERABLE for pure transform nodes.
+    EntityHandle Create(const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale, const unsigned int renderable);
+
+    EntityHandle Create(const EntityHandle parent, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale,
+                        const unsigned int renderable);
+
+    // Destroys the entity and everything below it.
+    void Destroy(const EntityHandle entity);
+
+    void SetParent(const EntityHandle entity, const EntityHandle parent);
+
+    void ClearParent(const EntityHandle entity);
+
+    bool IsValid(const EntityHandle entity);
+
+    void SetLocalTransform(const EntityHandle entity, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale);
+
+    void SetRenderable(const EntityHandle entity, const unsigned int renderable);
+
+    // As of the last UpdateTransforms.
+    XMMATRIX GetWorldMatrix(const EntityHandle entity);
+
+    // Composes every world matrix from the local transforms, in parallel when a job system is given.
+    void UpdateTransforms(JobSystemClass* jobSystem);
+
+    // Slot order arrays for batch processing, valid until the next structural change.
+    unsigned int GetCount();
+
+    const XMFLOAT4X4A* GetWorldMatrices();
+
+    const unsigned int* GetRenderables();
+
+    // The LOD each entity was last drawn at, kept here for the renderer so it moves with the entity's slot. New entities,
+    // and ones given another renderable, start at 0.
+    unsigned int* GetLods();
+
+    // Times UpdateTransforms over objectCount entities in shallow hierarchies, on one thread and on the job system.
+    static void Benchmark(const unsigned int objectCount, JobSystemClass* jobSystem);
+
+private:
+    static const unsigned int NO_SLOT = 0xFFFFFFFF;
+
+    // Fixed size array on a 16 byte boundary; std::vector can't promise that for the XM*A types on Win32.
+    template <class T>
+    class AlignedArray
+    {
+    public:
+        AlignedArray() : m_data(nullptr)
+        {
+        }
+
+        ~AlignedArray()
+        {
+            _aligned_free(m_data);
+        }
+
+        void Allocate(const unsigned int count)
+        {
+            _aligned_free(m_data);
+            m_data = (T*)_aligned_malloc(max(count, 1u) * sizeof(T), 16);
+            if (m_data == nullptr)
+            {
+                throw bad_alloc();
+            }
+        }
+
+        void Swap(AlignedArray& other)
+        {
+            swap(m_data, other.m_data);
+        }
+
+        T& operator[](const unsigned int index)
+        {
+            return m_data[index];
+        }
+
+        T* Get()
+        {
+            return m_data;
+        }
+
+    private:
+        T* m_data;
+
+        AlignedArray(const AlignedArray&);
+        AlignedArray& operator=(const AlignedArray&);
+    };
+
+    unsigned int m_capacity, m_count;
+    AlignedArray<XMFLOAT4A> m_positions, m_rotations, m_scales;
+    AlignedArray<XMFLOAT4X4A> m_worlds;
+    vector<unsigned int> m_parents;
+    vector<unsigned int> m_depths;
+    vector<unsigned int> m_renderables;
+    vector<unsigned int> m_lods;
+    vector<unsigned int> m_slotHandles;
+
+    // First slot of every depth level; only valid while m_sortPending is false.
+    vector<unsigned int> m_levelStarts;
+    bool m_sortPending;
+
+    vector<unsigned int> m_handleSlots;
+    vector<unsigned int> m_handleGenerations;
+    vector<unsigned int> m_freeHandles;
+
+    unsigned int GetSlot(const EntityHandle entity);
+
+    EntityHandle CreateInSlot(const unsigned int parentSlot, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale,
+                              const unsigned int renderable);
+
+    // Re-sorts the slots by depth after hierarchy edits.
+    void Sort();
+
+    // Moves old slot order[i] to slot i for i < count; slots not listed are dropped.
+    void Permute(const vector<unsigned int>& order, const unsigned int count);
+
+    void RebuildLevels();
+
+    void UpdateRange(const unsigned int begin, const unsigned int end);
+};
@@ -0,0 +1,94 @@
+#include "shaderlibraryclass.h"
+#include <cstring>
+
+// Generated by FxCompile into $(IntDir), one const BYTE g_<file name>[] each.
+#include "ColorVertexShader.h"
+#include "ColorInstancedVertexShader.h"
+#include "ColorPixelShader.h"
+
+namespace
+{
+    struct EmbeddedShader
+    {
+        const char* name;
+        const BYTE* data;
+        size_t size;
+    };
+
+    // In ShaderLibraryClass::Shader order.
+    const EmbeddedShader EMBEDDED_SHADERS[ShaderLibraryClass::SHADER_COUNT] =
+    {
+        { "ColorVertexShader", g_ColorVertexShader, sizeof(g_ColorVertexShader) },
+        { "ColorInstancedVertexShader", g_ColorInstancedVertexShader, sizeof(g_ColorInstancedVertexShader) },
+        { "ColorPixelShader", g_ColorPixelShader, sizeof(g_ColorPixelShader) }
+    };
+
+    // A DXBC container starts with its magic, a 16 byte checksum of the rest, a version of 1 and its total size.
+    const unsigned int DXBC_MAGIC = 0x43425844; // "DXBC"
+    const size_t DXBC_CHECKSUM_OFFSET = 4;
+    const size_t DXBC_SIZE_OFFSET = 24;
+    const size_t DXBC_HEADER_SIZE = 32;
+}
+
+ShaderLibraryClass::ShaderLibraryClass()
+{
+    memset(m_shaders, 0, sizeof(m_shaders));
+}
+
+ShaderLibraryClass::~ShaderLibraryClass()
+{
+}
+
+void ShaderLibraryClass::Initialize()
+{
+    PROFILE_FUNCTION();
+
+    size_t totalSize = 0;
+    for (int shader = 0; shader < SHADER_COUNT; shader++)
+    {
+        const EmbeddedShader& embedded = EMBEDDED_SHADERS[shader];
+        try
+        {
+            m_shaders[shader].key = GetKey(embedded.data, embedded.size);
+        }
+        catch (engine_exception& e)
+        {
+            throw engine_exception("Embedded shader ") << embedded.name << " is broken: " << e.what();
+        }
+        m_shaders[shader].data = embedded.data;
+        m_shaders[shader].size = embedded.size;
+        totalSize += embedded.size;
+    }
+
+    LOG_INFO("Shader library: {} embedded shaders, {} bytes", (int)SHADER_COUNT, totalSize);
+}
+
+ShaderLibraryClass::Bytecode ShaderLibraryClass::Load(const Shader shader) const
+{
+    if (shader < 0 || shader >= SHADER_COUNT || m_shaders[shader].data == nullptr)
+    {
+        throw engine_exception("No shader ") << (int)shader << " in the library";
+    }
+    return m_shaders[shader];
+}
+
+unsigned long long ShaderLibraryClass::GetKey(const void* data, const size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    unsigned int magic, containerSize;
+    if (data == nullptr || size < DXBC_HEADER_SIZE)
+    {
+        throw engine_exception("Shader bytecode is too short for a DXBC header: ") << size << " bytes";
+    }
+    memcpy(&magic, bytes, sizeof(magic));
+    memcpy(&containerSize, bytes + DXBC_SIZE_OFFSET, sizeof(containerSize));
+    if (magic != DXBC_MAGIC || containerSize != size)
+    {
+        throw engine_exception("Shader bytecode isn't a DXBC container of ") << size << " bytes";
+    }
+
+    // Half the checksum is plenty to tell a handful of shaders apart.
+    unsigned long long key;
+    memcpy(&key, bytes + DXBC_CHECKSUM_OFFSET, sizeof(key));
+    return key;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "engine_core.h"
+
+using namespace std;
+
+// Compiled shader bytecode, embedded in the executable at build time: FxCompile writes each .hlsl file as a header
+// (/Fh) that shaderlibraryclass.cpp includes, so nothing is read or compiled at run time. Each shader is keyed by the
+// checksum the compiler wrote into its DXBC header, which changes with the source, defines and flags it was built with.
+// Lookups index a table.
+class ShaderLibraryClass
+{
+public:
+    enum Shader
+    {
+        SHADER_COLOR_VERTEX,
+        SHADER_COLOR_INSTANCED_VERTEX,
+        SHADER_COLOR_PIXEL,
+        SHADER_COUNT
+    };
+
+    struct Bytecode
+    {
+        const void* data;
+        size_t size;
+        unsigned long long key; // Zero for empty bytecode.
+    };
+
+    ShaderLibraryClass();
+
+    ~ShaderLibraryClass();
+
+    // Checks the embedded bytecode is whole and reads the keys out of it.
+    void Initialize();
+
+    // The bytes are static, so they stay valid after the library is gone. Safe to call from several threads at once.
+    Bytecode Load(const Shader shader) const;
+
+    // Reads the compiler's checksum out of a DXBC blob, throwing when the blob isn't one.
+    static unsigned long long GetKey(const void* data, const size_t size);
+
+private:
+    Bytecode m_shaders[SHADER_COUNT];
+};
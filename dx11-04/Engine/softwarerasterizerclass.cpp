@@ -0,0 +1,748 @@
+#include "softwarerasterizerclass.h"
+
+namespace
+{
+    // Number of set bits in a 4-bit SSE movemask.
+    const int MASK_BIT_COUNT[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+    // Vertices and triangles handed to each setup job; small draws stay on the calling thread.
+    const int VERTICES_PER_JOB = 4096;
+    const int TRIANGLES_PER_JOB = 1024;
+
+    unsigned int PackColor(float red, float green, float blue, float alpha)
+    {
+        unsigned int r = (unsigned int)(min(max(red, 0.0f), 1.0f) * 255.0f + 0.5f);
+        unsigned int g = (unsigned int)(min(max(green, 0.0f), 1.0f) * 255.0f + 0.5f);
+        unsigned int b = (unsigned int)(min(max(blue, 0.0f), 1.0f) * 255.0f + 0.5f);
+        unsigned int a = (unsigned int)(min(max(alpha, 0.0f), 1.0f) * 255.0f + 0.5f);
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    // Converts four lanes of [0, 1] floats per channel into four R8G8B8A8 pixels.
+    __m128i PackColors(__m128 red, __m128 green, __m128 blue, __m128 alpha)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+
+        __m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(red, zero), one), scale), half));
+        __m128i g = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(green, zero), one), scale), half));
+        __m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(blue, zero), one), scale), half));
+        __m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(alpha, zero), one), scale), half));
+
+        return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+    }
+
+    struct SyntheticVertex
+    {
+        XMFLOAT3 position;
+        XMFLOAT4 color;
+    };
+
+    // Covers width x height pixels with cell x cell squares, each split into two clockwise triangles, clipped to the screen
+    // at the right and bottom. The positions are given in clip space for identity transforms; with power of two screen
+    // sizes every vertex lands exactly on a pixel corner. Each triangle is nearer than the one before, so a pixel covered
+    // twice passes the depth test twice and shows up in the pixel count.
+    void BuildTiling(const int width, const int height, const int cell, vector<SyntheticVertex>& vertices, vector<unsigned int>& indices)
+    {
+        vertices.clear();
+        indices.clear();
+
+        int cellsX = (width + cell - 1) / cell;
+        int cellsY = (height + cell - 1) / cell;
+        float depthStep = 1.0f / (float)(cellsX * cellsY * 2 + 1);
+
+        for (int y = 0; y < cellsY; y++)
+        {
+            for (int x = 0; x < cellsX; x++)
+            {
+                float left = (float)(x * cell) * 2.0f / width - 1.0f;
+                float right = (float)min((x + 1) * cell, width) * 2.0f / width - 1.0f;
+                float top = 1.0f - (float)(y * cell) * 2.0f / height;
+                float bottom = 1.0f - (float)min((y + 1) * cell, height) * 2.0f / height;
+                XMFLOAT4 color((float)(x & 1), (float)(y & 1), 0.5f, 1.0f);
+
+                const XMFLOAT2 corners[6] =
+                {
+                    XMFLOAT2(left, top), XMFLOAT2(right, top), XMFLOAT2(left, bottom),
+                    XMFLOAT2(right, top), XMFLOAT2(right, bottom), XMFLOAT2(left, bottom)
+                };
+                for (int i = 0; i < 6; i++)
+                {
+                    float depth = 1.0f - depthStep * (float)(vertices.size() / 3 + 1);
+                    SyntheticVertex vertex = { XMFLOAT3(corners[i].x, corners[i].y, depth), color };
+                    indices.push_back((unsigned int)vertices.size());
+                    vertices.push_back(vertex);
+                }
+            }
+        }
+    }
+}
+
+SoftwareRasterizerClass::SoftwareRasterizerClass()
+{
+    m_hwnd = NULL;
+    m_width = m_height = m_rowPitch = 0;
+    m_tilesX = m_tilesY = 0;
+    m_colorBuffer = nullptr;
+    m_depthBuffer = nullptr;
+    m_clearColor = 0;
+    m_clearPending = false;
+    m_chunkCount = 0;
+    m_job = nullptr;
+    m_jobCount = 0;
+    m_nextJob = 0;
+    m_jobsRemaining = 0;
+    m_jobGeneration = 0;
+    m_activeWorkers = 0;
+    m_shuttingDown = false;
+    ZeroMemory(&m_statistics, sizeof(m_statistics));
+}
+
+SoftwareRasterizerClass::~SoftwareRasterizerClass()
+{
+    Shutdown();
+}
+
+void SoftwareRasterizerClass::Initialize(const int screenWidth, const int screenHeight, const HWND hwnd)
+{
+    m_hwnd = hwnd;
+    m_width = screenWidth;
+    m_height = screenHeight;
+
+    // Pad the surfaces out to whole tiles so the tile loop never has to special case the right and bottom edges.
+    m_tilesX = (screenWidth + TILE_SIZE - 1) / TILE_SIZE;
+    m_tilesY = (screenHeight + TILE_SIZE - 1) / TILE_SIZE;
+    m_rowPitch = m_tilesX * TILE_SIZE;
+
+    size_t pixelCount = (size_t)m_rowPitch * m_tilesY * TILE_SIZE;
+    m_colorBuffer = static_cast<unsigned int*>(_aligned_malloc(pixelCount * sizeof(unsigned int), 16));
+    m_depthBuffer = static_cast<float*>(_aligned_malloc(pixelCount * sizeof(float), 16));
+    if (m_colorBuffer == nullptr || m_depthBuffer == nullptr)
+    {
+        throw engine_exception("Couldn't allocate software render target of ") << screenWidth << " x " << screenHeight;
+    }
+
+    ZeroMemory(m_colorBuffer, pixelCount * sizeof(unsigned int));
+
+    // Use every core; the calling thread takes part in each dispatch so only n - 1 workers are started.
+    int threadCount = (int)thread::hardware_concurrency();
+    StartWorkers(threadCount > 0 ? threadCount : 1);
+
+    QueryPerformanceFrequency(&m_frequency);
+
+    LOG_INFO("Software rasterizer = {} x {}, {} tiles, {} threads", m_width, m_height, m_tilesX * m_tilesY, GetThreadCount());
+}
+
+void SoftwareRasterizerClass::Shutdown()
+{
+    {
+        lock_guard<mutex> lock(m_jobMutex);
+        m_shuttingDown = true;
+    }
+    m_jobStart.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+
+    if (m_colorBuffer)
+    {
+        _aligned_free(m_colorBuffer);
+        m_colorBuffer = nullptr;
+    }
+
+    if (m_depthBuffer)
+    {
+        _aligned_free(m_depthBuffer);
+        m_depthBuffer = nullptr;
+    }
+}
+
+void SoftwareRasterizerClass::BeginScene(float red, float green, float blue, float alpha)
+{
+    QueryPerformanceCounter(&m_frameStart);
+
+    // The clear is done per tile by the workers at the end of the frame.
+    m_clearColor = PackColor(red, green, blue, alpha);
+    m_clearPending = true;
+    m_chunkCount = 0;
+}
+
+void SoftwareRasterizerClass::DrawIndexed(const void* vertices, const unsigned int vertexStride, const unsigned int vertexCount,
+                                          const unsigned int* indices, const int indexCount,
+                                          const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection)
+{
+    // Vertex stage: the equivalent of ColorVertexShader.hlsl, with the three matrices folded into one.
+    XMMATRIX worldViewProjection = world * view * projection;
+    const unsigned char* vertexBytes = static_cast<const unsigned char*>(vertices);
+
+    if (m_clipVertices.size() < vertexCount)
+    {
+        m_clipVertices.resize(vertexCount);
+    }
+
+    int vertexJobs = ((int)vertexCount + VERTICES_PER_JOB - 1) / VERTICES_PER_JOB;
+    Dispatch(vertexJobs, [&](int job, int)
+    {
+        unsigned int first = job * VERTICES_PER_JOB;
+        unsigned int last = min(first + VERTICES_PER_JOB, vertexCount);
+        for (unsigned int i = first; i < last; i++)
+        {
+            const XMFLOAT3* position = reinterpret_cast<const XMFLOAT3*>(vertexBytes + i * vertexStride);
+            const XMFLOAT4* color = reinterpret_cast<const XMFLOAT4*>(vertexBytes + i * vertexStride + sizeof(XMFLOAT3));
+
+            XMStoreFloat4(&m_clipVertices[i].position, XMVector3Transform(XMLoadFloat3(position), worldViewProjection));
+            m_clipVertices[i].color = *color;
+        }
+    });
+
+    // Setup and binning: each job gets its own chunk so bins stay in submission order without any locking.
+    int triangleCount = indexCount / 3;
+    int triangleJobs = (triangleCount + TRIANGLES_PER_JOB - 1) / TRIANGLES_PER_JOB;
+    unsigned int firstChunk = m_chunkCount;
+    for (int i = 0; i < triangleJobs; i++)
+    {
+        AcquireChunk();
+    }
+
+    Dispatch(triangleJobs, [&](int job, int)
+    {
+        int first = job * TRIANGLES_PER_JOB;
+        int last = min(first + TRIANGLES_PER_JOB, triangleCount);
+        SetupTriangles(indices, first, last, *m_chunks[firstChunk + job]);
+    });
+}
+
+void SoftwareRasterizerClass::EndScene()
+{
+    // Rasterize every tile in parallel; each tile walks the chunks in order so draw order is preserved.
+    Dispatch(m_tilesX * m_tilesY, [this](int tile, int worker)
+    {
+        RasterizeTile(tile, worker);
+    });
+    m_clearPending = false;
+
+    UpdateStatistics();
+
+    Present();
+}
+
+const unsigned int* SoftwareRasterizerClass::GetColorBuffer()
+{
+    return m_colorBuffer;
+}
+
+int SoftwareRasterizerClass::GetRowPitch()
+{
+    return m_rowPitch;
+}
+
+int SoftwareRasterizerClass::GetThreadCount()
+{
+    return (int)m_workers.size() + 1;
+}
+
+void SoftwareRasterizerClass::StartWorkers(const int threadCount)
+{
+    m_workerPixels.assign(threadCount, 0);
+
+    for (int i = 1; i < threadCount; i++)
+    {
+        m_workers.push_back(thread(&SoftwareRasterizerClass::WorkerThread, this, i));
+    }
+}
+
+void SoftwareRasterizerClass::WorkerThread(const int workerIndex)
+{
+    unsigned int generation = 0;
+
+    for (;;)
+    {
+        {
+            unique_lock<mutex> lock(m_jobMutex);
+            m_jobStart.wait(lock, [&] { return m_shuttingDown || m_jobGeneration != generation; });
+            if (m_shuttingDown)
+            {
+                return;
+            }
+
+            generation = m_jobGeneration;
+            m_activeWorkers++;
+        }
+
+        RunJobs(workerIndex);
+
+        {
+            lock_guard<mutex> lock(m_jobMutex);
+            m_activeWorkers--;
+        }
+        m_jobDone.notify_all();
+    }
+}
+
+void SoftwareRasterizerClass::Dispatch(const int jobCount, const function<void(int, int)>& job)
+{
+    if (jobCount <= 0)
+    {
+        return;
+    }
+
+    // A single job isn't worth waking the workers for.
+    if (jobCount == 1 || m_workers.empty())
+    {
+        for (int i = 0; i < jobCount; i++)
+        {
+            job(i, 0);
+        }
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(m_jobMutex);
+        m_job = &job;
+        m_jobCount = jobCount;
+        m_nextJob = 0;
+        m_jobsRemaining = jobCount;
+        m_jobGeneration++;
+    }
+    m_jobStart.notify_all();
+
+    RunJobs(0);
+
+    // Wait for the jobs to finish and for every worker to leave RunJobs so the job can safely go out of scope.
+    unique_lock<mutex> lock(m_jobMutex);
+    m_jobDone.wait(lock, [this] { return m_jobsRemaining == 0 && m_activeWorkers == 0; });
+    m_job = nullptr;
+}
+
+void SoftwareRasterizerClass::RunJobs(const int workerIndex)
+{
+    for (;;)
+    {
+        int job = m_nextJob++;
+        if (job >= m_jobCount)
+        {
+            return;
+        }
+
+        (*m_job)(job, workerIndex);
+
+        if (--m_jobsRemaining == 0)
+        {
+            lock_guard<mutex> lock(m_jobMutex);
+            m_jobDone.notify_all();
+        }
+    }
+}
+
+SoftwareRasterizerClass::BinnedChunk* SoftwareRasterizerClass::AcquireChunk()
+{
+    // Chunks are recycled between frames so their vectors keep their capacity.
+    if (m_chunkCount == m_chunks.size())
+    {
+        unique_ptr<BinnedChunk> chunk(new BinnedChunk());
+        chunk->tileBins.resize(m_tilesX * m_tilesY);
+        m_chunks.push_back(move(chunk));
+    }
+
+    BinnedChunk* chunk = m_chunks[m_chunkCount++].get();
+    chunk->triangles.clear();
+    for (auto& bin : chunk->tileBins)
+    {
+        bin.clear();
+    }
+
+    return chunk;
+}
+
+void SoftwareRasterizerClass::SetupTriangles(const unsigned int* indices, const int firstTriangle, const int lastTriangle, BinnedChunk& chunk)
+{
+    for (int t = firstTriangle; t < lastTriangle; t++)
+    {
+        const ClipVertex* v[3] = { &m_clipVertices[indices[t * 3]], &m_clipVertices[indices[t * 3 + 1]], &m_clipVertices[indices[t * 3 + 2]] };
+
+        // Trivially reject triangles with all three vertices outside the same clip plane.
+        unsigned int outcode = ~0u;
+        for (int i = 0; i < 3; i++)
+        {
+            const XMFLOAT4& p = v[i]->position;
+            outcode &= (p.x < -p.w ? 1 : 0) | (p.x > p.w ? 2 : 0) | (p.y < -p.w ? 4 : 0) | (p.y > p.w ? 8 : 0) | (p.z < 0.0f ? 16 : 0) | (p.z > p.w ? 32 : 0);
+        }
+        if (outcode != 0)
+        {
+            continue;
+        }
+
+        // Clip against the near plane (z >= 0 in D3D clip space), which can turn the triangle into a quad.
+        ClipVertex polygon[4];
+        int polygonCount = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            const ClipVertex& a = *v[i];
+            const ClipVertex& b = *v[(i + 1) % 3];
+            bool aInside = a.position.z >= 0.0f;
+            bool bInside = b.position.z >= 0.0f;
+
+            if (aInside)
+            {
+                polygon[polygonCount++] = a;
+            }
+
+            if (aInside != bInside)
+            {
+                float t = a.position.z / (a.position.z - b.position.z);
+                XMStoreFloat4(&polygon[polygonCount].position, XMVectorLerp(XMLoadFloat4(&a.position), XMLoadFloat4(&b.position), t));
+                XMStoreFloat4(&polygon[polygonCount].color, XMVectorLerp(XMLoadFloat4(&a.color), XMLoadFloat4(&b.color), t));
+                polygonCount++;
+            }
+        }
+
+        for (int i = 2; i < polygonCount; i++)
+        {
+            SetupTriangle(polygon[0], polygon[i - 1], polygon[i], chunk);
+        }
+    }
+}
+
+void SoftwareRasterizerClass::SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, BinnedChunk& chunk)
+{
+    const ClipVertex* v[3] = { &v0, &v1, &v2 };
+    float x[3], y[3];
+    TriangleSetup triangle;
+
+    // Perspective divide and viewport transform.
+    for (int i = 0; i < 3; i++)
+    {
+        float invW = 1.0f / v[i]->position.w;
+        x[i] = (v[i]->position.x * invW * 0.5f + 0.5f) * m_width;
+        y[i] = (0.5f - v[i]->position.y * invW * 0.5f) * m_height;
+        triangle.z[i] = v[i]->position.z * invW;
+        triangle.invW[i] = invW;
+        XMStoreFloat4(&triangle.colorOverW[i], XMVectorScale(XMLoadFloat4(&v[i]->color), invW));
+    }
+
+    // Clockwise triangles are front facing (FrontCounterClockwise = false), so cull anything with a non-positive area.
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (!(area > 0.0f))
+    {
+        return;
+    }
+    triangle.invArea = 1.0f / area;
+
+    // Edge i is opposite vertex i, so its value divided by the area is that vertex's barycentric weight.
+    for (int i = 0; i < 3; i++)
+    {
+        int a = (i + 1) % 3;
+        int b = (i + 2) % 3;
+        triangle.edgeA[i] = y[a] - y[b];
+        triangle.edgeB[i] = x[b] - x[a];
+        triangle.edgeX[i] = x[a];
+        triangle.edgeY[i] = y[a];
+
+        // Top-left fill rule: pixels exactly on an edge belong to the triangle only for top and left edges.
+        triangle.edgeTopLeft[i] = triangle.edgeA[i] > 0.0f || (triangle.edgeA[i] == 0.0f && triangle.edgeB[i] > 0.0f);
+    }
+
+    float minX = min(x[0], min(x[1], x[2]));
+    float maxX = max(x[0], max(x[1], x[2]));
+    float minY = min(y[0], min(y[1], y[2]));
+    float maxY = max(y[0], max(y[1], y[2]));
+    triangle.minX = max(0, (int)floorf(minX));
+    triangle.minY = max(0, (int)floorf(minY));
+    triangle.maxX = min(m_width - 1, (int)ceilf(maxX));
+    triangle.maxY = min(m_height - 1, (int)ceilf(maxY));
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+    {
+        return;
+    }
+
+    unsigned int index = (unsigned int)chunk.triangles.size();
+    chunk.triangles.push_back(triangle);
+
+    for (int ty = triangle.minY / TILE_SIZE; ty <= triangle.maxY / TILE_SIZE; ty++)
+    {
+        for (int tx = triangle.minX / TILE_SIZE; tx <= triangle.maxX / TILE_SIZE; tx++)
+        {
+            chunk.tileBins[ty * m_tilesX + tx].push_back(index);
+        }
+    }
+}
+
+void SoftwareRasterizerClass::RasterizeTile(const int tileIndex, const int workerIndex)
+{
+    int tileMinX = (tileIndex % m_tilesX) * TILE_SIZE;
+    int tileMinY = (tileIndex / m_tilesX) * TILE_SIZE;
+    int tileMaxX = tileMinX + TILE_SIZE - 1;
+    int tileMaxY = tileMinY + TILE_SIZE - 1;
+
+    if (m_clearPending)
+    {
+        __m128i color = _mm_set1_epi32((int)m_clearColor);
+        __m128 depth = _mm_set1_ps(1.0f);
+        for (int y = tileMinY; y <= tileMaxY; y++)
+        {
+            for (int x = tileMinX; x <= tileMaxX; x += 4)
+            {
+                _mm_store_si128(reinterpret_cast<__m128i*>(m_colorBuffer + y * m_rowPitch + x), color);
+                _mm_store_ps(m_depthBuffer + y * m_rowPitch + x, depth);
+            }
+        }
+    }
+
+    unsigned long long pixels = 0;
+    for (unsigned int c = 0; c < m_chunkCount; c++)
+    {
+        const BinnedChunk& chunk = *m_chunks[c];
+        for (unsigned int index : chunk.tileBins[tileIndex])
+        {
+            RasterizeTriangle(chunk.triangles[index], tileMinX, tileMinY, tileMaxX, tileMaxY, pixels);
+        }
+    }
+
+    m_workerPixels[workerIndex] += pixels;
+}
+
+void SoftwareRasterizerClass::RasterizeTriangle(const TriangleSetup& triangle, const int tileMinX, const int tileMinY,
+                                                const int tileMaxX, const int tileMaxY, unsigned long long& pixels)
+{
+    int minX = max(triangle.minX, tileMinX) & ~3;
+    int maxX = min(triangle.maxX, tileMaxX);
+    int minY = max(triangle.minY, tileMinY);
+    int maxY = min(triangle.maxY, tileMaxY);
+
+    const __m128 laneOffset = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    const __m128i laneIndex = _mm_set_epi32(3, 2, 1, 0);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i lastColumn = _mm_set1_epi32(triangle.maxX);
+
+    __m128 edgeA[3], edgeStep[3], topLeft[3];
+    for (int i = 0; i < 3; i++)
+    {
+        edgeA[i] = _mm_set1_ps(triangle.edgeA[i]);
+        edgeStep[i] = _mm_set1_ps(triangle.edgeA[i] * 4.0f);
+        topLeft[i] = _mm_castsi128_ps(_mm_set1_epi32(triangle.edgeTopLeft[i] ? -1 : 0));
+    }
+
+    const __m128 invArea = _mm_set1_ps(triangle.invArea);
+    const __m128 z0 = _mm_set1_ps(triangle.z[0]), z1 = _mm_set1_ps(triangle.z[1]), z2 = _mm_set1_ps(triangle.z[2]);
+    const __m128 w0 = _mm_set1_ps(triangle.invW[0]), w1 = _mm_set1_ps(triangle.invW[1]), w2 = _mm_set1_ps(triangle.invW[2]);
+    const XMFLOAT4* c = triangle.colorOverW;
+
+    for (int y = minY; y <= maxY; y++)
+    {
+        // Evaluate the edge functions at the centre of the first four pixels in the row, then step four pixels at a time.
+        __m128 px = _mm_add_ps(_mm_set1_ps((float)minX), laneOffset);
+        float py = (float)y + 0.5f;
+        __m128 edge[3];
+        for (int i = 0; i < 3; i++)
+        {
+            __m128 dx = _mm_sub_ps(px, _mm_set1_ps(triangle.edgeX[i]));
+            edge[i] = _mm_add_ps(_mm_mul_ps(edgeA[i], dx), _mm_set1_ps(triangle.edgeB[i] * (py - triangle.edgeY[i])));
+        }
+
+        unsigned int* colorRow = m_colorBuffer + y * m_rowPitch;
+        float* depthRow = m_depthBuffer + y * m_rowPitch;
+
+        for (int x = minX; x <= maxX; x += 4)
+        {
+            __m128 inside = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_add_epi32(_mm_set1_epi32(x), laneIndex), lastColumn));
+            inside = _mm_andnot_ps(inside, _mm_castsi128_ps(_mm_set1_epi32(-1)));
+            for (int i = 0; i < 3; i++)
+            {
+                __m128 onOrInside = _mm_or_ps(_mm_and_ps(topLeft[i], _mm_cmpge_ps(edge[i], zero)), _mm_andnot_ps(topLeft[i], _mm_cmpgt_ps(edge[i], zero)));
+                inside = _mm_and_ps(inside, onOrInside);
+            }
+
+            if (_mm_movemask_ps(inside) != 0)
+            {
+                __m128 b0 = _mm_mul_ps(edge[0], invArea);
+                __m128 b1 = _mm_mul_ps(edge[1], invArea);
+                __m128 b2 = _mm_mul_ps(edge[2], invArea);
+
+                // Depth test (D3D11_COMPARISON_LESS); z/w is affine in screen space so it interpolates directly.
+                __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, z0), _mm_mul_ps(b1, z1)), _mm_mul_ps(b2, z2));
+                __m128 depth = _mm_load_ps(depthRow + x);
+                __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, depth));
+                int passMask = _mm_movemask_ps(pass);
+
+                if (passMask != 0)
+                {
+                    _mm_store_ps(depthRow + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, depth)));
+
+                    // Pixel stage: the perspective correct interpolated vertex colour, as ColorPixelShader.hlsl returns it.
+                    __m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, w0), _mm_mul_ps(b1, w1)), _mm_mul_ps(b2, w2));
+                    __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), w);
+                    __m128 red = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(c[0].x)), _mm_mul_ps(b1, _mm_set1_ps(c[1].x))), _mm_mul_ps(b2, _mm_set1_ps(c[2].x))), invW);
+                    __m128 green = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(c[0].y)), _mm_mul_ps(b1, _mm_set1_ps(c[1].y))), _mm_mul_ps(b2, _mm_set1_ps(c[2].y))), invW);
+                    __m128 blue = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(c[0].z)), _mm_mul_ps(b1, _mm_set1_ps(c[1].z))), _mm_mul_ps(b2, _mm_set1_ps(c[2].z))), invW);
+                    __m128 alpha = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(c[0].w)), _mm_mul_ps(b1, _mm_set1_ps(c[1].w))), _mm_mul_ps(b2, _mm_set1_ps(c[2].w))), invW);
+
+                    __m128i* colorPtr = reinterpret_cast<__m128i*>(colorRow + x);
+                    __m128i passBits = _mm_castps_si128(pass);
+                    __m128i color = _mm_or_si128(_mm_and_si128(passBits, PackColors(red, green, blue, alpha)), _mm_andnot_si128(passBits, _mm_load_si128(colorPtr)));
+                    _mm_store_si128(colorPtr, color);
+
+                    pixels += MASK_BIT_COUNT[passMask];
+                }
+            }
+
+            for (int i = 0; i < 3; i++)
+            {
+                edge[i] = _mm_add_ps(edge[i], edgeStep[i]);
+            }
+        }
+    }
+}
+
+void SoftwareRasterizerClass::Present()
+{
+    // Headless nodes have no window, in which case the frame just stays in the colour buffer.
+    if (m_hwnd == NULL)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    // Describe the colour buffer as a top-down 32-bit DIB with R8G8B8A8 channel masks.
+    struct
+    {
+        BITMAPINFOHEADER header;
+        DWORD masks[3];
+    } bitmapInfo;
+    ZeroMemory(&bitmapInfo, sizeof(bitmapInfo));
+    bitmapInfo.header.biSize = sizeof(BITMAPINFOHEADER);
+    bitmapInfo.header.biWidth = m_rowPitch;
+    bitmapInfo.header.biHeight = -m_height;
+    bitmapInfo.header.biPlanes = 1;
+    bitmapInfo.header.biBitCount = 32;
+    bitmapInfo.header.biCompression = BI_BITFIELDS;
+    bitmapInfo.masks[0] = 0x000000FF;
+    bitmapInfo.masks[1] = 0x0000FF00;
+    bitmapInfo.masks[2] = 0x00FF0000;
+
+    HDC hdc = GetDC(m_hwnd);
+    StretchDIBits(hdc, 0, 0, m_width, m_height, 0, 0, m_width, m_height, m_colorBuffer,
+                  reinterpret_cast<BITMAPINFO*>(&bitmapInfo), DIB_RGB_COLORS, SRCCOPY);
+    ReleaseDC(m_hwnd, hdc);
+#endif
+}
+
+void SoftwareRasterizerClass::UpdateStatistics()
+{
+    LARGE_INTEGER frameEnd;
+    QueryPerformanceCounter(&frameEnd);
+    m_statistics.seconds += (double)(frameEnd.QuadPart - m_frameStart.QuadPart) / (double)m_frequency.QuadPart;
+
+    for (unsigned int c = 0; c < m_chunkCount; c++)
+    {
+        m_statistics.triangles += m_chunks[c]->triangles.size();
+    }
+
+    for (auto& pixels : m_workerPixels)
+    {
+        m_statistics.pixels += pixels;
+        pixels = 0;
+    }
+
+    // Report throughput periodically so headless nodes can be sized from the log.
+    if (++m_statistics.frames == STATISTICS_FRAMES)
+    {
+        LOG_INFO("Software rasterizer: {} triangles/sec, {} pixels/sec, {} ms/frame on {} threads", m_statistics.triangles / m_statistics.seconds,
+                 m_statistics.pixels / m_statistics.seconds, m_statistics.seconds * 1000.0 / m_statistics.frames, GetThreadCount());
+        ZeroMemory(&m_statistics, sizeof(m_statistics));
+    }
+}
+
+void SoftwareRasterizerClass::Validate()
+{
+    const struct
+    {
+        int width, height;
+    } screens[] = { { 256, 128 }, { 32, 32 } };
+    const int cells[] = { 1, 3, 16, 64, 100 };
+
+    vector<SyntheticVertex> vertices;
+    vector<unsigned int> indices;
+    for (const auto& screen : screens)
+    {
+        SoftwareRasterizerClass rasterizer;
+        rasterizer.Initialize(screen.width, screen.height, NULL);
+
+        for (const int cell : cells)
+        {
+            BuildTiling(screen.width, screen.height, cell, vertices, indices);
+
+            rasterizer.BeginScene(0.0f, 0.0f, 0.0f, 0.0f);
+            rasterizer.DrawIndexed(vertices.data(), sizeof(SyntheticVertex), (unsigned int)vertices.size(), indices.data(), (int)indices.size(),
+                                   XMMatrixIdentity(), XMMatrixIdentity(), XMMatrixIdentity());
+            rasterizer.EndScene();
+
+            unsigned long long expected = (unsigned long long)screen.width * screen.height;
+            if (rasterizer.m_statistics.triangles != indices.size() / 3 || rasterizer.m_statistics.pixels != expected)
+            {
+                throw engine_exception("Software rasterizer validation: ") << cell << " pixel cells on " << screen.width << " x " << screen.height
+                    << " gave " << rasterizer.m_statistics.triangles << " triangles and " << rasterizer.m_statistics.pixels << " pixels, expected "
+                    << indices.size() / 3 << " and " << expected;
+            }
+
+            for (int y = 0; y < screen.height; y++)
+            {
+                for (int x = 0; x < screen.width; x++)
+                {
+                    if (rasterizer.m_colorBuffer[y * rasterizer.m_rowPitch + x] == 0)
+                    {
+                        throw engine_exception("Software rasterizer validation: ") << cell << " pixel cells left pixel " << x << ", " << y << " empty";
+                    }
+                }
+            }
+
+            ZeroMemory(&rasterizer.m_statistics, sizeof(rasterizer.m_statistics));
+        }
+    }
+}
+
+void SoftwareRasterizerClass::Benchmark(const int frames)
+{
+    const int width = 1024;
+    const int height = 512;
+    const int cells[] = { 4, 16, 64, 256 };
+
+    SoftwareRasterizerClass rasterizer;
+    rasterizer.Initialize(width, height, NULL);
+
+    vector<SyntheticVertex> vertices;
+    vector<unsigned int> indices;
+    for (const int cell : cells)
+    {
+        BuildTiling(width, height, cell, vertices, indices);
+
+        // One frame to size the clip vertices and chunks, then the measured ones; the totals are taken every frame so the
+        // periodic statistics log never fires in between.
+        Statistics total;
+        ZeroMemory(&total, sizeof(total));
+        for (int frame = -1; frame < frames; frame++)
+        {
+            rasterizer.BeginScene(0.0f, 0.0f, 0.0f, 0.0f);
+            rasterizer.DrawIndexed(vertices.data(), sizeof(SyntheticVertex), (unsigned int)vertices.size(), indices.data(), (int)indices.size(),
+                                   XMMatrixIdentity(), XMMatrixIdentity(), XMMatrixIdentity());
+            rasterizer.EndScene();
+
+            if (frame >= 0)
+            {
+                total.triangles += rasterizer.m_statistics.triangles;
+                total.pixels += rasterizer.m_statistics.pixels;
+                total.seconds += rasterizer.m_statistics.seconds;
+                total.frames++;
+            }
+            ZeroMemory(&rasterizer.m_statistics, sizeof(rasterizer.m_statistics));
+        }
+
+        LOG_INFO("Software rasterizer benchmark: {} x {} px triangles at {} x {}, {} triangles/sec, {} pixels/sec, {} ms/frame on {} threads", cell,
+                 cell, width, height, total.triangles / total.seconds, total.pixels / total.seconds, total.seconds * 1000.0 / total.frames,
+                 rasterizer.GetThreadCount());
+    }
+}
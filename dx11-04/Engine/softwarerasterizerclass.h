@@ -0,0 +1,138 @@
+#pragma once
+#include "engine_core.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+using namespace std;
+using namespace DirectX;
+
+// CPU implementation of the colour pipeline (ColorVertexShader.hlsl + ColorPixelShader.hlsl) for machines without a GPU.
+// Triangles are transformed and set up as they are submitted and binned into screen tiles; the tiles are then rasterized
+// in parallel across all cores at EndScene using SSE edge functions and a 32-bit float depth buffer.
+class SoftwareRasterizerClass
+{
+public:
+    SoftwareRasterizerClass();
+
+    ~SoftwareRasterizerClass();
+
+    void Initialize(const int screenWidth, const int screenHeight, const HWND hwnd);
+
+    void Shutdown();
+
+    void BeginScene(float red, float green, float blue, float alpha);
+
+    // Vertices must match the colour input layout: a float3 position at offset 0 followed by a float4 colour.
+    void DrawIndexed(const void* vertices, const unsigned int vertexStride, const unsigned int vertexCount,
+                     const unsigned int* indices, const int indexCount,
+                     const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection);
+
+    void EndScene();
+
+    // Returns the R8G8B8A8 colour buffer; rows are GetRowPitch() pixels apart.
+    const unsigned int* GetColorBuffer();
+
+    int GetRowPitch();
+
+    int GetThreadCount();
+
+    // Tiles the screen with triangles of a few sizes and checks that every pixel is covered exactly once, which the fill
+    // rule and the tile binning must guarantee for shared edges. Throws on a failure.
+    static void Validate();
+
+    // Rasterizes the same tiling headless with triangles from a few pixels to a quarter of the screen across, and logs
+    // triangles and pixels per second for each size.
+    static void Benchmark(const int frames);
+
+private:
+    static const int TILE_SIZE = 64;
+    static const int STATISTICS_FRAMES = 120;
+
+    struct ClipVertex
+    {
+        XMFLOAT4 position;
+        XMFLOAT4 color;
+    };
+
+    // Screen space triangle with everything the tile loop needs, laid out so the edge equations can be splatted into SSE registers.
+    struct TriangleSetup
+    {
+        float edgeA[3], edgeB[3];
+        float edgeX[3], edgeY[3];
+        int edgeTopLeft[3];
+        float z[3];
+        float invW[3];
+        XMFLOAT4 colorOverW[3];
+        float invArea;
+        int minX, minY, maxX, maxY;
+    };
+
+    // Output of one worker for one draw; bins hold indices into triangles for every tile.
+    struct BinnedChunk
+    {
+        vector<TriangleSetup> triangles;
+        vector<vector<unsigned int>> tileBins;
+    };
+
+    struct Statistics
+    {
+        unsigned long long triangles;
+        unsigned long long pixels;
+        double seconds;
+        int frames;
+    };
+
+    HWND m_hwnd;
+    int m_width, m_height, m_rowPitch;
+    int m_tilesX, m_tilesY;
+    unsigned int* m_colorBuffer;
+    float* m_depthBuffer;
+    unsigned int m_clearColor;
+    bool m_clearPending;
+    vector<ClipVertex> m_clipVertices;
+    vector<unique_ptr<BinnedChunk>> m_chunks;
+    unsigned int m_chunkCount;
+    vector<unsigned long long> m_workerPixels;
+    Statistics m_statistics;
+    LARGE_INTEGER m_frequency, m_frameStart;
+
+    vector<thread> m_workers;
+    mutex m_jobMutex;
+    condition_variable m_jobStart, m_jobDone;
+    const function<void(int, int)>* m_job;
+    int m_jobCount;
+    atomic<int> m_nextJob;
+    atomic<int> m_jobsRemaining;
+    unsigned int m_jobGeneration;
+    int m_activeWorkers;
+    bool m_shuttingDown;
+
+    void StartWorkers(const int threadCount);
+
+    void WorkerThread(const int workerIndex);
+
+    void Dispatch(const int jobCount, const function<void(int, int)>& job);
+
+    void RunJobs(const int workerIndex);
+
+    BinnedChunk* AcquireChunk();
+
+    void SetupTriangles(const unsigned int* indices, const int firstTriangle, const int lastTriangle, BinnedChunk& chunk);
+
+    void SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, BinnedChunk& chunk);
+
+    void RasterizeTile(const int tileIndex, const int workerIndex);
+
+    void RasterizeTriangle(const TriangleSetup& triangle, const int tileMinX, const int tileMinY,
+                           const int tileMaxX, const int tileMaxY, unsigned long long& pixels);
+
+    void Present();
+
+    void UpdateStatistics();
+};
@@ -0,0 +1,372 @@
+#include "statecacheclass.h"
+
+StateCacheClass::StateCacheClass()
+{
+    m_deviceContext = nullptr;
+    m_numViewports = 0;
+    m_numRenderTargets = 0;
+    m_issued = m_elided = 0;
+    m_totalIssued = m_totalElided = 0;
+    m_frames = 0;
+    Invalidate();
+}
+
+StateCacheClass::~StateCacheClass()
+{
+}
+
+void StateCacheClass::Initialize(ID3D11DeviceContext* deviceContext)
+{
+    m_deviceContext = deviceContext;
+
+    // Only a D3D11.1 runtime can bind part of a constant buffer; without it the *1 calls are unavailable.
+    m_deviceContext1.Reset();
+    deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)m_deviceContext1.GetAddressOf());
+    Invalidate();
+}
+
+void StateCacheClass::Invalidate()
+{
+    m_knownState = 0;
+    m_knownVertexBuffers = 0;
+    m_knownVSConstantBuffers = 0;
+    m_knownPSConstantBuffers = 0;
+    m_pipelineState = nullptr;
+}
+
+ID3D11DeviceContext* StateCacheClass::GetDeviceContext()
+{
+    return m_deviceContext;
+}
+
+bool StateCacheClass::IsRedundant(const unsigned int state, const bool unchanged)
+{
+    if ((m_knownState & state) != 0 && unchanged)
+    {
+        m_elided++;
+        return true;
+    }
+
+    if ((state & KNOWN_PIPELINE_STATE) != 0)
+    {
+        m_pipelineState = nullptr;
+    }
+
+    m_knownState |= state;
+    m_issued++;
+    return false;
+}
+
+void StateCacheClass::IASetInputLayout(ID3D11InputLayout* inputLayout)
+{
+    if (IsRedundant(KNOWN_INPUT_LAYOUT, inputLayout == m_inputLayout))
+    {
+        return;
+    }
+
+    m_inputLayout = inputLayout;
+    m_deviceContext->IASetInputLayout(inputLayout);
+}
+
+void StateCacheClass::IASetVertexBuffers(const unsigned int startSlot, const unsigned int numBuffers, ID3D11Buffer* const* buffers,
+                                         const unsigned int* strides, const unsigned int* offsets)
+{
+    // Narrow the call down to the slots that actually change.
+    unsigned int firstChanged = numBuffers, lastChanged = 0;
+    for (unsigned int i = 0; i < numBuffers; i++)
+    {
+        unsigned int slot = startSlot + i;
+        bool known = (m_knownVertexBuffers & (1u << slot)) != 0;
+        if (!known || m_vertexBuffers[slot] != buffers[i] || m_vertexStrides[slot] != strides[i] || m_vertexOffsets[slot] != offsets[i])
+        {
+            firstChanged = min(firstChanged, i);
+            lastChanged = i;
+        }
+    }
+
+    if (firstChanged == numBuffers)
+    {
+        m_elided++;
+        return;
+    }
+
+    for (unsigned int i = firstChanged; i <= lastChanged; i++)
+    {
+        unsigned int slot = startSlot + i;
+        m_vertexBuffers[slot] = buffers[i];
+        m_vertexStrides[slot] = strides[i];
+        m_vertexOffsets[slot] = offsets[i];
+        m_knownVertexBuffers |= 1u << slot;
+    }
+
+    m_issued++;
+    m_deviceContext->IASetVertexBuffers(startSlot + firstChanged, lastChanged - firstChanged + 1,
+                                        buffers + firstChanged, strides + firstChanged, offsets + firstChanged);
+}
+
+void StateCacheClass::IASetIndexBuffer(ID3D11Buffer* indexBuffer, const DXGI_FORMAT format, const unsigned int offset)
+{
+    if (IsRedundant(KNOWN_INDEX_BUFFER, indexBuffer == m_indexBuffer && format == m_indexFormat && offset == m_indexOffset))
+    {
+        return;
+    }
+
+    m_indexBuffer = indexBuffer;
+    m_indexFormat = format;
+    m_indexOffset = offset;
+    m_deviceContext->IASetIndexBuffer(indexBuffer, format, offset);
+}
+
+void StateCacheClass::IASetPrimitiveTopology(const D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    if (IsRedundant(KNOWN_TOPOLOGY, topology == m_topology))
+    {
+        return;
+    }
+
+    m_topology = topology;
+    m_deviceContext->IASetPrimitiveTopology(topology);
+}
+
+void StateCacheClass::VSSetShader(ID3D11VertexShader* vertexShader)
+{
+    if (IsRedundant(KNOWN_VERTEX_SHADER, vertexShader == m_vertexShader))
+    {
+        return;
+    }
+
+    m_vertexShader = vertexShader;
+    m_deviceContext->VSSetShader(vertexShader, NULL, 0);
+}
+
+void StateCacheClass::PSSetShader(ID3D11PixelShader* pixelShader)
+{
+    if (IsRedundant(KNOWN_PIXEL_SHADER, pixelShader == m_pixelShader))
+    {
+        return;
+    }
+
+    m_pixelShader = pixelShader;
+    m_deviceContext->PSSetShader(pixelShader, NULL, 0);
+}
+
+bool StateCacheClass::FilterConstantBuffers(ConstantBufferBinding* shadow, unsigned int& known, const unsigned int startSlot, const unsigned int numBuffers,
+                                            ID3D11Buffer* const* buffers, const unsigned int* firstConstants, const unsigned int* numConstants,
+                                            unsigned int& firstChanged, unsigned int& lastChanged)
+{
+    firstChanged = numBuffers;
+    lastChanged = 0;
+    for (unsigned int i = 0; i < numBuffers; i++)
+    {
+        unsigned int slot = startSlot + i;
+        unsigned int first = firstConstants ? firstConstants[i] : 0;
+        unsigned int count = numConstants ? numConstants[i] : 0;
+        if ((known & (1u << slot)) == 0 || shadow[slot].buffer != buffers[i] || shadow[slot].firstConstant != first || shadow[slot].numConstants != count)
+        {
+            firstChanged = min(firstChanged, i);
+            lastChanged = i;
+        }
+    }
+
+    if (firstChanged == numBuffers)
+    {
+        m_elided++;
+        return false;
+    }
+
+    for (unsigned int i = firstChanged; i <= lastChanged; i++)
+    {
+        ConstantBufferBinding& binding = shadow[startSlot + i];
+        binding.buffer = buffers[i];
+        binding.firstConstant = firstConstants ? firstConstants[i] : 0;
+        binding.numConstants = numConstants ? numConstants[i] : 0;
+        known |= 1u << (startSlot + i);
+    }
+
+    m_issued++;
+    return true;
+}
+
+void StateCacheClass::VSSetConstantBuffers(const unsigned int startSlot, const unsigned int numBuffers, ID3D11Buffer* const* buffers)
+{
+    unsigned int first, last;
+    if (FilterConstantBuffers(m_vsConstantBuffers, m_knownVSConstantBuffers, startSlot, numBuffers, buffers, nullptr, nullptr, first, last))
+    {
+        m_deviceContext->VSSetConstantBuffers(startSlot + first, last - first + 1, buffers + first);
+    }
+}
+
+void StateCacheClass::PSSetConstantBuffers(const unsigned int startSlot, const unsigned int numBuffers, ID3D11Buffer* const* buffers)
+{
+    unsigned int first, last;
+    if (FilterConstantBuffers(m_psConstantBuffers, m_knownPSConstantBuffers, startSlot, numBuffers, buffers, nullptr, nullptr, first, last))
+    {
+        m_deviceContext->PSSetConstantBuffers(startSlot + first, last - first + 1, buffers + first);
+    }
+}
+
+void StateCacheClass::VSSetConstantBuffers1(const unsigned int startSlot, const unsigned int numBuffers, ID3D11Buffer* const* buffers,
+                                            const unsigned int* firstConstants, const unsigned int* numConstants)
+{
+    if (!m_deviceContext1)
+    {
+        throw engine_exception("Binding constant buffer ranges needs a D3D11.1 device context");
+    }
+
+    unsigned int first, last;
+    if (FilterConstantBuffers(m_vsConstantBuffers, m_knownVSConstantBuffers, startSlot, numBuffers, buffers, firstConstants, numConstants, first, last))
+    {
+        m_deviceContext1->VSSetConstantBuffers1(startSlot + first, last - first + 1, buffers + first, firstConstants + first, numConstants + first);
+    }
+}
+
+void StateCacheClass::PSSetConstantBuffers1(const unsigned int startSlot, const unsigned int numBuffers, ID3D11Buffer* const* buffers,
+                                            const unsigned int* firstConstants, const unsigned int* numConstants)
+{
+    if (!m_deviceContext1)
+    {
+        throw engine_exception("Binding constant buffer ranges needs a D3D11.1 device context");
+    }
+
+    unsigned int first, last;
+    if (FilterConstantBuffers(m_psConstantBuffers, m_knownPSConstantBuffers, startSlot, numBuffers, buffers, firstConstants, numConstants, first, last))
+    {
+        m_deviceContext1->PSSetConstantBuffers1(startSlot + first, last - first + 1, buffers + first, firstConstants + first, numConstants + first);
+    }
+}
+
+bool StateCacheClass::SupportsConstantBufferOffsets()
+{
+    return m_deviceContext1.Get() != nullptr;
+}
+
+void StateCacheClass::RSSetState(ID3D11RasterizerState* rasterizerState)
+{
+    if (IsRedundant(KNOWN_RASTERIZER_STATE, rasterizerState == m_rasterizerState))
+    {
+        return;
+    }
+
+    m_rasterizerState = rasterizerState;
+    m_deviceContext->RSSetState(rasterizerState);
+}
+
+void StateCacheClass::RSSetViewports(const unsigned int numViewports, const D3D11_VIEWPORT* viewports)
+{
+    bool unchanged = numViewports == m_numViewports && numViewports <= MAX_VIEWPORTS && memcmp(viewports, m_viewports, numViewports * sizeof(D3D11_VIEWPORT)) == 0;
+    if (IsRedundant(KNOWN_VIEWPORTS, unchanged))
+    {
+        return;
+    }
+
+    m_numViewports = min(numViewports, MAX_VIEWPORTS);
+    memcpy(m_viewports, viewports, m_numViewports * sizeof(D3D11_VIEWPORT));
+    m_deviceContext->RSSetViewports(numViewports, viewports);
+}
+
+void StateCacheClass::OMSetRenderTargets(const unsigned int numViews, ID3D11RenderTargetView* const* renderTargetViews, ID3D11DepthStencilView* depthStencilView)
+{
+    bool unchanged = numViews == m_numRenderTargets && numViews <= MAX_RENDER_TARGETS && depthStencilView == m_depthStencilView;
+    for (unsigned int i = 0; i < numViews && unchanged; i++)
+    {
+        unchanged = renderTargetViews[i] == m_renderTargets[i];
+    }
+
+    if (IsRedundant(KNOWN_RENDER_TARGETS, unchanged))
+    {
+        return;
+    }
+
+    m_numRenderTargets = min(numViews, MAX_RENDER_TARGETS);
+    for (unsigned int i = 0; i < m_numRenderTargets; i++)
+    {
+        m_renderTargets[i] = renderTargetViews[i];
+    }
+    m_depthStencilView = depthStencilView;
+    m_deviceContext->OMSetRenderTargets(numViews, renderTargetViews, depthStencilView);
+}
+
+void StateCacheClass::OMSetDepthStencilState(ID3D11DepthStencilState* depthStencilState, const unsigned int stencilRef)
+{
+    if (IsRedundant(KNOWN_DEPTH_STENCIL_STATE, depthStencilState == m_depthStencilState && stencilRef == m_stencilRef))
+    {
+        return;
+    }
+
+    m_depthStencilState = depthStencilState;
+    m_stencilRef = stencilRef;
+    m_deviceContext->OMSetDepthStencilState(depthStencilState, stencilRef);
+}
+
+void StateCacheClass::OMSetBlendState(ID3D11BlendState* blendState, const float blendFactor[4], const unsigned int sampleMask)
+{
+    // A null blend factor means { 1, 1, 1, 1 } to D3D11, so compare it as that.
+    const float defaultFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    const float* factor = blendFactor ? blendFactor : defaultFactor;
+
+    bool unchanged = blendState == m_blendState && sampleMask == m_sampleMask && memcmp(factor, m_blendFactor, sizeof(m_blendFactor)) == 0;
+    if (IsRedundant(KNOWN_BLEND_STATE, unchanged))
+    {
+        return;
+    }
+
+    m_blendState = blendState;
+    m_sampleMask = sampleMask;
+    memcpy(m_blendFactor, factor, sizeof(m_blendFactor));
+    m_deviceContext->OMSetBlendState(blendState, factor, sampleMask);
+}
+
+void StateCacheClass::SetPipelineState(const PipelineCacheClass::PipelineState* pipelineState)
+{
+    if (pipelineState == m_pipelineState)
+    {
+        m_elided++;
+        return;
+    }
+
+    // Each piece is still filtered on its own, so switching between similar states only sets what they don't share.
+    RSSetState(pipelineState->rasterizerState);
+    OMSetDepthStencilState(pipelineState->depthStencilState, pipelineState->stencilRef);
+    OMSetBlendState(pipelineState->blendState, pipelineState->blendFactor, pipelineState->sampleMask);
+    VSSetShader(pipelineState->vertexShader);
+    PSSetShader(pipelineState->pixelShader);
+    IASetInputLayout(pipelineState->inputLayout);
+    IASetPrimitiveTopology(pipelineState->topology);
+    m_pipelineState = pipelineState;
+}
+
+void StateCacheClass::DrawIndexed(const unsigned int indexCount, const unsigned int startIndexLocation, const int baseVertexLocation)
+{
+    m_deviceContext->DrawIndexed(indexCount, startIndexLocation, baseVertexLocation);
+}
+
+void StateCacheClass::DrawIndexedInstanced(const unsigned int indexCountPerInstance, const unsigned int instanceCount, const unsigned int startIndexLocation,
+                                           const int baseVertexLocation, const unsigned int startInstanceLocation)
+{
+    m_deviceContext->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+}
+
+void StateCacheClass::EndFrame()
+{
+    m_totalIssued += m_issued;
+    m_totalElided += m_elided;
+    m_issued = m_elided = 0;
+
+    if (++m_frames == STATISTICS_FRAMES)
+    {
+        LOG_INFO("State cache: {} calls issued, {} elided per frame", (double)m_totalIssued / m_frames, (double)m_totalElided / m_frames);
+
+        m_totalIssued = m_totalElided = 0;
+        m_frames = 0;
+    }
+}
+
+unsigned int StateCacheClass::GetIssuedCalls()
+{
+    return m_issued;
+}
+
+unsigned int StateCacheClass::GetElidedCalls()
+{
+    return m_elided;
+}
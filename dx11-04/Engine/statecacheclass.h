@@ -0,0 +1,157 @@
+#pragma once
+#include "engine.h"
+#include "pipelinecacheclass.h"
+#include <d3d11_1.h>
+
+using namespace std;
+using namespace Microsoft::WRL;
+
+// Shadow copy of the pipeline state bound on a device context. Every Set call is compared against what is already bound
+// and dropped when nothing would change, so callers can set their full state for every draw without paying for it.
+// Anything that changes the context behind the cache's back must be followed by Invalidate().
+class StateCacheClass
+{
+public:
+    StateCacheClass();
+
+    ~StateCacheClass();
+
+    void Initialize(ID3D11DeviceContext* deviceContext);
+
+    // Forgets all shadowed state so the next call of every kind is issued.
+    void Invalidate();
+
+    // The wrapped context, for calls the cache doesn't filter (Map, Unmap, Clear...).
+    ID3D11DeviceContext* GetDeviceContext();
+
+    void IASetInputLayout(ID3D11InputLayout* inputLayout);
+
+    void IASetVertexBuffers(const unsigned int startSlot, const unsigned int numBuffers, ID3D11Buffer* const* buffers,
+                            const unsigned int* strides, const unsigned int* offsets);
+
+    void IASetIndexBuffer(ID3D11Buffer* indexBuffer, const DXGI_FORMAT format, const unsigned int offset);
+
+    void IASetPrimitiveTopology(const D3D11_PRIMITIVE_TOPOLOGY topology);
+
+    void VSSetShader(ID3D11VertexShader* vertexShader);
+
+    void PSSetShader(ID3D11PixelShader* pixelShader);
+
+    void VSSetConstantBuffers(const unsigned int startSlot, const unsigned int numBuffers, ID3D11Buffer* const* buffers);
+
+    void PSSetConstantBuffers(const unsigned int startSlot, const unsigned int numBuffers, ID3D11Buffer* const* buffers);
+
+    // Binds ranges of constant buffers, in 16 byte constants. Needs a D3D11.1 runtime; check SupportsConstantBufferOffsets().
+    void VSSetConstantBuffers1(const unsigned int startSlot, const unsigned int numBuffers, ID3D11Buffer* const* buffers,
+                               const unsigned int* firstConstants, const unsigned int* numConstants);
+
+    void PSSetConstantBuffers1(const unsigned int startSlot, const unsigned int numBuffers, ID3D11Buffer* const* buffers,
+                               const unsigned int* firstConstants, const unsigned int* numConstants);
+
+    bool SupportsConstantBufferOffsets();
+
+    void RSSetState(ID3D11RasterizerState* rasterizerState);
+
+    void RSSetViewports(const unsigned int numViewports, const D3D11_VIEWPORT* viewports);
+
+    void OMSetRenderTargets(const unsigned int numViews, ID3D11RenderTargetView* const* renderTargetViews, ID3D11DepthStencilView* depthStencilView);
+
+    void OMSetDepthStencilState(ID3D11DepthStencilState* depthStencilState, const unsigned int stencilRef);
+
+    void OMSetBlendState(ID3D11BlendState* blendState, const float blendFactor[4], const unsigned int sampleMask);
+
+    // Binds every piece of a pipeline state that differs from what is bound. Binding the handle that is already bound
+    // costs one comparison, unless one of its pieces has been set on its own since.
+    void SetPipelineState(const PipelineCacheClass::PipelineState* pipelineState);
+
+    void DrawIndexed(const unsigned int indexCount, const unsigned int startIndexLocation, const int baseVertexLocation);
+
+    void DrawIndexedInstanced(const unsigned int indexCountPerInstance, const unsigned int instanceCount, const unsigned int startIndexLocation,
+                              const int baseVertexLocation, const unsigned int startInstanceLocation);
+
+    // Adds this frame's counters to the running totals and periodically writes the per frame averages to the log.
+    void EndFrame();
+
+    // Calls passed to the context and calls dropped so far this frame.
+    unsigned int GetIssuedCalls();
+
+    unsigned int GetElidedCalls();
+
+private:
+    static const unsigned int MAX_VERTEX_BUFFERS = D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+    static const unsigned int MAX_CONSTANT_BUFFERS = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+    static const unsigned int MAX_RENDER_TARGETS = 8;
+    static const unsigned int MAX_VIEWPORTS = 16;
+    static const int STATISTICS_FRAMES = 120;
+
+    ID3D11DeviceContext* m_deviceContext;
+    ComPtr<ID3D11DeviceContext1> m_deviceContext1;
+
+    ID3D11InputLayout* m_inputLayout;
+    ID3D11Buffer* m_vertexBuffers[MAX_VERTEX_BUFFERS];
+    unsigned int m_vertexStrides[MAX_VERTEX_BUFFERS];
+    unsigned int m_vertexOffsets[MAX_VERTEX_BUFFERS];
+    ID3D11Buffer* m_indexBuffer;
+    DXGI_FORMAT m_indexFormat;
+    unsigned int m_indexOffset;
+    D3D11_PRIMITIVE_TOPOLOGY m_topology;
+    ID3D11VertexShader* m_vertexShader;
+    ID3D11PixelShader* m_pixelShader;
+    // Ranges bound with the *1 calls; a count of zero means the whole buffer.
+    struct ConstantBufferBinding
+    {
+        ID3D11Buffer* buffer;
+        unsigned int firstConstant;
+        unsigned int numConstants;
+    };
+
+    ConstantBufferBinding m_vsConstantBuffers[MAX_CONSTANT_BUFFERS];
+    ConstantBufferBinding m_psConstantBuffers[MAX_CONSTANT_BUFFERS];
+    ID3D11RasterizerState* m_rasterizerState;
+    unsigned int m_numViewports;
+    D3D11_VIEWPORT m_viewports[MAX_VIEWPORTS];
+    unsigned int m_numRenderTargets;
+    ID3D11RenderTargetView* m_renderTargets[MAX_RENDER_TARGETS];
+    ID3D11DepthStencilView* m_depthStencilView;
+    ID3D11DepthStencilState* m_depthStencilState;
+    unsigned int m_stencilRef;
+    ID3D11BlendState* m_blendState;
+    float m_blendFactor[4];
+    unsigned int m_sampleMask;
+    // The last pipeline state bound, or null once any state it covers has changed.
+    const PipelineCacheClass::PipelineState* m_pipelineState;
+
+    // Bit masks of which shadowed fields (and which buffer slots) are known to match the context.
+    enum KnownState
+    {
+        KNOWN_INPUT_LAYOUT = 1 << 0,
+        KNOWN_INDEX_BUFFER = 1 << 1,
+        KNOWN_TOPOLOGY = 1 << 2,
+        KNOWN_VERTEX_SHADER = 1 << 3,
+        KNOWN_PIXEL_SHADER = 1 << 4,
+        KNOWN_RASTERIZER_STATE = 1 << 5,
+        KNOWN_VIEWPORTS = 1 << 6,
+        KNOWN_RENDER_TARGETS = 1 << 7,
+        KNOWN_DEPTH_STENCIL_STATE = 1 << 8,
+        KNOWN_BLEND_STATE = 1 << 9,
+        // Everything a pipeline state sets.
+        KNOWN_PIPELINE_STATE = KNOWN_INPUT_LAYOUT | KNOWN_TOPOLOGY | KNOWN_VERTEX_SHADER | KNOWN_PIXEL_SHADER | KNOWN_RASTERIZER_STATE
+                               | KNOWN_DEPTH_STENCIL_STATE | KNOWN_BLEND_STATE
+    };
+
+    unsigned int m_knownState;
+    unsigned int m_knownVertexBuffers;
+    unsigned int m_knownVSConstantBuffers;
+    unsigned int m_knownPSConstantBuffers;
+
+    unsigned int m_issued, m_elided;
+    unsigned long long m_totalIssued, m_totalElided;
+    int m_frames;
+
+    bool IsRedundant(const unsigned int state, const bool unchanged);
+
+    // Null firstConstants and numConstants bind whole buffers.
+    bool FilterConstantBuffers(ConstantBufferBinding* shadow, unsigned int& known, const unsigned int startSlot, const unsigned int numBuffers,
+                               ID3D11Buffer* const* buffers, const unsigned int* firstConstants, const unsigned int* numConstants,
+                               unsigned int& firstChanged, unsigned int& lastChanged);
+};
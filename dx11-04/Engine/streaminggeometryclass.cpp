@@ -0,0 +1,197 @@
+#include "streaminggeometryclass.h"
+
+StreamingGeometryClass::StreamingGeometryClass() : m_overflowed(false), m_failedAllocations(0)
+{
+    m_stateCache = nullptr;
+    m_indexFormat = DXGI_FORMAT_R16_UINT;
+    m_indexStride = 2;
+    m_mapped = false;
+    m_discardPending = true;
+    m_totalBytes = m_totalFailedAllocations = m_totalDiscards = 0;
+    m_frames = 0;
+
+    m_vertices.data = m_indices.data = nullptr;
+    m_vertices.size = m_indices.size = 0;
+    m_vertices.offset = m_indices.offset = 0;
+    m_vertices.frameStart = m_indices.frameStart = 0;
+    m_vertices.lastFrameBytes = m_indices.lastFrameBytes = 0;
+}
+
+StreamingGeometryClass::~StreamingGeometryClass()
+{
+    if (m_mapped)
+    {
+        End();
+    }
+}
+
+void StreamingGeometryClass::Initialize(ID3D11Device* device, StateCacheClass* stateCache, const unsigned int vertexBytes, const unsigned int indexBytes,
+                                        const DXGI_FORMAT indexFormat)
+{
+    if (indexFormat != DXGI_FORMAT_R16_UINT && indexFormat != DXGI_FORMAT_R32_UINT)
+    {
+        throw engine_exception("Streaming index buffers must be R16_UINT or R32_UINT, not ") << (int)indexFormat;
+    }
+
+    m_stateCache = stateCache;
+    m_indexFormat = indexFormat;
+    m_indexStride = indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
+    CreateRing(device, m_vertices, vertexBytes, D3D11_BIND_VERTEX_BUFFER);
+    CreateRing(device, m_indices, indexBytes, D3D11_BIND_INDEX_BUFFER);
+    m_discardPending = true;
+}
+
+void StreamingGeometryClass::CreateRing(ID3D11Device* device, Ring& ring, const unsigned int size, const unsigned int bindFlags)
+{
+    D3D11_BUFFER_DESC bufferDesc;
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = size;
+    bufferDesc.BindFlags = bindFlags;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    bufferDesc.MiscFlags = 0;
+    bufferDesc.StructureByteStride = 0;
+
+    HRESULT result = device->CreateBuffer(&bufferDesc, NULL, ring.buffer.ReleaseAndGetAddressOf());
+    if (FAILED(result))
+    {
+        throw engine_exception("Couldn't create streaming buffer, result code = ") << result;
+    }
+
+    ring.data = nullptr;
+    ring.size = size;
+    ring.offset = 0;
+    ring.frameStart = 0;
+    ring.lastFrameBytes = 0;
+}
+
+void StreamingGeometryClass::Begin()
+{
+    PROFILE_FUNCTION();
+
+    if (m_mapped)
+    {
+        throw engine_exception("Streaming geometry is already mapped");
+    }
+
+    // Expect this frame to stream about as much as the last one; if that won't fit behind the data still in flight,
+    // start both rings over in fresh storage.
+    bool discard = m_discardPending || m_overflowed.load()
+                   || m_vertices.offset.load() + m_vertices.lastFrameBytes > m_vertices.size
+                   || m_indices.offset.load() + m_indices.lastFrameBytes > m_indices.size;
+
+    MapRing(m_vertices, discard);
+    MapRing(m_indices, discard);
+
+    if (discard)
+    {
+        m_totalDiscards++;
+    }
+    m_discardPending = false;
+    m_overflowed = false;
+    m_mapped = true;
+}
+
+void StreamingGeometryClass::MapRing(Ring& ring, const bool discard)
+{
+    if (discard)
+    {
+        ring.offset = 0;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    HRESULT result = m_stateCache->GetDeviceContext()->Map(ring.buffer.Get(), 0, discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE,
+                                                           0, &mappedResource);
+    if (FAILED(result))
+    {
+        throw engine_exception("Couldn't lock streaming buffer, result code = ") << result;
+    }
+
+    ring.data = (unsigned char*)mappedResource.pData;
+    ring.frameStart = ring.offset.load();
+}
+
+bool StreamingGeometryClass::Reserve(Ring& ring, const unsigned int size, const unsigned int alignment, unsigned int& offset)
+{
+    unsigned int current = ring.offset.load(memory_order_relaxed);
+    for (;;)
+    {
+        unsigned int aligned = (current + alignment - 1) / alignment * alignment;
+        if (aligned > ring.size || size > ring.size - aligned)
+        {
+            return false;
+        }
+
+        if (ring.offset.compare_exchange_weak(current, aligned + size, memory_order_relaxed))
+        {
+            offset = aligned;
+            return true;
+        }
+    }
+}
+
+bool StreamingGeometryClass::Allocate(const unsigned int vertexCount, const unsigned int vertexStride, const unsigned int indexCount, Span& span)
+{
+    // Vertices start on a multiple of their stride so the span's offset is a whole base vertex.
+    unsigned int vertexOffset, indexOffset;
+    if (!Reserve(m_vertices, vertexCount * vertexStride, vertexStride, vertexOffset)
+        || !Reserve(m_indices, indexCount * m_indexStride, m_indexStride, indexOffset))
+    {
+        // A vertex reservation that succeeded is simply left unused until the rings wrap.
+        m_overflowed = true;
+        m_failedAllocations.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    span.vertices = m_vertices.data + vertexOffset;
+    span.indices = m_indices.data + indexOffset;
+    span.baseVertex = vertexOffset / vertexStride;
+    span.startIndex = indexOffset / m_indexStride;
+    return true;
+}
+
+void StreamingGeometryClass::End()
+{
+    PROFILE_FUNCTION();
+
+    if (!m_mapped)
+    {
+        throw engine_exception("Streaming geometry isn't mapped");
+    }
+
+    ID3D11DeviceContext* deviceContext = m_stateCache->GetDeviceContext();
+    deviceContext->Unmap(m_vertices.buffer.Get(), 0);
+    deviceContext->Unmap(m_indices.buffer.Get(), 0);
+    m_vertices.data = m_indices.data = nullptr;
+    m_mapped = false;
+
+    m_vertices.lastFrameBytes = m_vertices.offset.load() - m_vertices.frameStart;
+    m_indices.lastFrameBytes = m_indices.offset.load() - m_indices.frameStart;
+
+    m_totalBytes += m_vertices.lastFrameBytes + m_indices.lastFrameBytes;
+    m_totalFailedAllocations += m_failedAllocations.exchange(0);
+    if (++m_frames == STATISTICS_FRAMES)
+    {
+        LOG_INFO("Streaming geometry: {} MB, {} failed allocations, {} discards per frame", (double)m_totalBytes / m_frames / (1024.0 * 1024.0),
+                 (double)m_totalFailedAllocations / m_frames, (double)m_totalDiscards / m_frames);
+
+        m_totalBytes = m_totalFailedAllocations = m_totalDiscards = 0;
+        m_frames = 0;
+    }
+}
+
+void StreamingGeometryClass::Bind(const unsigned int vertexStride)
+{
+    unsigned int offset = 0;
+    m_stateCache->IASetVertexBuffers(0, 1, m_vertices.buffer.GetAddressOf(), &vertexStride, &offset);
+    m_stateCache->IASetIndexBuffer(m_indices.buffer.Get(), m_indexFormat, 0);
+}
+
+unsigned int StreamingGeometryClass::GetIndexStride()
+{
+    return m_indexStride;
+}
+
+unsigned int StreamingGeometryClass::GetStreamedBytes()
+{
+    return (m_vertices.offset.load() - m_vertices.frameStart) + (m_indices.offset.load() - m_indices.frameStart);
+}
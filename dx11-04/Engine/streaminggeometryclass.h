@@ -0,0 +1,82 @@
+#pragma once
+#include "engine.h"
+#include "statecacheclass.h"
+#include <atomic>
+
+using namespace std;
+using namespace Microsoft::WRL;
+
+// Geometry generated every frame (trails, debug shapes, deformed meshes) streamed through one dynamic vertex buffer and
+// one dynamic index buffer used as rings. Begin maps both rings on the render thread, appending behind last frame's data
+// with NO_OVERWRITE, or with DISCARD when last frame's usage wouldn't fit in what is left. Between Begin and End any
+// thread may Allocate spans and write straight into the mapped memory; End unmaps, after which the spans can be drawn
+// with DrawIndexed(indexCount, span.startIndex, span.baseVertex) once Bind has set the buffers. An allocation that
+// doesn't fit this frame fails rather than wrapping, since a discard would drop the spans already handed out; the next
+// Begin then discards.
+class StreamingGeometryClass
+{
+public:
+    struct Span
+    {
+        void* vertices;
+        void* indices; // GetIndexStride() bytes per index, relative to the span's own vertices.
+        unsigned int baseVertex;
+        unsigned int startIndex;
+    };
+
+    StreamingGeometryClass();
+
+    ~StreamingGeometryClass();
+
+    // indexFormat is DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT.
+    void Initialize(ID3D11Device* device, StateCacheClass* stateCache, const unsigned int vertexBytes, const unsigned int indexBytes,
+                    const DXGI_FORMAT indexFormat);
+
+    void Begin();
+
+    // Thread safe between Begin and End. Returns false when the rings are out of room for this frame.
+    bool Allocate(const unsigned int vertexCount, const unsigned int vertexStride, const unsigned int indexCount, Span& span);
+
+    // Every writer must have finished before End is called.
+    void End();
+
+    // Binds the vertex ring to slot 0 with the given stride and the index ring.
+    void Bind(const unsigned int vertexStride);
+
+    unsigned int GetIndexStride();
+
+    // Bytes handed out since Begin.
+    unsigned int GetStreamedBytes();
+
+private:
+    static const int STATISTICS_FRAMES = 120;
+
+    struct Ring
+    {
+        ComPtr<ID3D11Buffer> buffer;
+        unsigned char* data;
+        unsigned int size;
+        atomic<unsigned int> offset;
+        unsigned int frameStart;
+        unsigned int lastFrameBytes;
+    };
+
+    StateCacheClass* m_stateCache;
+    Ring m_vertices, m_indices;
+    DXGI_FORMAT m_indexFormat;
+    unsigned int m_indexStride;
+    bool m_mapped;
+    bool m_discardPending;
+    atomic<bool> m_overflowed;
+
+    atomic<unsigned int> m_failedAllocations;
+    unsigned long long m_totalBytes, m_totalFailedAllocations, m_totalDiscards;
+    int m_frames;
+
+    void CreateRing(ID3D11Device* device, Ring& ring, const unsigned int size, const unsigned int bindFlags);
+
+    void MapRing(Ring& ring, const bool discard);
+
+    // Carves size bytes starting on a multiple of alignment out of the ring; false if they don't fit.
+    static bool Reserve(Ring& ring, const unsigned int size, const unsigned int alignment, unsigned int& offset);
+};
@@ -0,0 +1,607 @@
+#include "swapchainclass.h"
+#include <cmath>
+
+namespace
+{
+#ifdef _WIN32
+    // Flip discard and tearing arrived with Windows 10, after the SDK this builds against. The values are fixed by DXGI,
+    // so they are asked for by number, and swap chains that older systems can't create are stepped down from.
+    const DXGI_SWAP_EFFECT SWAP_EFFECT_FLIP_DISCARD = (DXGI_SWAP_EFFECT)4;
+    const UINT SWAP_CHAIN_FLAG_ALLOW_TEARING = 2048;
+#endif
+    // DXGI_PRESENT_ALLOW_TEARING, from the same SDK.
+    const UINT PRESENT_ALLOW_TEARING = 0x200;
+
+    // What DXGI lets the CPU queue ahead when nobody sets the frame latency.
+    const unsigned int DEFAULT_FRAME_LATENCY = 3;
+}
+
+SwapChainClass::SimulatedDisplay::SimulatedDisplay()
+{
+    Initialize(60.0, 2);
+}
+
+void SwapChainClass::SimulatedDisplay::Initialize(const double refreshRate, const unsigned int bufferCount)
+{
+    m_time = 0;
+    m_refreshTicks = max((long long)(1000000.0 / refreshRate + 0.5), 1LL);
+    m_bufferCount = bufferCount;
+    m_maximumFrameLatency = DEFAULT_FRAME_LATENCY;
+    m_queued = 0;
+    m_lastShown = -m_refreshTicks;
+    m_frameStart = 0;
+    m_framesShown = m_tornFrames = 0;
+    m_totalLatency = 0;
+}
+
+SwapChainClass::Target SwapChainClass::SimulatedDisplay::GetTarget()
+{
+    Target target;
+    target.setMaximumFrameLatency = [this](UINT maximumFrameLatency)
+    {
+        m_maximumFrameLatency = max(maximumFrameLatency, 1u);
+    };
+    target.waitForFrame = [this](DWORD)
+    {
+        WaitForFrame();
+        return true;
+    };
+    target.present = [this](UINT syncInterval, UINT flags)
+    {
+        Present(syncInterval, flags);
+        return S_OK;
+    };
+    // Stretching costs the display nothing.
+    target.setSourceSize = [](UINT, UINT)
+    {
+        return S_OK;
+    };
+    return target;
+}
+
+FrameTimerClass::Clock SwapChainClass::SimulatedDisplay::GetClock()
+{
+    FrameTimerClass::Clock clock;
+    clock.frequency = 1000000;
+    clock.now = [this]() { return m_time; };
+    clock.sleep = [this](long long ticks) { m_time += ticks; };
+    clock.wait = clock.sleep;
+    return clock;
+}
+
+void SwapChainClass::SimulatedDisplay::Advance(const long long ticks)
+{
+    m_time += ticks;
+}
+
+long long SwapChainClass::SimulatedDisplay::GetTime()
+{
+    return m_time;
+}
+
+unsigned int SwapChainClass::SimulatedDisplay::GetFramesShown()
+{
+    return m_framesShown;
+}
+
+double SwapChainClass::SimulatedDisplay::GetMeanLatency()
+{
+    return m_framesShown > 0 ? (double)m_totalLatency / m_framesShown / 1000000.0 : 0.0;
+}
+
+unsigned int SwapChainClass::SimulatedDisplay::GetTornFrames()
+{
+    return m_tornFrames;
+}
+
+void SwapChainClass::SimulatedDisplay::Retire()
+{
+    unsigned int shown = 0;
+    while (shown < m_queued && m_queue[shown].shown <= m_time)
+    {
+        shown++;
+    }
+
+    for (unsigned int i = shown; i < m_queued; i++)
+    {
+        m_queue[i - shown] = m_queue[i];
+    }
+    m_queued -= shown;
+}
+
+void SwapChainClass::SimulatedDisplay::WaitForQueue(const unsigned int limit)
+{
+    Retire();
+    while (m_queued >= limit)
+    {
+        m_time = m_queue[0].shown;
+        Retire();
+    }
+}
+
+long long SwapChainClass::SimulatedDisplay::GetNextRefresh(const long long time)
+{
+    return (time / m_refreshTicks + 1) * m_refreshTicks;
+}
+
+void SwapChainClass::SimulatedDisplay::WaitForFrame()
+{
+    // A flip model frame also needs a buffer that isn't queued or on screen.
+    unsigned int limit = m_bufferCount > 1 ? min(m_maximumFrameLatency, m_bufferCount - 1) : m_maximumFrameLatency;
+    WaitForQueue(min(limit, MAX_QUEUED_FRAMES));
+    m_frameStart = m_time;
+}
+
+void SwapChainClass::SimulatedDisplay::Present(const UINT syncInterval, const UINT flags)
+{
+    long long shown;
+    if (syncInterval == 0 && (flags & PRESENT_ALLOW_TEARING) != 0)
+    {
+        shown = m_time;
+        m_tornFrames++;
+    }
+    else if (syncInterval == 0)
+    {
+        // An uncapped frame is shown at the next refresh, replacing any frame still waiting for it, which never is.
+        Retire();
+        shown = GetNextRefresh(m_time);
+        if (m_queued > 0)
+        {
+            m_queued--;
+            m_framesShown--;
+            m_totalLatency -= m_queue[m_queued].latency;
+        }
+    }
+    else
+    {
+        // Waits for room in the queue like WaitForFrame, but after the frame's input was sampled.
+        long long frameStart = m_frameStart;
+        WaitForFrame();
+        m_frameStart = frameStart;
+        shown = max(GetNextRefresh(m_time), m_lastShown + (long long)syncInterval * m_refreshTicks);
+    }
+
+    if (shown > m_time)
+    {
+        m_queue[m_queued].shown = shown;
+        m_queue[m_queued].latency = shown - m_frameStart;
+        m_queued++;
+        m_lastShown = shown;
+    }
+
+    m_framesShown++;
+    m_totalLatency += shown - m_frameStart;
+    m_frameStart = m_time;
+}
+
+SwapChainClass::SwapChainClass()
+{
+    m_settings = GetDefaultSettings(true);
+#ifdef _WIN32
+    m_frameLatencyWaitable = NULL;
+#endif
+    m_fullscreen = false;
+    m_waitTicks = m_presentTicks = 0;
+    m_frames = 0;
+}
+
+SwapChainClass::~SwapChainClass()
+{
+    Shutdown();
+}
+
+SwapChainClass::Settings SwapChainClass::GetDefaultSettings(const bool vsync)
+{
+    Settings settings;
+    settings.swapEffect = SWAP_FLIP_DISCARD;
+    settings.bufferCount = 3;
+    settings.maximumFrameLatency = 1;
+    settings.waitable = true;
+    settings.vsync = vsync;
+    settings.allowTearing = !vsync;
+    return settings;
+}
+
+#ifdef _WIN32
+void SwapChainClass::Initialize(ID3D11Device* device, const HWND hwnd, const unsigned int screenWidth, const unsigned int screenHeight,
+                                const DXGI_RATIONAL& refreshRate, const bool fullscreen, const Settings& settings)
+{
+    // Swap chains have to come from the factory that made the device's adapter.
+    ComPtr<IDXGIDevice1> dxgiDevice;
+    HRESULT result = device->QueryInterface(__uuidof(IDXGIDevice1), &dxgiDevice);
+    if (FAILED(result))
+    {
+        throw engine_exception("Device has no DXGI device to create a swap chain with, result code = ") << result;
+    }
+
+    ComPtr<IDXGIAdapter> adapter;
+    result = dxgiDevice->GetAdapter(&adapter);
+    if (FAILED(result))
+    {
+        throw engine_exception("Could not get the device's adapter, result code = ") << result;
+    }
+
+    // Try the settings, then do without what the system lacks: tearing, then flip discard, then the waitable object,
+    // then the flip model (and with it DXGI 1.2) altogether.
+    Settings attempt = settings;
+    attempt.maximumFrameLatency = max(attempt.maximumFrameLatency, 1u);
+    ComPtr<IDXGIFactory2> factory;
+    if (FAILED(adapter->GetParent(__uuidof(IDXGIFactory2), &factory)))
+    {
+        attempt.swapEffect = SWAP_DISCARD;
+    }
+    for (;;)
+    {
+        if (attempt.swapEffect == SWAP_DISCARD)
+        {
+            attempt.bufferCount = 1;
+            attempt.waitable = false;
+            attempt.allowTearing = false;
+        }
+        else
+        {
+            attempt.bufferCount = min(max(attempt.bufferCount, 2u), (unsigned int)DXGI_MAX_SWAP_CHAIN_BUFFERS);
+        }
+
+        if (CreateSwapChain(factory.Get(), device, adapter.Get(), hwnd, screenWidth, screenHeight, refreshRate, fullscreen, attempt))
+        {
+            break;
+        }
+
+        if (attempt.swapEffect == SWAP_DISCARD)
+        {
+            throw engine_exception("Could not create a swap chain");
+        }
+
+        LOG_WARNING("Swap chain: could not create swap effect {} with {} buffers{}{}, stepping down", (int)attempt.swapEffect, attempt.bufferCount,
+                    attempt.waitable ? ", waitable" : "", attempt.allowTearing ? ", tearing" : "");
+        if (attempt.allowTearing)
+        {
+            attempt.allowTearing = false;
+        }
+        else if (attempt.swapEffect == SWAP_FLIP_DISCARD)
+        {
+            attempt.swapEffect = SWAP_FLIP_SEQUENTIAL;
+        }
+        else if (attempt.waitable)
+        {
+            attempt.waitable = false;
+        }
+        else
+        {
+            attempt.swapEffect = SWAP_DISCARD;
+        }
+    }
+
+    m_settings = attempt;
+    m_fullscreen = fullscreen;
+    SetDXGITarget(dxgiDevice.Get());
+    m_clock = FrameTimerClass::GetSystemClock();
+    m_target.setMaximumFrameLatency(m_settings.maximumFrameLatency);
+    m_waitTicks = m_presentTicks = 0;
+    m_frames = 0;
+
+    LOG_INFO("Swap chain: swap effect {}, {} buffers, frame latency {}{}{}", (int)m_settings.swapEffect, m_settings.bufferCount,
+             m_settings.maximumFrameLatency, m_settings.waitable ? ", waitable" : "", m_settings.allowTearing ? ", tearing allowed" : "");
+}
+#endif
+
+void SwapChainClass::Initialize(const Target& target, const FrameTimerClass::Clock& clock, const Settings& settings)
+{
+    m_settings = settings;
+    m_settings.maximumFrameLatency = max(m_settings.maximumFrameLatency, 1u);
+    m_target = target;
+    m_clock = clock;
+    m_fullscreen = false;
+    m_target.setMaximumFrameLatency(m_settings.maximumFrameLatency);
+    m_waitTicks = m_presentTicks = 0;
+    m_frames = 0;
+}
+
+void SwapChainClass::Shutdown()
+{
+#ifdef _WIN32
+    // Before shutting down set to windowed mode or when you release the swap chain it will throw an exception.
+    if (m_swapChain)
+    {
+        m_swapChain->SetFullscreenState(false, NULL);
+    }
+
+    if (m_frameLatencyWaitable != NULL)
+    {
+        CloseHandle(m_frameLatencyWaitable);
+        m_frameLatencyWaitable = NULL;
+    }
+#endif
+
+    // The target holds references to the swap chain.
+    m_target = Target();
+#ifdef _WIN32
+    m_swapChain.Reset();
+#endif
+}
+
+#ifdef _WIN32
+bool SwapChainClass::CreateSwapChain(IDXGIFactory2* factory, ID3D11Device* device, IDXGIAdapter* adapter, const HWND hwnd,
+                                     const unsigned int screenWidth, const unsigned int screenHeight, const DXGI_RATIONAL& refreshRate,
+                                     const bool fullscreen, const Settings& settings)
+{
+    HRESULT result;
+    if (settings.swapEffect == SWAP_DISCARD)
+    {
+        ComPtr<IDXGIFactory> legacyFactory;
+        result = adapter->GetParent(__uuidof(IDXGIFactory), &legacyFactory);
+        if (FAILED(result))
+        {
+            throw engine_exception("Could not get the adapter's DXGI factory, result code = ") << result;
+        }
+
+        DXGI_SWAP_CHAIN_DESC swapChainDesc;
+        ZeroMemory(&swapChainDesc, sizeof(swapChainDesc));
+
+        // Set to a single back buffer.
+        swapChainDesc.BufferCount = 1;
+
+        // Set the width and height of the back buffer.
+        swapChainDesc.BufferDesc.Width = screenWidth;
+        swapChainDesc.BufferDesc.Height = screenHeight;
+
+        // Set regular 32-bit surface for the back buffer.
+        swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+        // Set the refresh rate of the back buffer.
+        swapChainDesc.BufferDesc.RefreshRate.Numerator = settings.vsync ? refreshRate.Numerator : 0;
+        swapChainDesc.BufferDesc.RefreshRate.Denominator = settings.vsync ? refreshRate.Denominator : 1;
+
+        // Set the usage of the back buffer.
+        swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+
+        // Set the handle for the window to render to.
+        swapChainDesc.OutputWindow = hwnd;
+
+        // Turn multisampling off.
+        swapChainDesc.SampleDesc.Count = 1;
+        swapChainDesc.SampleDesc.Quality = 0;
+
+        // Set to full screen or windowed mode.
+        swapChainDesc.Windowed = !fullscreen;
+
+        // Set the scan line ordering and scaling to unspecified.
+        swapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+        swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+
+        // Discard the back buffer contents after presenting.
+        swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+
+        result = legacyFactory->CreateSwapChain(device, &swapChainDesc, m_swapChain.ReleaseAndGetAddressOf());
+        return SUCCEEDED(result);
+    }
+
+    // The flip model has no multisampled back buffers and takes the buffer count, effect and flags from the settings.
+    DXGI_SWAP_CHAIN_DESC1 swapChainDesc;
+    ZeroMemory(&swapChainDesc, sizeof(swapChainDesc));
+    swapChainDesc.Width = screenWidth;
+    swapChainDesc.Height = screenHeight;
+    swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    swapChainDesc.SampleDesc.Count = 1;
+    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    swapChainDesc.BufferCount = settings.bufferCount;
+    swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
+    swapChainDesc.SwapEffect = settings.swapEffect == SWAP_FLIP_DISCARD ? SWAP_EFFECT_FLIP_DISCARD : DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
+    swapChainDesc.Flags = (settings.waitable ? DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT : 0) |
+                          (settings.allowTearing ? SWAP_CHAIN_FLAG_ALLOW_TEARING : 0);
+
+    DXGI_SWAP_CHAIN_FULLSCREEN_DESC fullscreenDesc;
+    ZeroMemory(&fullscreenDesc, sizeof(fullscreenDesc));
+    fullscreenDesc.RefreshRate.Numerator = settings.vsync ? refreshRate.Numerator : 0;
+    fullscreenDesc.RefreshRate.Denominator = settings.vsync ? refreshRate.Denominator : 1;
+    fullscreenDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+    fullscreenDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+    fullscreenDesc.Windowed = !fullscreen;
+
+    ComPtr<IDXGISwapChain1> swapChain;
+    result = factory->CreateSwapChainForHwnd(device, hwnd, &swapChainDesc, &fullscreenDesc, NULL, &swapChain);
+    if (FAILED(result))
+    {
+        return false;
+    }
+
+    m_swapChain = swapChain;
+    return true;
+}
+
+void SwapChainClass::SetDXGITarget(IDXGIDevice1* dxgiDevice)
+{
+    // The waitable object's swap chain holds the frame latency; without one it is set on the device. The source size
+    // also needs DXGI 1.3, and a flip model swap chain to be stretched.
+    ComPtr<IDXGISwapChain2> swapChain2;
+    if (m_settings.swapEffect != SWAP_DISCARD && SUCCEEDED(m_swapChain->QueryInterface(__uuidof(IDXGISwapChain2), &swapChain2)))
+    {
+        m_target.setSourceSize = [swapChain2](UINT width, UINT height)
+        {
+            return swapChain2->SetSourceSize(width, height);
+        };
+    }
+
+    if (m_settings.waitable && swapChain2)
+    {
+        m_frameLatencyWaitable = swapChain2->GetFrameLatencyWaitableObject();
+        m_target.setMaximumFrameLatency = [swapChain2](UINT maximumFrameLatency)
+        {
+            swapChain2->SetMaximumFrameLatency(maximumFrameLatency);
+        };
+    }
+    else
+    {
+        m_settings.waitable = false;
+        ComPtr<IDXGIDevice1> device(dxgiDevice);
+        m_target.setMaximumFrameLatency = [device](UINT maximumFrameLatency)
+        {
+            device->SetMaximumFrameLatency(maximumFrameLatency);
+        };
+    }
+
+    HANDLE waitable = m_frameLatencyWaitable;
+    m_target.waitForFrame = [waitable](DWORD timeoutMilliseconds)
+    {
+        return WaitForSingleObjectEx(waitable, timeoutMilliseconds, TRUE) == WAIT_OBJECT_0;
+    };
+
+    IDXGISwapChain* swapChain = m_swapChain.Get();
+    m_target.present = [swapChain](UINT syncInterval, UINT flags)
+    {
+        return swapChain->Present(syncInterval, flags);
+    };
+}
+#endif
+
+void SwapChainClass::WaitForFrame()
+{
+    if (!m_settings.waitable)
+    {
+        return;
+    }
+
+    PROFILE_FUNCTION();
+
+    long long start = m_clock.now();
+    if (!m_target.waitForFrame(WAIT_TIMEOUT_MILLISECONDS))
+    {
+        LOG_WARNING("Swap chain: no frame after waiting {} ms", (unsigned int)WAIT_TIMEOUT_MILLISECONDS);
+    }
+    m_waitTicks += m_clock.now() - start;
+}
+
+void SwapChainClass::Present()
+{
+    PROFILE_FUNCTION();
+
+    // Tearing is only allowed in a window; exclusive fullscreen tears without being asked.
+    UINT syncInterval = m_settings.vsync ? 1 : 0;
+    UINT flags = !m_settings.vsync && m_settings.allowTearing && !m_fullscreen ? PRESENT_ALLOW_TEARING : 0;
+
+    long long start = m_clock.now();
+    HRESULT result = m_target.present(syncInterval, flags);
+    m_presentTicks += m_clock.now() - start;
+    if (FAILED(result))
+    {
+        throw engine_exception("Could not present, result code = ") << result;
+    }
+
+    if (++m_frames == STATISTICS_FRAMES)
+    {
+        double frequency = (double)m_clock.frequency;
+        LOG_INFO("Swap chain: {} ms waiting for the frame latency object and {} ms in Present per frame", m_waitTicks * 1000.0 / frequency / m_frames,
+                 m_presentTicks * 1000.0 / frequency / m_frames);
+        m_waitTicks = m_presentTicks = 0;
+        m_frames = 0;
+    }
+}
+
+bool SwapChainClass::SetSourceSize(const unsigned int width, const unsigned int height)
+{
+    if (!m_target.setSourceSize)
+    {
+        return false;
+    }
+
+    HRESULT result = m_target.setSourceSize(width, height);
+    if (FAILED(result))
+    {
+        LOG_WARNING("Swap chain: could not set the source size to {}x{}, result code = {}", width, height, result);
+        return false;
+    }
+
+    return true;
+}
+
+#ifdef _WIN32
+IDXGISwapChain* SwapChainClass::GetSwapChain()
+{
+    return m_swapChain.Get();
+}
+#endif
+
+const SwapChainClass::Settings& SwapChainClass::GetSettings()
+{
+    return m_settings;
+}
+
+void SwapChainClass::Validate()
+{
+    // Frames that cost the CPU 4 ms on a 60 Hz display.
+    const double refreshRate = 60.0;
+    const long long frameCost = 4000;
+    const int frameCount = 600;
+    const double refreshSeconds = 1.0 / refreshRate;
+
+    struct Case
+    {
+        const char* name;
+        Settings settings;
+    };
+
+    Settings blocking = GetDefaultSettings(true);
+    blocking.maximumFrameLatency = DEFAULT_FRAME_LATENCY;
+    blocking.waitable = false;
+    Settings waitable = GetDefaultSettings(true);
+    Settings torn = GetDefaultSettings(false);
+    Settings uncapped = GetDefaultSettings(false);
+    uncapped.allowTearing = false;
+    const Case cases[4] = { { "blocking", blocking }, { "waitable", waitable }, { "tearing", torn }, { "uncapped", uncapped } };
+
+    double latencies[4], frameRates[4];
+    unsigned int tornFrames[4];
+    for (int i = 0; i < 4; i++)
+    {
+        SimulatedDisplay display;
+        display.Initialize(refreshRate, cases[i].settings.bufferCount);
+        SwapChainClass swapChain;
+        swapChain.Initialize(display.GetTarget(), display.GetClock(), cases[i].settings);
+        for (int frame = 0; frame < frameCount; frame++)
+        {
+            swapChain.WaitForFrame();
+            display.Advance(frameCost);
+            swapChain.Present();
+        }
+
+        latencies[i] = display.GetMeanLatency();
+        frameRates[i] = display.GetFramesShown() * 1000000.0 / display.GetTime();
+        tornFrames[i] = display.GetTornFrames();
+        LOG_INFO("Swap chain validation, {}: {} ms latency, {} frames per second, {} torn", cases[i].name, latencies[i] * 1000.0, frameRates[i],
+                 tornFrames[i]);
+    }
+
+    // Blocking in Present queues two frames ahead of the display on three buffers; the waitable object at latency 1 shows
+    // every frame at the refresh after it started.
+    if (latencies[0] < 1.5 * refreshSeconds || latencies[1] > 1.01 * refreshSeconds)
+    {
+        throw engine_exception("Swap chain validation: latency of ") << latencies[1] * 1000.0 << " ms with the waitable object against "
+                                                                     << latencies[0] * 1000.0 << " ms blocking in Present";
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (fabs(frameRates[i] - refreshRate) > refreshRate * 0.01 || tornFrames[i] != 0)
+        {
+            throw engine_exception("Swap chain validation: vsync ") << cases[i].name << " ran at " << frameRates[i] << " frames per second";
+        }
+    }
+
+    // Torn frames go out as soon as they are done, at the CPU's pace. Uncapped frames without tearing still wait for a
+    // refresh, but never more than one.
+    double cpuRate = 1000000.0 / frameCost;
+    if (tornFrames[2] != (unsigned int)frameCount || latencies[2] > frameCost / 1000000.0 + 0.000001 || fabs(frameRates[2] - cpuRate) > cpuRate * 0.01)
+    {
+        throw engine_exception("Swap chain validation: tearing showed ") << tornFrames[2] << " torn frames at " << latencies[2] * 1000.0 << " ms";
+    }
+
+    if (tornFrames[3] != 0 || latencies[3] > refreshSeconds + frameCost / 1000000.0 || frameRates[3] > refreshRate * 1.01)
+    {
+        throw engine_exception("Swap chain validation: uncapped frames without tearing at ") << latencies[3] * 1000.0 << " ms and "
+                                                                                            << frameRates[3] << " frames per second";
+    }
+
+    LOG_INFO("Swap chain validation passed");
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include "engine.h"
+#include "frametimerclass.h"
+#include <functional>
+#ifdef _WIN32
+#include <dxgi1_3.h>
+#include "wrl/client.h"
+#endif
+
+using namespace std;
+using namespace Microsoft::WRL;
+
+// Presents frames and paces the CPU against the display. With a flip model swap chain and a frame latency waitable
+// object, WaitForFrame blocks until the swap chain can take another frame, so the loop waits before it samples input
+// rather than inside Present with input that has gone stale. Uncapped frames present with tearing allowed where the system
+// supports it. Whatever the settings ask for is stepped down to what the system can create, back to the blt model
+// swap chain of Windows 7. Presenting goes through a Target, so the pacing can also run against a SimulatedDisplay; off
+// Windows only that half is built, for the tests.
+class SwapChainClass
+{
+public:
+    enum SwapEffect
+    {
+        // The legacy blt model, which copies the back buffer out on Present.
+        SWAP_DISCARD,
+        SWAP_FLIP_SEQUENTIAL,
+        // Windows 10 and later.
+        SWAP_FLIP_DISCARD
+    };
+
+    struct Settings
+    {
+        SwapEffect swapEffect;
+        // 2 or 3 for the flip model; the blt model has one.
+        unsigned int bufferCount;
+        // Frames the CPU may queue ahead of the display; 1 has the lowest latency.
+        unsigned int maximumFrameLatency;
+        // Wait for the frame latency waitable object in WaitForFrame instead of blocking in Present.
+        bool waitable;
+        bool vsync;
+        // Present uncapped frames as soon as they are done, tearing, instead of at the next refresh.
+        bool allowTearing;
+    };
+
+    // What the swap chain does for Present, with the same arguments as DXGI. waitForFrame returns false on a timeout;
+    // setSourceSize is empty when the target always shows its whole back buffer.
+    struct Target
+    {
+        function<void(UINT)> setMaximumFrameLatency;
+        function<bool(DWORD)> waitForFrame;
+        function<HRESULT(UINT, UINT)> present;
+        function<HRESULT(UINT, UINT)> setSourceSize;
+    };
+
+    // A display that shows one queued frame per refresh, on a clock of its own that only moves when frames are waited
+    // for or Advance is called. Frames are queued at Present, at most the frame latency and one less than the buffer
+    // count at a time, and shown at the first free refresh; torn frames are shown at once. The latency of a frame is
+    // from when the CPU could start it, after the previous Present or WaitForFrame, until it is shown.
+    class SimulatedDisplay
+    {
+    public:
+        SimulatedDisplay();
+
+        // Ticks are microseconds.
+        void Initialize(const double refreshRate, const unsigned int bufferCount);
+
+        Target GetTarget();
+
+        // A FrameTimerClass clock on the display's time; sleep and wait advance it.
+        FrameTimerClass::Clock GetClock();
+
+        // Passes time for CPU work.
+        void Advance(const long long ticks);
+
+        long long GetTime();
+
+        unsigned int GetFramesShown();
+
+        // Mean latency of the shown frames in seconds, and how many of them tore.
+        double GetMeanLatency();
+
+        unsigned int GetTornFrames();
+
+    private:
+        static const unsigned int MAX_QUEUED_FRAMES = 16;
+
+        struct QueuedFrame
+        {
+            long long shown;
+            long long latency;
+        };
+
+        long long m_time;
+        long long m_refreshTicks;
+        unsigned int m_bufferCount;
+        unsigned int m_maximumFrameLatency;
+        // In present order, which is also the order they are shown in.
+        QueuedFrame m_queue[MAX_QUEUED_FRAMES];
+        unsigned int m_queued;
+        long long m_lastShown;
+        long long m_frameStart;
+        unsigned int m_framesShown, m_tornFrames;
+        long long m_totalLatency;
+
+        // Drops the frames shown by now.
+        void Retire();
+
+        // Waits until fewer than limit frames are queued.
+        void WaitForQueue(const unsigned int limit);
+
+        long long GetNextRefresh(const long long time);
+
+        void WaitForFrame();
+
+        void Present(const UINT syncInterval, const UINT flags);
+    };
+
+    SwapChainClass();
+
+    ~SwapChainClass();
+
+    // Flip discard with three buffers, latency 1 and the waitable object, tearing when vsync is off.
+    static Settings GetDefaultSettings(const bool vsync);
+
+#ifdef _WIN32
+    // Creates the swap chain for the window on device's adapter. The refresh rate is only used with vsync.
+    void Initialize(ID3D11Device* device, const HWND hwnd, const unsigned int screenWidth, const unsigned int screenHeight,
+                    const DXGI_RATIONAL& refreshRate, const bool fullscreen, const Settings& settings);
+#endif
+
+    // Presents to target instead of a swap chain, timed on clock.
+    void Initialize(const Target& target, const FrameTimerClass::Clock& clock, const Settings& settings);
+
+    void Shutdown();
+
+    // Blocks until the swap chain can take another frame; call it before sampling input for the frame. Returns at once
+    // without the waitable object.
+    void WaitForFrame();
+
+    void Present();
+
+    // Shows only the top left width by height of the back buffer from the next Present on, stretched over the window.
+    // False, with the whole back buffer still shown, when the swap chain can't; only the flip model on DXGI 1.3 can.
+    bool SetSourceSize(const unsigned int width, const unsigned int height);
+
+#ifdef _WIN32
+    // nullptr unless there is a real swap chain.
+    IDXGISwapChain* GetSwapChain();
+#endif
+
+    // What Initialize ended up with.
+    const Settings& GetSettings();
+
+    // Runs the pacing against simulated displays and checks that the waitable object cuts the latency of blocking in
+    // Present, that torn frames go out at once and that vsync holds the refresh rate. Throws on a failure.
+    static void Validate();
+
+private:
+    static const int STATISTICS_FRAMES = 120;
+    // Longest WaitForFrame waits before giving up on the waitable object, e.g. while the window is minimized.
+    static const DWORD WAIT_TIMEOUT_MILLISECONDS = 1000;
+
+    Settings m_settings;
+    Target m_target;
+    FrameTimerClass::Clock m_clock;
+#ifdef _WIN32
+    ComPtr<IDXGISwapChain> m_swapChain;
+    HANDLE m_frameLatencyWaitable;
+#endif
+    bool m_fullscreen;
+
+    long long m_waitTicks, m_presentTicks;
+    int m_frames;
+
+#ifdef _WIN32
+    // Tries to create the swap chain with the settings; false if the system doesn't support them. factory may be nullptr
+    // for the blt model.
+    bool CreateSwapChain(IDXGIFactory2* factory, ID3D11Device* device, IDXGIAdapter* adapter, const HWND hwnd,
+                         const unsigned int screenWidth, const unsigned int screenHeight, const DXGI_RATIONAL& refreshRate,
+                         const bool fullscreen, const Settings& settings);
+
+    void SetDXGITarget(IDXGIDevice1* dxgiDevice);
+#endif
+};
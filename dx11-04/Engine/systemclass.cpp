@@ -25,6 +25,17 @@ void SystemClass::Initialize()
     int screenWidth, screenHeight;
     //bool result;
 
+    // Start the profiler first so everything after it can be timed.
+    PROFILE_INITIALIZE();
+
+    LARGE_INTEGER frequency, startupBegin, startupEnd;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&startupBegin);
+
+    // Start the workers before anything that might want to hand them jobs; this thread becomes worker 0.
+    m_Jobs = unique_ptr<JobSystemClass>(new JobSystemClass());
+    m_Jobs->Initialize(0);
+
     // Initialize the width and height of the screen to zero before sending the variables into the function.
     screenWidth = 0;
     screenHeight = 0;
@@ -38,11 +49,20 @@ void SystemClass::Initialize()
 
     // Create the graphics object.  This object will handle rendering all the graphics for this application.
     m_Graphics = unique_ptr<GraphicsClass>(new GraphicsClass());
-    m_Graphics->Initialize(screenWidth, screenHeight, m_hwnd);
+    m_Graphics->Initialize(screenWidth, screenHeight, m_hwnd, m_Jobs.get(), RENDERER);
+
+    // Vsync already paces the frames.
+    m_Timer = unique_ptr<FrameTimerClass>(new FrameTimerClass());
+    m_Timer->Initialize(FrameTimerClass::GetSystemClock(), UPDATE_RATE, VSYNC_ENABLED ? 0.0 : MAX_FRAME_RATE, FRAME_LIMITER);
+
+    QueryPerformanceCounter(&startupEnd);
+    LOG_INFO("Startup took {} ms", (double)(startupEnd.QuadPart - startupBegin.QuadPart) * 1000.0 / frequency.QuadPart);
 }
 
 void SystemClass::Run()
 {
+    PROFILE_FUNCTION();
+
     MSG msg;
     bool done = false;
 
@@ -53,11 +73,18 @@ void SystemClass::Run()
     done = false;
     while (!done)
     {
-        // Handle the windows messages.
-        if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+        // Wait for the swap chain first, so the input below is as fresh as it can be when the frame is shown.
+        m_Graphics->WaitForFrame();
+
+        // Handle all the windows messages that arrived during the last frame.
+        while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
         {
             TranslateMessage(&msg);
             DispatchMessage(&msg);
+            if (msg.message == WM_QUIT)
+            {
+                break;
+            }
         }
 
         // If windows signals to end the application then exit.
@@ -67,16 +94,36 @@ void SystemClass::Run()
         }
         else
         {
-            // Otherwise do the frame processing; we're done if this returns false.
-            done = !Frame();
+            // Run the simulation steps that are due, then render between the last two; we're done if Frame returns false.
+            m_Timer->BeginFrame();
+            while (m_Timer->Step())
+            {
+                Update(m_Timer->GetTimestep());
+            }
+            done = !Frame(m_Timer->GetInterpolation());
+
+            // Hold the loop to the frame rate limit.
+            m_Timer->EndFrame();
         }
+
+        // Fold this frame's zones into the profiler statistics.
+        PROFILE_END_FRAME();
     }
 
     return;
 }
 
-bool SystemClass::Frame()
+void SystemClass::Update(const double timestep)
+{
+    PROFILE_FUNCTION();
+
+    m_Graphics->Update((float)timestep);
+}
+
+bool SystemClass::Frame(const float interpolation)
 {
+    PROFILE_FUNCTION();
+
     // Check if the user pressed escape and wants to exit the application.
     if (m_Input->IsKeyDown(VK_ESCAPE))
     {
@@ -84,7 +131,7 @@ bool SystemClass::Frame()
     }
 
     // Do the frame processing for the graphics object.
-    return m_Graphics->Frame();
+    return m_Graphics->Frame(interpolation);
 }
 
 LRESULT CALLBACK SystemClass::MessageHandler(HWND hwnd, UINT umsg, WPARAM wparam, LPARAM lparam)
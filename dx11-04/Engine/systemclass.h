@@ -6,9 +6,20 @@
 #include <memory>
 #include "inputclass.h"
 #include "graphicsclass.h"
+#include "jobsystemclass.h"
+#include "frametimerclass.h"
 
 using namespace std;
 
+// Simulation steps per second; frames in between are interpolated.
+const double UPDATE_RATE = 60.0;
+// Frame rate the loop is held to when vsync is off, so it doesn't spin a core on frames nobody sees.
+const double MAX_FRAME_RATE = 144.0;
+const FrameTimerClass::LimiterMode FRAME_LIMITER = FrameTimerClass::LIMITER_WAITABLE_TIMER;
+// Where the log is written; the file is only used with LogClass::SINK_FILE.
+const unsigned int LOG_SINKS = LogClass::SINK_DEBUGGER | LogClass::SINK_FILE;
+const char* const LOG_FILE = "engine.log";
+
 class SystemClass
 {
 public:
@@ -23,7 +34,9 @@ public:
     LRESULT CALLBACK MessageHandler(HWND, UINT, WPARAM, LPARAM);
 
 private:
-    bool Frame();
+    void Update(const double timestep);
+
+    bool Frame(const float interpolation);
 
     void InitializeWindows(int&, int&);
 
@@ -33,6 +46,8 @@ private:
     LPCWSTR m_applicationName;
     HINSTANCE m_hinstance;
     HWND m_hwnd;
+    unique_ptr<JobSystemClass> m_Jobs;
+    unique_ptr<FrameTimerClass> m_Timer;
     unique_ptr<InputClass> m_Input;
     unique_ptr<GraphicsClass> m_Graphics;
 };
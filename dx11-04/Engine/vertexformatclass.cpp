@@ -0,0 +1,207 @@
+#include "vertexformatclass.h"
+#include <cstring>
+#include <cfloat>
+
+using namespace DirectX::PackedVector;
+
+namespace
+{
+    const char* FORMAT_NAMES[VertexFormatClass::FORMAT_COUNT] = { "float", "unorm16_rgba8", "unorm16_half" };
+
+    struct Unorm16Rgba8Vertex
+    {
+        unsigned short position[4];
+        unsigned char color[4];
+    };
+
+    struct Unorm16HalfVertex
+    {
+        unsigned short position[4];
+        HALF color[4];
+    };
+
+    unsigned short EncodeUnorm16(const float value)
+    {
+        return (unsigned short)(min(max(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+    }
+
+    unsigned char EncodeUnorm8(const float value)
+    {
+        return (unsigned char)(min(max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    // Positions are stored as a fraction of the bounds, so the reciprocal of the extent maps them into 0-1.
+    void EncodePosition(const XMFLOAT3& position, const VertexFormatClass::Quantization& quantization, unsigned short* encoded)
+    {
+        const XMFLOAT4& scale = quantization.positionScale;
+        const XMFLOAT4& bias = quantization.positionBias;
+        encoded[0] = EncodeUnorm16(scale.x > 0.0f ? (position.x - bias.x) / scale.x : 0.0f);
+        encoded[1] = EncodeUnorm16(scale.y > 0.0f ? (position.y - bias.y) / scale.y : 0.0f);
+        encoded[2] = EncodeUnorm16(scale.z > 0.0f ? (position.z - bias.z) / scale.z : 0.0f);
+        encoded[3] = 0;
+    }
+
+    XMFLOAT3 DecodePosition(const unsigned short* encoded, const VertexFormatClass::Quantization& quantization)
+    {
+        const XMFLOAT4& scale = quantization.positionScale;
+        const XMFLOAT4& bias = quantization.positionBias;
+        return XMFLOAT3(encoded[0] / 65535.0f * scale.x + bias.x,
+                        encoded[1] / 65535.0f * scale.y + bias.y,
+                        encoded[2] / 65535.0f * scale.z + bias.z);
+    }
+}
+
+unsigned int VertexFormatClass::GetStride(const Format format)
+{
+    switch (format)
+    {
+    case VERTEX_UNORM16_RGBA8:
+        return sizeof(Unorm16Rgba8Vertex);
+    case VERTEX_UNORM16_HALF:
+        return sizeof(Unorm16HalfVertex);
+    default:
+        return sizeof(VertexType);
+    }
+}
+
+const char* VertexFormatClass::GetName(const Format format)
+{
+    return FORMAT_NAMES[format];
+}
+
+VertexFormatClass::Format VertexFormatClass::ParseName(const string& name)
+{
+    for (int i = 0; i < FORMAT_COUNT; i++)
+    {
+        if (name == FORMAT_NAMES[i])
+        {
+            return (Format)i;
+        }
+    }
+    throw engine_exception("Unknown vertex format ") << name;
+}
+
+unsigned int VertexFormatClass::GetInputLayout(const Format format, D3D11_INPUT_ELEMENT_DESC* elements)
+{
+    // The shader reads a float3 position and float4 colour whatever the storage; the input assembler does the unpacking.
+    const DXGI_FORMAT positionFormats[FORMAT_COUNT] = { DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R16G16B16A16_UNORM, DXGI_FORMAT_R16G16B16A16_UNORM };
+    const DXGI_FORMAT colorFormats[FORMAT_COUNT] = { DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R16G16B16A16_FLOAT };
+
+    elements[0].SemanticName = "POSITION";
+    elements[0].SemanticIndex = 0;
+    elements[0].Format = positionFormats[format];
+    elements[0].InputSlot = 0;
+    elements[0].AlignedByteOffset = 0;
+    elements[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+    elements[0].InstanceDataStepRate = 0;
+
+    elements[1].SemanticName = "COLOR";
+    elements[1].SemanticIndex = 0;
+    elements[1].Format = colorFormats[format];
+    elements[1].InputSlot = 0;
+    elements[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+    elements[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+    elements[1].InstanceDataStepRate = 0;
+
+    return 2;
+}
+
+void VertexFormatClass::ComputeBounds(const VertexType* vertices, const unsigned int vertexCount, XMFLOAT3& boundsMin, XMFLOAT3& boundsMax)
+{
+    XMVECTOR minimum = XMVectorReplicate(vertexCount == 0 ? 0.0f : FLT_MAX);
+    XMVECTOR maximum = XMVectorReplicate(vertexCount == 0 ? 0.0f : -FLT_MAX);
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        XMVECTOR position = XMLoadFloat3(&vertices[i].position);
+        minimum = XMVectorMin(minimum, position);
+        maximum = XMVectorMax(maximum, position);
+    }
+    XMStoreFloat3(&boundsMin, minimum);
+    XMStoreFloat3(&boundsMax, maximum);
+}
+
+VertexFormatClass::Quantization VertexFormatClass::GetQuantization(const Format format, const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax)
+{
+    Quantization quantization;
+    quantization.format = format;
+    if (format == VERTEX_FLOAT)
+    {
+        quantization.positionScale = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.0f);
+        quantization.positionBias = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+    else
+    {
+        quantization.positionScale = XMFLOAT4(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z, 0.0f);
+        quantization.positionBias = XMFLOAT4(boundsMin.x, boundsMin.y, boundsMin.z, 0.0f);
+    }
+    return quantization;
+}
+
+void VertexFormatClass::Encode(const Quantization& quantization, const VertexType* vertices, const unsigned int vertexCount, void* destination)
+{
+    switch (quantization.format)
+    {
+    case VERTEX_UNORM16_RGBA8:
+        for (unsigned int i = 0; i < vertexCount; i++)
+        {
+            Unorm16Rgba8Vertex& packed = ((Unorm16Rgba8Vertex*)destination)[i];
+            EncodePosition(vertices[i].position, quantization, packed.position);
+            packed.color[0] = EncodeUnorm8(vertices[i].color.x);
+            packed.color[1] = EncodeUnorm8(vertices[i].color.y);
+            packed.color[2] = EncodeUnorm8(vertices[i].color.z);
+            packed.color[3] = EncodeUnorm8(vertices[i].color.w);
+        }
+        break;
+    case VERTEX_UNORM16_HALF:
+        for (unsigned int i = 0; i < vertexCount; i++)
+        {
+            Unorm16HalfVertex& packed = ((Unorm16HalfVertex*)destination)[i];
+            EncodePosition(vertices[i].position, quantization, packed.position);
+            packed.color[0] = XMConvertFloatToHalf(vertices[i].color.x);
+            packed.color[1] = XMConvertFloatToHalf(vertices[i].color.y);
+            packed.color[2] = XMConvertFloatToHalf(vertices[i].color.z);
+            packed.color[3] = XMConvertFloatToHalf(vertices[i].color.w);
+        }
+        break;
+    default:
+        memcpy(destination, vertices, vertexCount * sizeof(VertexType));
+        break;
+    }
+}
+
+void VertexFormatClass::Decode(const Quantization& quantization, const void* source, const unsigned int vertexCount, VertexType* vertices)
+{
+    switch (quantization.format)
+    {
+    case VERTEX_UNORM16_RGBA8:
+        for (unsigned int i = 0; i < vertexCount; i++)
+        {
+            const Unorm16Rgba8Vertex& packed = ((const Unorm16Rgba8Vertex*)source)[i];
+            vertices[i].position = DecodePosition(packed.position, quantization);
+            vertices[i].color = XMFLOAT4(packed.color[0] / 255.0f, packed.color[1] / 255.0f, packed.color[2] / 255.0f, packed.color[3] / 255.0f);
+        }
+        break;
+    case VERTEX_UNORM16_HALF:
+        for (unsigned int i = 0; i < vertexCount; i++)
+        {
+            const Unorm16HalfVertex& packed = ((const Unorm16HalfVertex*)source)[i];
+            vertices[i].position = DecodePosition(packed.position, quantization);
+            vertices[i].color = XMFLOAT4(XMConvertHalfToFloat(packed.color[0]), XMConvertHalfToFloat(packed.color[1]),
+                                         XMConvertHalfToFloat(packed.color[2]), XMConvertHalfToFloat(packed.color[3]));
+        }
+        break;
+    default:
+        memcpy(vertices, source, vertexCount * sizeof(VertexType));
+        break;
+    }
+}
+
+unsigned int VertexFormatClass::GetIndexStride(const unsigned int vertexCount)
+{
+    return vertexCount <= 65536 ? sizeof(unsigned short) : sizeof(unsigned int);
+}
+
+DXGI_FORMAT VertexFormatClass::GetIndexFormat(const unsigned int indexStride)
+{
+    return indexStride == sizeof(unsigned short) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "engine.h"
+#include <DirectXPackedVector.h>
+
+using namespace std;
+using namespace DirectX;
+
+// Vertex formats the colour shaders can read. Packed formats store positions as 16-bit UNORM relative to the mesh bounds;
+// the vertex shader turns them back into object space with the per mesh positionScale and positionBias constants.
+class VertexFormatClass
+{
+public:
+    enum Format
+    {
+        VERTEX_FLOAT,         // float3 position, float4 color: 28 bytes.
+        VERTEX_UNORM16_RGBA8, // unorm16x4 position, unorm8x4 color: 12 bytes.
+        VERTEX_UNORM16_HALF,  // unorm16x4 position, half4 color: 16 bytes.
+        FORMAT_COUNT
+    };
+
+    // Unpacked vertex, what the converter and software renderer work with.
+    struct VertexType
+    {
+        XMFLOAT3 position;
+        XMFLOAT4 color;
+    };
+
+    static const unsigned int MAX_ELEMENTS = 2;
+
+    // Everything a shader needs to decode one mesh's vertices.
+    struct Quantization
+    {
+        Format format;
+        XMFLOAT4 positionScale;
+        XMFLOAT4 positionBias;
+    };
+
+    static unsigned int GetStride(const Format format);
+
+    static const char* GetName(const Format format);
+
+    // Accepts the names returned by GetName; throws on anything else.
+    static Format ParseName(const string& name);
+
+    // Fills elements with the slot 0 part of the input layout and returns the number written (at most MAX_ELEMENTS).
+    static unsigned int GetInputLayout(const Format format, D3D11_INPUT_ELEMENT_DESC* elements);
+
+    static void ComputeBounds(const VertexType* vertices, const unsigned int vertexCount, XMFLOAT3& boundsMin, XMFLOAT3& boundsMax);
+
+    static Quantization GetQuantization(const Format format, const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax);
+
+    static void Encode(const Quantization& quantization, const VertexType* vertices, const unsigned int vertexCount, void* destination);
+
+    static void Decode(const Quantization& quantization, const void* source, const unsigned int vertexCount, VertexType* vertices);
+
+    // 16-bit indices whenever every vertex can be addressed with them, 32-bit otherwise.
+    static unsigned int GetIndexStride(const unsigned int vertexCount);
+
+    static DXGI_FORMAT GetIndexFormat(const unsigned int indexStride);
+};
@@ -0,0 +1,69 @@
+#include "win32benchmarkclass.h"
+#include "colorshaderclass.h"
+#include "inputclass.h"
+#include "displayprofileclass.h"
+
+namespace
+{
+    // Keeps the optimizer from dropping the benchmarked work.
+    volatile unsigned int g_sink;
+}
+
+vector<BenchmarkClass::Result> Win32BenchmarkClass::RunAll()
+{
+    vector<BenchmarkClass::Result> results;
+
+    // The transpose into a stack copy and the copy into mapped memory that every draw's object constants go through.
+    results.push_back(BenchmarkClass::Measure("ColorShaderClass::WriteObjectConstants", [](unsigned int iterations)
+    {
+        VertexFormatClass::Quantization quantization;
+        quantization.positionScale = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.0f);
+        quantization.positionBias = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+        XMFLOAT4X4A constants[2], mapped[2];
+        for (unsigned int i = 0; i < iterations; i++)
+        {
+            unsigned int size = ColorShaderClass::WriteObjectConstants(constants, quantization, XMMatrixTranslation((float)i, 0.0f, 0.0f));
+            memcpy(mapped, constants, size);
+        }
+        g_sink = (unsigned int)mapped[0].m[0][3];
+    }));
+
+    InputClass input;
+    input.Initialize();
+    input.KeyDown(VK_ESCAPE);
+    InputClass* inputPtr = &input;
+    results.push_back(BenchmarkClass::Measure("InputClass::IsKeyDown", [inputPtr](unsigned int iterations)
+    {
+        unsigned int down = 0;
+        for (unsigned int i = 0; i < iterations; i++)
+        {
+            down += inputPtr->IsKeyDown(i & 0xFF) ? 1 : 0;
+        }
+        g_sink = down;
+    }));
+
+    // A typical monitor's list: every size at four refresh rates, with the window size near the end.
+    const unsigned int modeCount = 64;
+    unique_ptr<DXGI_MODE_DESC[]> modes(new DXGI_MODE_DESC[modeCount]);
+    for (unsigned int i = 0; i < modeCount; i++)
+    {
+        ZeroMemory(&modes[i], sizeof(DXGI_MODE_DESC));
+        modes[i].Width = 640 + (i / 4) * 80;
+        modes[i].Height = 480 + (i / 4) * 45;
+        modes[i].RefreshRate.Numerator = 60000 + (i % 4) * 15000;
+        modes[i].RefreshRate.Denominator = 1000;
+        modes[i].Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+    results.push_back(BenchmarkClass::Measure("DisplayProfileClass::GetRefreshRateForWindowSize", [&modes](unsigned int iterations)
+    {
+        unsigned int numerator = 0, denominator = 1;
+        for (unsigned int i = 0; i < iterations; i++)
+        {
+            DisplayProfileClass::GetRefreshRateForWindowSize(modeCount, modes, 1760, 1110, numerator, denominator);
+        }
+        g_sink = numerator / denominator;
+    }));
+
+    BenchmarkClass::LogResults(results);
+    return results;
+}
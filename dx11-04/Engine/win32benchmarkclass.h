@@ -0,0 +1,14 @@
+#pragma once
+#include "engine.h"
+#include "benchmarkclass.h"
+
+using namespace std;
+
+// The microbenchmarks that need the Windows or D3D headers, measured like BenchmarkClass's. "Engine.exe -benchmark" runs
+// them after the platform independent ones and compares both against the same baseline.
+class Win32BenchmarkClass
+{
+public:
+    // Runs every benchmark and logs the results.
+    static vector<BenchmarkClass::Result> RunAll();
+};
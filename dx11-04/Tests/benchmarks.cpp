@@ -0,0 +1,42 @@
+#include "engine_core.h"
+#include "benchmarkclass.h"
+#include <cstdlib>
+#include <string>
+
+using namespace std;
+
+// Runs the platform independent CPU microbenchmarks, the same as "Engine.exe -benchmark" less those needing Windows or D3D:
+//     EngineBenchmarks [baseline [threshold]]
+//     EngineBenchmarks -save baseline
+// With a baseline the process fails when a benchmark regressed against it by more than threshold (a fraction, 0.1 by
+// default) or allocates more; -save writes the results as the new baseline.
+int main(int argc, char* argv[])
+{
+    LogSession log(LogClass::SINK_STDERR, "");
+
+    bool save = argc > 1 && string(argv[1]) == "-save";
+    const char* baseline = argc > (save ? 2 : 1) ? argv[save ? 2 : 1] : nullptr;
+    double threshold = !save && argc > 2 ? atof(argv[2]) : BenchmarkClass::REGRESSION_THRESHOLD;
+    if (save && baseline == nullptr)
+    {
+        LOG_ERROR("-save needs a baseline file name");
+        return 1;
+    }
+
+    try
+    {
+        vector<BenchmarkClass::Result> results = BenchmarkClass::RunAll();
+        if (save)
+        {
+            BenchmarkClass::SaveBaseline(baseline, results);
+            return 0;
+        }
+
+        return baseline != nullptr && BenchmarkClass::CompareWithBaseline(baseline, results, threshold) > 0 ? 1 : 0;
+    }
+    catch (const engine_exception& e)
+    {
+        LOG_ERROR("Benchmarks failed: {}", e.what());
+        return 1;
+    }
+}
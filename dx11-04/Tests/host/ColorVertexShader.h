@@ -0,0 +1,12 @@
+#pragma once
+#include "unknwn.h"
+
+// See unknwn.h. Stands in for the header FxCompile generates from ColorVertexShader.hlsl: an empty DXBC container,
+// which only the null device takes. The checksums only tell the stand ins apart.
+const BYTE g_ColorVertexShader[] =
+{
+    0x44, 0x58, 0x42, 0x43, 0x01, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include "unknwn.h"
+#include <utility>
+
+// See unknwn.h. The reference counting smart pointer of wrl/client.h, with the members the engine uses.
+namespace Microsoft
+{
+    namespace WRL
+    {
+        template <typename T>
+        class ComPtr
+        {
+        public:
+            ComPtr() : m_pointer(nullptr)
+            {
+            }
+
+            ComPtr(T* pointer) : m_pointer(pointer)
+            {
+                if (m_pointer != nullptr)
+                {
+                    m_pointer->AddRef();
+                }
+            }
+
+            ComPtr(const ComPtr& other) : ComPtr(other.m_pointer)
+            {
+            }
+
+            ComPtr(ComPtr&& other) : m_pointer(other.m_pointer)
+            {
+                other.m_pointer = nullptr;
+            }
+
+            ~ComPtr()
+            {
+                Reset();
+            }
+
+            ComPtr& operator=(ComPtr other)
+            {
+                std::swap(m_pointer, other.m_pointer);
+                return *this;
+            }
+
+            T* Get() const
+            {
+                return m_pointer;
+            }
+
+            T* operator->() const
+            {
+                return m_pointer;
+            }
+
+            explicit operator bool() const
+            {
+                return m_pointer != nullptr;
+            }
+
+            T** GetAddressOf()
+            {
+                return &m_pointer;
+            }
+
+            T* const* GetAddressOf() const
+            {
+                return &m_pointer;
+            }
+
+            T** ReleaseAndGetAddressOf()
+            {
+                Reset();
+                return &m_pointer;
+            }
+
+            // WRL releases through a proxy here too, so the pointer can be created into again.
+            T** operator&()
+            {
+                return ReleaseAndGetAddressOf();
+            }
+
+            ULONG Reset()
+            {
+                ULONG references = 0;
+                if (m_pointer != nullptr)
+                {
+                    references = m_pointer->Release();
+                    m_pointer = nullptr;
+                }
+                return references;
+            }
+
+        private:
+            T* m_pointer;
+        };
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "d3d11.h"
+
+// See unknwn.h.
+struct ID3D11DeviceContext1 : ID3D11DeviceContext
+{
+    virtual void STDMETHODCALLTYPE VSSetConstantBuffers1(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers, const UINT* pFirstConstant,
+                                                         const UINT* pNumConstants) = 0;
+    virtual void STDMETHODCALLTYPE PSSetConstantBuffers1(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers, const UINT* pFirstConstant,
+                                                         const UINT* pNumConstants) = 0;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include "platform.h"
+#include <cstddef>
+#include <cstring>
+
+// The part of COM the engine's D3D code uses, for building it against the headers in this directory off Windows. These
+// headers only declare what the platform independent code and its tests touch; nothing here talks to a GPU.
+typedef int HRESULT;
+typedef unsigned int ULONG;
+typedef unsigned int UINT;
+typedef int INT;
+typedef float FLOAT;
+typedef unsigned char UINT8;
+typedef unsigned long long UINT64;
+typedef unsigned char BYTE;
+typedef size_t SIZE_T;
+typedef const char* LPCSTR;
+typedef char* LPSTR;
+
+#define STDMETHODCALLTYPE
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_NOTIMPL ((HRESULT)0x80004001)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_NOINTERFACE ((HRESULT)0x80004002)
+#define E_INVALIDARG ((HRESULT)0x80070057)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+struct IID
+{
+    const void* id;
+};
+
+typedef const IID& REFIID;
+
+// Private data is keyed by GUIDs, which nothing off Windows makes; the null device only takes them to drop them.
+struct GUID
+{
+    unsigned int Data1;
+    unsigned short Data2;
+    unsigned short Data3;
+    unsigned char Data4[8];
+};
+
+typedef const GUID& REFGUID;
+
+inline bool operator==(const IID& a, const IID& b)
+{
+    return a.id == b.id;
+}
+
+// Every interface gets the address of its own static as its id, which is as unique as a GUID within one program.
+template <typename Interface>
+const IID& HostInterfaceId()
+{
+    static const IID id = { &id };
+    return id;
+}
+
+#define __uuidof(Interface) HostInterfaceId<Interface>()
+
+struct IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) = 0;
+    virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+    virtual ULONG STDMETHODCALLTYPE Release() = 0;
+
+protected:
+    ~IUnknown()
+    {
+    }
+};
@@ -0,0 +1,4 @@
+#pragma once
+
+// See unknwn.h. The SDK keeps ComPtr under wrl/.
+#include "../client.h"
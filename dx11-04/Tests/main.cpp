@@ -0,0 +1,217 @@
+#include "engine_core.h"
+#include "calllogclass.h"
+#include "commandstreamclass.h"
+#include "displayprofileclass.h"
+#include "dynamicresolutionclass.h"
+#include "frametimerclass.h"
+#include "frustumcullerclass.h"
+#include "jobsystemclass.h"
+#include "linearallocatorclass.h"
+#include "lodselectorclass.h"
+#include "meshconverterclass.h"
+#include "meshoptimizerclass.h"
+#include "meshsimplifierclass.h"
+#include "poolallocatorclass.h"
+#include "softwarerasterizerclass.h"
+#include "swapchainclass.h"
+#ifndef _WIN32
+#include "graphicsclass.h"
+#include "pipelinecacheclass.h"
+#include "recordingcontextclass.h"
+#endif
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Runs the validations of the platform independent part of the engine, and with -benchmark its benchmarks, without a
+// window or a GPU; off Windows that includes frames on the null device:
+//     EngineTests [name...]
+//     EngineTests -benchmark [name...]
+// Without names everything of the kind runs. ctest runs every test by name; the process fails when any of them throws.
+namespace
+{
+#ifndef _WIN32
+    // Enough for the frames after the first to reuse everything the first created.
+    const int HEADLESS_TEST_FRAMES = 8;
+#endif
+
+    struct Test
+    {
+        const char* name;
+        function<void()> run;
+    };
+
+    vector<Test> GetTests()
+    {
+        vector<Test> tests;
+        tests.push_back({ "FrustumCuller", []()
+        {
+            if (!FrustumCullerClass::Validate())
+            {
+                throw engine_exception("The batched frustum tests disagree with the reference");
+            }
+        } });
+        tests.push_back({ "JobSystem", []()
+        {
+            JobSystemClass::Validate();
+        } });
+        tests.push_back({ "SoftwareRasterizer", []()
+        {
+            SoftwareRasterizerClass::Validate();
+        } });
+        tests.push_back({ "CommandStream", []()
+        {
+            JobSystemClass jobs;
+            jobs.Initialize(0);
+            CommandStreamClass::Validate(&jobs);
+        } });
+        tests.push_back({ "Allocators", []()
+        {
+            PoolAllocatorClass::Validate();
+            LinearAllocatorClass::Validate();
+        } });
+        tests.push_back({ "FrameTimer", []()
+        {
+            FrameTimerClass::Validate();
+        } });
+        tests.push_back({ "CallLog", []()
+        {
+            CallLogClass::Validate();
+        } });
+        tests.push_back({ "SwapChain", []()
+        {
+            SwapChainClass::Validate();
+        } });
+        tests.push_back({ "DisplayProfile", []()
+        {
+            DisplayProfileClass::Validate();
+        } });
+        tests.push_back({ "DynamicResolution", []()
+        {
+            DynamicResolutionClass::Statistics resolution = DynamicResolutionClass::Validate();
+            LOG_INFO("Dynamic resolution validation: {}% of the frame time variance of a spiking load removed, {} frames over budget against {} unscaled",
+                     resolution.GetVarianceRemoved() * 100.0, resolution.framesOverBudget, resolution.unscaledFramesOverBudget);
+        } });
+        tests.push_back({ "MeshOptimizer", []()
+        {
+            MeshOptimizerClass::Validate();
+        } });
+        tests.push_back({ "MeshConverter", []()
+        {
+            MeshConverterClass::Validate();
+        } });
+        tests.push_back({ "MeshSimplifier", []()
+        {
+            MeshSimplifierClass::Validate();
+        } });
+        tests.push_back({ "LodSelector", []()
+        {
+            LodSelectorClass::Validate();
+        } });
+#ifndef _WIN32
+        tests.push_back({ "StateCache", []()
+        {
+            RecordingContextClass::ValidateStateCache();
+        } });
+        tests.push_back({ "CommandLists", []()
+        {
+            JobSystemClass jobs;
+            jobs.Initialize(0);
+            RecordingContextClass::ValidateCommandLists(&jobs);
+        } });
+        tests.push_back({ "PipelineCache", []()
+        {
+            PipelineCacheClass::Validate();
+        } });
+        tests.push_back({ "HeadlessFrames", []()
+        {
+            int overBudget = GraphicsClass::RunHeadless(HEADLESS_TEST_FRAMES, 1.0f / 60.0f);
+            if (overBudget > 0)
+            {
+                throw engine_exception("Frame budgets exceeded on the null device: ") << overBudget;
+            }
+        } });
+#endif
+        return tests;
+    }
+
+    vector<Test> GetBenchmarks()
+    {
+        vector<Test> benchmarks;
+        benchmarks.push_back({ "FrustumCuller", []()
+        {
+            FrustumCullerClass::Benchmark(1000000);
+        } });
+        benchmarks.push_back({ "JobSystem", []()
+        {
+            JobSystemClass::Benchmark(100000);
+        } });
+        benchmarks.push_back({ "SoftwareRasterizer", []()
+        {
+            SoftwareRasterizerClass::Benchmark(20);
+        } });
+        benchmarks.push_back({ "LodSelector", []()
+        {
+            LodSelectorClass::Benchmark(100000, 120);
+        } });
+        return benchmarks;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    LogSession log(LogClass::SINK_STDERR, "");
+
+    int first = 1;
+    vector<Test> tests = GetTests();
+    if (argc > 1 && string(argv[1]) == "-benchmark")
+    {
+        tests = GetBenchmarks();
+        first = 2;
+    }
+
+    vector<const Test*> selected;
+    int failures = 0;
+    for (int i = first; i < argc; i++)
+    {
+        const Test* found = nullptr;
+        for (const Test& test : tests)
+        {
+            found = string(argv[i]) == test.name ? &test : found;
+        }
+        if (found == nullptr)
+        {
+            LOG_ERROR("No test named {}", argv[i]);
+            failures++;
+        }
+        else
+        {
+            selected.push_back(found);
+        }
+    }
+    if (first == argc)
+    {
+        for (const Test& test : tests)
+        {
+            selected.push_back(&test);
+        }
+    }
+
+    for (const Test* test : selected)
+    {
+        try
+        {
+            test->run();
+            LOG_INFO("{} passed", test->name);
+        }
+        catch (const engine_exception& e)
+        {
+            LOG_ERROR("{} failed: {}", test->name, e.what());
+            failures++;
+        }
+    }
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,851 @@
+#include "recordingcontextclass.h"
+#include "statecacheclass.h"
+#include "commandlistclass.h"
+#include "shaderlibraryclass.h"
+
+RecordingContextClass::RecordingContextClass(const bool supportsContext1)
+{
+    m_supportsContext1 = supportsContext1;
+    m_references = 1;
+}
+
+const vector<RecordingContextClass::CallRecord>& RecordingContextClass::GetCalls()
+{
+    return m_calls;
+}
+
+void RecordingContextClass::ClearCalls()
+{
+    m_calls.clear();
+}
+
+void RecordingContextClass::Record(const Call call, const unsigned int startSlot, const unsigned int count, const void* object)
+{
+    CallRecord record = { call, startSlot, count, object };
+    m_calls.push_back(record);
+}
+
+HRESULT RecordingContextClass::QueryInterface(REFIID riid, void** ppvObject)
+{
+    if (riid == __uuidof(IUnknown) || riid == __uuidof(ID3D11DeviceContext) || (m_supportsContext1 && riid == __uuidof(ID3D11DeviceContext1)))
+    {
+        AddRef();
+        *ppvObject = static_cast<ID3D11DeviceContext1*>(this);
+        return S_OK;
+    }
+
+    *ppvObject = nullptr;
+    return E_NOINTERFACE;
+}
+
+// The context lives on the stack of its test, so the count is only kept to catch leaked references.
+ULONG RecordingContextClass::AddRef()
+{
+    return ++m_references;
+}
+
+ULONG RecordingContextClass::Release()
+{
+    return --m_references;
+}
+
+void RecordingContextClass::IASetInputLayout(ID3D11InputLayout* pInputLayout)
+{
+    Record(CALL_IA_SET_INPUT_LAYOUT, 0, 0, pInputLayout);
+}
+
+void RecordingContextClass::IASetVertexBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppVertexBuffers, const UINT* pStrides, const UINT* pOffsets)
+{
+    Record(CALL_IA_SET_VERTEX_BUFFERS, StartSlot, NumBuffers, NumBuffers > 0 ? ppVertexBuffers[0] : nullptr);
+}
+
+void RecordingContextClass::IASetIndexBuffer(ID3D11Buffer* pIndexBuffer, DXGI_FORMAT Format, UINT Offset)
+{
+    Record(CALL_IA_SET_INDEX_BUFFER, 0, 0, pIndexBuffer);
+}
+
+void RecordingContextClass::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology)
+{
+    Record(CALL_IA_SET_PRIMITIVE_TOPOLOGY, 0, 0, nullptr);
+}
+
+void RecordingContextClass::VSSetShader(ID3D11VertexShader* pVertexShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+    Record(CALL_VS_SET_SHADER, 0, 0, pVertexShader);
+}
+
+void RecordingContextClass::PSSetShader(ID3D11PixelShader* pPixelShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+    Record(CALL_PS_SET_SHADER, 0, 0, pPixelShader);
+}
+
+void RecordingContextClass::VSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+    Record(CALL_VS_SET_CONSTANT_BUFFERS, StartSlot, NumBuffers, NumBuffers > 0 ? ppConstantBuffers[0] : nullptr);
+}
+
+void RecordingContextClass::PSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+    Record(CALL_PS_SET_CONSTANT_BUFFERS, StartSlot, NumBuffers, NumBuffers > 0 ? ppConstantBuffers[0] : nullptr);
+}
+
+void RecordingContextClass::VSSetConstantBuffers1(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers, const UINT* pFirstConstant,
+                                                  const UINT* pNumConstants)
+{
+    Record(CALL_VS_SET_CONSTANT_BUFFERS1, StartSlot, NumBuffers, NumBuffers > 0 ? ppConstantBuffers[0] : nullptr);
+}
+
+void RecordingContextClass::PSSetConstantBuffers1(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers, const UINT* pFirstConstant,
+                                                  const UINT* pNumConstants)
+{
+    Record(CALL_PS_SET_CONSTANT_BUFFERS1, StartSlot, NumBuffers, NumBuffers > 0 ? ppConstantBuffers[0] : nullptr);
+}
+
+void RecordingContextClass::RSSetState(ID3D11RasterizerState* pRasterizerState)
+{
+    Record(CALL_RS_SET_STATE, 0, 0, pRasterizerState);
+}
+
+void RecordingContextClass::RSSetViewports(UINT NumViewports, const D3D11_VIEWPORT* pViewports)
+{
+    Record(CALL_RS_SET_VIEWPORTS, 0, NumViewports, nullptr);
+}
+
+void RecordingContextClass::OMSetRenderTargets(UINT NumViews, ID3D11RenderTargetView* const* ppRenderTargetViews, ID3D11DepthStencilView* pDepthStencilView)
+{
+    Record(CALL_OM_SET_RENDER_TARGETS, 0, NumViews, NumViews > 0 ? ppRenderTargetViews[0] : nullptr);
+}
+
+void RecordingContextClass::OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState, UINT StencilRef)
+{
+    Record(CALL_OM_SET_DEPTH_STENCIL_STATE, 0, 0, pDepthStencilState);
+}
+
+void RecordingContextClass::OMSetBlendState(ID3D11BlendState* pBlendState, const FLOAT BlendFactor[4], UINT SampleMask)
+{
+    Record(CALL_OM_SET_BLEND_STATE, 0, 0, pBlendState);
+}
+
+void RecordingContextClass::DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation)
+{
+    Record(CALL_DRAW_INDEXED, 0, IndexCount, nullptr);
+}
+
+void RecordingContextClass::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation,
+                                                 UINT StartInstanceLocation)
+{
+    Record(CALL_DRAW_INDEXED_INSTANCED, 0, IndexCountPerInstance, nullptr);
+}
+
+void RecordingContextClass::GetDevice(ID3D11Device** ppDevice)
+{
+    *ppDevice = nullptr;
+}
+
+HRESULT RecordingContextClass::GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT RecordingContextClass::SetPrivateData(REFGUID guid, UINT DataSize, const void* pData)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT RecordingContextClass::SetPrivateDataInterface(REFGUID guid, const IUnknown* pData)
+{
+    return E_NOTIMPL;
+}
+
+void RecordingContextClass::PSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::PSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+}
+
+void RecordingContextClass::Draw(UINT VertexCount, UINT StartVertexLocation)
+{
+}
+
+HRESULT RecordingContextClass::Map(ID3D11Resource* pResource, UINT Subresource, D3D11_MAP MapType, UINT MapFlags, D3D11_MAPPED_SUBRESOURCE* pMappedResource)
+{
+    return E_NOTIMPL;
+}
+
+void RecordingContextClass::Unmap(ID3D11Resource* pResource, UINT Subresource)
+{
+}
+
+void RecordingContextClass::DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation)
+{
+}
+
+void RecordingContextClass::GSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+}
+
+void RecordingContextClass::GSSetShader(ID3D11GeometryShader* pShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+}
+
+void RecordingContextClass::VSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::VSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+}
+
+void RecordingContextClass::Begin(ID3D11Asynchronous* pAsync)
+{
+}
+
+void RecordingContextClass::End(ID3D11Asynchronous* pAsync)
+{
+}
+
+HRESULT RecordingContextClass::GetData(ID3D11Asynchronous* pAsync, void* pData, UINT DataSize, UINT GetDataFlags)
+{
+    return E_NOTIMPL;
+}
+
+void RecordingContextClass::SetPredication(ID3D11Predicate* pPredicate, BOOL PredicateValue)
+{
+}
+
+void RecordingContextClass::GSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::GSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+}
+
+void RecordingContextClass::OMSetRenderTargetsAndUnorderedAccessViews(UINT NumRTVs, ID3D11RenderTargetView* const* ppRenderTargetViews,
+                                                                      ID3D11DepthStencilView* pDepthStencilView, UINT UAVStartSlot, UINT NumUAVs,
+                                                                      ID3D11UnorderedAccessView* const* ppUnorderedAccessViews, const UINT* pUAVInitialCounts)
+{
+}
+
+void RecordingContextClass::SOSetTargets(UINT NumBuffers, ID3D11Buffer* const* ppSOTargets, const UINT* pOffsets)
+{
+}
+
+void RecordingContextClass::DrawAuto()
+{
+}
+
+void RecordingContextClass::DrawIndexedInstancedIndirect(ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs)
+{
+}
+
+void RecordingContextClass::DrawInstancedIndirect(ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs)
+{
+}
+
+void RecordingContextClass::Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ)
+{
+}
+
+void RecordingContextClass::DispatchIndirect(ID3D11Buffer* pBufferForArgs, UINT AlignedByteOffsetForArgs)
+{
+}
+
+void RecordingContextClass::RSSetScissorRects(UINT NumRects, const D3D11_RECT* pRects)
+{
+}
+
+void RecordingContextClass::CopySubresourceRegion(ID3D11Resource* pDstResource, UINT DstSubresource, UINT DstX, UINT DstY, UINT DstZ,
+                                                  ID3D11Resource* pSrcResource, UINT SrcSubresource, const D3D11_BOX* pSrcBox)
+{
+}
+
+void RecordingContextClass::CopyResource(ID3D11Resource* pDstResource, ID3D11Resource* pSrcResource)
+{
+}
+
+void RecordingContextClass::UpdateSubresource(ID3D11Resource* pDstResource, UINT DstSubresource, const D3D11_BOX* pDstBox, const void* pSrcData,
+                                              UINT SrcRowPitch, UINT SrcDepthPitch)
+{
+}
+
+void RecordingContextClass::CopyStructureCount(ID3D11Buffer* pDstBuffer, UINT DstAlignedByteOffset, ID3D11UnorderedAccessView* pSrcView)
+{
+}
+
+void RecordingContextClass::ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView, const FLOAT ColorRGBA[4])
+{
+}
+
+void RecordingContextClass::ClearUnorderedAccessViewUint(ID3D11UnorderedAccessView* pUnorderedAccessView, const UINT Values[4])
+{
+}
+
+void RecordingContextClass::ClearUnorderedAccessViewFloat(ID3D11UnorderedAccessView* pUnorderedAccessView, const FLOAT Values[4])
+{
+}
+
+void RecordingContextClass::ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView, UINT ClearFlags, FLOAT Depth, UINT8 Stencil)
+{
+}
+
+void RecordingContextClass::GenerateMips(ID3D11ShaderResourceView* pShaderResourceView)
+{
+}
+
+void RecordingContextClass::SetResourceMinLOD(ID3D11Resource* pResource, FLOAT MinLOD)
+{
+}
+
+FLOAT RecordingContextClass::GetResourceMinLOD(ID3D11Resource* pResource)
+{
+    return 0.0f;
+}
+
+void RecordingContextClass::ResolveSubresource(ID3D11Resource* pDstResource, UINT DstSubresource, ID3D11Resource* pSrcResource, UINT SrcSubresource,
+                                               DXGI_FORMAT Format)
+{
+}
+
+void RecordingContextClass::ExecuteCommandList(ID3D11CommandList* pCommandList, BOOL RestoreContextState)
+{
+}
+
+void RecordingContextClass::HSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::HSSetShader(ID3D11HullShader* pHullShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+}
+
+void RecordingContextClass::HSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+}
+
+void RecordingContextClass::HSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+}
+
+void RecordingContextClass::DSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::DSSetShader(ID3D11DomainShader* pDomainShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+}
+
+void RecordingContextClass::DSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+}
+
+void RecordingContextClass::DSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+}
+
+void RecordingContextClass::CSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView* const* ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::CSSetUnorderedAccessViews(UINT StartSlot, UINT NumUAVs, ID3D11UnorderedAccessView* const* ppUnorderedAccessViews,
+                                                      const UINT* pUAVInitialCounts)
+{
+}
+
+void RecordingContextClass::CSSetShader(ID3D11ComputeShader* pComputeShader, ID3D11ClassInstance* const* ppClassInstances, UINT NumClassInstances)
+{
+}
+
+void RecordingContextClass::CSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState* const* ppSamplers)
+{
+}
+
+void RecordingContextClass::CSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ppConstantBuffers)
+{
+}
+
+void RecordingContextClass::VSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+}
+
+void RecordingContextClass::PSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::PSGetShader(ID3D11PixelShader** ppPixelShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+}
+
+void RecordingContextClass::PSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+}
+
+void RecordingContextClass::VSGetShader(ID3D11VertexShader** ppVertexShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+}
+
+void RecordingContextClass::PSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+}
+
+void RecordingContextClass::IAGetInputLayout(ID3D11InputLayout** ppInputLayout)
+{
+}
+
+void RecordingContextClass::IAGetVertexBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppVertexBuffers, UINT* pStrides, UINT* pOffsets)
+{
+}
+
+void RecordingContextClass::IAGetIndexBuffer(ID3D11Buffer** pIndexBuffer, DXGI_FORMAT* Format, UINT* Offset)
+{
+}
+
+void RecordingContextClass::GSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+}
+
+void RecordingContextClass::GSGetShader(ID3D11GeometryShader** ppGeometryShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+}
+
+void RecordingContextClass::IAGetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY* pTopology)
+{
+}
+
+void RecordingContextClass::VSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::VSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+}
+
+void RecordingContextClass::GetPredication(ID3D11Predicate** ppPredicate, BOOL* pPredicateValue)
+{
+}
+
+void RecordingContextClass::GSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::GSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+}
+
+void RecordingContextClass::OMGetRenderTargets(UINT NumViews, ID3D11RenderTargetView** ppRenderTargetViews, ID3D11DepthStencilView** ppDepthStencilView)
+{
+}
+
+void RecordingContextClass::OMGetRenderTargetsAndUnorderedAccessViews(UINT NumRTVs, ID3D11RenderTargetView** ppRenderTargetViews,
+                                                                      ID3D11DepthStencilView** ppDepthStencilView, UINT UAVStartSlot, UINT NumUAVs,
+                                                                      ID3D11UnorderedAccessView** ppUnorderedAccessViews)
+{
+}
+
+void RecordingContextClass::OMGetBlendState(ID3D11BlendState** ppBlendState, FLOAT BlendFactor[4], UINT* pSampleMask)
+{
+}
+
+void RecordingContextClass::OMGetDepthStencilState(ID3D11DepthStencilState** ppDepthStencilState, UINT* pStencilRef)
+{
+}
+
+void RecordingContextClass::SOGetTargets(UINT NumBuffers, ID3D11Buffer** ppSOTargets)
+{
+}
+
+void RecordingContextClass::RSGetState(ID3D11RasterizerState** ppRasterizerState)
+{
+}
+
+void RecordingContextClass::RSGetViewports(UINT* pNumViewports, D3D11_VIEWPORT* pViewports)
+{
+}
+
+void RecordingContextClass::RSGetScissorRects(UINT* pNumRects, D3D11_RECT* pRects)
+{
+}
+
+void RecordingContextClass::HSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::HSGetShader(ID3D11HullShader** ppHullShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+}
+
+void RecordingContextClass::HSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+}
+
+void RecordingContextClass::HSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+}
+
+void RecordingContextClass::DSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::DSGetShader(ID3D11DomainShader** ppDomainShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+}
+
+void RecordingContextClass::DSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+}
+
+void RecordingContextClass::DSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+}
+
+void RecordingContextClass::CSGetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView** ppShaderResourceViews)
+{
+}
+
+void RecordingContextClass::CSGetUnorderedAccessViews(UINT StartSlot, UINT NumUAVs, ID3D11UnorderedAccessView** ppUnorderedAccessViews)
+{
+}
+
+void RecordingContextClass::CSGetShader(ID3D11ComputeShader** ppComputeShader, ID3D11ClassInstance** ppClassInstances, UINT* pNumClassInstances)
+{
+}
+
+void RecordingContextClass::CSGetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState** ppSamplers)
+{
+}
+
+void RecordingContextClass::CSGetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer** ppConstantBuffers)
+{
+}
+
+void RecordingContextClass::ClearState()
+{
+}
+
+void RecordingContextClass::Flush()
+{
+}
+
+D3D11_DEVICE_CONTEXT_TYPE RecordingContextClass::GetType()
+{
+    return D3D11_DEVICE_CONTEXT_IMMEDIATE;
+}
+
+UINT RecordingContextClass::GetContextFlags()
+{
+    return 0;
+}
+
+HRESULT RecordingContextClass::FinishCommandList(BOOL RestoreDeferredContextState, ID3D11CommandList** ppCommandList)
+{
+    return E_NOTIMPL;
+}
+
+void RecordingContextClass::ValidateStateCache()
+{
+    auto check = [](const bool passed, const char* what)
+    {
+        if (!passed)
+        {
+            throw engine_exception("State cache validation: ") << what;
+        }
+    };
+
+    // The cache only compares pointers, so objects are stand in addresses that are never dereferenced.
+    char objects[16];
+    ID3D11Buffer* buffers[4] = { (ID3D11Buffer*)&objects[0], (ID3D11Buffer*)&objects[1], (ID3D11Buffer*)&objects[2], (ID3D11Buffer*)&objects[3] };
+    ID3D11InputLayout* inputLayout = (ID3D11InputLayout*)&objects[4];
+    ID3D11VertexShader* vertexShader = (ID3D11VertexShader*)&objects[5];
+    ID3D11PixelShader* pixelShader = (ID3D11PixelShader*)&objects[6];
+    ID3D11RasterizerState* rasterizerStates[2] = { (ID3D11RasterizerState*)&objects[7], (ID3D11RasterizerState*)&objects[8] };
+    ID3D11DepthStencilState* depthStencilState = (ID3D11DepthStencilState*)&objects[9];
+    ID3D11BlendState* blendState = (ID3D11BlendState*)&objects[10];
+    ID3D11RenderTargetView* renderTarget = (ID3D11RenderTargetView*)&objects[11];
+    ID3D11DepthStencilView* depthStencilView = (ID3D11DepthStencilView*)&objects[12];
+
+    RecordingContextClass context(true);
+    {
+        StateCacheClass cache;
+        cache.Initialize(&context);
+        check(cache.SupportsConstantBufferOffsets(), "a D3D11.1 context wasn't detected");
+
+        // Every kind of call twice: the first reaches the context, the second doesn't.
+        const unsigned int strides[3] = { 16, 16, 8 };
+        const unsigned int offsets[3] = { 0, 0, 0 };
+        const float blendFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        D3D11_VIEWPORT viewport = { 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+        for (int pass = 0; pass < 2; pass++)
+        {
+            cache.IASetInputLayout(inputLayout);
+            cache.IASetVertexBuffers(0, 3, buffers, strides, offsets);
+            cache.IASetIndexBuffer(buffers[3], DXGI_FORMAT_R16_UINT, 0);
+            cache.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            cache.VSSetShader(vertexShader);
+            cache.PSSetShader(pixelShader);
+            cache.VSSetConstantBuffers(0, 2, buffers);
+            cache.PSSetConstantBuffers(0, 1, buffers);
+            cache.RSSetState(rasterizerStates[0]);
+            cache.RSSetViewports(1, &viewport);
+            cache.OMSetRenderTargets(1, &renderTarget, depthStencilView);
+            cache.OMSetDepthStencilState(depthStencilState, 1);
+            // A null blend factor is D3D's { 1, 1, 1, 1 }, so the second pass matches the first.
+            cache.OMSetBlendState(blendState, pass == 0 ? blendFactor : nullptr, 0xFFFFFFFF);
+            cache.DrawIndexed(3, 0, 0);
+        }
+        check(context.GetCalls().size() == 13 + 2, "a redundant call reached the context");
+        check(cache.GetIssuedCalls() == 13 && cache.GetElidedCalls() == 13, "the counters don't match the calls that reached the context");
+        check(context.GetCalls()[13].call == CALL_DRAW_INDEXED && context.GetCalls()[14].call == CALL_DRAW_INDEXED, "a draw wasn't passed through");
+
+        // Counters are per frame.
+        cache.EndFrame();
+        check(cache.GetIssuedCalls() == 0 && cache.GetElidedCalls() == 0, "EndFrame didn't reset the counters");
+
+        // Only the slots that changed are bound, as one range from the first to the last of them.
+        context.ClearCalls();
+        ID3D11Buffer* rebound[3] = { buffers[0], buffers[3], buffers[2] };
+        cache.IASetVertexBuffers(0, 3, rebound, strides, offsets);
+        const unsigned int newOffsets[3] = { 0, 0, 64 };
+        cache.IASetVertexBuffers(0, 3, rebound, strides, newOffsets);
+        check(context.GetCalls().size() == 2 && context.GetCalls()[0].startSlot == 1 && context.GetCalls()[0].count == 1
+              && context.GetCalls()[1].startSlot == 2 && context.GetCalls()[1].count == 1, "vertex buffers weren't narrowed to the changed slots");
+
+        // Binding another range of the same buffer is a change; binding the same range again isn't.
+        context.ClearCalls();
+        const unsigned int firstConstants[2] = { 0, 16 };
+        const unsigned int numConstants[2] = { 16, 16 };
+        cache.VSSetConstantBuffers1(0, 2, buffers, firstConstants, numConstants);
+        cache.VSSetConstantBuffers1(0, 2, buffers, firstConstants, numConstants);
+        check(context.GetCalls().size() == 1 && context.GetCalls()[0].call == CALL_VS_SET_CONSTANT_BUFFERS1, "a constant buffer range wasn't filtered");
+
+        // Invalidate forgets everything, so the same state goes out again.
+        context.ClearCalls();
+        cache.Invalidate();
+        cache.RSSetState(rasterizerStates[0]);
+        cache.RSSetState(rasterizerStates[0]);
+        check(context.GetCalls().size() == 1, "state set after Invalidate wasn't issued exactly once");
+
+        // Of a pipeline state only the unknown pieces are set, the same handle again costs nothing and another handle only
+        // the pieces that differ.
+        PipelineCacheClass::PipelineState solid = { 1, rasterizerStates[0], depthStencilState, 1, blendState, { 1.0f, 1.0f, 1.0f, 1.0f }, 0xFFFFFFFF,
+                                                    vertexShader, pixelShader, inputLayout, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST };
+        PipelineCacheClass::PipelineState wireframe = solid;
+        wireframe.hash = 2;
+        wireframe.rasterizerState = rasterizerStates[1];
+        cache.EndFrame();
+        context.ClearCalls();
+        cache.SetPipelineState(&solid);
+        cache.SetPipelineState(&solid);
+        bool setRasterizerState = false;
+        for (const CallRecord& record : context.GetCalls())
+        {
+            setRasterizerState |= record.call == CALL_RS_SET_STATE;
+        }
+        check(context.GetCalls().size() == 6 && !setRasterizerState, "binding a pipeline state set more than what wasn't known");
+        cache.SetPipelineState(&wireframe);
+        check(context.GetCalls().size() == 7 && context.GetCalls()[6].call == CALL_RS_SET_STATE, "switching pipeline states set more than the rasterizer state");
+        check(cache.GetIssuedCalls() == 6 + 1 && cache.GetElidedCalls() == 1 + 1 + 6, "the pipeline state counters are off");
+    }
+    check(context.m_references == 1, "the state cache leaked a reference to its context");
+
+    // Without D3D11.1 the plain calls still work and the range calls refuse.
+    RecordingContextClass oldContext(false);
+    StateCacheClass cache;
+    cache.Initialize(&oldContext);
+    check(!cache.SupportsConstantBufferOffsets(), "a D3D11.0 context was taken for D3D11.1");
+    cache.PSSetConstantBuffers(0, 1, buffers);
+    check(oldContext.GetCalls().size() == 1, "a plain constant buffer call didn't reach a D3D11.0 context");
+    bool threw = false;
+    try
+    {
+        const unsigned int firstConstant = 0, numConstant = 16;
+        cache.PSSetConstantBuffers1(0, 1, buffers, &firstConstant, &numConstant);
+    }
+    catch (const engine_exception&)
+    {
+        threw = true;
+    }
+    check(threw && oldContext.GetCalls().size() == 1, "a range call on a D3D11.0 context didn't throw");
+}
+
+void RecordingContextClass::ValidateCommandLists(JobSystemClass* jobSystem)
+{
+    auto check = [](const bool passed, const char* what)
+    {
+        if (!passed)
+        {
+            throw engine_exception("Command list validation: ") << what;
+        }
+    };
+
+    SwapChainClass::Settings presentSettings = { SwapChainClass::SWAP_FLIP_DISCARD, 3, 1, true, true, true };
+    D3DClass d3d;
+    d3d.Initialize(64, 64, presentSettings, NULL, false, 1000.0f, 0.1f, D3DClass::RENDERER_NULL);
+    ShaderLibraryClass shaderLibrary;
+    shaderLibrary.Initialize();
+    ColorShaderClass shader;
+    shader.Initialize(d3d.GetDevice(), d3d.GetPipelineCache(), &shaderLibrary);
+
+    // Draw d of list i uses model (i + d) % modelCount, so every draw binds other buffers than the one before it and list
+    // i draws i + 1 times. Binding each model on a context of its own tells which buffers are its.
+    const unsigned int modelCount = 3;
+    const unsigned int listCount = 6;
+    unique_ptr<ModelClass> models[modelCount];
+    const void* indexBuffers[modelCount];
+    const void* vertexBuffers[modelCount];
+    for (unsigned int model = 0; model < modelCount; model++)
+    {
+        models[model] = unique_ptr<ModelClass>(new ModelClass());
+        models[model]->Initialize(d3d.GetDevice(), VertexFormatClass::VERTEX_UNORM16_RGBA8);
+        RecordingContextClass probe(false);
+        StateCacheClass probeCache;
+        probeCache.Initialize(&probe);
+        models[model]->Render(&probeCache, 0);
+        check(probe.GetCalls().size() == 2, "a model didn't bind exactly its vertex and index buffers");
+        vertexBuffers[model] = probe.GetCalls()[0].object;
+        indexBuffers[model] = probe.GetCalls()[1].object;
+    }
+
+    XMMATRIX view = XMMatrixTranslation(0.0f, 0.0f, 10.0f);
+    XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 1.0f, 0.1f, 1000.0f);
+    auto recordLists = [jobSystem, &d3d, &shader, &models, &view, &projection](vector<unique_ptr<CommandListClass>>& lists)
+    {
+        jobSystem->ParallelFor((unsigned int)lists.size(), 1, [&lists, &d3d, &shader, &models, &view, &projection](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; i++)
+            {
+                lists[i]->Begin(&d3d);
+                lists[i]->SetFrameConstants(view, projection);
+                for (unsigned int draw = 0; draw <= i; draw++)
+                {
+                    lists[i]->Draw(models[(i + draw) % modelCount].get(), &shader, XMMatrixTranslation((float)draw, (float)i, 0.0f));
+                }
+                lists[i]->End();
+            }
+        });
+    };
+
+    // CPU streams, replayed in list order through a state cache the way the software renderer draws them. The cache only
+    // binds a model's buffers when they change, so the expected calls follow from the model of each draw.
+    vector<unique_ptr<CommandListClass>> streams;
+    for (unsigned int i = 0; i < listCount; i++)
+    {
+        streams.push_back(unique_ptr<CommandListClass>(new CommandListClass()));
+        streams[i]->Initialize(nullptr);
+    }
+    recordLists(streams);
+
+    vector<CallRecord> expected;
+    int previousModel = -1;
+    for (unsigned int i = 0; i < listCount; i++)
+    {
+        check(!streams[i]->IsDeferred() && streams[i]->GetDrawCount() == i + 1, "a CPU stream didn't record its draws");
+        for (unsigned int draw = 0; draw <= i; draw++)
+        {
+            int model = (int)((i + draw) % modelCount);
+            if (model != previousModel)
+            {
+                CallRecord vertexBuffer = { CALL_IA_SET_VERTEX_BUFFERS, 0, 1, vertexBuffers[model] };
+                CallRecord indexBuffer = { CALL_IA_SET_INDEX_BUFFER, 0, 0, indexBuffers[model] };
+                expected.push_back(vertexBuffer);
+                expected.push_back(indexBuffer);
+                previousModel = model;
+            }
+            CallRecord drawIndexed = { CALL_DRAW_INDEXED, 0, (unsigned int)models[model]->GetIndexCount(0), nullptr };
+            expected.push_back(drawIndexed);
+        }
+    }
+
+    RecordingContextClass context(false);
+    {
+        StateCacheClass stateCache;
+        stateCache.Initialize(&context);
+        for (unsigned int i = 0; i < listCount; i++)
+        {
+            streams[i]->Replay([&stateCache](const CommandListClass::Command& command)
+            {
+                if (command.type == CommandStreamClass::COMMAND_DRAW)
+                {
+                    command.model->Render(&stateCache, command.lod);
+                    stateCache.DrawIndexed(command.model->GetIndexCount(command.lod), 0, 0);
+                }
+            });
+        }
+    }
+    const vector<CallRecord>& calls = context.GetCalls();
+    check(calls.size() == expected.size(), "the CPU streams replayed a different number of calls");
+    for (size_t call = 0; call < calls.size(); call++)
+    {
+        if (calls[call].call != expected[call].call || calls[call].startSlot != expected[call].startSlot || calls[call].count != expected[call].count
+            || calls[call].object != expected[call].object)
+        {
+            throw engine_exception("Command list validation: replayed call ") << (unsigned int)call << " is out of order";
+        }
+    }
+
+    // Without the software renderer a CPU stream has nothing to execute on.
+    bool threw = false;
+    try
+    {
+        streams[0]->Execute(&d3d);
+    }
+    catch (const engine_exception&)
+    {
+        threw = true;
+    }
+    check(threw, "a CPU stream executed without the software renderer");
+
+    // Deferred contexts, executed in list order on the null device's immediate context. Each list starts from default
+    // state, so every draw follows the index buffer of its model, and the lists show up between their executes.
+    vector<unique_ptr<CommandListClass>> lists;
+    for (unsigned int i = 0; i < listCount; i++)
+    {
+        lists.push_back(unique_ptr<CommandListClass>(new CommandListClass()));
+        lists[i]->Initialize(d3d.GetDevice());
+    }
+    recordLists(lists);
+
+    NullDeviceClass* nullDevice = d3d.GetNullDevice();
+    d3d.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+    for (unsigned int i = 0; i < listCount; i++)
+    {
+        check(lists[i]->IsDeferred() && lists[i]->GetDrawCount() == i + 1, "a deferred list didn't record its draws");
+        lists[i]->Execute(&d3d);
+    }
+    // A list only executes once per recording.
+    lists[0]->Execute(&d3d);
+    d3d.EndScene();
+
+    // The null device numbers objects in creation order, so the numbers of the models' index buffers are learned from the
+    // first list that draws them.
+    unsigned int indexBufferNumbers[modelCount] = {};
+    int list = -1;
+    unsigned int draw = 0, indexBuffer = 0;
+    for (const NullDeviceClass::CallRecord& record : nullDevice->GetFrameLog())
+    {
+        if (record.call == NullDeviceClass::CALL_EXECUTE_COMMAND_LIST)
+        {
+            check(list < 0 || draw == (unsigned int)list + 1, "an executed list is missing draws");
+            list++;
+            draw = 0;
+        }
+        else if (record.call == NullDeviceClass::CALL_IA_SET_INDEX_BUFFER)
+        {
+            indexBuffer = record.arguments[0];
+        }
+        else if (record.call == NullDeviceClass::CALL_DRAW_INDEXED)
+        {
+            check(list >= 0 && list < (int)listCount && draw <= (unsigned int)list, "a draw ran outside its list");
+            unsigned int model = (list + draw) % modelCount;
+            indexBufferNumbers[model] = indexBufferNumbers[model] == 0 ? indexBuffer : indexBufferNumbers[model];
+            check(indexBuffer != 0 && indexBuffer == indexBufferNumbers[model], "an executed draw used another model's buffers");
+            draw++;
+        }
+    }
+    check(list == (int)listCount - 1 && draw == listCount, "the deferred lists weren't each executed once");
+    check(indexBufferNumbers[0] != indexBufferNumbers[1] && indexBufferNumbers[1] != indexBufferNumbers[2] && indexBufferNumbers[0] != indexBufferNumbers[2],
+          "two models executed with the same index buffer");
+
+    LOG_INFO("Command list validation passed: {} lists replayed and executed in order", listCount);
+}
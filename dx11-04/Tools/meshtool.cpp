@@ -0,0 +1,57 @@
+#include "engine_core.h"
+#include "meshconverterclass.h"
+#include <cstdlib>
+#include <string>
+
+using namespace std;
+
+// The offline mesh pipeline of MeshConverterClass, without Windows or D3D:
+//     MeshTool -convert input.obj|input.ply|input.mesh output.mesh [vertex format]
+//     MeshTool -optimize input.mesh output.mesh
+//     MeshTool -simplify input.mesh output.mesh [ratio]
+// -convert writes unorm16_rgba8 vertices by default; -optimize welds and reorders a .mesh file converted before the
+// optimizer, and -simplify cuts the full model down to ratio (0.5 by default) of its triangles. Both keep the vertex
+// format and rebuild the LOD chain.
+int main(int argc, char* argv[])
+{
+    LogSession log(LogClass::SINK_STDERR, "");
+
+    if (argc < 4)
+    {
+        LOG_ERROR("Usage: MeshTool -convert|-optimize|-simplify input output [vertex format|ratio]");
+        return 1;
+    }
+
+    string command = argv[1];
+    const char* inputFileName = argv[2];
+    const char* outputFileName = argv[3];
+    const char* option = argc > 4 ? argv[4] : nullptr;
+    try
+    {
+        if (command == "-convert")
+        {
+            VertexFormatClass::Format format = option != nullptr ? VertexFormatClass::ParseName(option) : VertexFormatClass::VERTEX_UNORM16_RGBA8;
+            MeshConverterClass::Convert(inputFileName, outputFileName, format);
+        }
+        else if (command == "-optimize")
+        {
+            MeshConverterClass::Optimize(inputFileName, outputFileName);
+        }
+        else if (command == "-simplify")
+        {
+            MeshConverterClass::Simplify(inputFileName, outputFileName, option != nullptr ? (float)atof(option) : 0.5f);
+        }
+        else
+        {
+            LOG_ERROR("Unknown command {}", command);
+            return 1;
+        }
+    }
+    catch (const engine_exception& e)
+    {
+        LOG_ERROR("{} failed: {}", command, e.what());
+        return 1;
+    }
+
+    return 0;
+}